@@ -32,6 +32,7 @@
 // ----- Includes -----
 
 #include "Animation.h"
+#include <string.h>
 
 
 // --------------------------------------------------------------------------------
@@ -42,7 +43,7 @@ Animation::Animation(int id, const char* name, int length, const char* looping,
     _id             = id;
     _name           = const_cast<char *>(name);
     _length         = length;
-    _looping        = const_cast<char *>(looping);
+    _looping        = !(looping && strcmp(looping, "false") == 0);     // Animations loop unless the file says otherwise
     _loop_to        = loop_to;
     _mainline       = new Mainline();
     _timelineList   = new std::vector <Timeline *>;
@@ -50,7 +51,9 @@ Animation::Animation(int id, const char* name, int length, const char* looping,
 
 Animation::~Animation() {
     delete _mainline;
-    delete [] _timelineList;
+    for (unsigned int i = 0; i < _timelineList->size(); i++)
+        delete _timelineList->at(i);
+    delete _timelineList;
 }
 
 // --------------------------------------------------------------------------------
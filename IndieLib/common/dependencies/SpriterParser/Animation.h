@@ -62,6 +62,14 @@ std::vector <Timeline *>* getTimeLines(){
  	return _timelineList;
  }
 
+ int getLength(){
+ 	return _length;
+ }
+
+ bool isLooping(){
+ 	return _looping;
+ }
+
 
  // ----- Public Sets ------
 
@@ -74,7 +82,7 @@ private:
  int                         _id;
  char*                       _name;
  int                         _length;
- char*                       _looping;
+ bool                        _looping;
  int                         _loop_to;
  Mainline                    *_mainline;
  std::vector <Timeline *>    *_timelineList;
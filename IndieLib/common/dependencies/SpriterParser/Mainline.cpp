@@ -43,7 +43,9 @@ Mainline::Mainline() {
 }
 
 Mainline::~Mainline() {
-    delete [] _keyList;
+    for (unsigned int i = 0; i < _keyList->size(); i++)
+        delete _keyList->at(i);
+    delete _keyList;
 }
 
 // --------------------------------------------------------------------------------
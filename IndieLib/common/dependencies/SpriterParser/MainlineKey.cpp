@@ -41,27 +41,47 @@
 MainlineKey::MainlineKey(int id, int time) {
     _id				= id;
     _time			= time;
+    _bonerefList	= new std::vector <MainlineBoneref *>;
     _objectrefList	= new std::vector <MainlineObjectref *>;
     _objectList		= new std::vector <MainlineObject *>;
 }
 
 MainlineKey::~MainlineKey() {
-    delete [] _objectrefList;
-    delete [] _objectList;
+    for (unsigned int i = 0; i < _bonerefList->size(); i++)
+        delete _bonerefList->at(i);
+    for (unsigned int i = 0; i < _objectrefList->size(); i++)
+        delete _objectrefList->at(i);
+    for (unsigned int i = 0; i < _objectList->size(); i++)
+        delete _objectList->at(i);
+
+    delete _bonerefList;
+    delete _objectrefList;
+    delete _objectList;
 }
 
 // --------------------------------------------------------------------------------
 //									 Public methods
 // --------------------------------------------------------------------------------
 
-void MainlineKey::addObjectref(int id, int timeline, int key, int z_index) {
+void MainlineKey::addBoneref(int id, int parent, int timeline, int key) {
+	MainlineBoneref *mainlineBonerefPtr = new MainlineBoneref();
+    mainlineBonerefPtr->id = id;
+    mainlineBonerefPtr->parent = parent;
+    mainlineBonerefPtr->timeline = timeline;
+    mainlineBonerefPtr->key = key;
+    
+    _bonerefList->push_back(mainlineBonerefPtr);
+}
+
+void MainlineKey::addObjectref(int id, int parent, int timeline, int key, int z_index) {
 	MainlineObjectref *mainlineObjectrefPtr = new MainlineObjectref();
     mainlineObjectrefPtr->id = id;
+    mainlineObjectrefPtr->parent = parent;
     mainlineObjectrefPtr->timeline = timeline;
     mainlineObjectrefPtr->key = key;
     mainlineObjectrefPtr->z_index = z_index;
     
-    _objectrefList->insert(_objectrefList->begin() + id, mainlineObjectrefPtr);
+    _objectrefList->push_back(mainlineObjectrefPtr);
 }
 
 void MainlineKey::addObject(int id, const char* object_type, int folder, int file, float x, float y, float pivot_x, float pivot_y, float angle, float scale_x, float scale_y, float a) {
@@ -34,6 +34,7 @@
 
 // ----- Includes -----
 
+#include "MainlineBoneref.h"
 #include "MainlineObjectref.h"
 #include "MainlineObject.h"
 #include <vector>
@@ -54,7 +55,8 @@ public:
     
     // ----- Public Sets ------
     
-    void addObjectref(int id, int timeline, int key, int z_index);
+    void addBoneref(int id, int parent, int timeline, int key);
+    void addObjectref(int id, int parent, int timeline, int key, int z_index);
     void addObject(int id, const char* object_type, int folder, int file, float x, float y, float pivot_x, float pivot_y, float angle, float scale_x, float scale_y, float a);
     
     // ----- Public Gets ------
@@ -67,6 +69,10 @@ public:
         return _time;
     }
     
+    std::vector <MainlineBoneref *>* getBonerefs(){
+        return _bonerefList;
+    }
+    
     std::vector <MainlineObjectref *>* getObjectrefs(){
         return _objectrefList;
     }
@@ -83,6 +89,7 @@ private:
 
     int                                 _id;
     int                                 _time;
+    std::vector <MainlineBoneref *>     *_bonerefList;
     std::vector <MainlineObjectref *>   *_objectrefList;
     std::vector <MainlineObject *>      *_objectList;
 
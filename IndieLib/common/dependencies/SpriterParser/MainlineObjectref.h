@@ -36,6 +36,7 @@
 struct MainlineObjectref {
 	
 	int	id;
+	int	parent;		// id of the boneref the object is attached to, -1 if none
 	int	timeline;
 	int	key;
 	int	z_index;
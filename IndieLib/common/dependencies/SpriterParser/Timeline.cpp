@@ -47,7 +47,9 @@ Timeline::Timeline(int id, const char* name, const char* object_type, const char
 }
 
 Timeline::~Timeline() {
-    delete [] _keyList;
+    for (unsigned int i = 0; i < _keyList->size(); i++)
+        delete _keyList->at(i);
+    delete _keyList;
 }
 
 // --------------------------------------------------------------------------------
@@ -55,7 +57,7 @@ Timeline::~Timeline() {
 // --------------------------------------------------------------------------------
 
 TimelineKey* Timeline::addKey(int id, int time, int spin) {
-	TimelineKey *keyPtr = new TimelineKey(id, time, (spin == 0 ? 1 : spin));
+	TimelineKey *keyPtr = new TimelineKey(id, time, spin);
     _keyList->insert(_keyList->begin() + id, keyPtr);
     
     return keyPtr;
@@ -46,7 +46,9 @@ TimelineKey::TimelineKey(int id, int time, int spin) {
 }
 
 TimelineKey::~TimelineKey() {
-    delete [] _objectList; // TODO is this really only one instance instead?
+    for (unsigned int i = 0; i < _objectList->size(); i++)
+        delete _objectList->at(i);
+    delete _objectList;
 }
 
 // --------------------------------------------------------------------------------
@@ -674,6 +674,66 @@ typedef int IND_Type;
 #define IND_ALPHA                           202
 /**@}*/
 
+/**
+ * @defgroup IND_AlphaClass Alpha classes of the surfaces
+ * @ingroup Types
+ */
+/**@{*/
+
+//! Alpha classes of the surfaces
+
+/**
+@b IND_AlphaClass (alpha class of a surface).
+
+When a surface is created, the alpha channel of its image is checked in order to know if the surface
+has only opaque pixels, only opaque and fully transparent pixels, or semitransparent pixels. Surfaces
+that aren't translucent can be drawn before the rest of entities of the layer (see IND_Entity2dManager::setOpaqueFirst()).
+
+<b>Types IND_AlphaClass</b>
+
+@arg ::IND_ALPHA_CLASS_OPAQUE
+@arg ::IND_ALPHA_CLASS_TESTED
+@arg ::IND_ALPHA_CLASS_TRANSLUCENT
+*/
+typedef int IND_AlphaClass;
+
+//! All the pixels of the surface are opaque.
+#define IND_ALPHA_CLASS_OPAQUE              0
+//! The pixels of the surface are opaque or fully transparent (alpha test is enough for drawing it).
+#define IND_ALPHA_CLASS_TESTED              1
+//! The surface has semitransparent pixels, or its image couldn't be checked.
+#define IND_ALPHA_CLASS_TRANSLUCENT         2
+/**@}*/
+
+/**
+ * @defgroup IND_FillBlend Blending of the pixels in the fill rate statistics
+ * @ingroup Types
+ */
+/**@{*/
+
+//! Blending of the pixels in the fill rate statistics
+
+/**
+@b IND_FillBlend (blending of the drawn pixels).
+
+The pixels counted by the fill rate statistics (see IND_Render::setFillStats()) are split by the
+blending used for drawing them.
+
+<b>Types IND_FillBlend</b>
+
+@arg ::IND_FILL_REPLACE
+@arg ::IND_FILL_BLEND
+*/
+typedef int IND_FillBlend;
+
+//! Pixels that replace the pixels of the screen (::IND_OPAQUE surfaces without alpha or fade).
+#define IND_FILL_REPLACE                    0
+//! Pixels blended with the pixels of the screen (::IND_ALPHA surfaces, alpha or fade).
+#define IND_FILL_BLEND                      1
+//! Number of blendings of the fill rate statistics.
+#define IND_FILL_BLEND_MODES                2
+/**@}*/
+
 /**
  * @defgroup IND_Align Font alignment
  * @ingroup Types
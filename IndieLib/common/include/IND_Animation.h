@@ -104,6 +104,10 @@ The  @b tokens or <b>keywords</b> of a @b IndieLib animation file are:
 
 @b Note: "//"  can be used before a phrase for writing comments.
 
+For faster loading, a script can be converted with IND_AnimationManager::saveBundle() into a binary
+bundle (.anb) that contains all the frames in a single file. The bundle is loaded instead of the script
+when it has the same name as the script.
+
 @image html surfa1.jpg Animations example in IndieLib.
 */
 class LIB_EXP IND_Animation : public IND_Object{
@@ -130,7 +134,7 @@ public:
 	}
 	//! This function returns the pointer to the object ::IND_Image that contains the frame received or NULL in case that the object has not been loaded.
 	IND_Image               *getImage(unsigned int pFrame);
-	//! This function returns the pointer to the object ::IND_Surface that contains the frame received or NULL in case that the object has not been loaded.
+	//! This function returns the pointer to the object ::IND_Surface that contains the frame received or NULL in case that the object has not been loaded. When the frame is packed into an atlas, the surface is the atlas page (shared with other frames).
 	IND_Surface             *getSurface(unsigned int pFrame);
 
 	// ----- Relative to a concrete sequence ------
@@ -144,7 +148,26 @@ public:
 	//! This function returns the name, in a string of characters, of the sequence received as a paramater.
 	const char* const getName(unsigned int pSequence);
 
+	//! This function returns the position, in the list of frames of the animation, of a frame of the sequence.
+	unsigned int                     getFramePosInVec(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the time, in milliseconds, that a frame of the sequence is displayed.
+	unsigned int                     getFrameTime(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the horizontal offset of a frame of the sequence.
+	unsigned int                     getFrameOffsetX(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the vertical offset of a frame of the sequence.
+	unsigned int                     getFrameOffsetY(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the pointer to the object ::IND_Surface of a frame of the sequence.
+	IND_Surface             *getFrameSurface(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the width of a frame of the sequence (the width of its image, also when the frame is packed into an atlas).
+	int                     getFrameWidth(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the height of a frame of the sequence (the height of its image, also when the frame is packed into an atlas).
+	int                     getFrameHeight(unsigned int pSequence, unsigned int pFrame);
+	//! This function returns the atlas page where a frame of the sequence is packed, or NULL if the frame has a surface of its own, and the rectangle of the page that holds a region of the frame (see IND_AnimationManager::setAtlas()).
+	IND_Surface             *getFrameAtlas(unsigned int pSequence, unsigned int pFrame, int *pX, int *pY, int *pWidth, int *pHeight, int *pDrawX, int *pDrawY);
+
 	//FIXME: NOT DOCUMENTED
+	// The "actual" frame is the one of the animation blitted directly with IND_Render::blitAnimation().
+	// Each IND_Entity2d has its own actual frame (see IND_Entity2d::getFramePos()).
 	unsigned int                     getActualFramePos(unsigned int pSequence);
 	unsigned int                     getActualFramePosInVec(unsigned int pSequence);
 	unsigned int                     getActualFrameTime(unsigned int pSequence);
@@ -152,7 +175,7 @@ public:
 	unsigned int                     getActualOffsetY(unsigned int pSequence);
 	IND_Surface             *getActualSurface(unsigned int pSequence);
 	void                    setActualFramePos(unsigned int pSequence, unsigned int pPos);
-	IND_Timer               *getSequenceTimer(unsigned int pSequence);
+	float                   getElapsedTime(unsigned int pSequence);
 
 	bool                    getIsActive(unsigned int pSequence);
 	void                    setIsActive(unsigned int pSequence, bool pAct);
@@ -232,9 +255,15 @@ private:
 		return _vectorFrames;
 	}
 
+	// ----- Private methods ------
+
+	int                     updateSequence(unsigned int pSequence, double pClock);
+	int                     updateSequence(unsigned int pSequence, SEQUENCE_PLAYBACK *pPlayback, double pClock);
+
 	// ----- Friends -----
 
 	friend class IND_AnimationManager;
+	friend class IND_Render;
 	friend class DirectXRender;
 	friend class OpenGLES_iOS_Render;
 	friend class IND_Entity2dManager;
@@ -66,7 +66,7 @@ public:
 
 	// ----- Init/End -----
 
-	IND_AnimationManager(): _ok(false)  { }
+	IND_AnimationManager(): _ok(false), _atlas(false), _atlasTrim(false), _rebuildBundles(false)  { }
 	~IND_AnimationManager()              {
 		end();
 	}
@@ -114,6 +114,25 @@ public:
 
 	bool remove(IND_Animation *pAn);
 
+	bool saveBundle(const char *pAnimation, const char *pBundle);
+	void setRebuildBundles(bool pRebuild);
+	//! This function returns true if the stale animation bundles are made again when they are added (see setRebuildBundles()).
+	bool isRebuildBundles()              {
+		return _rebuildBundles;
+	}
+
+	// ----- Frames atlas -----
+
+	void setAtlas(bool pAtlas, bool pTrim);
+	//! This function returns true if the frames of the animations are packed into atlas pages (see setAtlas()).
+	bool isAtlas()              {
+		return _atlas;
+	}
+	//! This function returns true if the transparent borders of the frames are trimmed when they are packed (see setAtlas()).
+	bool isAtlasTrim()              {
+		return _atlasTrim;
+	}
+
 
 private:
 
@@ -122,6 +141,9 @@ private:
 	// ----- Private -----
 
 	bool _ok;
+	bool _atlas;
+	bool _atlasTrim;
+	bool _rebuildBundles;
 
 	// ----- Enums -----
 
@@ -165,6 +187,9 @@ private:
 	bool        remove(IND_Animation *pAn, bool pType);
 
 	bool        parseAnimation(IND_Animation *pNewAnimation, const char *pAnimationName);
+	bool        loadBundle(IND_Animation *pNewAnimation, const char *pBundleName, const char *pAnimationName, bool *pStale);
+	void        packAtlas(IND_Animation *pAn, IND_Type pType, IND_Quality pQuality);
+	void        freeFrames(IND_Animation *pAn);
 	bool        isDeclaredFrame(const char *pFrameName, IND_Animation *pNewAnimation, int *pPos);
 
 	void        writeMessage();
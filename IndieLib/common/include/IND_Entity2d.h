@@ -37,6 +37,7 @@
 #include "Defines.h"
 #include <list>
 #include "IND_Object.h"
+#include "IND_Sequence.h"
 
 // ----- Forward declarations -----
 
@@ -44,6 +45,8 @@ class CollisionParser;
 class IND_Animation;
 class IND_Surface;
 class IND_Font;
+class SpatialGrid;
+class TextMesh;
 
 // --------------------------------------------------------------------------------
 //									 IND_Entity2d
@@ -208,6 +211,10 @@ public:
 	int     getSequence()      {
 		return _sequence;
 	}
+	//! Returns the frame of the sequence that the entity is showing. Each entity plays the animation on its own.
+	int     getFramePos()      {
+		return _playback._frame;
+	}
 	//! Returns the number of repetitions the animation has to do. If this value is equal or less than zero, it indicates that the amination is looping.
 	int     getNumReplays()      {
 		return _numReplays;
@@ -394,6 +401,10 @@ public:
 	bool    isShowGridAreas()              {
 		return _showGridAreas;
 	}
+	//! Returns the pixels drawn by the entity the last time that its layer was rendered, when the fill rate statistics are enabled (see IND_Render::setFillStats())
+	int     getFillPixelsInt()      {
+		return _fillPixels;
+	}
 	/**@}*/
 
 private:
@@ -421,6 +432,7 @@ private:
 
 	// Space transformation attributes
 	bool _updateTransFlag;  // Flag for knowing when to recalculate the transformation matrix of an entity
+	bool _updateCacheFlag;  // Flag for knowing when to redraw the cached layer of an entity (see IND_Entity2dManager::setLayerCache())
 	float _x;               // x Coordinate
 	float _y;               // y Coordinate
 	int _z;                 // Depth (indicates which object will be blitted upon which other)
@@ -464,6 +476,7 @@ private:
 
 	// Animation attributes
 	unsigned int _sequence;          // Index of the sequence
+	SEQUENCE_PLAYBACK _playback;     // Actual frame and time of the sequence (the animation is shared by many entities)
 	int _numReplays;        // Num of replays of the sequence
 	int _firstTime;         // Flag
 
@@ -480,6 +493,7 @@ private:
 	int _charSpacing;       // Additional space between letters
 	int _lineSpacing;       // Space between lines
 	char *_text;            // Text
+	TextMesh *_textMesh;    // Quads of the text, kept until it changes (created when it is first drawn)
 
 	// Collision attributes
 	bool _showCollisionAreas;
@@ -487,6 +501,17 @@ private:
 	// Grid areas attributes
 	bool _showGridAreas;
 
+	// Fill rate statistics
+	int _fillPixels;        // Pixels drawn the last time the entity was rendered
+
+	// Spatial index of the layer (see IND_Entity2dManager::setSpatialIndex()), not restarted by initAttrib()
+	SpatialGrid *_spatialGrid;       // Spatial index that has the entity, or NULL
+	bool _spatialDirty;              // The bounds have to be calculated again
+	bool _spatialLarge;              // Too big for the cells, always tested
+	int _spatialCells [4];           // Cells covered by the bounds (min x, min y, max x, max y)
+	float _spatialBox [4];           // World bounding box (min x, min y, max x, max y)
+	unsigned int _spatialStamp;      // Last query of the spatial index that returned the entity
+
 	// Collision list for surfaces (the collision list for animations is in IND_AnimationManager.h)
 	list <BOUNDING_COLLISION *> *_listBoundingCollision; // Vector of bounding areas for collision checking
 
@@ -497,10 +522,12 @@ private:
 	// ----- Private methods -----
 
 	void    initAttrib();
+	void    spatialChanged();
 
 	// ----- Friends -----
 
 	friend class IND_Entity2dManager;
+	friend class SpatialGrid;
 
     /** @endcond */
 };
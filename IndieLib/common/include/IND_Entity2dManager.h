@@ -47,6 +47,9 @@ class IND_Render;
 class CollisionParser;
 class IND_Entity2d;
 class IND_Math;
+struct UPDATE_WORKER;
+struct LAYER_CACHE;
+class SpatialGrid;
 
 // ----- Defines -----
 
@@ -75,7 +78,7 @@ public:
 
 	// ----- Init/End -----
 
-	IND_Entity2dManager(): _ok(false),_render(NULL),_math(NULL)  { }
+	IND_Entity2dManager(): _ok(false),_render(NULL),_math(NULL),_updatePass(false),_updateClock(0.0),_numUpdateThreads(1),_opaqueFirst(false)  { }
 	~IND_Entity2dManager()              {
 		end();
 	}
@@ -90,6 +93,13 @@ public:
 	bool            add(int pLayer, IND_Entity2d *pNewEntity2d);
 	bool            remove(IND_Entity2d *pEn);
 
+	void            update(float pDeltaTime);
+	void            setUpdateThreads(int pNumThreads);
+	//! Returns the number of threads used by IND_Entity2dManager::update() (1 = only the calling thread).
+	int             getUpdateThreads()      {
+		return _numUpdateThreads;
+	}
+
 	/**
 	@b Operation:
 	
@@ -101,6 +111,18 @@ public:
 		renderEntities2d(0);
 	};
 	void     renderEntities2d(int pLayer);
+	void     setOpaqueFirst(bool pOpaqueFirst);
+	//! Returns true if the opaque entities are drawn first (see IND_Entity2dManager::setOpaqueFirst()).
+	bool     isOpaqueFirst()      {
+		return _opaqueFirst;
+	}
+	int      getFillPixelsInt(int pLayer);
+	bool     setLayerCache(int pLayer, bool pCache, int pMargin);
+	bool     isLayerCache(int pLayer);
+	void     invalidateLayerCache(int pLayer);
+	bool     setSpatialIndex(int pLayer, int pCellSize);
+	int      getSpatialIndex(int pLayer);
+	int      getNumCulledInt(int pLayer);
 	void     renderCollisionAreas(unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
 	void     renderCollisionAreas(int pLayer, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
 	/**
@@ -130,6 +152,20 @@ private:
 	IND_Render *_render;
 	IND_Math *_math;
 
+	// Update pass
+	bool _updatePass;                               // update() has been called: rendering doesn't advance the animations
+	double _updateClock;                            // Animation clock advanced by update()
+	int _numUpdateThreads;
+	vector <IND_Entity2d *> _listUpdate;            // Animated entities of all the layers (rebuilt in each update)
+	vector <UPDATE_WORKER *> _listUpdateWorkers;    // Threads that help the calling thread in update()
+
+	bool _opaqueFirst;                              // Opaque entities drawn first (see setOpaqueFirst())
+	int _layerFillPixels [NUM_LAYERS];              // Pixels drawn the last time each layer was rendered
+	LAYER_CACHE *_layerCaches [NUM_LAYERS];         // Render targets of the cached layers (see setLayerCache()), or NULL
+	SpatialGrid *_layerGrids [NUM_LAYERS];          // Spatial indexes of the layers (see setSpatialIndex()), or NULL
+	int _layerCulled [NUM_LAYERS];                  // Entities discarded by the spatial index the last time each layer was rendered
+	vector <IND_Entity2d *> _listVisible;           // Entities of a layer selected by its spatial index
+
 	// ----- Containers -----
 
 	vector <IND_Entity2d *> *_listEntities2d  [NUM_LAYERS];
@@ -145,6 +181,20 @@ private:
 
 	void addToList(int pLayer, IND_Entity2d *pNewEntity2d);
 
+	void renderLayer(int pLayer, bool pUpdate);
+	void renderLayerCache(int pLayer);
+	void renderEntity(IND_Entity2d *pEn, bool pUpdate);
+	void setEntityTransform(IND_Entity2d *pEn);
+	void renderOpaqueFirst(vector <IND_Entity2d *> *pList, bool pUpdate);
+	vector <IND_Entity2d *> *selectVisible(int pLayer);
+	void updateSpatialBounds(SpatialGrid *pGrid, IND_Entity2d *pEn);
+	bool isOpaqueEntity(IND_Entity2d *pEn);
+	IND_AlphaClass getEntityAlphaClass(IND_Entity2d *pEn);
+	void updateEntity(IND_Entity2d *pEn, double pClock);
+	void updateEntities(int pFirst, int pLast, double pClock);
+	void freeUpdateThreads();
+	static int updateThread(void *pWorker);
+
 	void writeMessage();
 	void initVars();
 	void freeVars();
@@ -92,7 +92,9 @@ private:
 
 	/** @cond DOCUMENT_PRIVATEAPI */
 
-    IND_Font() {}
+    IND_Font() {
+        buildLetterLookup();
+    }
     virtual ~IND_Font() {}
     
 	// ----- Structures ------
@@ -180,6 +182,9 @@ private:
 
 	FONT _font;
 
+	// Index in the letter array of each character (-1 when the font doesn't have it)
+	int _letterLookup [256];
+
 	// ----- Private sets ------
 
 	void setLetters(LETTER *pLetters) {
@@ -205,11 +210,27 @@ private:
 		_font._type = type;
 	}
 
+	// Fills the lookup table, once the letters are loaded. A character repeated in the font keeps
+	// its first letter, as the old linear search did
+	void buildLetterLookup() {
+		for (int i = 0; i < 256; i++)
+			_letterLookup [i] = -1;
+		for (int i = 0; i < _font._numChars; i++) {
+			if (_letterLookup [_font._letters [i]._letter] < 0)
+				_letterLookup [_font._letters [i]._letter] = i;
+		}
+	}
+
 	// ----- Private gets ------
 
 	LETTER *getLetters() {
 		return _font._letters;
 	}
+	// Letter of a character, or NULL when the font doesn't have it
+	LETTER *getLetter(unsigned char pChar) {
+		int mIndex = _letterLookup [pChar];
+		return mIndex < 0 ? NULL : &_font._letters [mIndex];
+	}
     KERNING *getKernings() {
 		return _font._kernings;
 	}
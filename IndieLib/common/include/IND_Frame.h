@@ -57,8 +57,19 @@ private:
 		IND_Surface *_surface;
 		int _offsetX;
 		int _offsetY;
+		IND_Surface *_atlas;        // Atlas page where the frame is packed (when it has no surface of its own)
+		int _atlasX;                // Rectangle of the frame in the atlas page
+		int _atlasY;
+		int _atlasWidth;
+		int _atlasHeight;
+		int _trimX;                 // Transparent border trimmed at the left and top of the frame
+		int _trimY;
+		int _width;                 // Size of the frame (before trimming)
+		int _height;
 		list <BOUNDING_COLLISION *> *_listBoundingCollision;
-		structFrame() : _name(NULL), _image(NULL), _surface(NULL), _offsetX(0), _offsetY(0),_listBoundingCollision(NULL){
+		structFrame() : _name(NULL), _image(NULL), _surface(NULL), _offsetX(0), _offsetY(0),
+			_atlas(NULL), _atlasX(0), _atlasY(0), _atlasWidth(0), _atlasHeight(0), _trimX(0), _trimY(0), _width(0), _height(0),
+			_listBoundingCollision(NULL){
 			_name       = new char [MAX_TOKEN];
 			_image      = 0;
 			_surface    = 0;
@@ -95,6 +106,19 @@ private:
 	void SetOffsetY(int pOffsetY)      {
 		_frame._offsetY = pOffsetY;
 	}
+	void setAtlas(IND_Surface *pAtlas, int pX, int pY, int pWidth, int pHeight, int pTrimX, int pTrimY)  {
+		_frame._atlas = pAtlas;
+		_frame._atlasX = pX;
+		_frame._atlasY = pY;
+		_frame._atlasWidth = pWidth;
+		_frame._atlasHeight = pHeight;
+		_frame._trimX = pTrimX;
+		_frame._trimY = pTrimY;
+	}
+	void setSize(int pWidth, int pHeight)  {
+		_frame._width = pWidth;
+		_frame._height = pHeight;
+	}
 
 	// ----- Private gets ------
 
@@ -113,6 +137,19 @@ private:
 	int         GetOffsetY()  {
 		return _frame._offsetY;
 	}
+	IND_Surface *getAtlas()  {
+		return _frame._atlas;
+	}
+	int         getWidth()  {
+		if (_frame._surface) return _frame._surface->getWidth();
+		if (_frame._atlas) return _frame._width;
+		return _frame._image ? _frame._image->getWidth() : 0;
+	}
+	int         getHeight()  {
+		if (_frame._surface) return _frame._surface->getHeight();
+		if (_frame._atlas) return _frame._height;
+		return _frame._image ? _frame._image->getHeight() : 0;
+	}
 	list <BOUNDING_COLLISION *> *GetListBoundingCollision() {
 		return _frame._listBoundingCollision;
 	}
@@ -31,7 +31,14 @@
 #include "Defines.h"
 
 #include <string>
+
+#ifdef INDIERENDER_OPENGL
+#include "dependencies/glew-1.9.0/include/GL/glew.h"
+#endif
+
+#ifdef INDIERENDER_GLES_IOS
 #include <OpenGLES/ES2/gl.h>
+#endif
 
 using namespace std;
 
@@ -62,6 +69,25 @@ public:
     UniformType getType();
     int arrayLength();
     int matrixSize();
+    
+    // Typed setters. The program of the uniform has to be in use. The value is only uploaded
+    // when it is different from the last one set through the uniform.
+    void setInt(GLint value);
+    void setFloat(GLfloat value);
+    void setIntVector(const GLint* values);
+    void setFloatVector(const GLfloat* values);
+    void setMatrix(const GLfloat* values);
+    void setValue(const void* value);
+    
+private:
+    IND_GLSLShaderUniform() : _glLocation(-1), _glType(0), _cachedBytes(0) {}
+    virtual ~IND_GLSLShaderUniform() {}
+    
+    bool changed(const void* value, int bytes);
+    
+    // Last value uploaded (up to a 4x4 matrix)
+    unsigned char _cachedValue[16 * sizeof(GLfloat)];
+    int _cachedBytes;
 };
 
 #endif //__IND_GLSHADERUNIFORM_H_
@@ -68,6 +68,7 @@ class IND_3dMesh;
 class IND_Animation;
 class IND_Camera2d;
 class IND_Camera3d;
+class TextMesh;
 
 // ----- Defines -----
 
@@ -95,8 +96,20 @@ public:
 	// ----- Init/End -----
 
 	IND_Render():
-		_wrappedRenderer(NULL)
-	{}
+		_wrappedRenderer(NULL),
+		_animationClock(0.0),
+		_fixedFrameTime(0.0f),
+		_uploadBytes(0),
+		_uploadTime(0.0f),
+		_lastUploadBytes(0),
+		_lastUploadTime(0.0f),
+		_trimmedPixels(0),
+		_lastTrimmedPixels(0),
+		_fillStats(false)
+	{
+		for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+			_lastFillPixels [i] = 0;
+	}
 	~IND_Render()              {
 		end();
 	}
@@ -436,6 +449,26 @@ public:
 	float getFrameTime()      {
 		return _last;
 	}
+	//! This function sets a fixed time step, in miliseconds, used for each frame instead of the measured time.
+	/**
+	When it is greater than 0, each IND_Render::beginScene() advances the animations, and the value returned
+	by IND_Render::getFrameTime(), by exactly this time. This makes the animations deterministic (i.e. for replays or
+	tests). Default: 0 (the measured time of the frame is used).
+	*/
+	void setFixedFrameTime(float pFrameTime)      {
+		_fixedFrameTime = pFrameTime > 0.0f ? pFrameTime : 0.0f;
+	}
+	//! This function returns the fixed time step set with IND_Render::setFixedFrameTime(), or 0 if it is not used.
+	float getFixedFrameTime()      {
+		return _fixedFrameTime;
+	}
+	//! This function returns in miliseconds the animation clock: the sum of the frame times of all the frames.
+	/**
+	All the animations advance using this clock, which is taken only once per frame in IND_Render::beginScene().
+	*/
+	double getAnimationClock()      {
+		return _animationClock;
+	}
 	/**@}*/
 
 	//! This function returns the number of renderered objects in one frame
@@ -460,6 +493,41 @@ public:
 	//! Resets the counters for discarded objects
 	void resetNumDiscardedObjects();
 
+	//! This function returns the number of bytes of texture data uploaded to the graphic card during the last frame
+	//! @return The number of bytes
+	int getTextureUploadBytesInt()      {
+		return _lastUploadBytes;
+	}
+
+	//! This function returns in miliseconds the time spent uploading texture data during the last frame
+	float getTextureUploadTime()      {
+		return _lastUploadTime;
+	}
+
+	//! This function returns the number of pixels that were not drawn during the last frame because they belong to trimmed transparent borders (see IND_SurfaceManager::setTrim() and IND_AnimationManager::setAtlas())
+	//! @return The number of pixels
+	int getTrimmedPixelsInt()      {
+		return _lastTrimmedPixels;
+	}
+
+	bool setFillStats(bool pFillStats, bool pHeatmap);
+	//! This function returns true if the fill rate statistics are enabled (see IND_Render::setFillStats())
+	bool isFillStats()      {
+		return _fillStats;
+	}
+	int getFillPixelsInt();
+	int getFillPixelsInt(IND_FillBlend pBlend);
+	float getOverdraw();
+	bool blitOverdrawHeatmap();
+
+	bool setProgrammable2d(bool pProgrammable);
+	bool isProgrammable2d();
+	void setProgramBinaryCache(const char *pDirectory);
+
+	bool setDistanceField2d(bool pDistanceField);
+	void setDistanceFieldOutline2d(float pWidth, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
+	void setDistanceFieldShadow2d(float pOffsetX, float pOffsetY, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
+
 private:
     /** @cond DOCUMENT_PRIVATEAPI */
 
@@ -484,6 +552,10 @@ private:
 	float _lastTime;
 	float _last;
 
+	// Animation clock (sum of the frame times) and fixed frame time (0 = not used)
+	double _animationClock;
+	float _fixedFrameTime;
+
 
 	// Fps
 	int _fpsCounter;
@@ -491,6 +563,20 @@ private:
 	float _lastTimeFps;
 	int _lastFps;
 
+	// Texture uploads (current frame / last finished frame)
+	int _uploadBytes;
+	float _uploadTime;
+	int _lastUploadBytes;
+	float _lastUploadTime;
+
+	// Pixels saved by trimmed surfaces and frames (current frame / last finished frame)
+	int _trimmedPixels;
+	int _lastTrimmedPixels;
+
+	// Fill rate statistics (last finished frame, the current one is counted by the renderer)
+	bool _fillStats;
+	int _lastFillPixels [IND_FILL_BLEND_MODES];
+
 	// ----- Private methods -----
 
 	IND_Window* createRender(IND_WindowProperties& windowProperties);
@@ -499,14 +585,30 @@ private:
 	// ----- Private Interface (for friend classes) -----
 
 	void reCalculateFrustrumPlanes();
+	bool getVisibleArea(IND_Vector3 *pMin, IND_Vector3 *pMax);
 	void blitCollisionCircle(int pPosX, int pPosY, int pRadius, float pScale, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pWorldMatrix);
 	void blitCollisionLine(int pPosX1, int pPosY1, int pPosX2, int pPosY2,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pIndWorldMatrix);
+	void addTextureUpload(int pBytes, float pTime);
+	void addTrimmedPixels(IND_Surface *pSu);
+	void addTrimmedPixels(IND_Animation *pAn, unsigned int pSequence, unsigned int pFrame);
+	int blitAnimationFrame(IND_Animation *pAn, unsigned int pSequence, unsigned int pFrame,
+	                       int pX, int pY, int pWidth, int pHeight, bool pToggleWrap, float pUOffset, float pVOffset);
+	bool beginOpaquePass();
+	void endOpaquePass();
+	void setDepth(float pDepth);
+	void endDepthPasses();
+	int getCurrentFillPixels();
+	bool beginRenderTarget(IND_Surface *pSu, int pMargin, IND_Matrix *pCamera);
+	void endRenderTarget();
+	bool blitRenderTarget(IND_Surface *pSu, const IND_Matrix &pCamera, int pMargin);
+	void setTextMesh(TextMesh *pMesh);
 
 	// ----- Friends -----
 
 	friend class IND_Entity2dManager;
 	friend class IND_Input;
 	friend class DirectXTextureBuilder;
+	friend class OpenGLTextureBuilder;
     
     /** @endcond */
 };
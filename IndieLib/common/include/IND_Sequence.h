@@ -33,9 +33,22 @@
 #define _IND_SEQUENCE_
 
 #include <vector>
-#include "IND_Timer.h"
 #include "Defines.h"
 
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// Playback position of a sequence. Each IND_Entity2d keeps its own one, so any number of
+// entities can play the same IND_Animation, each one in a different frame.
+struct SEQUENCE_PLAYBACK {
+	SEQUENCE_PLAYBACK() : _frame(0), _elapsedTime(0.0f), _lastClock(0.0), _isActive(false) {}
+	int _frame;                             // Actual frame of the sequence
+	float _elapsedTime;                     // Time the actual frame has been displayed
+	double _lastClock;                      // Animation clock (IND_Render) when the playback was last updated
+	bool _isActive;                         // False until the first frame is drawn
+};
+
+/** @endcond */
+
 
 // --------------------------------------------------------------------------------
 //										IND_Sequence
@@ -61,18 +74,14 @@ private:
 
 	// Sequence (list of frames)
 	struct structSequence {
-		IND_Timer _timer;                   // Sequence timer
-		int i;                              // Pointer to actual frame
+		SEQUENCE_PLAYBACK _playback;        // Playback used when the animation is blitted directly with IND_Render
 		int _width;                         // With of the wider frame of the sequence
 		int _height;                        // Height of the wider frame of the sequence
 		int _numFrames;                     // Number of frames of the sequence
 		char *_name;                        // Sequence name
 		vector <FRAME_TIME *> *_listFrames; // List of frames with their times
-		bool _isActive;                     // Flage
 		structSequence() {
             _name = new char [1024];
-			i = 0;
-			_isActive = 0;
 			_width = _height = _numFrames =  0;
 			_listFrames = new vector <FRAME_TIME *>;
 		}
@@ -101,7 +110,7 @@ private:
 	// ----- Private sets ------
 
 	void                    setActualFramePos(int pPos)              {
-		_sequence.i = pPos;
+		_sequence._playback._frame = pPos;
 	}
 	void                    setHighWidth(int pWidth)            {
 		_sequence._width = pWidth;
@@ -123,16 +132,16 @@ private:
 	}
 
 	void                    setIsActive(bool pAct)             {
-		_sequence._isActive = pAct;
+		_sequence._playback._isActive = pAct;
 	}
 
 	// ----- Private gets ------
 
-	IND_Timer               *getSequenceTimer()                      {
-		return &_sequence._timer;
+	SEQUENCE_PLAYBACK       *getPlayback()                      {
+		return &_sequence._playback;
 	}
 	int                     getActualFramePos()                      {
-		return _sequence.i;
+		return _sequence._playback._frame;
 	}
 	int                     getHighWidth()                      {
 		return _sequence._width;
@@ -142,7 +151,7 @@ private:
 	}
 
 	bool                    getIsActive()                      {
-		return _sequence._isActive;
+		return _sequence._playback._isActive;
 	}
 
 	int                     getNumFrames()                      {
@@ -155,11 +164,17 @@ private:
 		return _sequence._listFrames;
 	}
 
+	int                     getFramePosInVec(int pFrame)                      {
+		return (*getListFrames()) [pFrame]->_pos;
+	}
+	int                     getFrameTime(int pFrame)                      {
+		return (*getListFrames()) [pFrame]->_time;
+	}
 	int                     getActualFramePosInVec()                      {
-		return (*getListFrames()) [getActualFramePos()]->_pos;
+		return getFramePosInVec(getActualFramePos());
 	}
 	int                     getActualFrameTime()                      {
-		return (*getListFrames()) [getActualFramePos()]->_time;
+		return getFrameTime(getActualFramePos());
 	}
 
 
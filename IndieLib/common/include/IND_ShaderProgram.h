@@ -47,14 +47,23 @@ public:
         delete this;
     }
     
+    // Cache of linked programs on disk (GL_ARB_get_program_binary), set before compile(). The binaries
+    // are kept in the directory, keyed by the sources and the driver (vendor, renderer and version)
+    void setBinaryCache(const char* directory, const char* driverId);
+    
     bool compile(const char* vertexShader, const char* fragmentShader);
     bool link();
+    bool isFromBinaryCache();
     void use();
     
+    // Handle of a uniform, resolved after link(). Keep it and use its typed setters, which skip
+    // the uploads of unchanged values, instead of looking the uniform up by name for each value
     IND_GLSLShaderUniform* getUniform(const char* uniformName);
     
+    // Looks the uniform up by name, and sets the value with the typed setter of its type
     void setSingleUniformValue(const void* value, const char* uniformName);
     int getPositionForVertexAttribute(const char* vertextAttribureName);
+    bool bindUniformBlock(const char* blockName, unsigned int bindingPoint);
     
     string errorLog();
 
@@ -31,6 +31,14 @@ extern const char* IND_Uniform_MVMatrix;
 extern const char* IND_Uniform_PMatrix;
 extern const char* IND_Uniform_RGBAColor;
 extern const char* IND_Uniform_SpriteTexture;
+extern const char* IND_Uniform_AlphaReference;
+extern const char* IND_Uniform_OutlineWidth;
+extern const char* IND_Uniform_OutlineColor;
+extern const char* IND_Uniform_ShadowOffset;
+extern const char* IND_Uniform_ShadowColor;
+
+/// Standard uniform blocks (desktop GL)
+extern const char* IND_UniformBlock_Matrices2d;
 
 /// Standard vertex attribute names used in many programs
 extern const char* IND_VertexAttribute_Position;
@@ -42,12 +50,15 @@ extern const char* IND_VertexShader_UniformRGBAColor;
 extern const char* IND_FragmentShader_Color;
 extern const char* IND_VertexShader_PerVertexRGBAColor;
 extern const char* IND_VertexShader_Simple2DTexture;
+extern const char* IND_VertexShader_Batched2DTexture;
 
 /// Sources for fragment shaders
 extern const char* IND_FragmentShader_Simple2DTexture_RGBA;
 extern const char* IND_FragmentShader_Simple2DTexture_BGRA;
 extern const char* IND_FragmentShader_2DTexture_RGBATint;
 extern const char* IND_FragmentShader_2DTexture_RGBAFade;
+extern const char* IND_FragmentShader_Batched2DTexture;
+extern const char* IND_FragmentShader_Batched2DDistanceField;
 
 /// Default engine existing shader programs. Compiled and linked, added to internal manager.
 extern const char* IND_Program_UniformRGBAColor;
@@ -55,5 +66,7 @@ extern const char* IND_Program_PerVertexRGBAColor;
 extern const char* IND_Program_Simple2DTexture;
 extern const char* IND_Program_2DTexture_RGBATint;
 extern const char* IND_Program_2DTexture_RGBAFade;
+extern const char* IND_Program_Batched2DTexture;
+extern const char* IND_Program_Batched2DDistanceField;
 
 #endif
@@ -45,6 +45,9 @@
 
 // ----- Forward declarations -----
 
+class SpriterClip;
+class SpriterPose;
+
 //! Provides the folder / file relation
 struct Fileref {
     unsigned int folderId;
@@ -104,6 +107,16 @@ public:
     void playAnimation(int animation); // TODO maybe input parameter animationname instead??
     void stopAnimation();
 
+    //! Sets the position in the screen of the origin of the entity
+    void setPosition(int x, int y) {
+        _posX = x;
+        _posY = y;
+    }
+    //! Draws a line from each bone to its parent, to see the skeleton
+    void setDrawBones(bool drawBones) {
+        _drawBones = drawBones;
+    }
+
 	// ----- Public gets ------
 
 	//! Get the ID of the entity
@@ -118,6 +131,18 @@ public:
     std::vector <Animation *>* getAnimations() {
          return _animations;
     }
+    //! Get the x position in the screen of the origin of the entity
+    int getPosX() {
+        return _posX;
+    }
+    //! Get the y position in the screen of the origin of the entity
+    int getPosY() {
+        return _posY;
+    }
+    //! Returns true if the skeleton is drawn
+    bool getDrawBones() {
+        return _drawBones;
+    }
 	
 
 private:
@@ -139,24 +164,28 @@ private:
 	const char                  *_name;                 // Entity name
     SurfaceToFileMap            *_surfaces;             // map of surfaces used in animations
     std::vector <Animation *>   *_animations;           // vector of animations
+    std::vector <SpriterClip *> *_clips;                // animations flattened for playback (same index as _animations), shared by the instances
+    SpriterPose                 *_pose;                 // last pose evaluated for this entity, with the world transforms of its bones
+    
+    int                         _posX;                  // position in the screen of the origin of the entity
+    int                         _posY;
     
     int                         _currentAnimation;      // current animation playing
-    int                         _currentKey;            // current key of animation playing
+    int                         _currentKey;            // current mainline key of animation playing (cursor in the clip)
     double                         _currentTime;           // current time of the animation
     
-    bool                        _drawBones;             // TODO: support this in a later version
+    bool                        _drawBones;             // draw a line from each bone to its parent
     bool                        _drawObjectpositions;   // TODO: support this in a later version
 
 	// ----- Private sets ------
 	
 	// ----- Private methods -----
        
-    TimelineObject* getTimelineObject(int timelineId, int keyId);
-    IND_Surface* getSurface(int folderId, int fileId);
-    
     void initAttrib();
     void addSurface(int folderId, int fileId, IND_Surface *pSurface);
     Animation* addAnimation(int id, const char* name, int length, const char* looping, int loop_to);
+    void buildClips();
+    void shareData(IND_SpriterEntity *pSource);
     
 	// ----- Friends -----
 	
@@ -51,6 +51,8 @@ class IND_SpriterEntity;
 class IND_Render;
 class IND_Surface;
 class IND_Timer;
+struct SpriterSprite;
+class SpriterPose;
 
 
 // --------------------------------------------------------------------------------
@@ -88,6 +90,7 @@ public:
 	// ----- Public methods -----
     
 	bool addSpriterFile(const char *pSCMLFileName);
+	IND_SpriterEntity* addSpriterInstance(IND_SpriterEntity *pSource);
 	bool remove(IND_SpriterEntity *pSen);
 
     //! Get the list of managed entities
@@ -106,6 +109,7 @@ private:
     bool _ok;
     double _deltaTime;
     double _lastTime;
+    unsigned int _frame;                    // Counts the calls to renderEntities(), to share the poses evaluated in a frame
 
 	// ----- Enums -----
 
@@ -129,20 +133,17 @@ private:
     // ----- Render methods -----
 
     void        draw(IND_SpriterEntity *ent);
-    void        drawTransientObject(IND_SpriterEntity *ent, MainlineObjectref *mObjectref);
-    void        drawPersistentObject(IND_SpriterEntity *ent, MainlineObjectref *mObjectref);
-    void        drawBone(IND_SpriterEntity *ent, MainlineObjectref *mObjectref);
+    void        drawSprite(IND_SpriterEntity *ent, const SpriterSprite &sprite);
+    void        drawBone(IND_SpriterEntity *ent, const SpriterPose &pose, unsigned int boneIndex);
     
-    void        updateCurrentTime(IND_SpriterEntity *ent, double deltaTime);
+    bool        updateCurrentTime(IND_SpriterEntity *ent, double deltaTime);
     void        updateCurrentKey(IND_SpriterEntity *ent);
-    TimelineObject* getTimelineObject(IND_SpriterEntity *ent,int timelineId, int keyId);
-    IND_Surface*    getSurface(IND_SpriterEntity *ent, int folderId, int fileId);
        
     // ----- Parser methods -----
 
 	bool        parseSpriterData(const char *pSCMLFileName);
-    int         toInt(const char* input);
-    float       toFloat(const char* input);
+    int         toInt(const char* input, int defaultValue = 0);
+    float       toFloat(const char* input, float defaultValue = 0.f);
 	
     void        writeMessage();
 	void        initVars();
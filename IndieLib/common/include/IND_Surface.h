@@ -106,6 +106,20 @@ public:
 	int         getSpareX();
 	int         getSpareY();
 
+	//! This function returns true if the transparent borders of the surface were trimmed when it was created (see IND_SurfaceManager::setTrim()).
+	bool        isTrimmed();
+	//! This function returns the horizontal position of the part of the surface kept in textures (0 if it is not trimmed).
+	int         getTrimX();
+	//! This function returns the vertical position of the part of the surface kept in textures (0 if it is not trimmed).
+	int         getTrimY();
+	//! This function returns the width of the part of the surface kept in textures (the width of the surface if it is not trimmed).
+	int         getTrimWidth();
+	//! This function returns the height of the part of the surface kept in textures (the height of the surface if it is not trimmed).
+	int         getTrimHeight();
+
+	//! This function returns the alpha class of the surface, checked when it was created. See ::IND_AlphaClass.
+	IND_AlphaClass getAlphaClass();
+
 private:
 
 	/** @cond DOCUMENT_PRIVATEAPI */
@@ -139,6 +153,8 @@ private:
     void init();
     void release();
 
+	bool                    clipRegion(int *pX, int *pY, int *pWidth, int *pHeight, int *pDrawX, int *pDrawY);
+
     void freeTextureData();    //Used to free any render-specific data
 
 	string                  TypeToString(IND_Type pType);
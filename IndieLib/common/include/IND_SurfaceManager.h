@@ -93,7 +93,7 @@ public:
 
 	// ----- Init/End -----
 
-	IND_SurfaceManager(): _ok(false)  { }
+	IND_SurfaceManager(): _ok(false), _trim(false)  { }
 	~IND_SurfaceManager()              {
 		end();
 	}
@@ -151,6 +151,22 @@ public:
 
 	bool remove(IND_Surface *pSu);
 
+	//! This function returns the bytes of texture memory allocated by all the surfaces of the manager (including spare areas)
+	size_t getTextureMemoryInt()      {
+		return _textureMemory;
+	}
+
+	//! This function returns the bytes of texture memory wasted in spare areas by all the surfaces of the manager
+	size_t getTextureMemoryWastedInt()      {
+		return _textureMemoryWasted;
+	}
+
+	void setTrim(bool pTrim);
+	//! This function returns true if the transparent borders of the IND_ALPHA surfaces are trimmed when they are created (see setTrim()).
+	bool isTrim()      {
+		return _trim;
+	}
+
 private:
 
 	/** @cond DOCUMENT_PRIVATEAPI */
@@ -158,6 +174,7 @@ private:
 	// ----- Private -----
 
 	bool _ok;
+	bool _trim;
 
 	// ----- Objects -----
 
@@ -165,6 +182,11 @@ private:
 	IND_Render *_render;
     TextureBuilder *_textureBuilder;
 
+	// ----- Texture memory counters -----
+
+	size_t _textureMemory;
+	size_t _textureMemoryWasted;
+
 	// ----- Containers -----
 
     std::list <IND_Surface *> *_listSurfaces;
@@ -178,6 +200,15 @@ private:
 	                IND_Type        pType,
 	                IND_Quality     pQuality);
 
+	IND_Image *trimImage(IND_Image *pImage, int *pTrimX, int *pTrimY);
+	IND_AlphaClass classifyImage(IND_Image *pImage, IND_Type pType);
+	void    setTrimmed(IND_Surface *pSu, int pWidth, int pHeight, int pTrimX, int pTrimY);
+
+	bool    addCompressed(IND_Surface    *pNewSurface,
+	                      const char    *pName,
+	                      IND_Type        pType,
+	                      IND_Quality     pQuality);
+
 	bool    calculateAxis(IND_Surface *pSu,
 	                    float pAxisX,
 	                    float pAxisY,
@@ -186,6 +217,8 @@ private:
 
 	void                addToList(IND_Surface *pNewImage);
 	void                delFromlist(IND_Surface *pSu);
+	void                addTextureMemory(IND_Surface *pSu, int pSign);
+	int                 getWastedTextureMemory(IND_Surface *pSu);
 	void                writeMessage();
 	void				convertImage(IND_Image* pImage ,IND_Type pType, IND_Quality pQuality);
 	void                initVars();
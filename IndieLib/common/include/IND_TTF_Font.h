@@ -39,6 +39,7 @@
 #include "IND_Surface.h"
 
 #include <map>
+#include <vector>
 
 
 // NOTE: This class uses STL, the perfermance will be a lot better in Release version.
@@ -60,6 +61,8 @@
 
 class free_type_impl;               // forward-declare private "implementation" class.
 class free_type_ptr_wrapped_impl;   // forward-declare the freetype wrapped pointer delivered by the manger in the init method
+class GlyphRasterizer;              // forward-declare the worker thread for async caching
+struct RasterizedGlyph;
 
 // --------------------------------------------------------------------------------
 //									 IND_TTF_Font
@@ -85,6 +88,48 @@ public:
     //! Typedef uint32_t - TODO : should be moved to the defines setup
     typedef unsigned int uint32_t;
 
+	// ----- Structures ------
+
+	//! Glyph runs laid out by drawTextEx, kept between frames while the text, rectangle, format and font stay the same
+	struct TextLayout
+	{
+		TextLayout() : pFont(NULL), generation(0), fLeft(0), fTop(0), fRight(0), fBottom(0),
+						nFormat(0), bKerning(false), bUnderl(false), result(0) {}
+
+		// A glyph placed at its final top left corner
+		struct GlyphRun
+		{
+			IND_Surface		*pSurface;				// glyph texture
+			float			x;						// x pos
+			float			y;						// y pos
+		};
+
+		// An underline segment
+		struct UnderlineRun
+		{
+			float			xStart;					// x start
+			float			xEnd;					// x end
+			float			y;						// y pos
+		};
+
+		// Key
+		const IND_TTF_Font	*pFont;					// font the layout was built with
+		uint32_t			generation;				// char cache generation of that font
+		std::wstring		sText;					// text
+		float				fLeft;					// left
+		float				fTop;					// top
+		float				fRight;					// right
+		float				fBottom;				// bottom
+		uint32_t			nFormat;				// ex format
+		bool				bKerning;				// kerning actually applied
+		bool				bUnderl;				// underline
+
+		// Result
+		int							result;			// drawTextEx return value
+		std::vector<GlyphRun>		glyphs;			// glyphs inside the rectangle
+		std::vector<UnderlineRun>	underlines;		// underline segments
+	};
+
 	// ----- Init/End -----
     
 	IND_TTF_Font(	free_type_ptr_wrapped_impl *freetype_wrapped, IND_Render *pIndieRender, IND_ImageManager *pIndieImageManager,
@@ -109,15 +154,42 @@ public:
 	//! Clear all the cache entries
 	void clearAllCache();
 
+	//! Rasterize the chars that auto cache finds missing in a worker thread, they are skipped until uploaded
+	bool setAsyncCache(bool basync);
+
+	//! Is async cache enabled
+	bool isAsyncCache() {return _bAsyncCache;}
+
+	//! Cache chars ahead of time, in the worker thread with async cache
+	void prewarm(const std::wstring& str);
+
+	//! Cache the chars of an UTF-8 text file (i.e. a locale file) ahead of time
+	bool prewarmFromFile(const std::string& strpath);
+
+	//! Build the surfaces of up to iMaxGlyphs glyphs finished by the worker thread, returns how many were built
+	int uploadRasterizedGlyphs(int iMaxGlyphs);
+
+	//! Cache signed distance fields with iSpread pixels of margin instead of coverage, so the glyphs stay sharp at any scale
+	void setDistanceField(bool bsdf, int iSpread = 4);
+
+	//! Are the glyphs distance fields
+	bool isDistanceField() {return _bDistanceField;}
+
+	//! Set the outline of the distance field glyphs, fWidth in units of the field (0 to 0.5)
+	void setDistanceFieldOutline(float fWidth, uint32_t clrOutline, byte btTrans);
+
+	//! Set the shadow of the distance field glyphs, offset in pixels of the glyph (up to the spread)
+	void setDistanceFieldShadow(float fOffsetX, float fOffsetY, uint32_t clrShadow, byte btTrans);
+
 	//! Draw a tring
 	bool drawText(	const std::wstring& s, float x, float y, uint32_t clrFont,bool bFlipX, bool bFlipY,
 					float fZRotate, byte btTrans, bool bKerning, bool bUnderl);
 
-	//! Advanced draw text function
+	//! Advanced draw text function. The layout is rebuilt only when pLayout does not match the call
 	int drawTextEx(	const std::wstring& sText, float fLeft, float fTop, float fRight, float fBottom,
 					uint32_t nFormat, uint32_t clrFont, uint32_t clrBorder, uint32_t clrBack,byte btBorderTrans, 
 					byte btBackTrans,bool bFlipX, bool bFlipY, float fZRotate, byte btTrans, 
-					bool bKerning, bool bUnderl);
+					bool bKerning, bool bUnderl, TextLayout *pLayout = NULL);
 
 	//! Get the font name 
 	const std::string getFontName(){return _strName;}
@@ -191,6 +263,18 @@ private:
 	int						_CharHeight;            // current font height
 
 	bool					_bAutoCache;            // auto cache
+	bool					_bAsyncCache;           // auto cache in the worker thread
+	GlyphRasterizer			*_rasterizer;           // worker thread, while async cache is on and a face is loaded
+
+	bool					_bDistanceField;        // glyphs are signed distance fields
+	int						_iSpread;               // margin of the distance fields
+	float					_fOutlineWidth;         // outline of the distance fields
+	uint32_t				_clrOutline;
+	byte					_btOutlineTrans;
+	float					_fShadowX;              // shadow of the distance fields
+	float					_fShadowY;
+	uint32_t				_clrShadow;
+	byte					_btShadowTrans;
 	bool					_bHasKerning;           // font face has kerning
 	
 	bool					_bBold;                 // bold
@@ -203,21 +287,38 @@ private:
 	float					_fYHotSpot;             // y hotspot for bliting
 
 	CharCacheMap			_FontCharCache;         // character cache map
+	uint32_t				_cacheGeneration;       // bumped whenever the character cache changes
+
+	TextLayout				_scratchLayout;         // layout for drawTextEx calls without their own
     
     // ----- Private methods -----
     
 	// cache a single char
 	bool buildCharCache(wchar_t charCode);
 
+	// cache a single char, asynchronously if the worker thread is running
+	bool requestCharCache(wchar_t charCode);
+
+	// build the surface of a rasterized glyph and add it to the cache
+	bool addGlyphToCache(const RasterizedGlyph& glyph);
+
 	// render a single char
 	bool renderChar(	wchar_t charCode, float x, float y ,uint32_t clrFont, bool bFlipX, bool bFlipY, float fZRotate,
 						byte btTrans, bool bKerning, bool bUnderl);
 
+	// set the distance field state of the renderer before bliting glyphs, and reset it after
+	void beginGlyphs();
+	void endGlyphs();
+
+	// blit a glyph surface with its top left corner at (x, y)
+	void blitGlyph(	IND_Surface *pSurface, float x, float y, uint32_t clrFont, bool bFlipX, bool bFlipY,
+					float fZRotate, byte btTrans);
+
 	// get char cache entry
 	CharCacheNode* getCharCacheNode(wchar_t charCode);
 
 	// render glyph to image
-	bool renderGlyph(free_type_impl* impl, IND_Image *pImage);
+	bool renderGlyph(const RasterizedGlyph& glyph, IND_Image *pImage);
 
 	// advance with space 
 	uint32_t getSpaceAdvance();
@@ -230,10 +331,18 @@ private:
 	// get single line width
 	uint32_t getLineWidth( const std::wstring& sText, bool bFlipX, bool bFlipY, float fZRotate, bool bKerning);
 
-	// draw a single text line
-	void drawTextLineEx(	const std::wstring& sText, float penX, float penY, float fL, float fT,
-							float fR, float fB, uint32_t clrFont, bool bVertical, bool bR2L,bool bFlipX, 
-							bool bFlipY, float fZRotate, byte btTrans, bool bKerning, bool bUnderl);
+	// lay out a drawTextEx call
+	void buildTextLayout(	TextLayout &layout, const std::wstring& sText, float fLeft, float fTop, float fRight,
+							float fBottom, uint32_t nFormat, bool bFlipX, bool bFlipY, float fZRotate, bool bKerning,
+							bool bUnderl);
+
+	// lay out a single text line
+	void layoutTextLineEx(	TextLayout &layout, const std::wstring& sText, float penX, float penY, float fL, float fT,
+							float fR, float fB, bool bVertical, bool bR2L,bool bFlipX, 
+							bool bFlipY, float fZRotate, bool bKerning, bool bUnderl);
+
+	// add a glyph to a layout, pen at (x, y)
+	void addGlyphRun(TextLayout &layout, CharCacheNode *pNode, float x, float y);
 
 	void doDrawBorder(float fX_s, float fX_e, float fY, uint32_t clr, byte btTrans);
 
@@ -241,4 +350,4 @@ private:
 };
 /**@}*/
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
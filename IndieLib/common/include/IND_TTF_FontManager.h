@@ -105,6 +105,15 @@ public:
 	void setFontHotSpot(const std::string& strFontName, float hsx, float hsy);
 	void setFontScale(const std::string& strFontName, float sx, float sy);
 
+	bool setFontAsyncCache(const std::string& strFontName, bool ba);
+	void prewarmFont(const std::string& strFontName, const std::wstring& s);
+	bool prewarmFontFromFile(const std::string& strFontName, const std::string& strPath);
+	void setGlyphUploadBudget(int iMaxGlyphs) {_glyphUploadBudget = iMaxGlyphs;}
+	void setFontDistanceField(const std::string& strFontName, bool bsdf, int iSpread = 4);
+	void setFontOutline(const std::string& strFontName, float fWidth, uint32_t clrOutline, byte btTrans = 255);
+	void setFontShadow(const std::string& strFontName, float fOffsetX, float fOffsetY, uint32_t clrShadow, byte btTrans = 255);
+	int getGlyphUploadBudget() {return _glyphUploadBudget;}
+
 private:
 	
     /** @cond DOCUMENT_PRIVATEAPI */
@@ -123,6 +132,7 @@ private:
 	IND_Render                  *_pIndieRender;
 	IND_ImageManager            *_pIndieImageManager;
 	IND_SurfaceManager          *_pIndieSurfaceManager;
+	int                         _glyphUploadBudget;     // glyph surfaces built per frame from the worker threads
 
     // ----- Structures ------
     
@@ -150,6 +160,8 @@ private:
 		uint32_t			clrBak;				// background color
 		byte				btBdrTrans;			// border trans
 		byte				btBakTrans;			// back trans
+		// Layout EX
+		IND_TTF_Font::TextLayout	layout;		// glyph runs kept between frames
 	};
 	typedef std::map<const uint32_t, DrawTextRequestNode*> DTRList;
 	typedef DTRList::iterator DTRListIterator;
@@ -167,7 +179,7 @@ private:
 					uint32_t clrFont = 0xFFFFFF, uint32_t clrBorder = 0, uint32_t clrBack = 0,
 					byte btBorderTrans = 255, byte btBackTrans = 255, bool bFlipX = false, 
 					bool bFlipY = false, float fZRotate = 0, byte btTrans = 255, bool bKerning = false, 
-					bool bUnderl = false);
+					bool bUnderl = false, IND_TTF_Font::TextLayout *pLayout = NULL);
 
 	/** @endcond */
 
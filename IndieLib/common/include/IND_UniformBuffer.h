@@ -0,0 +1,74 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef __IND_UNIFORMBUFFER_H_
+#define __IND_UNIFORMBUFFER_H_
+
+#include "IND_Object.h"
+#include "Defines.h"
+#include "IND_GLShaderUniform.h"
+
+#include <vector>
+
+using namespace std;
+
+// Uniform buffer object, with per-frame data (cameras, lights, time...) shared by all the programs
+// that declare the same uniform block (see IND_ShaderProgram::bindUniformBlock()). Only available
+// with desktop OpenGL 3.1 or newer.
+class LIB_EXP IND_UniformBuffer : public IND_Object{
+public:
+    static IND_UniformBuffer* newUniformBuffer() {
+        return new IND_UniformBuffer();
+    }
+    
+    virtual void destroy() {
+        delete this;
+    }
+    
+    bool create(int size, unsigned int bindingPoint);
+    
+    // Only the bytes that changed since the last call are uploaded
+    void setData(const void* data, int offset, int size);
+    
+    int getSize() {
+        return static_cast<int>(_data.size());
+    }
+    unsigned int getBindingPoint() {
+        return _bindingPoint;
+    }
+    
+private:
+    IND_UniformBuffer() : _buffer(0), _bindingPoint(0) {}
+    virtual ~IND_UniformBuffer() { end(); }
+    
+    void end();
+    
+    GLuint _buffer;
+    unsigned int _bindingPoint;
+    vector<unsigned char> _data;    // Copy of the contents of the buffer
+};
+
+#endif //__IND_UNIFORMBUFFER_H_
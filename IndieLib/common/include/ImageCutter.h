@@ -99,6 +99,24 @@ public:
 	              int pBpp,
 	              unsigned char **pNewBlock);
 
+	void cutBlockTo(unsigned char *pPtrBlock,
+	                int pWidthImage,
+	                int pWidthBlock,
+	                int pHeightBlock,
+	                int pSpareX,
+	                int pSpareY,
+	                int pBpp,
+	                unsigned char *pDestBlock);
+
+	unsigned char *getScratchBuffer(int pSize);
+
+	// ----- Public sets -----
+
+	//! Use exactly sized blocks instead of power of two blocks (the renderer must support it)
+	void setNonPowerOfTwo(bool pNonPowerOfTwo) {
+		_nonPowerOfTwo = pNonPowerOfTwo;
+	}
+
 
 private:
 
@@ -106,6 +124,11 @@ private:
 
 	bool _ok;
 	int _maxTextureSize;
+	bool _nonPowerOfTwo;
+
+	// Scratch buffer reused by all the cuts that need a copy
+	unsigned char *_scratch;
+	int _scratchSize;
 
 	// ----- Objects -----
 
@@ -0,0 +1,141 @@
+/*****************************************************************************************
+ * File: AnimationBundle.cpp
+ * Desc: Layout of the binary animation bundles (.anb) loaded by IND_AnimationManager
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "AnimationBundle.h"
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// Checks that a table of the bundle is inside the data
+static bool isInside(int pOffset, int pCount, int pElementSize, int pSize) {
+	return (pOffset >= 0 && pCount >= 0 && pOffset <= pSize && pCount <= (pSize - pOffset) / pElementSize);
+}
+
+/**
+ * Returns the header of a bundle, or NULL if the data is not a valid bundle for this library
+ * (the tables are checked to be inside the data, but not their contents).
+ * @param pData			the data of the bundle
+ * @param pSize			the size of the data in bytes
+ */
+const BUNDLE_HEADER *AnimationBundle::getHeader(const unsigned char *pData, int pSize) {
+	if (!pData || pSize < (int) sizeof(BUNDLE_HEADER))
+		return NULL;
+
+	const BUNDLE_HEADER *mHeader = reinterpret_cast<const BUNDLE_HEADER *>(pData);
+	if (ANIMATION_BUNDLE_MAGIC != mHeader->_magic || ANIMATION_BUNDLE_VERSION != mHeader->_version)
+		return NULL;
+
+	if (mHeader->_atlasWidth < 0 || mHeader->_atlasHeight < 0 ||
+	    (mHeader->_atlasHeight && mHeader->_atlasWidth > (pSize / 4) / mHeader->_atlasHeight))
+		return NULL;
+
+	if (!isInside(mHeader->_framesOffset, mHeader->_numFrames, sizeof(BUNDLE_FRAME), pSize) ||
+	    !isInside(mHeader->_collisionsOffset, mHeader->_numCollisions, sizeof(BUNDLE_COLLISION), pSize) ||
+	    !isInside(mHeader->_sequencesOffset, mHeader->_numSequences, sizeof(BUNDLE_SEQUENCE), pSize) ||
+	    !isInside(mHeader->_frameTimesOffset, mHeader->_numFrameTimes, sizeof(BUNDLE_FRAME_TIME), pSize) ||
+	    !isInside(mHeader->_namesOffset, 0, 1, pSize) ||
+	    !isInside(mHeader->_atlasOffset, mHeader->_atlasWidth * mHeader->_atlasHeight, 4, pSize))
+		return NULL;
+
+	return mHeader;
+}
+
+// Frames sorted by height, then by width (the highest first)
+struct FrameOrder {
+	const int *_widths;
+	const int *_heights;
+	bool operator()(int pA, int pB) const {
+		if (_heights[pA] != _heights[pB])
+			return _heights[pA] > _heights[pB];
+		return _widths[pA] > _widths[pB];
+	}
+};
+
+/**
+ * Places the frames into one atlas, in rows (shelves) of frames of similar height.
+ * @param pNumFrames		number of frames
+ * @param pWidths			widths of the frames
+ * @param pHeights			heights of the frames
+ * @param pX, pY			returns the position of each frame in the atlas
+ * @param pAtlasWidth		returns the width of the atlas
+ * @param pAtlasHeight		returns the height of the atlas
+ */
+void AnimationBundle::packFrames(int pNumFrames, const int *pWidths, const int *pHeights, int *pX, int *pY, int *pAtlasWidth, int *pAtlasHeight) {
+	// The atlas width is chosen so the atlas is close to a square
+	int mMaxWidth = 0;
+	double mArea = 0;
+	std::vector<int> mOrder (pNumFrames);
+	for (int i = 0; i < pNumFrames; i++) {
+		mOrder[i] = i;
+		mArea += (double) pWidths[i] * pHeights[i];
+		if (pWidths[i] > mMaxWidth)
+			mMaxWidth = pWidths[i];
+	}
+
+	int mWidth = (int) ceil(sqrt(mArea));
+	if (mWidth < mMaxWidth)
+		mWidth = mMaxWidth;
+
+	FrameOrder mFrameOrder;
+	mFrameOrder._widths = pWidths;
+	mFrameOrder._heights = pHeights;
+	std::sort(mOrder.begin(), mOrder.end(), mFrameOrder);
+
+	// Shelves
+	int mShelfX = 0;
+	int mShelfY = 0;
+	int mShelfHeight = 0;
+	int mUsedWidth = 0;
+	for (int i = 0; i < pNumFrames; i++) {
+		int mFrame = mOrder[i];
+		if (mShelfX + pWidths[mFrame] > mWidth) {
+			mShelfY += mShelfHeight;
+			mShelfX = 0;
+			mShelfHeight = 0;
+		}
+
+		pX[mFrame] = mShelfX;
+		pY[mFrame] = mShelfY;
+
+		mShelfX += pWidths[mFrame];
+		if (mShelfX > mUsedWidth)
+			mUsedWidth = mShelfX;
+		if (pHeights[mFrame] > mShelfHeight)
+			mShelfHeight = pHeights[mFrame];
+	}
+
+	*pAtlasWidth = mUsedWidth;
+	*pAtlasHeight = mShelfY + mShelfHeight;
+}
+
+/** @endcond */
@@ -0,0 +1,122 @@
+/*****************************************************************************************
+ * File: AnimationBundle.h
+ * Desc: Layout of the binary animation bundles (.anb) loaded by IND_AnimationManager
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _ANIMATIONBUNDLE
+#define _ANIMATIONBUNDLE
+
+// ----- Includes -----
+
+#include "Defines.h"
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// ----- Defines -----
+
+#define ANIMATION_BUNDLE_MAGIC      0x41444E49      // "INDA"
+#define ANIMATION_BUNDLE_VERSION    2
+#define ANIMATION_BUNDLE_EXTENSION  ".anb"
+
+// A bundle is a single file with all the data of an animation script: the header, followed by
+// the tables of frames, collisions, sequences and frame times, the names (null terminated
+// strings) and the pixels of all the frames packed into one atlas. All the fields are 32 bit
+// integers in the byte order of the machine that made the bundle, and the tables are referenced
+// by their offset from the start of the file, so the bundle is used straight from a memory mapping.
+//
+// The atlas is 32 bpp, with the layout of FreeImage bitmaps (FI_RGBA_* channel order, rows from
+// the lower one). The rectangle of each frame is given in that layout.
+
+struct BUNDLE_HEADER {
+	int _magic;
+	int _version;
+	unsigned int _scriptTime;   // Modification time of the script when the bundle was made (see MappedFile::getModificationTime())
+	int _numFrames;
+	int _numCollisions;
+	int _numSequences;
+	int _numFrameTimes;
+	int _atlasWidth;
+	int _atlasHeight;
+	int _framesOffset;          // BUNDLE_FRAME [_numFrames]
+	int _collisionsOffset;      // BUNDLE_COLLISION [_numCollisions]
+	int _sequencesOffset;       // BUNDLE_SEQUENCE [_numSequences]
+	int _frameTimesOffset;      // BUNDLE_FRAME_TIME [_numFrameTimes]
+	int _namesOffset;           // Names, referenced by their offset from here
+	int _atlasOffset;           // _atlasWidth * _atlasHeight * 4 bytes
+};
+
+struct BUNDLE_FRAME {
+	int _name;
+	int _x;                     // Rectangle of the frame in the atlas
+	int _y;
+	int _width;
+	int _height;
+	int _offsetX;
+	int _offsetY;
+	int _firstCollision;        // Bounding collisions of the frame
+	int _numCollisions;
+};
+
+struct BUNDLE_COLLISION {
+	int _type;
+	int _id;                    // Name of the group of the collision
+	int _posX;
+	int _posY;
+	int _radius;
+	int _ax;
+	int _ay;
+	int _bx;
+	int _by;
+	int _cx;
+	int _cy;
+};
+
+struct BUNDLE_SEQUENCE {
+	int _name;
+	int _firstFrameTime;        // Frames of the sequence
+	int _numFrameTimes;
+};
+
+struct BUNDLE_FRAME_TIME {
+	int _frame;                 // Position in the frames table
+	int _time;                  // Milliseconds
+};
+
+class AnimationBundle {
+public:
+
+	//----- OTHER FUNCTIONS -----
+
+	static const BUNDLE_HEADER *getHeader(const unsigned char *pData, int pSize);
+	static void packFrames(int pNumFrames, const int *pWidths, const int *pHeights, int *pX, int *pY, int *pAtlasWidth, int *pAtlasHeight);
+};
+
+/** @endcond */
+
+#endif
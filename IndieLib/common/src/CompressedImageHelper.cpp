@@ -0,0 +1,689 @@
+/*****************************************************************************************
+ * File: CompressedImageHelper.cpp
+ * Desc: Helper class to load, save, encode and decode block compressed images
+ *       (DXT1, DXT5 and BC7) stored in .dds files
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "CompressedImageHelper.h"
+#include "dependencies/FreeImage/Dist/FreeImage.h"
+#include <stdio.h>
+#include <string.h>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// ----- DDS file layout -----
+
+#define DDS_MAGIC               0x20534444      // "DDS "
+#define DDS_HEADER_SIZE         124
+#define DDS_PIXELFORMAT_SIZE    32
+#define DDS_DX10_HEADER_SIZE    20
+#define DDSD_FLAGS              0x00081007      // Caps | Height | Width | PixelFormat | LinearSize
+#define DDSD_MIPMAPCOUNT        0x00020000
+#define DDS_MAX_SIZE            16384           // Largest width or height accepted when loading
+#define DDS_MAX_LEVELS          15              // Mipmap levels of a DDS_MAX_SIZE image
+#define DDPF_FOURCC             0x00000004
+#define DDSCAPS_TEXTURE         0x00001000
+
+#define DDS_FOURCC(a, b, c, d)  ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+#define DXGI_FORMAT_BC1_UNORM       71
+#define DXGI_FORMAT_BC1_UNORM_SRGB  72
+#define DXGI_FORMAT_BC3_UNORM       77
+#define DXGI_FORMAT_BC3_UNORM_SRGB  78
+#define DXGI_FORMAT_BC7_UNORM       98
+#define DXGI_FORMAT_BC7_UNORM_SRGB  99
+
+// DDS fields are little endian whatever the platform is
+static unsigned int readUInt(const unsigned char *pPtr) {
+	return (unsigned int)pPtr[0] | ((unsigned int)pPtr[1] << 8) | ((unsigned int)pPtr[2] << 16) | ((unsigned int)pPtr[3] << 24);
+}
+
+static void writeUInt(unsigned char *pPtr, unsigned int pValue) {
+	pPtr[0] = (unsigned char)(pValue & 0xFF);
+	pPtr[1] = (unsigned char)((pValue >> 8) & 0xFF);
+	pPtr[2] = (unsigned char)((pValue >> 16) & 0xFF);
+	pPtr[3] = (unsigned char)((pValue >> 24) & 0xFF);
+}
+
+// 5:6:5 color to 8 bits per channel
+static void unpack565(unsigned int pColor, unsigned char *pRGB) {
+	int mR = (pColor >> 11) & 0x1F;
+	int mG = (pColor >> 5) & 0x3F;
+	int mB = pColor & 0x1F;
+	pRGB[0] = (unsigned char)((mR << 3) | (mR >> 2));
+	pRGB[1] = (unsigned char)((mG << 2) | (mG >> 4));
+	pRGB[2] = (unsigned char)((mB << 3) | (mB >> 2));
+}
+
+static unsigned int pack565(const unsigned char *pRGB) {
+	return ((pRGB[0] >> 3) << 11) | ((pRGB[1] >> 2) << 5) | (pRGB[2] >> 3);
+}
+
+/**
+ * Name of the compressed variant of an image file (same name, .dds extension).
+ * @param pName				the name of the image file
+ * @param pCompressedName	buffer of at least MAX_TOKEN chars where the name is written
+ */
+void CompressedImageHelper::getCompressedName(const char *pName, char *pCompressedName) {
+	strncpy(pCompressedName, pName, MAX_TOKEN - 5);
+	pCompressedName[MAX_TOKEN - 5] = '\0';
+
+	// Extension starts at the last dot after the last path separator
+	char *mDot = strrchr(pCompressedName, '.');
+	char *mSlash = strrchr(pCompressedName, '/');
+	char *mBackSlash = strrchr(pCompressedName, '\\');
+	if (mDot && mDot > mSlash && mDot > mBackSlash)
+		*mDot = '\0';
+
+	strcat(pCompressedName, COMPRESSED_EXTENSION);
+}
+
+/**
+ * Bytes of each 4x4 block of a compressed format.
+ * @param pFormat		the compressed format
+ */
+int CompressedImageHelper::getBlockBytes(int pFormat) {
+	switch (pFormat) {
+		case COMPRESSED_DXT1: return 8;
+		case COMPRESSED_DXT5: return 16;
+		case COMPRESSED_BC7: return 16;
+		default: return 0;
+	}
+}
+
+/**
+ * Bytes of the compressed data of an image.
+ * @param pFormat		the compressed format
+ * @param pWidth		the width of the image in pixels
+ * @param pHeight		the height of the image in pixels
+ */
+int CompressedImageHelper::getDataSize(int pFormat, int pWidth, int pHeight) {
+	int mBlocksX = (pWidth + 3) / 4;
+	int mBlocksY = (pHeight + 3) / 4;
+	return (mBlocksX ? mBlocksX : 1) * (mBlocksY ? mBlocksY : 1) * getBlockBytes(pFormat);
+}
+
+/**
+ * True if the compressed format stores an alpha channel.
+ * @param pFormat		the compressed format
+ */
+bool CompressedImageHelper::hasAlpha(int pFormat) {
+	return (COMPRESSED_DXT5 == pFormat || COMPRESSED_BC7 == pFormat);
+}
+
+/**
+ * Name of a compressed format, for logging.
+ * @param pFormat		the compressed format
+ */
+const char *CompressedImageHelper::getFormatName(int pFormat) {
+	switch (pFormat) {
+		case COMPRESSED_DXT1: return "DXT1";
+		case COMPRESSED_DXT5: return "DXT5";
+		case COMPRESSED_BC7: return "BC7";
+		default: return "UNKNOWN";
+	}
+}
+
+/**
+ * Loads the first mipmap level of a .dds file. Returns false if the file doesn't exist,
+ * it is not in one of the supported compressed formats, or its header doesn't match
+ * the data stored in the file (sizes bigger than DDS_MAX_SIZE or levels missing).
+ * @param pName			the name of the file
+ * @param pImage		the image where the data is loaded (free it with freeImage())
+ */
+bool CompressedImageHelper::loadDDS(const char *pName, COMPRESSED_IMAGE *pImage) {
+	FILE *mFile = fopen(pName, "rb");
+	if (!mFile)
+		return false;
+
+	unsigned char mHeader [4 + DDS_HEADER_SIZE];
+	if (fread(mHeader, 1, sizeof(mHeader), mFile) != sizeof(mHeader) ||
+	    readUInt(mHeader) != DDS_MAGIC ||
+	    readUInt(mHeader + 4) != DDS_HEADER_SIZE) {
+		fclose(mFile);
+		return false;
+	}
+
+	// Header fields (offsets from the start of the file)
+	unsigned int mFlags = readUInt(mHeader + 8);
+	unsigned int mHeight = readUInt(mHeader + 12);
+	unsigned int mWidth = readUInt(mHeader + 16);
+	unsigned int mLevels = (mFlags & DDSD_MIPMAPCOUNT) ? readUInt(mHeader + 28) : 1;
+	unsigned int mPixelFlags = readUInt(mHeader + 80);
+	unsigned int mFourCC = readUInt(mHeader + 84);
+
+	int mFormat = COMPRESSED_UNKNOWN;
+	if (mPixelFlags & DDPF_FOURCC) {
+		if (DDS_FOURCC('D', 'X', 'T', '1') == mFourCC) {
+			mFormat = COMPRESSED_DXT1;
+		} else if (DDS_FOURCC('D', 'X', 'T', '5') == mFourCC) {
+			mFormat = COMPRESSED_DXT5;
+		} else if (DDS_FOURCC('D', 'X', '1', '0') == mFourCC) {
+			unsigned char mDX10 [DDS_DX10_HEADER_SIZE];
+			if (fread(mDX10, 1, DDS_DX10_HEADER_SIZE, mFile) == DDS_DX10_HEADER_SIZE) {
+				switch (readUInt(mDX10)) {
+					case DXGI_FORMAT_BC1_UNORM:
+					case DXGI_FORMAT_BC1_UNORM_SRGB:
+						mFormat = COMPRESSED_DXT1;
+						break;
+					case DXGI_FORMAT_BC3_UNORM:
+					case DXGI_FORMAT_BC3_UNORM_SRGB:
+						mFormat = COMPRESSED_DXT5;
+						break;
+					case DXGI_FORMAT_BC7_UNORM:
+					case DXGI_FORMAT_BC7_UNORM_SRGB:
+						mFormat = COMPRESSED_BC7;
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	}
+
+	if (!mLevels)
+		mLevels = 1;
+
+	if (COMPRESSED_UNKNOWN == mFormat ||
+	    !mWidth || mWidth > DDS_MAX_SIZE ||
+	    !mHeight || mHeight > DDS_MAX_SIZE ||
+	    mLevels > DDS_MAX_LEVELS) {
+		fclose(mFile);
+		return false;
+	}
+
+	// All the levels the header declares must be in the file, even if only the first one is read
+	long mDataStart = ftell(mFile);
+	if (mDataStart < 0 || fseek(mFile, 0, SEEK_END) != 0) {
+		fclose(mFile);
+		return false;
+	}
+	long mFileEnd = ftell(mFile);
+	if (mFileEnd < mDataStart || fseek(mFile, mDataStart, SEEK_SET) != 0) {
+		fclose(mFile);
+		return false;
+	}
+
+	unsigned long long mLevelsSize = 0;
+	unsigned int mLevelWidth = mWidth;
+	unsigned int mLevelHeight = mHeight;
+	for (unsigned int i = 0; i < mLevels; i++) {
+		unsigned long long mBlocksX = (mLevelWidth + 3) / 4;
+		unsigned long long mBlocksY = (mLevelHeight + 3) / 4;
+		mLevelsSize += mBlocksX * mBlocksY * getBlockBytes(mFormat);
+		mLevelWidth = (mLevelWidth > 1) ? mLevelWidth / 2 : 1;
+		mLevelHeight = (mLevelHeight > 1) ? mLevelHeight / 2 : 1;
+	}
+
+	if (mLevelsSize > (unsigned long long)(mFileEnd - mDataStart)) {
+		fclose(mFile);
+		return false;
+	}
+
+	// Sizes are bounded by DDS_MAX_SIZE, so the first level fits in an int
+	int mSize = getDataSize(mFormat, (int)mWidth, (int)mHeight);
+	unsigned char *mData = new unsigned char [mSize];
+	if (fread(mData, 1, mSize, mFile) != (size_t)mSize) {
+		DISPOSEARRAY(mData);
+		fclose(mFile);
+		return false;
+	}
+	fclose(mFile);
+
+	freeImage(pImage);
+	pImage->_format = mFormat;
+	pImage->_width = (int)mWidth;
+	pImage->_height = (int)mHeight;
+	pImage->_size = mSize;
+	pImage->_data = mData;
+
+	return true;
+}
+
+/**
+ * Saves a compressed image into a .dds file (BC7 images use the DX10 extended header).
+ * @param pName			the name of the file
+ * @param pImage		the image to save
+ */
+bool CompressedImageHelper::saveDDS(const char *pName, COMPRESSED_IMAGE *pImage) {
+	if (!pImage->_data || COMPRESSED_UNKNOWN == pImage->_format)
+		return false;
+
+	unsigned char mHeader [4 + DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE];
+	memset(mHeader, 0, sizeof(mHeader));
+
+	writeUInt(mHeader, DDS_MAGIC);
+	writeUInt(mHeader + 4, DDS_HEADER_SIZE);
+	writeUInt(mHeader + 8, DDSD_FLAGS);
+	writeUInt(mHeader + 12, pImage->_height);
+	writeUInt(mHeader + 16, pImage->_width);
+	writeUInt(mHeader + 20, pImage->_size);
+	writeUInt(mHeader + 28, 1);
+	writeUInt(mHeader + 76, DDS_PIXELFORMAT_SIZE);
+	writeUInt(mHeader + 80, DDPF_FOURCC);
+	writeUInt(mHeader + 108, DDSCAPS_TEXTURE);
+
+	int mHeaderSize = 4 + DDS_HEADER_SIZE;
+	switch (pImage->_format) {
+		case COMPRESSED_DXT1:
+			writeUInt(mHeader + 84, DDS_FOURCC('D', 'X', 'T', '1'));
+			break;
+		case COMPRESSED_DXT5:
+			writeUInt(mHeader + 84, DDS_FOURCC('D', 'X', 'T', '5'));
+			break;
+		default:
+			writeUInt(mHeader + 84, DDS_FOURCC('D', 'X', '1', '0'));
+			writeUInt(mHeader + mHeaderSize, DXGI_FORMAT_BC7_UNORM);
+			writeUInt(mHeader + mHeaderSize + 4, 3);         // Texture 2d
+			writeUInt(mHeader + mHeaderSize + 12, 1);        // Array size
+			mHeaderSize += DDS_DX10_HEADER_SIZE;
+			break;
+	}
+
+	FILE *mFile = fopen(pName, "wb");
+	if (!mFile)
+		return false;
+
+	bool mOk = (fwrite(mHeader, 1, mHeaderSize, mFile) == (size_t)mHeaderSize &&
+	            fwrite(pImage->_data, 1, pImage->_size, mFile) == (size_t)pImage->_size);
+	fclose(mFile);
+
+	return mOk;
+}
+
+/**
+ * Frees the data of a compressed image.
+ * @param pImage		the image to free
+ */
+void CompressedImageHelper::freeImage(COMPRESSED_IMAGE *pImage) {
+	DISPOSEARRAY(pImage->_data);
+	pImage->_format = COMPRESSED_UNKNOWN;
+	pImage->_width = 0;
+	pImage->_height = 0;
+	pImage->_size = 0;
+}
+
+/**
+ * True if the data of a compressed format can be decoded by software.
+ * @param pFormat		the compressed format
+ */
+bool CompressedImageHelper::canDecode(int pFormat) {
+	return (COMPRESSED_DXT1 == pFormat || COMPRESSED_DXT5 == pFormat);
+}
+
+/**
+ * Decodes a DXT1 / DXT5 image into 32 bpp pixels, with the channel order of FreeImage
+ * bitmaps (FI_RGBA_*). Used when the renderer can't upload the compressed data.
+ * @param pImage		the compressed image
+ * @param pPixels		buffer of _width * _height * 4 bytes, rows starting from the lower one (as FreeImage bitmaps)
+ */
+bool CompressedImageHelper::decode(COMPRESSED_IMAGE *pImage, unsigned char *pPixels) {
+	if (!canDecode(pImage->_format) || !pImage->_data)
+		return false;
+
+	int mBlocksX = (pImage->_width + 3) / 4;
+	int mBlocksY = (pImage->_height + 3) / 4;
+	int mBlockBytes = getBlockBytes(pImage->_format);
+	const unsigned char *mBlock = pImage->_data;
+	unsigned char mColors [16][4];
+
+	for (int mBy = 0; mBy < mBlocksY; mBy++) {
+		for (int mBx = 0; mBx < mBlocksX; mBx++) {
+			if (COMPRESSED_DXT1 == pImage->_format) {
+				decodeColorBlock(mBlock, false, mColors);
+			} else {
+				decodeColorBlock(mBlock + 8, true, mColors);
+				decodeAlphaBlock(mBlock, mColors);
+			}
+			mBlock += mBlockBytes;
+
+			// Pixels of the block that are inside the image
+			for (int y = 0; y < 4; y++) {
+				int mY = mBy * 4 + y;
+				if (mY >= pImage->_height)
+					break;
+				for (int x = 0; x < 4; x++) {
+					int mX = mBx * 4 + x;
+					if (mX >= pImage->_width)
+						break;
+					unsigned char *mPixel = pPixels + ((pImage->_height - 1 - mY) * pImage->_width + mX) * 4;
+					mPixel[FI_RGBA_RED] = mColors[y * 4 + x][0];
+					mPixel[FI_RGBA_GREEN] = mColors[y * 4 + x][1];
+					mPixel[FI_RGBA_BLUE] = mColors[y * 4 + x][2];
+					mPixel[FI_RGBA_ALPHA] = mColors[y * 4 + x][3];
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Encodes 32 bpp pixels (FreeImage channel order) as DXT1 or DXT5. The encoder fits each block
+ * to the bounding box of its colors, which is fast and good enough for sprites and backgrounds.
+ * @param pPixels		pixels of the image, rows starting from the lower one (as FreeImage bitmaps)
+ * @param pWidth		the width of the image in pixels
+ * @param pHeight		the height of the image in pixels
+ * @param pFormat		COMPRESSED_DXT1 or COMPRESSED_DXT5
+ * @param pImage		the image where the compressed data is stored (free it with freeImage())
+ */
+bool CompressedImageHelper::encode(const unsigned char *pPixels, int pWidth, int pHeight, int pFormat, COMPRESSED_IMAGE *pImage) {
+	if (!canDecode(pFormat) || pWidth <= 0 || pHeight <= 0)
+		return false;
+
+	freeImage(pImage);
+	pImage->_format = pFormat;
+	pImage->_width = pWidth;
+	pImage->_height = pHeight;
+	pImage->_size = getDataSize(pFormat, pWidth, pHeight);
+	pImage->_data = new unsigned char [pImage->_size];
+
+	int mBlocksX = (pWidth + 3) / 4;
+	int mBlocksY = (pHeight + 3) / 4;
+	unsigned char *mBlock = pImage->_data;
+	unsigned char mColors [16][4];
+
+	for (int mBy = 0; mBy < mBlocksY; mBy++) {
+		for (int mBx = 0; mBx < mBlocksX; mBx++) {
+			// Blocks on the borders repeat the last row / column of the image
+			for (int y = 0; y < 4; y++) {
+				int mY = mBy * 4 + y;
+				if (mY >= pHeight)
+					mY = pHeight - 1;
+				for (int x = 0; x < 4; x++) {
+					int mX = mBx * 4 + x;
+					if (mX >= pWidth)
+						mX = pWidth - 1;
+					const unsigned char *mPixel = pPixels + ((pHeight - 1 - mY) * pWidth + mX) * 4;
+					mColors[y * 4 + x][0] = mPixel[FI_RGBA_RED];
+					mColors[y * 4 + x][1] = mPixel[FI_RGBA_GREEN];
+					mColors[y * 4 + x][2] = mPixel[FI_RGBA_BLUE];
+					mColors[y * 4 + x][3] = mPixel[FI_RGBA_ALPHA];
+				}
+			}
+
+			if (COMPRESSED_DXT1 == pFormat) {
+				encodeColorBlock(mColors, mBlock);
+				mBlock += 8;
+			} else {
+				encodeAlphaBlock(mColors, mBlock);
+				encodeColorBlock(mColors, mBlock + 8);
+				mBlock += 16;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Flips a DXT1 / DXT5 image vertically in place, reversing the rows of blocks and the rows of
+ * pixels inside each block, so it can be uploaded starting from the lower row. Returns false
+ * (and leaves the image untouched) for other formats, or when the height is not a multiple of
+ * 4, as the rows added to fill the last blocks would end up at the start of the image.
+ * @param pImage		the compressed image
+ */
+bool CompressedImageHelper::flipRows(COMPRESSED_IMAGE *pImage) {
+	if (!canDecode(pImage->_format) || !pImage->_data || pImage->_height % 4)
+		return false;
+
+	int mBlockBytes = getBlockBytes(pImage->_format);
+	int mRowBytes = ((pImage->_width + 3) / 4) * mBlockBytes;
+	int mBlocksY = pImage->_height / 4;
+	unsigned char *mTemp = new unsigned char [mRowBytes];
+
+	// Swap the rows of blocks
+	for (int mBy = 0; mBy < mBlocksY / 2; mBy++) {
+		unsigned char *mUpper = pImage->_data + mBy * mRowBytes;
+		unsigned char *mLower = pImage->_data + (mBlocksY - 1 - mBy) * mRowBytes;
+		memcpy(mTemp, mUpper, mRowBytes);
+		memcpy(mUpper, mLower, mRowBytes);
+		memcpy(mLower, mTemp, mRowBytes);
+	}
+	delete [] mTemp;
+
+	// Reverse the rows of each block
+	for (unsigned char *mBlock = pImage->_data; mBlock < pImage->_data + pImage->_size; mBlock += mBlockBytes) {
+		unsigned char *mColor = mBlock;
+		if (COMPRESSED_DXT5 == pImage->_format) {
+			// 4 rows of 12 bits of alpha indices
+			unsigned int mLow = mBlock[2] | (mBlock[3] << 8) | (mBlock[4] << 16);
+			unsigned int mHigh = mBlock[5] | (mBlock[6] << 8) | (mBlock[7] << 16);
+			unsigned int mNewLow = (mHigh >> 12) | ((mHigh & 0xFFF) << 12);
+			unsigned int mNewHigh = (mLow >> 12) | ((mLow & 0xFFF) << 12);
+			for (int i = 0; i < 3; i++) {
+				mBlock[2 + i] = (unsigned char)((mNewLow >> (i * 8)) & 0xFF);
+				mBlock[5 + i] = (unsigned char)((mNewHigh >> (i * 8)) & 0xFF);
+			}
+			mColor = mBlock + 8;
+		}
+
+		// 4 rows of 8 bits of color indices
+		unsigned char mRow = mColor[4];
+		mColor[4] = mColor[7];
+		mColor[7] = mRow;
+		mRow = mColor[5];
+		mColor[5] = mColor[6];
+		mColor[6] = mRow;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------------------------------
+//									Private methods
+// --------------------------------------------------------------------------------
+
+/*
+==================
+Decodes the 8 bytes color part of a DXT block into RGBA colors. DXT1 blocks with the
+first color lower or equal than the second use three colors and transparent black.
+==================
+*/
+void CompressedImageHelper::decodeColorBlock(const unsigned char *pBlock, bool pFourColors, unsigned char pColors [16][4]) {
+	unsigned int mColor0 = pBlock[0] | (pBlock[1] << 8);
+	unsigned int mColor1 = pBlock[2] | (pBlock[3] << 8);
+
+	unsigned char mPalette [4][4];
+	unpack565(mColor0, mPalette[0]);
+	unpack565(mColor1, mPalette[1]);
+	mPalette[0][3] = mPalette[1][3] = mPalette[2][3] = mPalette[3][3] = 255;
+
+	for (int i = 0; i < 3; i++) {
+		if (pFourColors || mColor0 > mColor1) {
+			mPalette[2][i] = (unsigned char)((2 * mPalette[0][i] + mPalette[1][i]) / 3);
+			mPalette[3][i] = (unsigned char)((mPalette[0][i] + 2 * mPalette[1][i]) / 3);
+		} else {
+			mPalette[2][i] = (unsigned char)((mPalette[0][i] + mPalette[1][i]) / 2);
+			mPalette[3][i] = 0;
+		}
+	}
+	if (!pFourColors && mColor0 <= mColor1)
+		mPalette[3][3] = 0;
+
+	unsigned int mIndices = readUInt(pBlock + 4);
+	for (int i = 0; i < 16; i++) {
+		memcpy(pColors[i], mPalette[(mIndices >> (i * 2)) & 0x3], 4);
+	}
+}
+
+/*
+==================
+Decodes the 8 bytes alpha part of a DXT5 block
+==================
+*/
+void CompressedImageHelper::decodeAlphaBlock(const unsigned char *pBlock, unsigned char pColors [16][4]) {
+	int mAlpha [8];
+	mAlpha[0] = pBlock[0];
+	mAlpha[1] = pBlock[1];
+	if (mAlpha[0] > mAlpha[1]) {
+		for (int i = 1; i < 7; i++)
+			mAlpha[i + 1] = ((7 - i) * mAlpha[0] + i * mAlpha[1]) / 7;
+	} else {
+		for (int i = 1; i < 5; i++)
+			mAlpha[i + 1] = ((5 - i) * mAlpha[0] + i * mAlpha[1]) / 5;
+		mAlpha[6] = 0;
+		mAlpha[7] = 255;
+	}
+
+	// 16 indices of 3 bits
+	unsigned int mLow = pBlock[2] | (pBlock[3] << 8) | (pBlock[4] << 16);
+	unsigned int mHigh = pBlock[5] | (pBlock[6] << 8) | (pBlock[7] << 16);
+	for (int i = 0; i < 8; i++) {
+		pColors[i][3] = (unsigned char)mAlpha[(mLow >> (i * 3)) & 0x7];
+		pColors[i + 8][3] = (unsigned char)mAlpha[(mHigh >> (i * 3)) & 0x7];
+	}
+}
+
+/*
+==================
+Encodes the colors of a block using the corners of their bounding box as end points
+(always in four colors mode, so the block is decoded the same way as DXT1 and DXT5)
+==================
+*/
+void CompressedImageHelper::encodeColorBlock(unsigned char pColors [16][4], unsigned char *pBlock) {
+	unsigned char mMin [3] = {255, 255, 255};
+	unsigned char mMax [3] = {0, 0, 0};
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			if (pColors[i][c] < mMin[c]) mMin[c] = pColors[i][c];
+			if (pColors[i][c] > mMax[c]) mMax[c] = pColors[i][c];
+		}
+	}
+
+	// Inset the box a bit, the end points are rarely the best fit for the rest of the colors
+	for (int c = 0; c < 3; c++) {
+		int mInset = (mMax[c] - mMin[c]) / 16;
+		mMin[c] = (unsigned char)(mMin[c] + mInset);
+		mMax[c] = (unsigned char)(mMax[c] - mInset);
+	}
+
+	unsigned int mColor0 = pack565(mMax);
+	unsigned int mColor1 = pack565(mMin);
+	if (mColor0 < mColor1) {
+		unsigned int mSwap = mColor0;
+		mColor0 = mColor1;
+		mColor1 = mSwap;
+	}
+
+	pBlock[0] = (unsigned char)(mColor0 & 0xFF);
+	pBlock[1] = (unsigned char)(mColor0 >> 8);
+	pBlock[2] = (unsigned char)(mColor1 & 0xFF);
+	pBlock[3] = (unsigned char)(mColor1 >> 8);
+
+	// Same colors: every index is 0
+	if (mColor0 == mColor1) {
+		writeUInt(pBlock + 4, 0);
+		return;
+	}
+
+	// Palette as the decoder will see it
+	int mPalette [4][3];
+	unsigned char mRGB [3];
+	unpack565(mColor0, mRGB);
+	for (int c = 0; c < 3; c++) mPalette[0][c] = mRGB[c];
+	unpack565(mColor1, mRGB);
+	for (int c = 0; c < 3; c++) mPalette[1][c] = mRGB[c];
+	for (int c = 0; c < 3; c++) {
+		mPalette[2][c] = (2 * mPalette[0][c] + mPalette[1][c]) / 3;
+		mPalette[3][c] = (mPalette[0][c] + 2 * mPalette[1][c]) / 3;
+	}
+
+	unsigned int mIndices = 0;
+	for (int i = 0; i < 16; i++) {
+		int mBest = 0;
+		int mBestDistance = 0x7FFFFFFF;
+		for (int p = 0; p < 4; p++) {
+			int mDr = pColors[i][0] - mPalette[p][0];
+			int mDg = pColors[i][1] - mPalette[p][1];
+			int mDb = pColors[i][2] - mPalette[p][2];
+			int mDistance = mDr * mDr + mDg * mDg + mDb * mDb;
+			if (mDistance < mBestDistance) {
+				mBestDistance = mDistance;
+				mBest = p;
+			}
+		}
+		mIndices |= (unsigned int)mBest << (i * 2);
+	}
+	writeUInt(pBlock + 4, mIndices);
+}
+
+/*
+==================
+Encodes the alpha of a block in eight values mode, between the minimum and maximum alpha
+==================
+*/
+void CompressedImageHelper::encodeAlphaBlock(unsigned char pColors [16][4], unsigned char *pBlock) {
+	int mMin = 255;
+	int mMax = 0;
+	for (int i = 0; i < 16; i++) {
+		if (pColors[i][3] < mMin) mMin = pColors[i][3];
+		if (pColors[i][3] > mMax) mMax = pColors[i][3];
+	}
+
+	pBlock[0] = (unsigned char)mMax;
+	pBlock[1] = (unsigned char)mMin;
+
+	int mAlpha [8];
+	mAlpha[0] = mMax;
+	mAlpha[1] = mMin;
+	for (int i = 1; i < 7; i++)
+		mAlpha[i + 1] = ((7 - i) * mMax + i * mMin) / 7;
+
+	unsigned int mLow = 0;
+	unsigned int mHigh = 0;
+	for (int i = 0; i < 16; i++) {
+		int mBest = 0;
+		if (mMax != mMin) {
+			int mBestDistance = 256;
+			for (int p = 0; p < 8; p++) {
+				int mDistance = pColors[i][3] - mAlpha[p];
+				if (mDistance < 0) mDistance = -mDistance;
+				if (mDistance < mBestDistance) {
+					mBestDistance = mDistance;
+					mBest = p;
+				}
+			}
+		}
+		if (i < 8)
+			mLow |= (unsigned int)mBest << (i * 3);
+		else
+			mHigh |= (unsigned int)mBest << ((i - 8) * 3);
+	}
+
+	pBlock[2] = (unsigned char)(mLow & 0xFF);
+	pBlock[3] = (unsigned char)((mLow >> 8) & 0xFF);
+	pBlock[4] = (unsigned char)((mLow >> 16) & 0xFF);
+	pBlock[5] = (unsigned char)(mHigh & 0xFF);
+	pBlock[6] = (unsigned char)((mHigh >> 8) & 0xFF);
+	pBlock[7] = (unsigned char)((mHigh >> 16) & 0xFF);
+}
+
+/** @endcond */
@@ -0,0 +1,108 @@
+/*****************************************************************************************
+ * File: CompressedImageHelper.h
+ * Description: Helper class to load, save, encode and decode block compressed images
+ *              (DXT1, DXT5 and BC7) stored in .dds files
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _COMPRESSEDIMAGEHELPER
+#define _COMPRESSEDIMAGEHELPER
+
+// ----- Includes -----
+
+#include "Defines.h"
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// ----- Compressed formats -----
+
+#define COMPRESSED_UNKNOWN  0
+#define COMPRESSED_DXT1     1      // 4x4 blocks of 8 bytes, RGB (1 bit alpha)
+#define COMPRESSED_DXT5     2      // 4x4 blocks of 16 bytes, RGBA (interpolated alpha)
+#define COMPRESSED_BC7      3      // 4x4 blocks of 16 bytes, RGBA
+
+// Extension of the compressed variant of an image file
+#define COMPRESSED_EXTENSION ".dds"
+
+// Block compressed image data (only the first mipmap level is kept).
+// As in any DDS file, the rows of blocks are stored starting from the upper row of the image.
+struct COMPRESSED_IMAGE {
+	COMPRESSED_IMAGE() : _format(COMPRESSED_UNKNOWN), _width(0), _height(0), _size(0), _data(NULL) {}
+	int _format;
+	int _width;
+	int _height;
+	int _size;                  // Bytes of _data
+	unsigned char *_data;
+};
+
+class CompressedImageHelper {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	CompressedImageHelper() {
+	}
+	~CompressedImageHelper() {
+	}
+
+	//----- GET/SET FUNCTIONS -----
+
+	//----- OTHER FUNCTIONS -----
+
+	static void getCompressedName(const char *pName, char *pCompressedName);
+	static int getBlockBytes(int pFormat);
+	static int getDataSize(int pFormat, int pWidth, int pHeight);
+	static bool hasAlpha(int pFormat);
+	static const char *getFormatName(int pFormat);
+
+	static bool loadDDS(const char *pName, COMPRESSED_IMAGE *pImage);
+	static bool saveDDS(const char *pName, COMPRESSED_IMAGE *pImage);
+	static void freeImage(COMPRESSED_IMAGE *pImage);
+
+	static bool canDecode(int pFormat);
+	static bool decode(COMPRESSED_IMAGE *pImage, unsigned char *pPixels);
+	static bool encode(const unsigned char *pPixels, int pWidth, int pHeight, int pFormat, COMPRESSED_IMAGE *pImage);
+	static bool flipRows(COMPRESSED_IMAGE *pImage);
+
+    //----- PUBLIC VARIABLES ------
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	//----- INTERNAL FUNCTIONS -----
+
+	static void decodeColorBlock(const unsigned char *pBlock, bool pFourColors, unsigned char pColors [16][4]);
+	static void decodeAlphaBlock(const unsigned char *pBlock, unsigned char pColors [16][4]);
+	static void encodeColorBlock(unsigned char pColors [16][4], unsigned char *pBlock);
+	static void encodeAlphaBlock(unsigned char pColors [16][4], unsigned char *pBlock);
+};
+
+/** @endcond */
+
+#endif
@@ -34,7 +34,14 @@
 #include "DebugApi.h"
 #include "IndieVersion.h"
 #include "IND_Timer.h"
+#include "dependencies/SDL-2.0/include/SDL_timer.h"
 #include <string.h>
+#include <stdarg.h>
+
+// Visual Studio 2008 doesn't provide vsnprintf
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define vsnprintf _vsnprintf
+#endif
 
 const int DebugApi::LogHeaderOk = 1;
 const int DebugApi::LogHeaderError = 2;
@@ -43,6 +50,24 @@ const int DebugApi::LogHeaderWarning = 4;
 const int DebugApi::LogHeaderBegin = 5;
 const int DebugApi::LogHeaderEnd = 6;
 
+/*
+==================
+Writes a formatted text into a buffer of LOG_SLOT_SIZE chars, truncating it when
+it doesn't fit. Returns the number of chars written.
+==================
+*/
+static int formatText(char *pBuffer, const char *pFormat, va_list pArgs) {
+	int mLength = vsnprintf(pBuffer, LOG_SLOT_SIZE, pFormat, pArgs);
+
+	// Truncated (_vsnprintf returns -1 and doesn't add the terminating char)
+	if (mLength < 0 || mLength >= LOG_SLOT_SIZE) {
+		mLength = LOG_SLOT_SIZE - 1;
+		pBuffer [mLength] = 0;
+	}
+
+	return mLength;
+}
+
 // --------------------------------------------------------------------------------
 //							  Initialization / Destruction
 // --------------------------------------------------------------------------------
@@ -55,10 +80,15 @@ bool DebugApi::init() {
 
 	// File
 #if LOG_REDIRECT_TO_CONSOLE
-	_count = &std::cout;
+	_count = stdout;
 #else
-    _count = new ofstream("debug.log", ios::out);
+    _count = fopen("debug.log", "w");
 #endif //LOG_REDIRECT_TO_CONSOLE
+	if (!_count || !_lineId) {
+		freeVars();
+		return false;
+	}
+
 	// Time
 	time_t mT;							
 	time(&mT);							 
@@ -66,31 +96,36 @@ bool DebugApi::init() {
 
 	// :D
 
-	*_count << endl;
-
-	*_count << "                         ''~``                          " << endl;
-	*_count << "                        ( o o )                         " << endl;
-	*_count << "+------------------.oooO--(_)--Oooo.------------------+ " << endl;
-	*_count << "|                                                     | " << endl;
-	*_count << "|                .-------------------.                | " << endl;
-	*_count << "|                | I N D I E  L I B  |                | " << endl;
-	*_count << "|                .-------------------.                | " << endl;
-	*_count << "|                    .oooO                            | " << endl;
-	*_count << "|                    (   )   Oooo.                    | " << endl;
-	*_count << "+---------------------\\ (----(   )--------------------+" << endl;
-	*_count << "                       \\_)    ) /                      " << endl;
-	*_count << "                             (_/                        " << endl;
-    *_count << "Indielib version: "<<IND_VERSION.major<<"."<<IND_VERSION.minor<<"."<<IND_VERSION.revision;
-	*_count << endl;
-	*_count << endl;
-	*_count << "[Init time]:" << " (";
+	endLine();
+
+	append("                         ''~``                          "); endLine();
+	append("                        ( o o )                         "); endLine();
+	append("+------------------.oooO--(_)--Oooo.------------------+ "); endLine();
+	append("|                                                     | "); endLine();
+	append("|                .-------------------.                | "); endLine();
+	append("|                | I N D I E  L I B  |                | "); endLine();
+	append("|                .-------------------.                | "); endLine();
+	append("|                    .oooO                            | "); endLine();
+	append("|                    (   )   Oooo.                    | "); endLine();
+	append("+---------------------\\ (----(   )--------------------+"); endLine();
+	append("                       \\_)    ) /                      "); endLine();
+	append("                             (_/                        "); endLine();
+	appendf("Indielib version: %d.%d.%d", IND_VERSION.major, IND_VERSION.minor, IND_VERSION.revision);
+	endLine();
+	endLine();
+	append("[Init time]: (");
 
 	// Date
-	string days [7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thrusday", "Friday", "Saturday"};
-	string months [12] = {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"};
+	const char *days [7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thrusday", "Friday", "Saturday"};
+	const char *months [12] = {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"};
 
 	// Date
-	*_count << days [mPetm->tm_wday].c_str() << ", " << mPetm->tm_mday << " of " << months [mPetm->tm_mon].c_str() << " " << mPetm->tm_year + 1900 << ")" << endl << endl;
+	appendf("%s, %d of %s %d)", days [mPetm->tm_wday], mPetm->tm_mday, months [mPetm->tm_mon], mPetm->tm_year + 1900);
+	endLine();
+	endLine();
+
+	// Writer thread. If it can't be created, the lines are written directly.
+	_writer = SDL_CreateThread(writerThread, "IndieLib log", this);
 
 	//Start timer
 	_timer->start();
@@ -106,9 +141,24 @@ bool DebugApi::init() {
  */
 void DebugApi::end() {
 	if (_ok) {
+		// Unfinished line of this thread (the ones of other threads are lost)
+		LOG_LINE *mLine = getLine();
+		if (mLine->_length) {
+			pushLine(mLine->_text, mLine->_length);
+			mLine->_length = 0;
+		}
+
+		// The writer thread writes the remaining lines before finishing
+		if (_writer) {
+			SDL_AtomicSet(&_quit, 1);
+			SDL_WaitThread(_writer, NULL);
+			_writer = NULL;
+		}
+
 #if !LOG_REDIRECT_TO_CONSOLE
-		_count->close();
+		fclose(_count);
 #endif
+		_count = NULL;
         _timer->stop();
 		freeVars();
 		_ok = false;
@@ -126,52 +176,59 @@ void DebugApi::end() {
  *  @param pTextString		TODO describtion  
  *  @param pType			TODO describtion 
  */
-void DebugApi::header(string pTextString, int pType) {
+void DebugApi::header(const char *pTextString, int pType) {
 	if (!_ok) return;
+
+	LOG_LINE *mLine = getLine();
     
 	switch (pType) {
             // Ok
         default: //NO BREAK ON PURPOSE!
         case(LogHeaderOk): {
             // Line
-            *_count << "          ";
-            *_count << " [  OK   ] ";
+            append("          ");
+            append(" [  OK   ] ");
             advance();
-            *_count << pTextString.c_str() << endl;
+            append(pTextString);
+            endLine();
             
             break;
         }
             // Error
         case(LogHeaderError): {
             // Line
-            *_count << "          ";
-            *_count << " [ ERROR ] ";
+            append("          ");
+            append(" [ ERROR ] ");
             advance();
-            *_count << pTextString.c_str() << endl;
+            append(pTextString);
+            endLine();
             
             // If we are inside a BEGIN / END, we go out
-            if (_depth > 0) {
+            if (mLine->_depth > 0) {
                 // Going back
-                _depth -= ESP;
+                mLine->_depth -= ESP;
                 // Close bracket
-                *_count << "                     ";
+                append("                     ");
                 advance();
-                *_count << "}" << endl;
+                append("}");
+                endLine();
                 
                 // Line
                 writeTime();
-                *_count << " [  END  ] ";
+                append(" [  END  ] ");
                 advance();
-                *_count << "Error occurred";
+                append("Error occurred");
                 
                 // Measure the time between BEGIN and END
-                double elapsedTime = _timer->getTicks() - _tableTime [(_depth + ESP) / ESP];
+                double elapsedTime = _timer->getTicks() - mLine->_tableTime [(mLine->_depth + ESP) / ESP];
                 if (elapsedTime < 0) elapsedTime = 0; // Medida de seguridad
-                *_count << " [Elaped time = " << elapsedTime * 0.001f << " seg]" << endl;
+                appendf(" [Elaped time = %g seg]", elapsedTime * 0.001f);
+                endLine();
                 
                 // Line jump after BEGIN/END
-                if (!_depth) {
-                    *_count << "---------------------------------------------------------------------" << endl;
+                if (!mLine->_depth) {
+                    append("---------------------------------------------------------------------");
+                    endLine();
                 }
             }
             
@@ -182,20 +239,21 @@ void DebugApi::header(string pTextString, int pType) {
             // Info dosen't make a line jump in order DataChar and DataInt could write just after that line
         case(LogHeaderInfo): {
             // Line
-            *_count << "          ";
-            *_count << " [ INFO  ] ";
+            append("          ");
+            append(" [ INFO  ] ");
             advance();
-            *_count << pTextString.c_str();
+            append(pTextString);
             
             break;
         }
             // Warning
         case(LogHeaderWarning): {
             // Line
-            *_count << "          ";
-            *_count << " [WARNING] ";
+            append("          ");
+            append(" [WARNING] ");
             advance();
-            *_count << pTextString.c_str() << endl;
+            append(pTextString);
+            endLine();
             
             break;
         }
@@ -203,46 +261,53 @@ void DebugApi::header(string pTextString, int pType) {
         case(LogHeaderBegin): {
             // Line
             writeTime();
-            *_count << " [ BEGIN ] ";
+            append(" [ BEGIN ] ");
             advance();
-            *_count << "-- " << pTextString.c_str() << " --" << endl;
+            append("-- ");
+            append(pTextString);
+            append(" --");
+            endLine();
             
             // Open brackets
-            *_count << "                     ";
+            append("                     ");
             advance();
-            *_count << "{" << endl;
+            append("{");
+            endLine();
             
             // Advance
-            _depth += ESP;
+            mLine->_depth += ESP;
             
             // Store the current time in the time table
-            _tableTime [_depth / ESP] = _timer->getTicks();
+            mLine->_tableTime [mLine->_depth / ESP] = _timer->getTicks();
             
             break;
         }
             // End
         case(LogHeaderEnd): {
             // Going back
-            _depth -= ESP;
+            mLine->_depth -= ESP;
             // Close bracket
-            *_count << "                     ";
+            append("                     ");
             advance();
-            *_count << "}" << endl;
+            append("}");
+            endLine();
             
             // Line
             writeTime();
-            *_count << " [  END  ] ";
+            append(" [  END  ] ");
             advance();
-            *_count << pTextString.c_str();
+            append(pTextString);
             
             // Measure the time between BEGIN and END
-            double elapsedTime = _timer->getTicks() - _tableTime [(_depth + ESP) / ESP];
+            double elapsedTime = _timer->getTicks() - mLine->_tableTime [(mLine->_depth + ESP) / ESP];
             if (elapsedTime < 0) elapsedTime = 0; // Security Measure
-            *_count << " [Elapsed time = " << elapsedTime * 0.001f << " seg]" << endl;
+            appendf(" [Elapsed time = %g seg]", elapsedTime * 0.001f);
+            endLine();
             
             // Line jump after BEGIN/END
-            if (!_depth) {
-                *_count << "---------------------------------------------------------------------" << endl;
+            if (!mLine->_depth) {
+                append("---------------------------------------------------------------------");
+                endLine();
             }
             
             break;
@@ -256,13 +321,14 @@ void DebugApi::header(string pTextString, int pType) {
  *  @param pTextString		text to add to the debuglog
  *  @param pFlag			true if line should break
  */
-void DebugApi::dataChar(string pTextString, bool pFlag) {
+void DebugApi::dataChar(const char *pTextString, bool pFlag) {
 	if (!_ok) return;
 
-    *_count << " " << pTextString.c_str();
+	append(" ");
+	append(pTextString);
 	// Line jump
 	if (pFlag)
-		*_count << endl;
+		endLine();
 }
 
 
@@ -274,10 +340,10 @@ void DebugApi::dataChar(string pTextString, bool pFlag) {
 void DebugApi::dataInt(int pDataInt, bool pFlag) {
 	if (!_ok) return;
 
-	*_count << " " << pDataInt;
+	appendf(" %d", pDataInt);
 	// Jump line
 	if (pFlag)
-		*_count << endl;
+		endLine();
 }
 
 
@@ -289,20 +355,55 @@ void DebugApi::dataInt(int pDataInt, bool pFlag) {
 void DebugApi::dataFloat(float pDataFloat, bool pFlag) {
 	if (!_ok) return;
 
-	*_count << " " << pDataFloat;
+	appendf(" %g", pDataFloat);
 	// Line jump
 	if (pFlag)
-		*_count << endl;
+		endLine();
 }
 
+
+/**
+ * Writes a header with a printf-style formatted message. Unlike header(), a LogHeaderInfo
+ * message makes a line jump. The text is formatted in a stack buffer, no strings are allocated.
+ * Use it through the IND_LOG_ERROR / IND_LOG_WARNING / IND_LOG_INFO / IND_LOG_VERBOSE macros,
+ * so the messages above IND_LOG_LEVEL are removed at compile time.
+ *  @param pType			header type (LogHeaderOk, LogHeaderError...)
+ *  @param pFormat			printf-style format of the message
+ */
+void DebugApi::logf(int pType, const char *pFormat, ...) {
+	if (!_ok) return;
+
+	char mText [LOG_SLOT_SIZE];
+	va_list mArgs;
+	va_start(mArgs, pFormat);
+	formatText(mText, pFormat, mArgs);
+	va_end(mArgs);
+
+	header(mText, pType);
+	if (LogHeaderInfo == pType)
+		endLine();
+}
+
+
+/**
+ * Waits until the writer thread has written all the finished lines.
+ */
+void DebugApi::flush() {
+	if (!_ok) return;
+
+	while (_writer && SDL_AtomicGet(&_readIndex) != SDL_AtomicGet(&_writeIndex))
+		SDL_Delay(1);
+}
+
+
 /**
  * Writes a signal (for debugging purposes).
  */
 void DebugApi::breakPoint() {
 	if (!_ok) return;
 
-	*_count << "Abracadabra";
-	*_count << endl;
+	append("Abracadabra");
+	endLine();
 }
 
 
@@ -333,23 +434,8 @@ void DebugApi::writeTime() {
 	time(&t);
 	struct tm *petm = localtime(&t);
 
-	// Hour
-	*_count << "[";
-
-	// Hours
-	if (petm->tm_hour < 10)
-		*_count << "0";
-	*_count << petm->tm_hour << ":";
-
-	// Minutes
-	if (petm->tm_min < 10)
-		*_count << "0";
-	*_count << petm->tm_min << ":";
-
-	// Seconds
-	if (petm->tm_sec < 10)
-		*_count << "0";
-	*_count << petm->tm_sec << "]";
+	// [Hours:Minutes:Seconds]
+	appendf("[%02d:%02d:%02d]", petm->tm_hour, petm->tm_min, petm->tm_sec);
 }
 
 
@@ -357,8 +443,9 @@ void DebugApi::writeTime() {
  * Advance as many spaces as Depth.
  */
 void DebugApi::advance() {
-	for (int i = 0; i < _depth; i++)
-		*_count << " ";
+	int mDepth = getLine()->_depth;
+	for (int i = 0; i < mDepth; i++)
+		append(" ");
 }
 
 
@@ -378,7 +465,8 @@ void DebugApi::stop() {
 	_timer->stop();
 	if (elapsedTime < 0) elapsedTime = 0;
 	elapsedTime = elapsedTime * 0.001;
-	*_count << elapsedTime << endl;
+	appendf("%g", elapsedTime);
+	endLine();
 }
 
 
@@ -386,9 +474,179 @@ void DebugApi::stop() {
  * Draw all the characteres, including UNICODE.
  */
 void DebugApi::allFont() {
-	for (int i = 0; i < 256; i++)
-		*_count << (char) i;
-	*_count << endl;
+	char mChars [256];
+	for (int i = 1; i < 256; i++)
+		mChars [i - 1] = (char) i;
+	mChars [255] = 0;
+	append(mChars);
+	endLine();
+}
+
+
+/**
+ * Adds a text to the current line of the thread. When the line is full, it is sent as it is.
+ */
+void DebugApi::append(const char *pText) {
+	LOG_LINE *mLine = getLine();
+	while (*pText) {
+		if (LOG_SLOT_SIZE == mLine->_length) {
+			pushLine(mLine->_text, mLine->_length);
+			mLine->_length = 0;
+		}
+
+		mLine->_text [mLine->_length++] = *pText++;
+	}
+}
+
+
+/**
+ * Adds a printf-style formatted text to the current line.
+ */
+void DebugApi::appendf(const char *pFormat, ...) {
+	char mText [LOG_SLOT_SIZE];
+	va_list mArgs;
+	va_start(mArgs, pFormat);
+	formatText(mText, pFormat, mArgs);
+	va_end(mArgs);
+
+	append(mText);
+}
+
+
+/**
+ * Finishes the current line of the thread and sends it to the writer thread.
+ */
+void DebugApi::endLine() {
+	append("\n");
+	LOG_LINE *mLine = getLine();
+	pushLine(mLine->_text, mLine->_length);
+	mLine->_length = 0;
+}
+
+
+/**
+ * Returns the line of the calling thread, creating it the first time the thread logs.
+ */
+LOG_LINE *DebugApi::getLine() {
+	LOG_LINE *mLine = static_cast<LOG_LINE *>(SDL_TLSGet(_lineId));
+	if (mLine)
+		return mLine;
+
+	mLine = new LOG_LINE;
+	mLine->_length = 0;
+	mLine->_depth = 0;
+	for (int i = 0; i < 16; i++)
+		mLine->_tableTime [i] = 0;
+
+	// Added to the list without locks, it is only freed by end()
+	do {
+		mLine->_next = static_cast<LOG_LINE *>(SDL_AtomicGetPtr(&_lines));
+	} while (!SDL_AtomicCASPtr(&_lines, mLine->_next, mLine));
+
+	SDL_TLSSet(_lineId, mLine, NULL);
+	return mLine;
+}
+
+
+/**
+ * Copies a text into the ring buffer, using as many slots as needed. The writer thread will
+ * write it. If there is no writer thread, the text is written directly. The lines of the
+ * threads never need more than one slot, so each one is published in one step.
+ */
+void DebugApi::pushLine(const char *pText, int pLength) {
+	while (pLength > 0) {
+		int mLength = pLength < LOG_SLOT_SIZE ? pLength : LOG_SLOT_SIZE;
+
+		if (!_writer) {
+			fwrite(pText, 1, mLength, _count);
+			fflush(_count);
+		} else {
+			int mPosition;
+			LOG_SLOT *mSlot = reserveSlot(&mPosition);
+			memcpy(mSlot->_text, pText, mLength);
+			mSlot->_length = mLength;
+
+			// Publish the slot to the writer thread
+			SDL_MemoryBarrierRelease();
+			SDL_AtomicSet(&mSlot->_sequence, mPosition + 1);
+		}
+
+		pText += mLength;
+		pLength -= mLength;
+	}
+}
+
+
+/**
+ * Reserves the next free slot of the ring buffer, without locks: the slot at _writeIndex is free
+ * when its sequence is equal to the index, and it is taken by the producer that advances
+ * _writeIndex. When the ring buffer is full, waits for the writer thread.
+ *  @param pPosition		returns the position of the slot, used to publish it
+ */
+LOG_SLOT *DebugApi::reserveSlot(int *pPosition) {
+	for (;;) {
+		int mPosition = SDL_AtomicGet(&_writeIndex);
+		LOG_SLOT *mSlot = &_slots [mPosition & (LOG_RING_SLOTS - 1)];
+		int mDifference = (int) ((unsigned int) SDL_AtomicGet(&mSlot->_sequence) - (unsigned int) mPosition);
+
+		if (!mDifference) {
+			if (SDL_AtomicCAS(&_writeIndex, mPosition, (int) ((unsigned int) mPosition + 1))) {
+				*pPosition = mPosition;
+				return mSlot;
+			}
+		} else if (mDifference < 0) {
+			// Full, the writer thread has not written this slot yet
+			SDL_Delay(1);
+		}
+	}
+}
+
+
+/**
+ * Writes all the published slots, in order, and gives them back to the producers.
+ * Only called from the writer thread. Returns true if something was written.
+ */
+bool DebugApi::writeSlots() {
+	bool mWritten = false;
+	int mPosition = SDL_AtomicGet(&_readIndex);
+
+	for (;;) {
+		LOG_SLOT *mSlot = &_slots [mPosition & (LOG_RING_SLOTS - 1)];
+		if (SDL_AtomicGet(&mSlot->_sequence) != (int) ((unsigned int) mPosition + 1))
+			break;
+
+		SDL_MemoryBarrierAcquire();
+		fwrite(mSlot->_text, 1, mSlot->_length, _count);
+
+		// The slot can be reused in the next round of the ring buffer
+		SDL_AtomicSet(&mSlot->_sequence, (int) ((unsigned int) mPosition + LOG_RING_SLOTS));
+		mPosition = (int) ((unsigned int) mPosition + 1);
+		SDL_AtomicSet(&_readIndex, mPosition);
+		mWritten = true;
+	}
+
+	if (mWritten)
+		fflush(_count);
+
+	return mWritten;
+}
+
+
+/**
+ * Writer thread: writes the lines of the ring buffer until end() is called.
+ */
+int DebugApi::writerThread(void *pDebugApi) {
+	DebugApi *mDebugApi = static_cast<DebugApi *>(pDebugApi);
+
+	while (!SDL_AtomicGet(&mDebugApi->_quit)) {
+		if (!mDebugApi->writeSlots())
+			SDL_Delay(LOG_FLUSH_DELAY);
+	}
+
+	// Lines written before end() was called
+	mDebugApi->writeSlots();
+
+	return 0;
 }
 
 
@@ -396,11 +654,21 @@ void DebugApi::allFont() {
  * Init variables.
  */
 void DebugApi::initVars() {
-	_depth = 0;
 	_time = 0;
 	_timer = new IND_Timer();
-	for (int i = 0; i < 16; i++)
-		_tableTime [i] = 0;
+
+	_count = NULL;
+	_writer = NULL;
+
+	// A new id each time, so the lines freed by a previous end() are not used again
+	_lineId = SDL_TLSCreate();
+	_lines = NULL;
+	_slots = new LOG_SLOT [LOG_RING_SLOTS];
+	for (int i = 0; i < LOG_RING_SLOTS; i++)
+		SDL_AtomicSet(&_slots [i]._sequence, i);
+	SDL_AtomicSet(&_writeIndex, 0);
+	SDL_AtomicSet(&_readIndex, 0);
+	SDL_AtomicSet(&_quit, 0);
 }
 
 
@@ -408,9 +676,15 @@ void DebugApi::initVars() {
  * Free variables.
  */
 void DebugApi::freeVars() {
-#if !LOG_REDIRECT_TO_CONSOLE
-	DISPOSE(_count);
-#endif
+	LOG_LINE *mLine = static_cast<LOG_LINE *>(_lines);
+	while (mLine) {
+		LOG_LINE *mNext = mLine->_next;
+		delete mLine;
+		mLine = mNext;
+	}
+	_lines = NULL;
+
+	DISPOSEARRAY(_slots);
 	DISPOSE(_timer);
 }
 
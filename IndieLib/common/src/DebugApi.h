@@ -34,11 +34,15 @@
 
 
 #include <time.h>
+#include <stdio.h>
 
 #define ESP 3
 
 #include <fstream>
 
+#include "dependencies/SDL-2.0/include/SDL_atomic.h"
+#include "dependencies/SDL-2.0/include/SDL_thread.h"
+
 class IND_Timer;
 using namespace std;
 
@@ -48,7 +52,77 @@ using namespace std;
 #define LOG_REDIRECT_TO_CONSOLE 1
 #endif
 
-class IND_Timer;
+// ----- Log levels -----
+
+// Messages of a level above IND_LOG_LEVEL are removed at compile time (the arguments are not evaluated).
+// Define IND_LOG_LEVEL in the project settings to change it.
+#define IND_LOG_LEVEL_NONE      0
+#define IND_LOG_LEVEL_ERROR     1
+#define IND_LOG_LEVEL_WARNING   2
+#define IND_LOG_LEVEL_INFO      3      // Default: loading of resources, adding / removing entities...
+#define IND_LOG_LEVEL_VERBOSE   4      // Messages written each frame
+
+#ifndef IND_LOG_LEVEL
+#define IND_LOG_LEVEL IND_LOG_LEVEL_INFO
+#endif
+
+// Usage: IND_LOG_INFO(DebugApi::LogHeaderInfo, "Loading %s (%d x %d)", mName, mWidth, mHeight);
+#if IND_LOG_LEVEL >= IND_LOG_LEVEL_ERROR
+#define IND_LOG_ERROR(pType, ...)   g_debug->logf(pType, __VA_ARGS__)
+#else
+#define IND_LOG_ERROR(pType, ...)   ((void) 0)
+#endif
+
+#if IND_LOG_LEVEL >= IND_LOG_LEVEL_WARNING
+#define IND_LOG_WARNING(pType, ...) g_debug->logf(pType, __VA_ARGS__)
+#else
+#define IND_LOG_WARNING(pType, ...) ((void) 0)
+#endif
+
+#if IND_LOG_LEVEL >= IND_LOG_LEVEL_INFO
+#define IND_LOG_INFO(pType, ...)    g_debug->logf(pType, __VA_ARGS__)
+#else
+#define IND_LOG_INFO(pType, ...)    ((void) 0)
+#endif
+
+#if IND_LOG_LEVEL >= IND_LOG_LEVEL_VERBOSE
+#define IND_LOG_VERBOSE(pType, ...) g_debug->logf(pType, __VA_ARGS__)
+#else
+#define IND_LOG_VERBOSE(pType, ...) ((void) 0)
+#endif
+
+// ----- Ring buffer -----
+
+#define LOG_RING_SLOTS      256         // Must be a power of two
+#define LOG_SLOT_SIZE       512         // Max chars of each line (longer lines are split)
+#define LOG_FLUSH_DELAY     10          // Milliseconds the writer thread sleeps when there is nothing to write
+
+// Line of text waiting to be written by the writer thread.
+// _sequence tells the owner of the slot: the producer that reserved it or the writer thread.
+struct LOG_SLOT {
+	SDL_atomic_t _sequence;
+	int _length;
+	char _text [LOG_SLOT_SIZE];
+};
+
+// Line being composed by header() / dataChar() / dataInt()... Each thread has its own, so the lines
+// of different threads are never mixed: a line is copied to the ring buffer in one slot when it ends.
+struct LOG_LINE {
+	char _text [LOG_SLOT_SIZE];
+	int _length;
+
+	// Depth (increases with each "{" and goes down with each "}")
+	int _depth;
+
+	// Time table. After each BEGIN we introduce in this table taking in count the depth variable
+	// the current time. When we make the END, we substract in order to measure the time that have passed
+	// between the BEGIN and the END
+	// It is possible to make a total of 16 BEGIN/END
+	double _tableTime [16];
+
+	// Lines of all the threads, freed by end()
+	LOG_LINE *_next;
+};
 
 class DebugApi {
 public:
@@ -68,10 +142,18 @@ public:
 
 	// ----- Public methods -----
 
-	void header(string pData, int pType);
-	void dataChar(string pDataChar, bool pFlag);
+	void header(const char *pData, int pType);
+	void header(const string &pData, int pType) {
+		header(pData.c_str(), pType);
+	}
+	void dataChar(const char *pDataChar, bool pFlag);
+	void dataChar(const string &pDataChar, bool pFlag) {
+		dataChar(pDataChar.c_str(), pFlag);
+	}
 	void dataInt(int  pDataInt, bool pFlag);
 	void dataFloat(float pDataFloat, bool pFlag);
+	void logf(int pType, const char *pFormat, ...);
+	void flush();
 	void breakPoint();
 	char *duplicateCharString(const char *charString);
     
@@ -88,21 +170,20 @@ private:
 
 	bool _ok;
 
-	// Output debug file
-#if LOG_REDIRECT_TO_CONSOLE
-	ostream *_count;
-#else
-    ofstream *_count;
-#endif //LOG_REDIRECT_TO_CONSOLE
+	// Output debug file (only used by the writer thread once it is running)
+	FILE *_count;
 
-	// Depeth (increases with each  "{" and go down with each "}")
-	int _depth;
+	// Lines waiting to be written. Producers reserve slots with _writeIndex, the writer
+	// thread writes them in order and advances _readIndex.
+	LOG_SLOT *_slots;
+	SDL_atomic_t _writeIndex;
+	SDL_atomic_t _readIndex;
+	SDL_atomic_t _quit;
+	SDL_Thread *_writer;
 
-	// Time table. After each BEGIN we introduce in this table taking in count the depth variable
-	// the current time. When we make the END, we substract in order to measure the time that have passed
-	// between the BEGIN and the END
-	// It is possible to make a total of 16 BEGIN/END
-	double _tableTime [16];
+	// Line of each thread (thread local storage), and the list of all of them
+	SDL_TLSID _lineId;
+	void *_lines;
 
 	// Used for start/stop
 	unsigned long _time;
@@ -113,6 +194,15 @@ private:
 	void stop();
 	void allFont();
 
+	void append(const char *pText);
+	void appendf(const char *pFormat, ...);
+	void endLine();
+	LOG_LINE *getLine();
+	void pushLine(const char *pText, int pLength);
+	LOG_SLOT *reserveSlot(int *pPosition);
+	bool writeSlots();
+	static int writerThread(void *pDebugApi);
+
 	void initVars();
 	void freeVars();
 
@@ -122,4 +212,3 @@ private:
 /** @endcond */
 
 #endif // _DEBUGAPI_H_
-
@@ -0,0 +1,307 @@
+/*****************************************************************************************
+ * File: GlyphRasterizer.cpp
+ * Desc: Worker thread that rasterizes the glyphs of a TTF font
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+
+#include "GlyphRasterizer.h"
+#include FT_OUTLINE_H
+#include <math.h>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+//Coverage of a pixel of the glyph, 0 outside its bitmap
+static inline int coverageAt(const RasterizedGlyph *pGlyph, int pX, int pY) {
+	if (pX < 0 || pY < 0 || pX >= pGlyph->_width || pY >= pGlyph->_height)
+		return 0;
+	return pGlyph->_alpha [pY * pGlyph->_width + pX];
+}
+
+//Turns the coverage of a glyph into a signed distance field, with pSpread pixels of margin. The distance
+//of each pixel to the edge (half coverage) is mapped from [-pSpread, pSpread] to [0, 255]. The pixels on
+//the edge take it from their coverage, the rest from the nearest pixel on the other side.
+static void coverageToDistanceField(RasterizedGlyph *pGlyph, int pSpread) {
+	int mWidth = pGlyph->_width + 2 * pSpread;
+	int mHeight = pGlyph->_height + 2 * pSpread;
+	std::vector<unsigned char> mField(mWidth * mHeight);
+
+	for (int y = 0; y < mHeight; y++) {
+		for (int x = 0; x < mWidth; x++) {
+			int mCoverage = coverageAt(pGlyph, x - pSpread, y - pSpread);
+			bool mInside = mCoverage >= 128;
+			float mDistance;
+
+			if (mCoverage > 0 && mCoverage < 255) {
+				mDistance = mCoverage / 255.0f - 0.5f;
+			} else {
+				int mNearest = (pSpread + 1) * (pSpread + 1);
+				for (int j = -pSpread - 1; j <= pSpread + 1; j++) {
+					for (int i = -pSpread - 1; i <= pSpread + 1; i++) {
+						int mSquared = i * i + j * j;
+						if (mSquared < mNearest && (coverageAt(pGlyph, x - pSpread + i, y - pSpread + j) >= 128) != mInside)
+							mNearest = mSquared;
+					}
+				}
+				mDistance = sqrtf(static_cast<float>(mNearest)) - 0.5f;
+				if (!mInside)
+					mDistance = -mDistance;
+			}
+
+			float mValue = 0.5f + mDistance / (2.0f * pSpread);
+			if (mValue < 0.0f)
+				mValue = 0.0f;
+			if (mValue > 1.0f)
+				mValue = 1.0f;
+			mField [y * mWidth + x] = static_cast<unsigned char>(mValue * 255.0f + 0.5f);
+		}
+	}
+
+	pGlyph->_alpha.swap(mField);
+	pGlyph->_width = mWidth;
+	pGlyph->_height = mHeight;
+	pGlyph->_left -= pSpread;
+	pGlyph->_top += pSpread;
+}
+
+bool rasterizeGlyph(FT_Face pFace, bool pBold, const FT_Matrix *pItalic, int pSpread, wchar_t pCharCode, RasterizedGlyph *pGlyph) {
+	pGlyph->_charCode = pCharCode;
+	pGlyph->_glyphIndex = FT_Get_Char_Index(pFace, pCharCode);
+	if (pGlyph->_glyphIndex == 0)
+		return false;
+
+	if (FT_Load_Char(pFace, pCharCode, FT_LOAD_DEFAULT /*| FT_LOAD_NO_BITMAP*/))
+		return false;
+
+	// Bold
+	if (pBold)
+		FT_Outline_Embolden(&pFace->glyph->outline, 1 << 6);
+
+	// Italic
+	if (pItalic)
+		FT_Outline_Transform(&pFace->glyph->outline, pItalic);
+
+	if (FT_Render_Glyph(pFace->glyph, FT_RENDER_MODE_NORMAL))
+		return false;
+
+	FT_Bitmap *mBitmap = &pFace->glyph->bitmap;
+	if (mBitmap->width == 0 || mBitmap->rows == 0)
+		return false;
+
+	pGlyph->_advance = pFace->glyph->advance.x / 64;
+	pGlyph->_left = pFace->glyph->bitmap_left;
+	pGlyph->_top = pFace->glyph->bitmap_top;
+	pGlyph->_width = mBitmap->width;
+	pGlyph->_height = mBitmap->rows;
+	pGlyph->_alpha.assign(pGlyph->_width * pGlyph->_height, 0);
+
+	for (int y = 0; y < pGlyph->_height; y++) {
+		const unsigned char *mSrc = mBitmap->buffer + y * mBitmap->pitch;
+		unsigned char *mDst = &pGlyph->_alpha [y * pGlyph->_width];
+
+		for (int x = 0; x < pGlyph->_width; x++) {
+			switch (mBitmap->pixel_mode) {
+			case FT_PIXEL_MODE_GRAY:
+				mDst [x] = mSrc [x];
+				break;
+			case FT_PIXEL_MODE_MONO:
+				mDst [x] = (mSrc [x / 8] & (0x80 >> (x & 7))) ? 0xFF : 0x00;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	if (pSpread > 0)
+		coverageToDistanceField(pGlyph, pSpread);
+
+	return true;
+}
+
+//Opens its own face of the font and starts the worker thread.
+bool GlyphRasterizer::start(const std::string &pPath, int pSize, bool pBold, bool pItalic, int pSpread) {
+	stop();
+
+	if (FT_Init_FreeType(&_library))
+		return false;
+
+	if (FT_New_Face(_library, pPath.c_str(), 0, &_face) || FT_Set_Pixel_Sizes(_face, pSize, pSize)) {
+		FT_Done_FreeType(_library);
+		_library = NULL;
+		_face = NULL;
+		return false;
+	}
+
+	_bold = pBold;
+	_italic = pItalic;
+	_spread = pSpread;
+	_matItalic.xx = 1 << 16;
+	_matItalic.xy = 0x5800;
+	_matItalic.yx = 0;
+	_matItalic.yy = 1 << 16;
+
+	_quit = false;
+	_mutex = SDL_CreateMutex();
+	_cond = SDL_CreateCond();
+	_thread = SDL_CreateThread(workerThread, "IndieLib glyphs", this);
+
+	if (!_thread) {
+		stop();
+		return false;
+	}
+
+	return true;
+}
+
+//Stops the worker and frees the glyphs that weren't picked up.
+void GlyphRasterizer::stop() {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondSignal(_cond);
+		SDL_UnlockMutex(_mutex);
+
+		SDL_WaitThread(_thread, NULL);
+		_thread = NULL;
+	}
+
+	if (_cond) {
+		SDL_DestroyCond(_cond);
+		_cond = NULL;
+	}
+	if (_mutex) {
+		SDL_DestroyMutex(_mutex);
+		_mutex = NULL;
+	}
+
+	while (!_ready.empty()) {
+		delete _ready.front();
+		_ready.pop_front();
+	}
+	_requests.clear();
+	_inFlight.clear();
+	_missing.clear();
+
+	if (_library) {
+		FT_Done_FreeType(_library);             // Also frees _face
+		_library = NULL;
+		_face = NULL;
+	}
+}
+
+//Queues a char for the worker, unless it is already queued or the face can't render it.
+//Returns false if the char will never be ready.
+bool GlyphRasterizer::request(wchar_t pCharCode) {
+	if (!_thread)
+		return false;
+
+	SDL_LockMutex(_mutex);
+
+	bool mMissing = _missing.count(pCharCode) != 0;
+	if (!mMissing && _inFlight.insert(pCharCode).second) {
+		_requests.push_back(pCharCode);
+		SDL_CondSignal(_cond);
+	}
+
+	SDL_UnlockMutex(_mutex);
+
+	return !mMissing;
+}
+
+//Returns the next finished glyph, to be deleted by the caller, or NULL if there is none.
+RasterizedGlyph *GlyphRasterizer::popReady() {
+	if (!_thread)
+		return NULL;
+
+	RasterizedGlyph *mGlyph = NULL;
+
+	SDL_LockMutex(_mutex);
+
+	if (!_ready.empty()) {
+		mGlyph = _ready.front();
+		_ready.pop_front();
+		_inFlight.erase(mGlyph->_charCode);
+	}
+
+	SDL_UnlockMutex(_mutex);
+
+	return mGlyph;
+}
+
+//Marks a char as one that can't be rendered (i.e. its surface couldn't be created), so it is never requested again.
+void GlyphRasterizer::setMissing(wchar_t pCharCode) {
+	if (!_thread)
+		return;
+
+	SDL_LockMutex(_mutex);
+	_missing.insert(pCharCode);
+	SDL_UnlockMutex(_mutex);
+}
+
+int GlyphRasterizer::workerThread(void *pRasterizer) {
+	static_cast<GlyphRasterizer *>(pRasterizer)->run();
+	return 0;
+}
+
+void GlyphRasterizer::run() {
+	for (;;) {
+		SDL_LockMutex(_mutex);
+
+		while (!_quit && _requests.empty())
+			SDL_CondWait(_cond, _mutex);
+
+		if (_quit) {
+			SDL_UnlockMutex(_mutex);
+			return;
+		}
+
+		wchar_t mCharCode = _requests.front();
+		_requests.pop_front();
+
+		SDL_UnlockMutex(_mutex);
+
+		// The face is only touched by this thread while it runs
+		RasterizedGlyph *mGlyph = new RasterizedGlyph;
+		bool mOk = rasterizeGlyph(_face, _bold, _italic ? &_matItalic : NULL, _spread, mCharCode, mGlyph);
+
+		SDL_LockMutex(_mutex);
+
+		if (mOk) {
+			_ready.push_back(mGlyph);
+		} else {
+			_inFlight.erase(mCharCode);
+			_missing.insert(mCharCode);
+			delete mGlyph;
+		}
+
+		SDL_UnlockMutex(_mutex);
+	}
+}
+
+/** @endcond */
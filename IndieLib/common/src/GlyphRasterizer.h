@@ -0,0 +1,132 @@
+/*****************************************************************************************
+ * File: GlyphRasterizer.h
+ * Desc: Worker thread that rasterizes the glyphs of a TTF font
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _GLYPHRASTERIZER
+#define _GLYPHRASTERIZER
+
+//Library dependencies
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include "dependencies/SDL-2.0/include/SDL_mutex.h"
+#include "dependencies/SDL-2.0/include/SDL_thread.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// A glyph rendered by FreeType, copied out of the face so that it can cross threads
+struct RasterizedGlyph {
+	wchar_t _charCode;                      // Unicode char value
+	unsigned int _glyphIndex;               // Glyph index in the font face
+	unsigned int _advance;                  // Advance in pixels
+	int _left;                              // Left bearing of the bitmap
+	int _top;                               // Top bearing of the bitmap
+	int _width;                             // Bitmap size
+	int _height;
+	std::vector<unsigned char> _alpha;      // _width * _height coverage values, row by row
+};
+
+// Renders a char of a face (with the bold and italic styles of IND_TTF_Font) into pGlyph. With a spread,
+// the coverage is turned into a signed distance field with pSpread pixels of margin around the glyph.
+// Returns false if the face has no glyph for it, or its bitmap is empty.
+bool rasterizeGlyph(FT_Face pFace, bool pBold, const FT_Matrix *pItalic, int pSpread, wchar_t pCharCode, RasterizedGlyph *pGlyph);
+
+// Rasterizes the requested chars in its own thread, with its own FreeType library and face (FreeType
+// objects can't be shared between threads). The owner requests chars and picks up the finished glyphs
+// with popReady(); surfaces are still created by the owner, in the render thread.
+class GlyphRasterizer {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	GlyphRasterizer():
+		_thread(NULL),
+		_mutex(NULL),
+		_cond(NULL),
+		_quit(false),
+		_library(NULL),
+		_face(NULL),
+		_bold(false),
+		_italic(false),
+		_spread(0) {
+	}
+	~GlyphRasterizer() {
+		stop();
+	}
+
+	//----- OTHER FUNCTIONS -----
+
+	bool start(const std::string &pPath, int pSize, bool pBold, bool pItalic, int pSpread);
+	void stop();
+	bool isRunning() {
+		return _thread != NULL;
+	}
+	bool request(wchar_t pCharCode);
+	RasterizedGlyph *popReady();
+	void setMissing(wchar_t pCharCode);
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	SDL_Thread *_thread;
+	SDL_mutex *_mutex;                      // Guards the containers below and _quit
+	SDL_cond *_cond;                        // Signaled when there are requests or on stop()
+	bool _quit;
+
+	FT_Library _library;                    // Only used by the worker once started
+	FT_Face _face;
+	bool _bold;
+	bool _italic;
+	FT_Matrix _matItalic;
+	int _spread;                            // Spread of the distance fields, 0 for coverage
+
+	std::deque<wchar_t> _requests;          // Chars waiting for the worker
+	std::set<wchar_t> _inFlight;            // Requested and not popped yet, for requesting each char once
+	std::set<wchar_t> _missing;             // Chars the face can't render, never requested again
+	std::deque<RasterizedGlyph *> _ready;   // Finished glyphs waiting for popReady()
+
+	//----- INTERNAL FUNCTIONS -----
+
+	static int workerThread(void *pRasterizer);
+	void run();
+
+	// Not copyable, the thread points to it
+	GlyphRasterizer(const GlyphRasterizer &);
+	GlyphRasterizer &operator=(const GlyphRasterizer &);
+};
+
+/** @endcond */
+
+#endif
@@ -80,6 +80,8 @@ IND_Surface *IND_Animation::getSurface(unsigned int pFrame) {
 	vector<IND_Frame*> *frames = getVectorFrames();
 	if (frames && frames->size() > pFrame) {
 		 surf = (*frames) [pFrame]->getSurface();
+		 if (!surf)
+			 surf = (*frames) [pFrame]->getAtlas();
 	}
 	return surf;
 }
@@ -136,6 +138,147 @@ const char* const IND_Animation::getName(unsigned int pSequence) {
     }
 }
 
+/**
+ * Get the position of a frame of the sequence in the vector of frames of the animation
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+unsigned int IND_Animation::getFramePosInVec(unsigned int pSequence, unsigned int pFrame) {
+	unsigned int framePos = 0;
+	vector <IND_Sequence *> *sequences = getListSequences();
+	if (sequences && sequences->size() > pSequence && (*sequences) [pSequence]->getListFrames()->size() > pFrame) {
+		framePos = (*sequences) [pSequence]->getFramePosInVec(pFrame);
+	}
+	return framePos;
+}
+
+/**
+ * Get the time, in milliseconds, that a frame of the sequence is displayed
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+unsigned int IND_Animation::getFrameTime(unsigned int pSequence, unsigned int pFrame) {
+	unsigned int frameTime = 0;
+	vector <IND_Sequence *> *sequences = getListSequences();
+	if (sequences && sequences->size() > pSequence && (*sequences) [pSequence]->getListFrames()->size() > pFrame) {
+		frameTime = (*sequences) [pSequence]->getFrameTime(pFrame);
+	}
+	return frameTime;
+}
+
+/**
+ * Get the horizontal offset of a frame of the sequence
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+unsigned int IND_Animation::getFrameOffsetX(unsigned int pSequence, unsigned int pFrame) {
+	unsigned int offset = 0;
+	vector<IND_Frame*> *frames = getVectorFrames();
+	unsigned int framePos = getFramePosInVec(pSequence, pFrame);
+	if (frames && frames->size() > framePos) {
+		offset = (*frames) [framePos]->GetOffsetX();
+	}
+	return offset;
+}
+
+/**
+ * Get the vertical offset of a frame of the sequence
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+unsigned int IND_Animation::getFrameOffsetY(unsigned int pSequence, unsigned int pFrame) {
+	unsigned int offset = 0;
+	vector<IND_Frame*> *frames = getVectorFrames();
+	unsigned int framePos = getFramePosInVec(pSequence, pFrame);
+	if (frames && frames->size() > framePos) {
+		offset = (*frames) [framePos]->GetOffsetY();
+	}
+	return offset;
+}
+
+/**
+ * Get the surface of a frame of the sequence
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+IND_Surface *IND_Animation::getFrameSurface(unsigned int pSequence, unsigned int pFrame) {
+	return getSurface(getFramePosInVec(pSequence, pFrame));
+}
+
+/**
+ * Get the width of a frame of the sequence
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+int IND_Animation::getFrameWidth(unsigned int pSequence, unsigned int pFrame) {
+	int width = 0;
+	vector<IND_Frame*> *frames = getVectorFrames();
+	unsigned int framePos = getFramePosInVec(pSequence, pFrame);
+	if (frames && frames->size() > framePos) {
+		width = (*frames) [framePos]->getWidth();
+	}
+	return width;
+}
+
+/**
+ * Get the height of a frame of the sequence
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+int IND_Animation::getFrameHeight(unsigned int pSequence, unsigned int pFrame) {
+	int height = 0;
+	vector<IND_Frame*> *frames = getVectorFrames();
+	unsigned int framePos = getFramePosInVec(pSequence, pFrame);
+	if (frames && frames->size() > framePos) {
+		height = (*frames) [framePos]->getHeight();
+	}
+	return height;
+}
+
+/**
+ * Get the atlas page where a frame of the sequence is packed (see IND_AnimationManager::setAtlas()).
+ * Returns NULL if the frame has a surface of its own. pX, pY, pWidth and pHeight receive a region
+ * of the frame (all 0 for the whole frame) and return the rectangle of the atlas page to blit, which
+ * is empty when the region only covers trimmed borders. pDrawX and pDrawY return where the rectangle
+ * is drawn, relative to the frame origin (the offset of the frame not included).
+ * @param pSequence			The sequence number of a sequence in the list of sequences.
+ * @param pFrame			The frame number in the sequence.
+ */
+IND_Surface *IND_Animation::getFrameAtlas(unsigned int pSequence, unsigned int pFrame, int *pX, int *pY, int *pWidth, int *pHeight, int *pDrawX, int *pDrawY) {
+	vector<IND_Frame*> *frames = getVectorFrames();
+	unsigned int framePos = getFramePosInVec(pSequence, pFrame);
+	if (!frames || frames->size() <= framePos)
+		return NULL;
+
+	IND_Frame *frame = (*frames) [framePos];
+	if (frame->getSurface() || !frame->getAtlas())
+		return NULL;
+
+	// Region of the frame, the whole frame by default
+	int x1 = *pX + *pWidth;
+	int y1 = *pY + *pHeight;
+	if (!*pX && !*pY && !*pWidth && !*pHeight) {
+		x1 = frame->getWidth();
+		y1 = frame->getHeight();
+	}
+
+	// Clipped to the part of the frame kept in the atlas
+	IND_Frame::A_FRAME &data = frame->_frame;
+	int cx0 = *pX > data._trimX ? *pX : data._trimX;
+	int cy0 = *pY > data._trimY ? *pY : data._trimY;
+	int cx1 = x1 < data._trimX + data._atlasWidth ? x1 : data._trimX + data._atlasWidth;
+	int cy1 = y1 < data._trimY + data._atlasHeight ? y1 : data._trimY + data._atlasHeight;
+
+	*pDrawX = cx0 - *pX;
+	*pDrawY = cy0 - *pY;
+	*pX = data._atlasX + cx0 - data._trimX;
+	*pY = data._atlasY + cy0 - data._trimY;
+	*pWidth = cx1 > cx0 ? cx1 - cx0 : 0;
+	*pHeight = cy1 > cy0 ? cy1 - cy0 : 0;
+
+	return data._atlas;
+}
+
 /**
  * Get the current position of the frame in the list of frames of the sequence
  * @param pSequence			The sequence number of a sequence in the list of sequences.
@@ -154,12 +297,7 @@ unsigned int IND_Animation::getActualFramePos(unsigned int pSequence) {
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
 unsigned int IND_Animation::getActualFramePosInVec(unsigned int pSequence) {
-	unsigned int framePos = 0;
-	vector <IND_Sequence *> *sequences = getListSequences();
-	if (sequences && sequences->size() > pSequence) {
-		framePos = (*sequences) [pSequence]->getActualFramePosInVec();
-	}
-	return framePos;
+	return getFramePosInVec(pSequence, getActualFramePos(pSequence));
 }
 
 /**
@@ -167,12 +305,7 @@ unsigned int IND_Animation::getActualFramePosInVec(unsigned int pSequence) {
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
 unsigned int IND_Animation::getActualFrameTime(unsigned int pSequence) {
-	unsigned int frameTime = 0;
-	vector <IND_Sequence *> *sequences = getListSequences();
-	if (sequences && sequences->size() > pSequence) {
-		frameTime = (*sequences) [pSequence]->getActualFrameTime();
-	}
-	return frameTime;
+	return getFrameTime(pSequence, getActualFramePos(pSequence));
 }
 
 /**
@@ -180,11 +313,7 @@ unsigned int IND_Animation::getActualFrameTime(unsigned int pSequence) {
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
 unsigned int IND_Animation::getActualOffsetX(unsigned int pSequence) {
-	unsigned int offset = 0;
-	if (getVectorFrames() && getListSequences()) {
-		offset = (*getVectorFrames()) [(*getListSequences()) [pSequence]->getActualFramePosInVec()]->GetOffsetX();
-	}
-	return offset;
+	return getFrameOffsetX(pSequence, getActualFramePos(pSequence));
 }
 
 /**
@@ -192,12 +321,7 @@ unsigned int IND_Animation::getActualOffsetX(unsigned int pSequence) {
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
 unsigned int IND_Animation::getActualOffsetY(unsigned int pSequence) {
-	unsigned int offset = 0;
-	vector<IND_Frame*> *frames = getVectorFrames();
-	if (frames && frames->size() > pSequence && getListSequences()) {
-		offset = (*frames) [(*getListSequences()) [pSequence]->getActualFramePosInVec()]->GetOffsetY();
-	}
-	return offset;
+	return getFrameOffsetY(pSequence, getActualFramePos(pSequence));
 }
 
 /**
@@ -205,14 +329,7 @@ unsigned int IND_Animation::getActualOffsetY(unsigned int pSequence) {
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
 IND_Surface *IND_Animation::getActualSurface(unsigned int pSequence) {
-	IND_Surface* actualSurf = NULL;
-	vector<IND_Frame*> *frames = getVectorFrames();
-	vector <IND_Sequence *> *sequences = getListSequences();
-	if (frames && frames->size() > pSequence && sequences && sequences->size() > pSequence) {
-		actualSurf = (*getVectorFrames()) [(*getListSequences()) [pSequence]->getActualFramePosInVec()]->getSurface();
-	}
-
-	return actualSurf;
+	return getFrameSurface(pSequence, getActualFramePos(pSequence));
 }
 
 /**
@@ -228,16 +345,16 @@ void IND_Animation::setActualFramePos(unsigned int pSequence, unsigned int pPos)
 }
 
 /**
- * TODO describtion.
+ * Returns the time, in milliseconds, that the actual frame of the sequence has been displayed.
  * @param pSequence			The sequence number of a sequence in the list of sequences.
  */
-IND_Timer *IND_Animation::getSequenceTimer(unsigned int pSequence) {
-	IND_Timer* timer = NULL;
+float IND_Animation::getElapsedTime(unsigned int pSequence) {
+	float time = 0.0f;
 	vector <IND_Sequence *> *sequences = getListSequences();
 	if (sequences && sequences->size() > pSequence) {
-		timer = (*sequences) [pSequence]->getSequenceTimer();
+		time = (*sequences) [pSequence]->getPlayback()->_elapsedTime;
 	}
-	return timer;
+	return time;
 }
 
 /**
@@ -288,3 +405,69 @@ void IND_Animation::setSurface(unsigned int pFrame, IND_Surface *pNewSurface) {
 		(*getVectorFrames()) [pFrame]->setSurface(pNewSurface);
 	}
 }
+
+// --------------------------------------------------------------------------------
+//							       Private methods
+// --------------------------------------------------------------------------------
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+/*
+==================
+Advances the actual frame of a sequence (the one used by IND_Render::blitAnimation()).
+Returns -1 when the last frame of the sequence has finished, 1 otherwise.
+==================
+*/
+int IND_Animation::updateSequence(unsigned int pSequence, double pClock) {
+	vector <IND_Sequence *> *sequences = getListSequences();
+	if (!sequences || sequences->size() <= pSequence)
+		return 1;
+
+	return updateSequence(pSequence, (*sequences) [pSequence]->getPlayback(), pClock);
+}
+
+/*
+==================
+Advances a playback of a sequence. pClock is the animation clock of IND_Render (in milliseconds),
+taken once per frame in IND_Render::beginScene(), so no timer is read here. The animation itself
+is not modified, so the same animation can be played by any number of entities.
+Returns -1 when the last frame of the sequence has finished, 1 otherwise.
+==================
+*/
+int IND_Animation::updateSequence(unsigned int pSequence, SEQUENCE_PLAYBACK *pPlayback, double pClock) {
+	vector <IND_Sequence *> *sequences = getListSequences();
+	if (!sequences || sequences->size() <= pSequence)
+		return 1;
+
+	IND_Sequence *mSequence = (*sequences) [pSequence];
+
+	// The playback starts now
+	if (!pPlayback->_isActive) {
+		pPlayback->_lastClock = pClock;
+		pPlayback->_elapsedTime = 0.0f;
+		pPlayback->_isActive = true;
+	}
+
+	// Accumulate the time passed since the last update
+	pPlayback->_elapsedTime += static_cast<float>(pClock - pPlayback->_lastClock);
+	pPlayback->_lastClock = pClock;
+
+	// If the time of a frame have passed, go to the next frame
+	if (pPlayback->_elapsedTime > mSequence->getFrameTime(pPlayback->_frame)) {
+		pPlayback->_elapsedTime = 0.0f;
+
+		// Point to the next frame increasing the counter
+		pPlayback->_frame++;
+
+		// If the counter is higher than the number of frames of the sequence, we stay in the last one
+		if (pPlayback->_frame > mSequence->getNumFrames() - 1) {
+			pPlayback->_frame = mSequence->getNumFrames() - 1;
+			pPlayback->_isActive = false;
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+/** @endcond */
@@ -44,8 +44,24 @@
 #include "IND_Surface.h"
 #include "IND_Timer.h"
 #include "CollisionParser.h"
+#include "AnimationBundle.h"
+#include "MappedFile.h"
 
 #include <string>
+#include <algorithm>
+
+// Maximum size of an atlas page (frames bigger than a page keep a surface of their own)
+static const int ATLAS_PAGE_SIZE = 2048;
+
+// Name of the bundle variant of an animation script (same name, .anb extension)
+static string getBundleName(const char *pAnimationName) {
+	string mName (pAnimationName);
+	size_t mDot = mName.find_last_of('.');
+	size_t mSlash = mName.find_last_of("\\/");
+	if (mDot != string::npos && (mSlash == string::npos || mDot > mSlash))
+		mName.erase(mDot);
+	return mName + ANIMATION_BUNDLE_EXTENSION;
+}
 
 
 // --------------------------------------------------------------------------------
@@ -129,10 +145,17 @@ bool IND_AnimationManager::addToSurface(IND_Animation *pNewAnimation,
 	if (!addToImage(pNewAnimation, pAnimation))
 		return 0;
 
+	if (_atlas)
+		packAtlas(pNewAnimation, pType, pQuality);
+
 	for (unsigned int i = 0; i < pNewAnimation->getNumTotalFrames(); i++) {
 		// Pointer to the image
 		IND_Image *ActualImage = pNewAnimation->getImage(i);
 
+		// Frame already packed into an atlas page
+		if (!ActualImage)
+			continue;
+
 		// Creation of the surface
 		IND_Surface *mNewSurface = IND_Surface::newSurface();
 		_surfaceManager->add(mNewSurface, ActualImage, pType, pQuality);
@@ -176,13 +199,22 @@ bool IND_AnimationManager::addToSurface(IND_Animation *pNewAnimation,
 	if (IND_ALPHA != pType) 
 		return 0;
 
+	// Color key
+	for (unsigned int i = 0; i < pNewAnimation->getNumTotalFrames(); i++) {
+		pNewAnimation->getImage(i)->setAlpha(pR,pG,pB);
+	}
+
+	if (_atlas)
+		packAtlas(pNewAnimation, pType, pQuality);
+
 	for (unsigned int i = 0; i < pNewAnimation->getNumTotalFrames(); i++) {
 		// Pointer to the image
 		IND_Image *mCurrentImage = pNewAnimation->getImage(i);
 
-		// Color key
-		mCurrentImage->setAlpha(pR,pG,pB);
-		
+		// Frame already packed into an atlas page
+		if (!mCurrentImage)
+			continue;
+
 		// Creation of the surface
 		IND_Surface *mNewSurface = IND_Surface::newSurface();
 		_surfaceManager->add(mNewSurface, mCurrentImage, pType, pQuality);
@@ -301,9 +333,17 @@ bool IND_AnimationManager::addToImage(IND_Animation *pNewAnimation, const char *
 		return 0;
 	}
 	
-	// ----- Animation file parsing -----
+	// ----- Animation bundle (or file parsing) -----
+
+	// The binary bundle made with saveBundle() is used when it exists. A bundle made from an older
+	// version of the script is ignored (the script is parsed), or made again if setRebuildBundles() says so.
+	string mBundleName = getBundleName(pAnimation);
+	bool mStale = false;
+	bool mLoaded = loadBundle(pNewAnimation, mBundleName.c_str(), pAnimation, &mStale);
+	if (!mLoaded && mStale && _rebuildBundles && saveBundle(pAnimation, mBundleName.c_str()))
+		mLoaded = loadBundle(pNewAnimation, mBundleName.c_str(), pAnimation, &mStale);
 
-	if (!parseAnimation(pNewAnimation, pAnimation)) {
+	if (!mLoaded && !parseAnimation(pNewAnimation, pAnimation)) {
 		g_debug->header("Fatal error, cannot load the animation xml file", DebugApi::LogHeaderError);
 		return 0;
 	}
@@ -336,6 +376,221 @@ bool IND_AnimationManager::remove(IND_Animation *pAn) {
 }
 
 
+/**
+ * Converts an animation xml script into a binary animation bundle, returning 1 (true) if the
+ * bundle is written successfully. The bundle holds the frames, sequences, times, bounding
+ * collisions and the pixels of all the frames packed into one atlas, so loading it needs a single
+ * file. When a bundle with the name of the script and .anb extension exists (for example
+ * "character.anb" for "character.xml"), the add methods of this manager load it instead of the
+ * script. The bundle stores the modification time of the script: when the script changes, the add
+ * methods parse the script instead, until the bundle is made again (see setRebuildBundles()). It must
+ * be made again by hand when only the images change.
+ * @param pAnimation				Name of the animation XML script.
+ * @param pBundle					Name of the bundle file (.anb) to write.
+ */
+bool IND_AnimationManager::saveBundle(const char *pAnimation, const char *pBundle) {
+	g_debug->header("Saving animation bundle", DebugApi::LogHeaderBegin);
+	g_debug->header("File name:", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(pAnimation, 1);
+
+	if (!_ok) {
+		writeMessage();
+		return 0;
+	}
+
+	IND_Animation *mAnimation = IND_Animation::newAnimation();
+	if (!parseAnimation(mAnimation, pAnimation)) {
+		g_debug->header("Fatal error, cannot load the animation xml file", DebugApi::LogHeaderError);
+		freeFrames(mAnimation);
+		DISPOSEMANAGED(mAnimation);
+		return 0;
+	}
+
+	vector <IND_Frame *> *mFrames = mAnimation->getVectorFrames();
+	vector <IND_Sequence *> *mSequences = mAnimation->getListSequences();
+	int mNumFrames = static_cast<int>(mFrames->size());
+
+	// ----- Tables -----
+
+	string mNames;
+	vector <BUNDLE_FRAME> mBundleFrames (mNumFrames);
+	vector <BUNDLE_COLLISION> mBundleCollisions;
+	vector <BUNDLE_SEQUENCE> mBundleSequences;
+	vector <BUNDLE_FRAME_TIME> mBundleFrameTimes;
+	vector <int> mWidths (mNumFrames);
+	vector <int> mHeights (mNumFrames);
+
+	for (int i = 0; i < mNumFrames; i++) {
+		IND_Frame *mFrame = (*mFrames) [i];
+
+		// All the frames are stored with 32 bpp
+		mFrame->getImage()->convert(IND_RGBA, 32);
+
+		BUNDLE_FRAME &mBundleFrame = mBundleFrames [i];
+		mBundleFrame._name = static_cast<int>(mNames.size());
+		mNames.append(mFrame->getName()).push_back('\0');
+		mBundleFrame._width = mWidths [i] = mFrame->getImage()->getWidth();
+		mBundleFrame._height = mHeights [i] = mFrame->getImage()->getHeight();
+		mBundleFrame._offsetX = mFrame->GetOffsetX();
+		mBundleFrame._offsetY = mFrame->GetOffsetY();
+		mBundleFrame._firstCollision = static_cast<int>(mBundleCollisions.size());
+		mBundleFrame._numCollisions = static_cast<int>(mFrame->GetListBoundingCollision()->size());
+
+		list <BOUNDING_COLLISION *>::iterator mCollisionIter;
+		for (mCollisionIter  = mFrame->GetListBoundingCollision()->begin();
+		        mCollisionIter != mFrame->GetListBoundingCollision()->end();
+		        mCollisionIter++) {
+			BOUNDING_COLLISION *mCollision = *mCollisionIter;
+			BUNDLE_COLLISION mBundleCollision;
+			mBundleCollision._type = mCollision->getType();
+			mBundleCollision._id = static_cast<int>(mNames.size());
+			mNames.append(mCollision->getId()).push_back('\0');
+			mBundleCollision._posX = mCollision->_posX;
+			mBundleCollision._posY = mCollision->_posY;
+			mBundleCollision._radius = mCollision->_radius;
+			mBundleCollision._ax = mCollision->_ax;
+			mBundleCollision._ay = mCollision->_ay;
+			mBundleCollision._bx = mCollision->_bx;
+			mBundleCollision._by = mCollision->_by;
+			mBundleCollision._cx = mCollision->_cx;
+			mBundleCollision._cy = mCollision->_cy;
+			mBundleCollisions.push_back(mBundleCollision);
+		}
+	}
+
+	for (unsigned int i = 0; i < mSequences->size(); i++) {
+		IND_Sequence *mSequence = (*mSequences) [i];
+
+		BUNDLE_SEQUENCE mBundleSequence;
+		mBundleSequence._name = static_cast<int>(mNames.size());
+		mNames.append(mSequence->getName()).push_back('\0');
+		mBundleSequence._firstFrameTime = static_cast<int>(mBundleFrameTimes.size());
+		mBundleSequence._numFrameTimes = mSequence->getNumFrames();
+		mBundleSequences.push_back(mBundleSequence);
+
+		for (int j = 0; j < mSequence->getNumFrames(); j++) {
+			BUNDLE_FRAME_TIME mBundleFrameTime;
+			mBundleFrameTime._frame = (*mSequence->getListFrames()) [j]->_pos;
+			mBundleFrameTime._time = (*mSequence->getListFrames()) [j]->_time;
+			mBundleFrameTimes.push_back(mBundleFrameTime);
+		}
+	}
+
+	// Names area is padded, so the atlas is aligned
+	while (mNames.size() % 4)
+		mNames.push_back('\0');
+
+	// ----- Atlas -----
+
+	vector <int> mX (mNumFrames);
+	vector <int> mY (mNumFrames);
+	BUNDLE_HEADER mHeader;
+	AnimationBundle::packFrames(mNumFrames, &mWidths [0], &mHeights [0], &mX [0], &mY [0], &mHeader._atlasWidth, &mHeader._atlasHeight);
+
+	vector <unsigned char> mAtlas (mHeader._atlasWidth * mHeader._atlasHeight * 4, 0);
+	for (int i = 0; i < mNumFrames; i++) {
+		mBundleFrames [i]._x = mX [i];
+		mBundleFrames [i]._y = mY [i];
+
+		// 32 bpp FreeImage lines have no padding
+		unsigned char *mSrc = (*mFrames) [i]->getImage()->getPointer();
+		for (int y = 0; y < mHeights [i]; y++) {
+			memcpy(&mAtlas [((mY [i] + y) * mHeader._atlasWidth + mX [i]) * 4], mSrc + y * mWidths [i] * 4, mWidths [i] * 4);
+		}
+	}
+
+	// ----- Header -----
+
+	mHeader._magic = ANIMATION_BUNDLE_MAGIC;
+	mHeader._version = ANIMATION_BUNDLE_VERSION;
+	mHeader._scriptTime = MappedFile::getModificationTime(pAnimation);
+	mHeader._numFrames = mNumFrames;
+	mHeader._numCollisions = static_cast<int>(mBundleCollisions.size());
+	mHeader._numSequences = static_cast<int>(mBundleSequences.size());
+	mHeader._numFrameTimes = static_cast<int>(mBundleFrameTimes.size());
+	mHeader._framesOffset = sizeof(BUNDLE_HEADER);
+	mHeader._collisionsOffset = mHeader._framesOffset + mHeader._numFrames * sizeof(BUNDLE_FRAME);
+	mHeader._sequencesOffset = mHeader._collisionsOffset + mHeader._numCollisions * sizeof(BUNDLE_COLLISION);
+	mHeader._frameTimesOffset = mHeader._sequencesOffset + mHeader._numSequences * sizeof(BUNDLE_SEQUENCE);
+	mHeader._namesOffset = mHeader._frameTimesOffset + mHeader._numFrameTimes * sizeof(BUNDLE_FRAME_TIME);
+	mHeader._atlasOffset = mHeader._namesOffset + static_cast<int>(mNames.size());
+
+	freeFrames(mAnimation);
+	DISPOSEMANAGED(mAnimation);
+
+	// ----- Writing -----
+
+	::FILE *mFile = fopen(pBundle, "wb");
+	if (!mFile) {
+		g_debug->header("Cannot write the bundle file", DebugApi::LogHeaderError);
+		return 0;
+	}
+
+	fwrite(&mHeader, sizeof(BUNDLE_HEADER), 1, mFile);
+	if (mNumFrames)
+		fwrite(&mBundleFrames [0], sizeof(BUNDLE_FRAME), mBundleFrames.size(), mFile);
+	if (!mBundleCollisions.empty())
+		fwrite(&mBundleCollisions [0], sizeof(BUNDLE_COLLISION), mBundleCollisions.size(), mFile);
+	if (!mBundleSequences.empty())
+		fwrite(&mBundleSequences [0], sizeof(BUNDLE_SEQUENCE), mBundleSequences.size(), mFile);
+	if (!mBundleFrameTimes.empty())
+		fwrite(&mBundleFrameTimes [0], sizeof(BUNDLE_FRAME_TIME), mBundleFrameTimes.size(), mFile);
+	fwrite(mNames.data(), 1, mNames.size(), mFile);
+	if (!mAtlas.empty())
+		fwrite(&mAtlas [0], 1, mAtlas.size(), mFile);
+
+	bool mOk = !ferror(mFile);
+	fclose(mFile);
+
+	if (!mOk) {
+		g_debug->header("Cannot write the bundle file", DebugApi::LogHeaderError);
+		return 0;
+	}
+
+	g_debug->header("Bundle:", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(pBundle, 1);
+	g_debug->header("Frames atlas:", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(mHeader._atlasWidth, 0);
+	g_debug->dataChar("x", 0);
+	g_debug->dataInt(mHeader._atlasHeight, 1);
+	g_debug->header("Animation bundle saved", DebugApi::LogHeaderEnd);
+
+	return 1;
+}
+
+
+/**
+ * Sets if the frames of the animations added with the addToSurface() methods that don't specify a
+ * block size are packed into atlas pages. By default each frame has its own ::IND_Surface, so drawing
+ * an animation changes of texture on every frame. In an atlas, all the frames of an animation share
+ * one or a few textures (of 2048x2048 pixels at most) and each frame is drawn as a rectangle of its
+ * page, keeping the frame offsets. Frames bigger than a page keep their own surface.
+ *
+ * When pTrim is true, the transparent borders of the frames are not stored in the atlas, so they use
+ * less texture memory and less pixels are drawn. The size of the frames doesn't change.
+ *
+ * The frames of an atlas can be blitted entirely or by regions, but not wrapped (see
+ * IND_Entity2d::toggleWrap()). It only affects the animations added after calling this method.
+ * @param pAtlas				True for packing the frames into atlas pages.
+ * @param pTrim					True for trimming the transparent borders of the frames.
+ */
+void IND_AnimationManager::setAtlas(bool pAtlas, bool pTrim) {
+	_atlas = pAtlas;
+	_atlasTrim = pTrim;
+}
+
+/**
+ * Sets if the add methods make again, with saveBundle(), the animation bundles that are stale (made
+ * from an older version of their script) or invalid. The bundle is written next to the script, so
+ * the directory of the animations must be writable. By default the add methods don't write any file:
+ * they parse the script and the stale bundles are made again with saveBundle() or the tools.
+ * @param pRebuild				True for making the stale bundles again when they are added.
+ */
+void IND_AnimationManager::setRebuildBundles(bool pRebuild) {
+	_rebuildBundles = pRebuild;
+}
+
+
 // --------------------------------------------------------------------------------
 //									Private methods
 // --------------------------------------------------------------------------------
@@ -578,7 +833,6 @@ bool IND_AnimationManager::parseAnimation(IND_Animation *pNewAnimation, const ch
 		if (mXSequence->Attribute("name")) {
 			mNewSequence = new IND_Sequence();
 			mNewSequence->setName(mXSequence->Attribute("name"));
-            mNewSequence->getSequenceTimer()->start();
 		} else {
 			g_debug->header("The sequence doesn't have a \"name\" attribute", DebugApi::LogHeaderError);
 			mXmlDoc->Clear();
@@ -658,6 +912,165 @@ bool IND_AnimationManager::parseAnimation(IND_Animation *pNewAnimation, const ch
 }
 
 
+/**
+ * Loads a binary animation bundle (see saveBundle()). The file is memory mapped and the images
+ * of the frames are copied from the atlas, so all the data is read with one file open. Returns
+ * 0 (false), without modifying the animation, if the bundle doesn't exist, is not valid, or is
+ * stale: it was made from a script with another modification time (a missing script is not
+ * checked, so bundles can be shipped without their scripts). Invalid bundles of an existing
+ * script are reported as stale too, so the ones of older versions are made again.
+ * @param pNewAnimation				The animation where the bundle is loaded.
+ * @param pBundleName				Name of the bundle file.
+ * @param pAnimationName			Name of the script the bundle was made from.
+ * @param pStale					Set to true if the bundle is stale.
+ */
+bool IND_AnimationManager::loadBundle(IND_Animation *pNewAnimation, const char *pBundleName, const char *pAnimationName, bool *pStale) {
+	*pStale = false;
+
+	MappedFile mFile;
+	if (!mFile.open(pBundleName))
+		return 0;
+
+	const unsigned char *mData = mFile.getData();
+	int mSize = mFile.getSize();
+	const BUNDLE_HEADER *mHeader = AnimationBundle::getHeader(mData, mSize);
+	unsigned int mScriptTime = MappedFile::getModificationTime(pAnimationName);
+	if (!mHeader) {
+		g_debug->header("Invalid animation bundle:", DebugApi::LogHeaderWarning);
+		g_debug->dataChar(pBundleName, 1);
+		*pStale = (mScriptTime != 0);
+		return 0;
+	}
+
+	if (mScriptTime && mScriptTime != mHeader->_scriptTime) {
+		g_debug->header("Stale animation bundle, the script changed:", DebugApi::LogHeaderWarning);
+		g_debug->dataChar(pBundleName, 1);
+		*pStale = true;
+		return 0;
+	}
+
+	const BUNDLE_FRAME *mFrames = reinterpret_cast<const BUNDLE_FRAME *>(mData + mHeader->_framesOffset);
+	const BUNDLE_COLLISION *mCollisions = reinterpret_cast<const BUNDLE_COLLISION *>(mData + mHeader->_collisionsOffset);
+	const BUNDLE_SEQUENCE *mSequences = reinterpret_cast<const BUNDLE_SEQUENCE *>(mData + mHeader->_sequencesOffset);
+	const BUNDLE_FRAME_TIME *mFrameTimes = reinterpret_cast<const BUNDLE_FRAME_TIME *>(mData + mHeader->_frameTimesOffset);
+	const char *mNames = reinterpret_cast<const char *>(mData + mHeader->_namesOffset);
+	const unsigned char *mAtlas = mData + mHeader->_atlasOffset;
+	int mNamesSize = mHeader->_atlasOffset - mHeader->_namesOffset;
+
+	// ----- Checking the references, nothing is created from an invalid bundle -----
+
+	bool mValid = (mNamesSize > 0 && '\0' == mNames [mNamesSize - 1]);
+	for (int i = 0; mValid && i < mHeader->_numFrames; i++) {
+		const BUNDLE_FRAME &mFrame = mFrames [i];
+		mValid = (mFrame._name >= 0 && mFrame._name < mNamesSize &&
+		          mFrame._x >= 0 && mFrame._y >= 0 && mFrame._width > 0 && mFrame._height > 0 &&
+		          mFrame._width <= mHeader->_atlasWidth - mFrame._x &&
+		          mFrame._height <= mHeader->_atlasHeight - mFrame._y &&
+		          mFrame._firstCollision >= 0 && mFrame._numCollisions >= 0 &&
+		          mFrame._numCollisions <= mHeader->_numCollisions - mFrame._firstCollision);
+	}
+	for (int i = 0; mValid && i < mHeader->_numCollisions; i++) {
+		mValid = (mCollisions [i]._id >= 0 && mCollisions [i]._id < mNamesSize);
+	}
+	for (int i = 0; mValid && i < mHeader->_numSequences; i++) {
+		const BUNDLE_SEQUENCE &mSequence = mSequences [i];
+		mValid = (mSequence._name >= 0 && mSequence._name < mNamesSize &&
+		          mSequence._firstFrameTime >= 0 && mSequence._numFrameTimes > 0 &&
+		          mSequence._numFrameTimes <= mHeader->_numFrameTimes - mSequence._firstFrameTime);
+	}
+	for (int i = 0; mValid && i < mHeader->_numFrameTimes; i++) {
+		mValid = (mFrameTimes [i]._frame >= 0 && mFrameTimes [i]._frame < mHeader->_numFrames);
+	}
+
+	if (!mValid || !mHeader->_numFrames || !mHeader->_numSequences) {
+		g_debug->header("Invalid animation bundle:", DebugApi::LogHeaderWarning);
+		g_debug->dataChar(pBundleName, 1);
+		return 0;
+	}
+
+	g_debug->header("Animation bundle:", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(pBundleName, 1);
+
+	// ----------------- Frames -----------------
+
+	for (int i = 0; i < mHeader->_numFrames; i++) {
+		const BUNDLE_FRAME &mFrame = mFrames [i];
+		IND_Frame *mNewFrame = new IND_Frame;
+		pNewAnimation->_vectorFrames->push_back(mNewFrame);
+
+		mNewFrame->setName(mNames + mFrame._name);
+		mNewFrame->SetOffsetX(mFrame._offsetX);
+		mNewFrame->SetOffsetY(mFrame._offsetY);
+
+		// Image of the frame, copied from the atlas
+		IND_Image *mNewImage = IND_Image::newImage();
+		if (!_imageManager->add(mNewImage, mFrame._width, mFrame._height, IND_RGBA)) {
+			DISPOSEMANAGED(mNewImage);
+			freeFrames(pNewAnimation);
+			return 0;
+		}
+		mNewFrame->setImage(mNewImage);
+
+		unsigned char *mDst = mNewImage->getPointer();
+		for (int y = 0; y < mFrame._height; y++) {
+			memcpy(mDst + y * mFrame._width * 4,
+			       mAtlas + ((mFrame._y + y) * mHeader->_atlasWidth + mFrame._x) * 4,
+			       mFrame._width * 4);
+		}
+
+		// Bounding collisions
+		for (int j = 0; j < mFrame._numCollisions; j++) {
+			const BUNDLE_COLLISION &mCollision = mCollisions [mFrame._firstCollision + j];
+			BOUNDING_COLLISION *mNewCollision = new BOUNDING_COLLISION(mCollision._type, mNames + mCollision._id);
+			mNewCollision->_posX = mCollision._posX;
+			mNewCollision->_posY = mCollision._posY;
+			mNewCollision->_radius = mCollision._radius;
+			mNewCollision->_ax = mCollision._ax;
+			mNewCollision->_ay = mCollision._ay;
+			mNewCollision->_bx = mCollision._bx;
+			mNewCollision->_by = mCollision._by;
+			mNewCollision->_cx = mCollision._cx;
+			mNewCollision->_cy = mCollision._cy;
+			mNewFrame->GetListBoundingCollision()->push_back(mNewCollision);
+		}
+	}
+
+	// ----------------- Sequences -----------------
+
+	for (int i = 0; i < mHeader->_numSequences; i++) {
+		const BUNDLE_SEQUENCE &mSequence = mSequences [i];
+		IND_Sequence *mNewSequence = new IND_Sequence();
+		mNewSequence->setName(mNames + mSequence._name);
+
+		for (int j = 0; j < mSequence._numFrameTimes; j++) {
+			const BUNDLE_FRAME_TIME &mFrameTime = mFrameTimes [mSequence._firstFrameTime + j];
+			IND_Sequence::FRAME_TIME *mNewFrameTime = new IND_Sequence::FRAME_TIME;
+			mNewFrameTime->_pos = mFrameTime._frame;
+			mNewFrameTime->_time = mFrameTime._time;
+
+			const BUNDLE_FRAME &mFrame = mFrames [mFrameTime._frame];
+			if (mFrame._width > mNewSequence->getHighWidth())
+				mNewSequence->setHighWidth(mFrame._width);
+			if (mFrame._height > mNewSequence->getHighHeight())
+				mNewSequence->setHighHeight(mFrame._height);
+
+			mNewSequence->_sequence._listFrames->push_back(mNewFrameTime);
+		}
+		mNewSequence->setNumFrames(mSequence._numFrameTimes);
+
+		pNewAnimation->_animation._listSequences->push_back(mNewSequence);
+		pNewAnimation->_animation._sumSequences++;
+	}
+
+	g_debug->header("Frames | sequences:", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(mHeader->_numFrames, 0);
+	g_debug->dataChar("|", 0);
+	g_debug->dataInt(mHeader->_numSequences, 1);
+
+	return 1;
+}
+
+
 /**
  * Deletes an animation.
  * @param pAn					TODO describtion.
@@ -696,6 +1109,179 @@ bool IND_AnimationManager::remove(IND_Animation *pAn, bool pType) {
 
 	// ------ Free all the surfaces and animations -----
 
+	freeFrames(pAn);
+
+	if (pType) return 1;
+
+	// Quit from list
+	delFromlist(pAn);
+
+	g_debug->header("Ok", DebugApi::LogHeaderEnd);
+
+	return 1;
+}
+
+
+/**
+ * Packs the images of the frames of an animation into atlas pages (see setAtlas()). The packed
+ * frames get a rectangle of a page and their images are freed. Frames that don't fit in a page,
+ * or in a page that needs more than one texture, keep their images for a surface of their own.
+ * @param pAn					The animation.
+ * @param pType					Surface type of the pages (see ::IND_Type)
+ * @param pQuality				Surface quality of the pages (see ::IND_Quality)
+ */
+void IND_AnimationManager::packAtlas(IND_Animation *pAn, IND_Type pType, IND_Quality pQuality) {
+	vector <IND_Frame *> *mFrames = pAn->getVectorFrames();
+
+	// ----- Frames to pack, trimming the transparent borders -----
+
+	vector <int> mPack;
+	vector <int> mLeft;         // Kept rectangle of each frame (image lines, bottom-up)
+	vector <int> mBottom;
+	vector <int> mWidths;       // Kept size, plus one pixel of border at each side
+	vector <int> mHeights;
+	int mFrameBytes = 0;
+
+	for (int i = 0; i < static_cast<int>(mFrames->size()); i++) {
+		IND_Image *mImage = (*mFrames) [i]->getImage();
+		mImage->convert(IND_RGBA, 32);
+		int mWidth = mImage->getWidth();
+		int mHeight = mImage->getHeight();
+		mFrameBytes += mWidth * mHeight * 4;
+
+		int mX0 = 0, mY0 = 0, mX1 = mWidth, mY1 = mHeight;
+		if (_atlasTrim) {
+			mX0 = mWidth;
+			mY0 = mHeight;
+			mX1 = mY1 = 0;
+			unsigned char *mPixels = mImage->getPointer();
+			for (int y = 0; y < mHeight; y++) {
+				for (int x = 0; x < mWidth; x++) {
+					if (mPixels [(y * mWidth + x) * 4 + 3]) {
+						if (x < mX0) mX0 = x;
+						if (x >= mX1) mX1 = x + 1;
+						if (y < mY0) mY0 = y;
+						if (y >= mY1) mY1 = y + 1;
+					}
+				}
+			}
+
+			// Fully transparent frame
+			if (mX1 <= mX0 || mY1 <= mY0)
+				mX0 = mY0 = mX1 = mY1 = 0;
+		}
+
+		if (mX1 - mX0 + 2 > ATLAS_PAGE_SIZE || mY1 - mY0 + 2 > ATLAS_PAGE_SIZE)
+			continue;
+
+		mPack.push_back(i);
+		mLeft.push_back(mX0);
+		mBottom.push_back(mY0);
+		mWidths.push_back(mX1 - mX0 + 2);
+		mHeights.push_back(mY1 - mY0 + 2);
+	}
+
+	// ----- Pages -----
+
+	int mNumPack = static_cast<int>(mPack.size());
+	vector <int> mX (mNumPack);
+	vector <int> mY (mNumPack);
+	int mNumPages = 0;
+	int mNumPacked = 0;
+	int mPageBytes = 0;
+
+	for (int mFirst = 0; mFirst < mNumPack; ) {
+		// As many frames as fit in a page (a single frame always fits)
+		int mCount = mNumPack - mFirst;
+		int mPageWidth, mPageHeight;
+		for (;;) {
+			AnimationBundle::packFrames(mCount, &mWidths [mFirst], &mHeights [mFirst], &mX [mFirst], &mY [mFirst], &mPageWidth, &mPageHeight);
+			if (mPageWidth <= ATLAS_PAGE_SIZE && mPageHeight <= ATLAS_PAGE_SIZE)
+				break;
+			mCount -= (mCount + 7) / 8;
+		}
+
+		IND_Image *mPageImage = IND_Image::newImage();
+		if (!_imageManager->add(mPageImage, mPageWidth, mPageHeight, IND_RGBA)) {
+			DISPOSEMANAGED(mPageImage);
+			break;
+		}
+
+		// Frames are copied line by line, the borders between them stay transparent
+		unsigned char *mDst = mPageImage->getPointer();
+		memset(mDst, 0, mPageWidth * mPageHeight * 4);
+		for (int i = mFirst; i < mFirst + mCount; i++) {
+			IND_Image *mImage = (*mFrames) [mPack [i]]->getImage();
+			unsigned char *mSrc = mImage->getPointer();
+			for (int y = 0; y < mHeights [i] - 2; y++) {
+				memcpy(mDst + ((mY [i] + 1 + y) * mPageWidth + mX [i] + 1) * 4,
+				       mSrc + ((mBottom [i] + y) * mImage->getWidth() + mLeft [i]) * 4,
+				       (mWidths [i] - 2) * 4);
+			}
+		}
+
+		IND_Surface *mPage = IND_Surface::newSurface();
+		bool mOk = _surfaceManager->add(mPage, mPageImage, pType, pQuality);
+		_imageManager->remove(mPageImage);
+
+		if (!mOk) {
+			DISPOSEMANAGED(mPage);
+			break;
+		}
+		if (mPage->getNumTextures() > 1) {
+			_surfaceManager->remove(mPage);
+			break;
+		}
+
+		// Frames point to their rectangles (rows from the top, as the surface regions)
+		for (int i = mFirst; i < mFirst + mCount; i++) {
+			IND_Frame *mFrame = (*mFrames) [mPack [i]];
+			IND_Image *mImage = mFrame->getImage();
+			int mKeptHeight = mHeights [i] - 2;
+			mFrame->setSize(mImage->getWidth(), mImage->getHeight());
+			mFrame->setAtlas(mPage,
+			                 mX [i] + 1,
+			                 mPageHeight - (mY [i] + 1) - mKeptHeight,
+			                 mWidths [i] - 2,
+			                 mKeptHeight,
+			                 mLeft [i],
+			                 mImage->getHeight() - mBottom [i] - mKeptHeight);
+
+			_imageManager->remove(mImage);
+			mFrame->setImage(0);
+		}
+
+		mNumPages++;
+		mNumPacked += mCount;
+		mPageBytes += mPageWidth * mPageHeight * 4;
+		mFirst += mCount;
+	}
+
+	// ----- g_debug -----
+
+	g_debug->header("Frames packed into atlas pages:", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(mNumPacked, 0);
+	g_debug->dataChar("->", 0);
+	g_debug->dataInt(mNumPages, 1);
+	g_debug->header("Textures (frames | atlas):", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(static_cast<int>(mFrames->size()), 0);
+	g_debug->dataChar("|", 0);
+	g_debug->dataInt(static_cast<int>(mFrames->size()) - mNumPacked + mNumPages, 1);
+	g_debug->header("Frame pixels bytes (frames | atlas pages):", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(mFrameBytes, 0);
+	g_debug->dataChar("|", 0);
+	g_debug->dataInt(mPageBytes, 1);
+}
+
+
+/**
+ * Frees the frames of an animation, with their images and surfaces.
+ * @param pAn					The animation.
+ */
+void IND_AnimationManager::freeFrames(IND_Animation *pAn) {
+	// Atlas pages are shared by several frames
+	vector <IND_Surface *> mPages;
+
 	vector <IND_Frame *>::iterator mVectorFramesIter;
 	for (mVectorFramesIter  = pAn->_vectorFrames->begin();
 	        mVectorFramesIter  != pAn->_vectorFrames->end();
@@ -708,19 +1294,18 @@ bool IND_AnimationManager::remove(IND_Animation *pAn, bool pType) {
 		if ((*mVectorFramesIter)->getSurface())
 			_surfaceManager->remove((*mVectorFramesIter)->getSurface());
 
+		// Free atlas page
+		IND_Surface *mPage = (*mVectorFramesIter)->getAtlas();
+		if (mPage && find(mPages.begin(), mPages.end(), mPage) == mPages.end()) {
+			mPages.push_back(mPage);
+			_surfaceManager->remove(mPage);
+		}
+
 		// Free frame
 		DISPOSE(*mVectorFramesIter);
 	}
 
-    
-	if (pType) return 1;
-
-	// Quit from list
-	delFromlist(pAn);
-
-	g_debug->header("Ok", DebugApi::LogHeaderEnd);
-
-	return 1;
+	pAn->_vectorFrames->clear();
 }
 
 
@@ -37,6 +37,8 @@
 #include "IND_Animation.h"
 #include "IND_Surface.h"
 #include "IND_Font.h"
+#include "SpatialGrid.h"
+#include "TextMesh.h"
 
 #if defined (PLATFORM_LINUX)
 #include <stdlib.h>
@@ -65,7 +67,16 @@ void IND_Entity2d::destroy() {
 }
 
 
-IND_Entity2d::IND_Entity2d() : _text(NULL),  _listBoundingCollision(NULL) {
+IND_Entity2d::IND_Entity2d() : _text(NULL), _textMesh(NULL), _listBoundingCollision(NULL) {
+	_spatialGrid = NULL;
+	_spatialDirty = 0;
+	_spatialLarge = 0;
+	_spatialStamp = 0;
+	for (int i = 0; i < 4; i++) {
+		_spatialCells [i] = 0;
+		_spatialBox [i] = 0.0f;
+	}
+
 	initAttrib();
 }
 
@@ -80,6 +91,7 @@ IND_Entity2d::~IND_Entity2d() {
     
 	DISPOSE(_listBoundingCollision);
     DISPOSEARRAY(_text);
+    DISPOSE(_textMesh);
 }
 
 
@@ -164,6 +176,10 @@ void IND_Entity2d::setFont(IND_Font *pFont) {
 	
 	initAttrib();
 	_font = pFont;
+
+	// A new font with the same address as the previous one
+	if (_textMesh)
+		_textMesh->invalidate();
 }
 
 /**
@@ -172,6 +188,7 @@ void IND_Entity2d::setFont(IND_Font *pFont) {
  * @param pShow					True = show the entity / False = hide entity.
  */
 void IND_Entity2d::setShow(bool pShow) {
+	_updateCacheFlag = 1;
 	_show = pShow;
 }
 
@@ -181,11 +198,11 @@ void IND_Entity2d::setShow(bool pShow) {
  * @param pSequence				Frame number of the sequence to draw.
  */
 void IND_Entity2d::setSequence(unsigned int pSequence) {
+	_updateCacheFlag = 1;
+	spatialChanged();
 	if (_an) {
-		_an->setActualFramePos(_sequence, 0);
-		_an->setIsActive(_sequence, false); //Reset
+		_playback = SEQUENCE_PLAYBACK(); //Reset
         _sequence = pSequence;
-        _an->setIsActive(_sequence, true); //Set
 	}
 }
 
@@ -218,6 +235,7 @@ void IND_Entity2d::setNumReplays(int pNumReplays) {
  * @param pY2					Y value of the endpoint of the line.
  */
 void IND_Entity2d::setLine(int pX1, int pY1, int pX2, int pY2) {
+	_updateCacheFlag = 1;
 	_x1 = pX1;
 	_y1 = pY1;
 	_x2 = pX2;
@@ -233,6 +251,7 @@ void IND_Entity2d::setLine(int pX1, int pY1, int pX2, int pY2) {
  * @param pY2					Y value of the lower right point of the rectangle.
  */
 void IND_Entity2d::setRectangle(int pX1, int pY1, int pX2, int pY2) {
+	_updateCacheFlag = 1;
 	_x1 = pX1;
 	_y1 = pY1;
 	_x2 = pX2;
@@ -245,6 +264,7 @@ void IND_Entity2d::setRectangle(int pX1, int pY1, int pX2, int pY2) {
  * @param pRadius				Length of the radius of the primitive ::IND_REGULAR_POLY.
  */
 void IND_Entity2d::setRadius(int pRadius) {
+	_updateCacheFlag = 1;
 	_radius = pRadius;
 }
 
@@ -254,6 +274,7 @@ void IND_Entity2d::setRadius(int pRadius) {
  * @param pNumSides				Number of sides of the regular polygon ::IND_REGULAR_POLY.
  */
 void IND_Entity2d::setNumSides(int pNumSides) {
+	_updateCacheFlag = 1;
 	_numSides = pNumSides;
 }
 
@@ -263,6 +284,7 @@ void IND_Entity2d::setNumSides(int pNumSides) {
  * @param pPolyAngle				Angle of the regular polygon ::IND_REGULAR_POLY.
  */
 void IND_Entity2d::setPolyAngle(float pPolyAngle) {
+	_updateCacheFlag = 1;
 	_polyAngle = pPolyAngle;
 }
 
@@ -274,6 +296,7 @@ void IND_Entity2d::setPolyAngle(float pPolyAngle) {
  * @param pPolyPoints				Pointer to an array of points ::IND_Point. Example: ::IND_Point mPoly3 [] = {{60, 10}, {20, 15}, {50, 90}, {170, 190}} =>  Indicates three points (each one with its x and y coordinates).
  */
 void IND_Entity2d::setPolyPoints(IND_Point *pPolyPoints) {
+	_updateCacheFlag = 1;
 	if(!pPolyPoints) {
 		return;
 	}
@@ -286,6 +309,7 @@ void IND_Entity2d::setPolyPoints(IND_Point *pPolyPoints) {
  * @param pNumLines				Number of edges to draw.
  */
 void IND_Entity2d::setNumLines(int pNumLines) {
+	_updateCacheFlag = 1;
 	_numLines = pNumLines;
 }
 
@@ -295,6 +319,7 @@ void IND_Entity2d::setNumLines(int pNumLines) {
  * @param pAlign				Text alignment. See ::IND_Align.
  */
 void IND_Entity2d::setAlign(IND_Align pAlign) {
+	_updateCacheFlag = 1;
 	_align = pAlign;
 }
 
@@ -304,6 +329,7 @@ void IND_Entity2d::setAlign(IND_Align pAlign) {
  * @param pCharSpacing				Width of the additional space between letters.
  */
 void IND_Entity2d::setCharSpacing(int pCharSpacing) {
+	_updateCacheFlag = 1;
 	_charSpacing = pCharSpacing;
 }
 
@@ -313,6 +339,7 @@ void IND_Entity2d::setCharSpacing(int pCharSpacing) {
  * @param pLineSpacing				Height of the line spacing between lines.
  */
 void IND_Entity2d::setLineSpacing(int pLineSpacing) {
+	_updateCacheFlag = 1;
 	_lineSpacing = pLineSpacing;
 }
 
@@ -322,6 +349,7 @@ void IND_Entity2d::setLineSpacing(int pLineSpacing) {
  * @param pText					Text to draw in the screen.
  */
 void IND_Entity2d::setText(const char *pText) {
+	_updateCacheFlag = 1;
 	if (pText) {
 		DISPOSEARRAY(_text);
 
@@ -347,7 +375,11 @@ void IND_Entity2d::setPosition(float pX, float pY, int pZ) {
 		_x = pX;
 		_y = pY;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
+	if (pZ != _z)
+		_updateCacheFlag = 1;
 	_z = pZ;
 }
 
@@ -365,6 +397,8 @@ void IND_Entity2d::setAngleXYZ(float pAnX, float pAnY, float pAnZ) {
 		_angleY = pAnY;
 		_angleZ = pAnZ;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -379,6 +413,8 @@ void IND_Entity2d::setScale(float pSx, float pSy) {
 		_scaleX = pSx;
 		_scaleY = pSy;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -395,6 +431,8 @@ void IND_Entity2d::setBackCull(bool pCull) {
 	if (pCull != _cull) {
 		_cull = pCull;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -408,6 +446,8 @@ void IND_Entity2d::setMirrorX(bool pMx) {
 	if (pMx != _mirrorX) {
 		_mirrorX = pMx;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -421,6 +461,8 @@ void IND_Entity2d::setMirrorY(bool pMy) {
 	if (pMy != _mirrorY) {
 		_mirrorY = pMy;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -443,6 +485,8 @@ void IND_Entity2d::setFilter(IND_Filter pF) {
 	if (pF != _filter) {
 		_filter = pF;
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 	}
 }
 
@@ -468,6 +512,8 @@ bool IND_Entity2d::setHotSpot(float pX, float pY) {
 	// If updated
 	if (pX != _hotSpotX || pY != _hotSpotY) {
 		_updateTransFlag = 1;
+		_updateCacheFlag = 1;
+		spatialChanged();
 
 		if (_su) {
 			_hotSpotX = pX;
@@ -517,6 +563,7 @@ bool IND_Entity2d::setHotSpot(float pX, float pY) {
  * @param pRegionHeight					Height of the region.
  */
 bool IND_Entity2d::setRegion(int pOffX, int pOffY, int pRegionWidth, int pRegionHeight) {
+	_updateCacheFlag = 1;
 	if (!_su && !_an) return 0;
 
 	if (pRegionWidth    <= 0) return 0;
@@ -526,6 +573,7 @@ bool IND_Entity2d::setRegion(int pOffX, int pOffY, int pRegionWidth, int pRegion
 	_offY           = pOffY;
 	_regionWidth    = pRegionWidth;
 	_regionHeight   = pRegionHeight;
+	spatialChanged();
 
 	return 1;
 }
@@ -536,6 +584,7 @@ bool IND_Entity2d::setRegion(int pOffX, int pOffY, int pRegionWidth, int pRegion
  * @param pWrap						(Activates / Deactivates) = (true, false) the repetition of the image in the x,y axis.
  */
 bool IND_Entity2d::toggleWrap(bool pWrap) {
+	_updateCacheFlag = 1;
 	if (!_su && !_an) return 0;
 
 	_wrap = pWrap;
@@ -551,6 +600,7 @@ bool IND_Entity2d::toggleWrap(bool pWrap) {
  * @param pVOffset				Vertical displacement of the image (V coordinate).
  */
 void IND_Entity2d::setWrapOffset(float pUOffset, float pVOffset) {
+	_updateCacheFlag = 1;
 	_uOffset = pUOffset;
 	_vOffset = pVOffset;
 }
@@ -576,6 +626,7 @@ void IND_Entity2d::setLayer(int pLayer) {
  * @param pR, pG, pB					Bytes R, G, B
  */
 void IND_Entity2d::setTint(unsigned char pR, unsigned char pG, unsigned char pB) {
+	_updateCacheFlag = 1;
 	_r = pR;
 	_g = pG;
 	_b = pB;
@@ -592,6 +643,7 @@ void IND_Entity2d::setTint(unsigned char pR, unsigned char pG, unsigned char pB)
  * @param pA						Byte A.
  */
 void IND_Entity2d::setTransparency(unsigned char pA) {
+	_updateCacheFlag = 1;
 	_a = pA;
 }
 
@@ -613,6 +665,7 @@ void IND_Entity2d::setTransparency(unsigned char pA) {
  * @param pR, pG, pB, pA				Bytes R, G, B, A.
  */
 void IND_Entity2d::setFade(unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA) {
+	_updateCacheFlag = 1;
 	_fadeR = pR;
 	_fadeG = pG;
 	_fadeB = pB;
@@ -625,6 +678,7 @@ void IND_Entity2d::setFade(unsigned char pR, unsigned char pG, unsigned char pB,
  * @param pSo						Indicates the blending source, see (::IND_BlendingType).
  */
 void IND_Entity2d::setBlendSource(IND_BlendingType pSo) {
+	_updateCacheFlag = 1;
 	_so = pSo;
 }
 
@@ -634,6 +688,7 @@ void IND_Entity2d::setBlendSource(IND_BlendingType pSo) {
  * @param pDs						Indicates blending destiny, see (::IND_BlendingType).
  */
 void IND_Entity2d::setBlendDest(IND_BlendingType pDs) {
+	_updateCacheFlag = 1;
 	_ds = pDs;
 }
 
@@ -897,6 +952,8 @@ void IND_Entity2d::initAttrib() {
 
 	// Space transformation attributes
 	_updateTransFlag = 1;
+	_updateCacheFlag = 1;
+	spatialChanged();
 	_x = 0;
 	_y = 0;
 	_z = 0;
@@ -939,6 +996,7 @@ void IND_Entity2d::initAttrib() {
 
 	// Animation attributes
 	_sequence = 0;
+	_playback = SEQUENCE_PLAYBACK();
 	_numReplays = -1;
 	_firstTime = 1;
 
@@ -969,6 +1027,19 @@ void IND_Entity2d::initAttrib() {
 
 	// Show grid areas
 	_showGridAreas = 1;
+
+	// Fill rate statistics
+	_fillPixels = 0;
+}
+
+/*
+==================
+Tells the spatial index of the layer that the bounds of the entity have to be calculated again
+==================
+*/
+void IND_Entity2d::spatialChanged() {
+	if (_spatialGrid)
+		_spatialGrid->markDirty(this);
 }
 
 /** @endcond */
@@ -44,9 +44,38 @@
 #include "CollisionParser.h"
 #include "IND_Entity2d.h"
 #include "IND_Math.h"
+#include "SpatialGrid.h"
+#include "TextMesh.h"
+#include "dependencies/SDL-2.0/include/SDL_thread.h"
+#include "dependencies/SDL-2.0/include/SDL_mutex.h"
+#include "dependencies/SDL-2.0/include/SDL_cpuinfo.h"
 
 /** @cond DOCUMENT_PRIVATEAPI */
 
+// Minimum number of entities updated by each thread in update()
+#define UPDATE_MIN_CHUNK 256
+
+// Thread of the update pass. Each time _start is signaled, it updates the entities
+// [_first, _last) of the update list and signals _done.
+struct UPDATE_WORKER {
+	IND_Entity2dManager *_manager;
+	SDL_Thread *_thread;
+	SDL_sem *_start;
+	SDL_sem *_done;
+	int _first;
+	int _last;
+	double _clock;
+	bool _quit;
+};
+
+// Render target of a cached layer (see IND_Entity2dManager::setLayerCache())
+struct LAYER_CACHE {
+	IND_Surface *_surface;
+	IND_Matrix _camera;                             // Camera used the last time that the layer was drawn into the surface
+	int _margin;                                    // Pixels drawn outside of each side of the viewport
+	bool _dirty;                                    // Entities added or removed since the layer was drawn
+};
+
 /**
  * For sorting the vector
  */
@@ -57,6 +86,17 @@ bool zIsLess(IND_Entity2d *pLhs, IND_Entity2d *pRhs) {
 		return 0;
 }
 
+/**
+ * For sorting the entities selected by a spatial index, that aren't in the order of the layer.
+ * Entities with the same z value keep the order in which they were added.
+ */
+bool zIdIsLess(IND_Entity2d *pLhs, IND_Entity2d *pRhs) {
+	if (pLhs->getPosZ() != pRhs->getPosZ())
+		return pLhs->getPosZ() < pRhs->getPosZ();
+
+	return pLhs->getId() < pRhs->getId();
+}
+
 unsigned int IND_Entity2dManager::_idTrack = 0;
 
 /** @endcond */
@@ -103,6 +143,7 @@ bool IND_Entity2dManager::init(IND_Render *pRender) {
 void IND_Entity2dManager::end() {
 	if (_ok) {
 		g_debug->header("Finalizing Entity2dManager", DebugApi::LogHeaderBegin);
+		freeUpdateThreads();
 		DISPOSE (_math);
 		g_debug->header("Freeing 2d entities" , DebugApi::LogHeaderBegin);
 		freeVars();
@@ -133,10 +174,9 @@ bool IND_Entity2dManager::isOK()           const {
  * @param pNewEntity2d				Pointer to an entity object.
  */
 bool IND_Entity2dManager::add(IND_Entity2d *pNewEntity2d) {
-	g_debug->header("Adding 2d entity", DebugApi::LogHeaderBegin);
-	g_debug->header("Name:", DebugApi::LogHeaderInfo);
+	IND_LOG_INFO(DebugApi::LogHeaderBegin, "Adding 2d entity");
     pNewEntity2d->_id = _idTrack++;
-	g_debug->dataInt(pNewEntity2d->getId(), 1);
+	IND_LOG_INFO(DebugApi::LogHeaderInfo, "Name: %d", pNewEntity2d->getId());
 
 	if (!_ok) {
 		writeMessage();
@@ -148,9 +188,10 @@ bool IND_Entity2dManager::add(IND_Entity2d *pNewEntity2d) {
 	addToList(0, pNewEntity2d);
 
 	pNewEntity2d->setLayer(0);
+	invalidateLayerCache(0);
 	// ----- g_debug -----
 
-	g_debug->header("2d entity added", DebugApi::LogHeaderEnd);
+	IND_LOG_INFO(DebugApi::LogHeaderEnd, "2d entity added");
 
 	return 1;
 }
@@ -171,12 +212,10 @@ bool IND_Entity2dManager::add(IND_Entity2d *pNewEntity2d) {
  * @param pNewEntity2d                		Pointer to an entity object.
  */
 bool IND_Entity2dManager::add(int pLayer, IND_Entity2d *pNewEntity2d) {
-	g_debug->header("Adding 2d entity", DebugApi::LogHeaderBegin);
-	g_debug->header("Name:", DebugApi::LogHeaderInfo);
+	IND_LOG_INFO(DebugApi::LogHeaderBegin, "Adding 2d entity");
     pNewEntity2d->_id = _idTrack++;
-	g_debug->dataInt(pNewEntity2d->getId(), 1);
-	g_debug->header("Layer:", DebugApi::LogHeaderInfo);
-	g_debug->dataInt(pLayer, 1);
+	IND_LOG_INFO(DebugApi::LogHeaderInfo, "Name: %d", pNewEntity2d->getId());
+	IND_LOG_INFO(DebugApi::LogHeaderInfo, "Layer: %d", pLayer);
 
 	if (!_ok) {
 		writeMessage();
@@ -191,9 +230,10 @@ bool IND_Entity2dManager::add(int pLayer, IND_Entity2d *pNewEntity2d) {
 	addToList(pLayer, pNewEntity2d);
 
 	pNewEntity2d->setLayer(pLayer);
+	invalidateLayerCache(pLayer);
 	// ----- g_debug -----
 
-	g_debug->header("2d entity added", DebugApi::LogHeaderEnd);
+	IND_LOG_INFO(DebugApi::LogHeaderEnd, "2d entity added");
 
 	return 1;
 }
@@ -204,15 +244,14 @@ bool IND_Entity2dManager::add(int pLayer, IND_Entity2d *pNewEntity2d) {
  * @param pEn				Pointer to an entity object.
  */
 bool IND_Entity2dManager::remove(IND_Entity2d *pEn) {
-	g_debug->header("Freeing 2d entity", DebugApi::LogHeaderBegin);
-	g_debug->header("Name:", DebugApi::LogHeaderInfo);
-	g_debug->dataInt(pEn->getId(), 1);
-
 	if (!_ok || !pEn) {
 		writeMessage();
 		return 0;
 	}
 
+	IND_LOG_INFO(DebugApi::LogHeaderBegin, "Freeing 2d entity");
+	IND_LOG_INFO(DebugApi::LogHeaderInfo, "Name: %d", pEn->getId());
+
 	// Search object in all the layers
 	for (int i = 0; i < NUM_LAYERS; i++) {
 		bool mIs = 0;
@@ -232,281 +271,272 @@ bool IND_Entity2dManager::remove(IND_Entity2d *pEn) {
 
 			// Quit from list
 			_listEntities2d[i]->erase(_listIter);
+			invalidateLayerCache(i);
+			if (_layerGrids [i])
+				_layerGrids [i]->remove(pEn);
 
-			g_debug->header("Ok", DebugApi::LogHeaderEnd);
+			IND_LOG_INFO(DebugApi::LogHeaderEnd, "Ok");
 
 			return 1;
 		}
 	}
 
-	g_debug->header("Entity not found", DebugApi::LogHeaderEnd);
+	IND_LOG_INFO(DebugApi::LogHeaderEnd, "Entity not found");
 	return 0;
 }
 
+/**
+ * Advances the animations (actual frame, elapsed time and replays) of all the entities of all the layers.
+ *
+ * Once this method has been called, IND_Entity2dManager::renderEntities2d() only draws the entities, without
+ * advancing their animations. So the entities that are hidden or out of the screen are animated too, and
+ * the animations only depend on the times received (i.e. for replays). When this method is not used, the
+ * animations advance when they are drawn.
+ *
+ * The entities are updated in parallel when IND_Entity2dManager::setUpdateThreads() is used.
+ * @param pDeltaTime			Time, in milliseconds, to advance the animations. Usually IND_Render::getFrameTime().
+ */
+void IND_Entity2dManager::update(float pDeltaTime) {
+	if (!_ok) return;
+
+	// The first update continues the clock used until now by the render
+	if (!_updatePass) {
+		_updateClock = _render->getAnimationClock();
+		_updatePass = true;
+	}
+
+	_updateClock += pDeltaTime;
+
+	// ----- Animated entities of all the layers -----
+
+	_listUpdate.clear();
+	for (int i = 0; i < NUM_LAYERS; i++) {
+		vector <IND_Entity2d *>::iterator mIter;
+		for (mIter  = _listEntities2d[i]->begin();
+		        mIter != _listEntities2d[i]->end();
+		        mIter++) {
+			if ((*mIter)->_an)
+				_listUpdate.push_back(*mIter);
+		}
+	}
+
+	// ----- Chunks -----
+
+	int mNumEntities = static_cast<int>(_listUpdate.size());
+	int mNumChunks = static_cast<int>(_listUpdateWorkers.size()) + 1;
+	if (mNumChunks > mNumEntities / UPDATE_MIN_CHUNK)
+		mNumChunks = mNumEntities / UPDATE_MIN_CHUNK;
+	if (mNumChunks < 1)
+		mNumChunks = 1;
+	int mChunkSize = (mNumEntities + mNumChunks - 1) / mNumChunks;
+
+	// The worker threads update the first chunks and this thread the last one
+	for (int i = 0; i < mNumChunks - 1; i++) {
+		UPDATE_WORKER *mWorker = _listUpdateWorkers [i];
+		mWorker->_first = i * mChunkSize;
+		mWorker->_last = (i + 1) * mChunkSize;
+		mWorker->_clock = _updateClock;
+		SDL_SemPost(mWorker->_start);
+	}
+
+	updateEntities((mNumChunks - 1) * mChunkSize, mNumEntities, _updateClock);
+
+	for (int i = 0; i < mNumChunks - 1; i++)
+		SDL_SemWait(_listUpdateWorkers [i]->_done);
+}
+
+/**
+ * Sets the number of threads used by IND_Entity2dManager::update(), including the calling thread.
+ * The entities are only updated in parallel when there are enough of them (256 for each thread).
+ * Default: 1 (only the calling thread).
+ * @param pNumThreads			Number of threads. 0 = one thread for each CPU.
+ */
+void IND_Entity2dManager::setUpdateThreads(int pNumThreads) {
+	if (!_ok) return;
+
+	if (pNumThreads <= 0)
+		pNumThreads = SDL_GetCPUCount();
+
+	freeUpdateThreads();
+
+	for (int i = 1; i < pNumThreads; i++) {
+		UPDATE_WORKER *mWorker = new UPDATE_WORKER;
+		mWorker->_manager = this;
+		mWorker->_start = SDL_CreateSemaphore(0);
+		mWorker->_done = SDL_CreateSemaphore(0);
+		mWorker->_first = mWorker->_last = 0;
+		mWorker->_clock = 0.0;
+		mWorker->_quit = false;
+		mWorker->_thread = SDL_CreateThread(updateThread, "IndieLib update", mWorker);
+
+		if (!mWorker->_thread) {
+			g_debug->header("Unable to create update thread", DebugApi::LogHeaderWarning);
+			SDL_DestroySemaphore(mWorker->_start);
+			SDL_DestroySemaphore(mWorker->_done);
+			DISPOSE(mWorker);
+			break;
+		}
+
+		_listUpdateWorkers.push_back(mWorker);
+	}
+
+	_numUpdateThreads = static_cast<int>(_listUpdateWorkers.size()) + 1;
+}
+
 /**
  * Renders (draws on the screen) all the entities of the manager of a concrete layer.
  */
 void IND_Entity2dManager::renderEntities2d(int pLayer) {
 	if (!_ok || _listEntities2d[pLayer]->empty()) return;
 
-	// Sort the list by z value ONLY if the z value of an entity has changed
-	// TODO: How to know if an entity has changed z-value from here int order to avoid sorting?
-	sort(_listEntities2d[pLayer]->begin(), _listEntities2d[pLayer]->end(), zIsLess);
+	if (_layerCaches [pLayer])
+		renderLayerCache(pLayer);
+	else
+		renderLayer(pLayer, !_updatePass);
+}
 
-	//Set cull region
-	_render->reCalculateFrustrumPlanes();
+/**
+ * Returns the pixels drawn by the entities of a layer the last time that it was rendered, when the fill
+ * rate statistics are enabled (see IND_Render::setFillStats()).
+ * @param pLayer				Layer.
+ */
+int IND_Entity2dManager::getFillPixelsInt(int pLayer) {
+	if (pLayer < 0 || pLayer >= NUM_LAYERS)
+		return 0;
 
-	// Iterates the list
-	vector <IND_Entity2d *>::iterator mIter;
-	for (mIter  = _listEntities2d[pLayer]->begin();
-	        mIter != _listEntities2d[pLayer]->end();
-	        mIter++) {
-		// Only render it if "show" flag is true
-		if ((*mIter)->_show) {
-			// If it has an animation or a surface assigned
-			if ((*mIter)->_su || (*mIter)->_an) {
-				// Set transformations ONLY if the entity space attributes has been modified
-				if ((*mIter)->_updateTransFlag) {
-					(*mIter)->_updateTransFlag = 0;
-
-					int mWidthTemp = 0;
-					int mHeightTemp = 0;
-
-					// ---- We obtain the width and height of the animation or the surface -----
-
-					if ((*mIter)->_su) {
-						mWidthTemp  = (*mIter)->_su->getWidth();
-						mHeightTemp = (*mIter)->_su->getHeight();
-					} else {
-						if ((*mIter)->_an->getActualSurface((*mIter)->getSequence())) {
-							mWidthTemp  = (*mIter)->_an->getActualSurface((*mIter)->getSequence())->getWidth();
-							mHeightTemp = (*mIter)->_an->getActualSurface((*mIter)->getSequence())->getHeight();
-						}
-					}
+	return _layerFillPixels [pLayer];
+}
 
-					// ----- Transformations -----
+/**
+ * Sets if the entities of a layer that are opaque (see ::IND_AlphaClass) are drawn before the rest of
+ * entities, from the front to the back, when the layer is rendered. Then the rest of the entities are
+ * drawn from the back to the front, and their pixels that are behind the opaque ones are discarded with
+ * the depth test, so the same image is drawn with less overdraw (i.e. for layers with many tiles).
+ * Entities with alpha, fade or other blending types are always drawn in the second pass.
+ * It only works with the OpenGL renderer (the layers are drawn from the back to the front in the
+ * other renderers). Default: false.
+ * @param pOpaqueFirst			True for drawing the opaque entities first.
+ */
+void IND_Entity2dManager::setOpaqueFirst(bool pOpaqueFirst) {
+	_opaqueFirst = pOpaqueFirst;
+}
 
-					_render->setTransform2d((int)(*mIter)->_x,
-					                        (int)(*mIter)->_y,
-					                        (*mIter)->_angleX,
-					                        (*mIter)->_angleY,
-					                        (*mIter)->_angleZ,
-					                        (*mIter)->_scaleX,
-					                        (*mIter)->_scaleY,
-					                        (*mIter)->_axisCalX,
-					                        (*mIter)->_axisCalY,
-					                        (*mIter)->_mirrorX,
-					                        (*mIter)->_mirrorY,
-					                        mWidthTemp,
-					                        mHeightTemp,
-					                        &(*mIter)->_mat);
-				} else {
-					_render->setTransform2d((*mIter)->_mat);
-				}
+/**
+ * Sets if a layer is cached in a render target. The entities of a cached layer are only drawn again
+ * when one of them changes (position, transformation, color, surface, frame of its animation...), an
+ * entity is added or removed, or the camera is rotated, zoomed or moved further than the margin. In
+ * the rest of frames, the render target is drawn instead of the entities, so it is useful for layers
+ * with many entities that almost never change (backgrounds, tiles...).
+ *
+ * The render target has the size of the viewport plus the margin in each side (i.e. a margin of 64
+ * pixels allows scrolling 64 pixels before drawing the layer again). Returns 0 (false) if the layer
+ * can't be cached (then it is drawn as usual). Only the OpenGL renderer supports render targets.
+ * @param pLayer				Layer.
+ * @param pCache				True for caching the layer, false for drawing it as usual.
+ * @param pMargin				Pixels drawn outside of each side of the viewport.
+ */
+bool IND_Entity2dManager::setLayerCache(int pLayer, bool pCache, int pMargin) {
+	if (!_ok || pLayer < 0 || pLayer >= NUM_LAYERS || pMargin < 0)
+		return 0;
 
-				// ----- Color attributes -----
-
-				_render->setRainbow2d((*mIter)->getType(),
-				                      (*mIter)->_cull,
-				                      (*mIter)->_mirrorX,
-				                      (*mIter)->_mirrorY,
-				                      (*mIter)->_filter,
-				                      (*mIter)->_r,
-				                      (*mIter)->_g,
-				                      (*mIter)->_b,
-				                      (*mIter)->_a,
-				                      (*mIter)->_fadeR,
-				                      (*mIter)->_fadeG,
-				                      (*mIter)->_fadeB,
-				                      (*mIter)->_fadeA,
-				                      (*mIter)->_so,
-				                      (*mIter)->_ds);
-
-				// ----- Surface blitting -----
+	LAYER_CACHE *mCache = _layerCaches [pLayer];
+	if (!pCache) {
+		if (mCache) {
+			DISPOSEMANAGED(mCache->_surface);
+			DISPOSE(_layerCaches [pLayer]);
+		}
+		return 1;
+	}
 
-				if ((*mIter)->_su) {
-					// Surface region specified
-					if (((*mIter)->_regionWidth > 0) && ((*mIter)->_regionHeight > 0)) {
-						// X or Y wrapping
-						if ((*mIter)->_wrap) {
-							_render->blitWrapSurface((*mIter)->_su,
-							                         (*mIter)->_regionWidth,
-							                         (*mIter)->_regionHeight,
-							                         (*mIter)->_uOffset,
-							                         (*mIter)->_vOffset);
-						}
-						// No wrapping
-						else {
-							_render->blitRegionSurface((*mIter)->_su,
-							                           (*mIter)->_offX,
-							                           (*mIter)->_offY,
-							                           (*mIter)->_regionWidth,
-							                           (*mIter)->_regionHeight);
-						}
-					}
-					// Blits all the surface
-					else
-						_render->blitSurface((*mIter)->_su);
-				}
+	if (!mCache) {
+		mCache = new LAYER_CACHE;
+		mCache->_surface = IND_Surface::newSurface();
+		_layerCaches [pLayer] = mCache;
+	}
 
-				// ----- Animation blitting -----
+	mCache->_margin = pMargin;
+	mCache->_dirty = true;
 
-				else {
-					// Animation is looping
-					if ((*mIter)->_numReplays == -1) {
-						// Blits the animation, returns -1 when finishes
-						if (_render->blitAnimation((*mIter)->_an,
-						                           (*mIter)->_sequence,
-						                           (*mIter)->_offX,
-						                           (*mIter)->_offY,
-						                           (*mIter)->_regionWidth,
-						                           (*mIter)->_regionHeight,
-						                           (*mIter)->_wrap,
-						                           (*mIter)->_uOffset,
-						                           (*mIter)->_vOffset) == -1) {
-							// Reset the animation
-							(*mIter)->_an->setActualFramePos((*mIter)->_sequence, 0);
-						}
-					} else
-						// If there is a stablished number or replays
-					{
-						// Blits the animation, returns -1 when finishes
-						if (_render->blitAnimation((*mIter)->_an,
-						                           (*mIter)->_sequence,
-						                           (*mIter)->_offX,
-						                           (*mIter)->_offY,
-						                           (*mIter)->_regionWidth,
-						                           (*mIter)->_regionHeight,
-						                           (*mIter)->_wrap,
-						                           (*mIter)->_uOffset,
-						                           (*mIter)->_vOffset) == -1) {
-							// There are replays
-							if ((*mIter)->_numReplays > 0) {
-								// Reset animation
-								(*mIter)->_an->setActualFramePos((*mIter)->_sequence, 0);
-
-								// Decrease the number of replays
-								(*mIter)->_numReplays--;
-							}
-							// There are no replays
-							else {
-								// Blits the last frame
-								(*mIter)->_an->setActualFramePos((*mIter)->_sequence, (*mIter)->_an->getNumFrames((*mIter)->_sequence) - 1);
-							}
-						}
-					}
-				}
-			} else
-				// If it has a 2d primitive assigned
-				if ((*mIter)->_pri2d) {
-					switch ((*mIter)->_pri2d) {
-						// Pixel
-					case IND_PIXEL: {
-
-						_render->blitPixel((int)(*mIter)->_x,
-						                   (int)(*mIter)->_y,
-						                   (*mIter)->_r,
-						                   (*mIter)->_g,
-						                   (*mIter)->_b,
-						                   (*mIter)->_a);
-						break;
-					}
+	return 1;
+}
 
-					// Regular polygon
-					case IND_REGULAR_POLY: {
-
-						_render->blitRegularPoly((int)(*mIter)->_x,
-						                         (int)(*mIter)->_y,
-						                         (*mIter)->_radius,
-						                         (*mIter)->_numSides,
-						                         (*mIter)->_polyAngle,
-						                         (*mIter)->_r,
-						                         (*mIter)->_g,
-						                         (*mIter)->_b,
-						                         (*mIter)->_a);
-						break;
-					}
+/**
+ * Returns true if a layer is cached in a render target (see IND_Entity2dManager::setLayerCache()).
+ * @param pLayer				Layer.
+ */
+bool IND_Entity2dManager::isLayerCache(int pLayer) {
+	if (pLayer < 0 || pLayer >= NUM_LAYERS)
+		return 0;
 
-					// Rectangle
-					case IND_RECTANGLE: {
-
-						_render->blitRectangle((*mIter)->_x1,
-						                       (*mIter)->_y1,
-						                       (*mIter)->_x2,
-						                       (*mIter)->_y2,
-						                       (*mIter)->_r,
-						                       (*mIter)->_g,
-						                       (*mIter)->_b,
-						                       (*mIter)->_a);
-						break;
-					}
+	return _layerCaches [pLayer] != NULL;
+}
 
-					// Fill rectangle
-					case IND_FILL_RECTANGLE: {
-						_render->blitFillRectangle((*mIter)->_x1,
-						                           (*mIter)->_y1,
-						                           (*mIter)->_x2,
-						                           (*mIter)->_y2,
-						                           (*mIter)->_r,
-						                           (*mIter)->_g,
-						                           (*mIter)->_b,
-						                           (*mIter)->_a);
-						break;
-					}
+/**
+ * Forces the entities of a cached layer to be drawn again the next time that the layer is rendered
+ * (see IND_Entity2dManager::setLayerCache()). Only needed for changes that the entities don't know
+ * about, like modifying the image of a surface that is being used.
+ * @param pLayer				Layer.
+ */
+void IND_Entity2dManager::invalidateLayerCache(int pLayer) {
+	if (pLayer >= 0 && pLayer < NUM_LAYERS && _layerCaches [pLayer])
+		_layerCaches [pLayer]->_dirty = true;
+}
 
-					// Poly2d
-					case IND_POLY2D: {
+/**
+ * Sets a spatial index for a layer. The entities of the layer are kept in a grid of square cells, using
+ * their world bounding boxes, and only the entities that are in the cells seen by the camera are sorted,
+ * transformed and drawn. The grid is updated only for the entities that have been moved, rotated,
+ * scaled or changed, so it is useful for big layers with many static entities (i.e. scrolling worlds),
+ * where most of them are out of the screen.
+ *
+ * The size of the cells should be similar to the size of the entities (i.e. 256 pixels). Primitives and
+ * fonts are always drawn. Only the OpenGL renderer can select the visible cells (the rest of renderers
+ * draw the whole layer, as usual). Default: 0 (no spatial index).
+ * @param pLayer				Layer.
+ * @param pCellSize				Size of the cells in pixels, or 0 for removing the spatial index.
+ */
+bool IND_Entity2dManager::setSpatialIndex(int pLayer, int pCellSize) {
+	if (!_ok || pLayer < 0 || pLayer >= NUM_LAYERS || pCellSize < 0)
+		return 0;
 
-						_render->blitPoly2d((*mIter)->_polyPoints,
-						                    (*mIter)->_numLines,
-						                    (*mIter)->_r,
-						                    (*mIter)->_g,
-						                    (*mIter)->_b,
-						                    (*mIter)->_a);
-						break;
-					}
+	DISPOSE(_layerGrids [pLayer]);
+	_layerCulled [pLayer] = 0;
+	if (!pCellSize)
+		return 1;
 
-					// Line
-					case IND_LINE: {
-
-						_render->blitLine((*mIter)->_x1,
-						                  (*mIter)->_y1,
-						                  (*mIter)->_x2,
-						                  (*mIter)->_y2,
-						                  (*mIter)->_r,
-						                  (*mIter)->_g,
-						                  (*mIter)->_b,
-						                  (*mIter)->_a);
-						break;
-					}
-					}
-				} else
-					// If it has a font assigned
-					if ((*mIter)->_font) {
-
-						_render->blitText((*mIter)->_font,
-						                  (*mIter)->_text,
-						                  (int)(*mIter)->_x,
-						                  (int)(*mIter)->_y,
-						                  (*mIter)->_charSpacing,
-						                  (*mIter)->_lineSpacing,
-						                  (*mIter)->_scaleX,
-						                  (*mIter)->_scaleY,
-						                  (*mIter)->_r,
-						                  (*mIter)->_g,
-						                  (*mIter)->_b,
-						                  (*mIter)->_a,
-						                  (*mIter)->_fadeR,
-						                  (*mIter)->_fadeG,
-						                  (*mIter)->_fadeB,
-						                  (*mIter)->_fadeA,
-						                  (*mIter)->_filter,
-						                  (*mIter)->_so,
-						                  (*mIter)->_ds,
-						                  (*mIter)->_align);
-					}
-		}
-	}
+	_layerGrids [pLayer] = new SpatialGrid(pCellSize);
+
+	vector <IND_Entity2d *>::iterator mIter;
+	for (mIter  = _listEntities2d[pLayer]->begin();
+	        mIter != _listEntities2d[pLayer]->end();
+	        mIter++)
+		_layerGrids [pLayer]->insert(*mIter);
+
+	return 1;
+}
+
+/**
+ * Returns the size of the cells of the spatial index of a layer, or 0 if it hasn't got a spatial index
+ * (see IND_Entity2dManager::setSpatialIndex()).
+ * @param pLayer				Layer.
+ */
+int IND_Entity2dManager::getSpatialIndex(int pLayer) {
+	if (pLayer < 0 || pLayer >= NUM_LAYERS || !_layerGrids [pLayer])
+		return 0;
+
+	return _layerGrids [pLayer]->getCellSize();
+}
+
+/**
+ * Returns the number of entities of a layer that were discarded by its spatial index the last time that
+ * the layer was rendered (see IND_Entity2dManager::setSpatialIndex()).
+ * @param pLayer				Layer.
+ */
+int IND_Entity2dManager::getNumCulledInt(int pLayer) {
+	if (pLayer < 0 || pLayer >= NUM_LAYERS)
+		return 0;
+
+	return _layerCulled [pLayer];
 }
 
 /**
@@ -545,7 +575,7 @@ void IND_Entity2dManager::renderCollisionAreas(int pLayer, unsigned char pR, uns
 				if ((*mIter)->_an) {
 
 					vector <IND_Frame*> *frames = (*mIter)->_an->getVectorFrames();
-					unsigned int framePos = (*mIter)->_an->getActualFramePos((*mIter)->getSequence());
+					unsigned int framePos = (*mIter)->_an->getFramePosInVec((*mIter)->_sequence, (*mIter)->_playback._frame);
 					if (frames && frames->size() > framePos) {
 						mBoundingListToRender = (*frames) [framePos]->GetListBoundingCollision();
 					}
@@ -601,9 +631,11 @@ void IND_Entity2dManager::renderGridAreas(int pLayer, unsigned char pR, unsigned
 					surface = (*mIter)->_su;
 				}
 
-				// Surface of current frame
+				// Surface of current frame (frames packed into an atlas page have no grid of their own)
 				if ((*mIter)->_an) {
-					surface = (*mIter)->_an->getActualSurface((*mIter)->getSequence());
+					int mX = 0, mY = 0, mWidth = 0, mHeight = 0, mDrawX, mDrawY;
+					if (!(*mIter)->_an->getFrameAtlas((*mIter)->_sequence, (*mIter)->_playback._frame, &mX, &mY, &mWidth, &mHeight, &mDrawX, &mDrawY))
+						surface = (*mIter)->_an->getFrameSurface((*mIter)->_sequence, (*mIter)->_playback._frame);
 				}
 
 				if (surface) {
@@ -667,7 +699,7 @@ bool IND_Entity2dManager::isCollision(IND_Entity2d *pEn1, const char *pId1, IND_
 	}
 	// Is an animation
 	else {
-		mBoundingList1 = (*(pEn1->_an->getVectorFrames())) [pEn1->_an->getActualFramePosInVec(pEn1->getSequence())]->GetListBoundingCollision();
+		mBoundingList1 = (*(pEn1->_an->getVectorFrames())) [pEn1->_an->getFramePosInVec(pEn1->_sequence, pEn1->_playback._frame)]->GetListBoundingCollision();
 	}
 
 	// Is a surface
@@ -676,7 +708,7 @@ bool IND_Entity2dManager::isCollision(IND_Entity2d *pEn1, const char *pId1, IND_
 	}
 	// Is an animation
 	else {
-		mBoundingList2 = (*(pEn2->_an->getVectorFrames())) [pEn2->_an->getActualFramePosInVec(pEn2->getSequence())]->GetListBoundingCollision();
+		mBoundingList2 = (*(pEn2->_an->getVectorFrames())) [pEn2->_an->getFramePosInVec(pEn2->_sequence, pEn2->_playback._frame)]->GetListBoundingCollision();
 	}
 
 	if (isCollision(mBoundingList1, mBoundingList2,
@@ -695,6 +727,586 @@ bool IND_Entity2dManager::isCollision(IND_Entity2d *pEn1, const char *pId1, IND_
 
 /** @cond DOCUMENT_PRIVATEAPI */
 
+/*
+==================
+Renders all the entities of a layer. The animations of the entities are advanced if pUpdate is true.
+==================
+*/
+void IND_Entity2dManager::renderLayer(int pLayer, bool pUpdate) {
+	//Set cull region
+	_render->reCalculateFrustrumPlanes();
+
+	vector <IND_Entity2d *> *mList = _listEntities2d[pLayer];
+	if (_layerGrids [pLayer]) {
+		// Only the visible entities, in the order of the layer
+		mList = selectVisible(pLayer);
+		sort(mList->begin(), mList->end(), zIdIsLess);
+	} else {
+		// Sort the list by z value ONLY if the z value of an entity has changed
+		// TODO: How to know if an entity has changed z-value from here int order to avoid sorting?
+		sort(mList->begin(), mList->end(), zIsLess);
+	}
+
+	bool mFillStats = _render->isFillStats();
+	int mFillPixels = mFillStats ? _render->getCurrentFillPixels() : 0;
+
+	if (_opaqueFirst) {
+		renderOpaqueFirst(mList, pUpdate);
+	} else {
+		// Iterates the list
+		vector <IND_Entity2d *>::iterator mIter;
+		for (mIter  = mList->begin();
+		        mIter != mList->end();
+		        mIter++) {
+			// Only render it if "show" flag is true
+			if ((*mIter)->_show)
+				renderEntity(*mIter, pUpdate);
+		}
+	}
+
+	if (mFillStats)
+		_layerFillPixels [pLayer] = _render->getCurrentFillPixels() - mFillPixels;
+}
+
+/*
+==================
+Renders a cached layer (see setLayerCache()). The entities are only drawn into the render target when
+one of them has changed or the camera can't reuse the render target. Otherwise, only the render target
+is drawn.
+==================
+*/
+void IND_Entity2dManager::renderLayerCache(int pLayer) {
+	LAYER_CACHE *mCache = _layerCaches [pLayer];
+
+	// Without an update() pass, the animations advance here, also when the layer isn't drawn again
+	bool mDirty = mCache->_dirty;
+	vector <IND_Entity2d *>::iterator mIter;
+	for (mIter  = _listEntities2d[pLayer]->begin();
+	        mIter != _listEntities2d[pLayer]->end();
+	        mIter++) {
+		IND_Entity2d *mEn = *mIter;
+		if (!_updatePass && mEn->_show && mEn->_an && !mEn->_su)
+			updateEntity(mEn, _render->getAnimationClock());
+
+		if (mEn->_updateCacheFlag) {
+			mDirty = true;
+			mEn->_updateCacheFlag = 0;
+		}
+	}
+
+	if (!mDirty && _render->blitRenderTarget(mCache->_surface, mCache->_camera, mCache->_margin))
+		return;
+
+	// Draws the layer into the render target
+	if (!_render->beginRenderTarget(mCache->_surface, mCache->_margin, &mCache->_camera)) {
+		renderLayer(pLayer, false);
+		return;
+	}
+
+	renderLayer(pLayer, false);
+	_render->endRenderTarget();
+	mCache->_dirty = false;
+
+	_render->blitRenderTarget(mCache->_surface, mCache->_camera, mCache->_margin);
+}
+
+/*
+==================
+Renders an entity of a layer. The animation of the entity is advanced if pUpdate is true.
+==================
+*/
+void IND_Entity2dManager::renderEntity(IND_Entity2d *pEn, bool pUpdate) {
+	bool mFillStats = _render->isFillStats();
+	int mFillPixels = mFillStats ? _render->getCurrentFillPixels() : 0;
+
+	// If it has an animation or a surface assigned
+	if (pEn->_su || pEn->_an) {
+		// Set transformations ONLY if the entity space attributes has been modified
+		if (pEn->_updateTransFlag)
+			setEntityTransform(pEn);
+		else
+			_render->setTransform2d(pEn->_mat);
+
+		// ----- Color attributes -----
+
+		_render->setRainbow2d(pEn->getType(),
+		                      pEn->_cull,
+		                      pEn->_mirrorX,
+		                      pEn->_mirrorY,
+		                      pEn->_filter,
+		                      pEn->_r,
+		                      pEn->_g,
+		                      pEn->_b,
+		                      pEn->_a,
+		                      pEn->_fadeR,
+		                      pEn->_fadeG,
+		                      pEn->_fadeB,
+		                      pEn->_fadeA,
+		                      pEn->_so,
+		                      pEn->_ds);
+
+		// ----- Surface blitting -----
+
+		if (pEn->_su) {
+			// Surface region specified
+			if ((pEn->_regionWidth > 0) && (pEn->_regionHeight > 0)) {
+				// X or Y wrapping
+				if (pEn->_wrap) {
+					_render->blitWrapSurface(pEn->_su,
+					                         pEn->_regionWidth,
+					                         pEn->_regionHeight,
+					                         pEn->_uOffset,
+					                         pEn->_vOffset);
+				}
+				// No wrapping
+				else {
+					_render->blitRegionSurface(pEn->_su,
+					                           pEn->_offX,
+					                           pEn->_offY,
+					                           pEn->_regionWidth,
+					                           pEn->_regionHeight);
+				}
+			}
+			// Blits all the surface
+			else
+				_render->blitSurface(pEn->_su);
+		}
+
+		// ----- Animation blitting -----
+
+		else {
+			// Without an update() pass, the animation advances when it is drawn
+			if (pUpdate)
+				updateEntity(pEn, _render->getAnimationClock());
+
+			_render->blitAnimationFrame(pEn->_an,
+			                            pEn->_sequence,
+			                            pEn->_playback._frame,
+			                            pEn->_offX,
+			                            pEn->_offY,
+			                            pEn->_regionWidth,
+			                            pEn->_regionHeight,
+			                            pEn->_wrap,
+			                            pEn->_uOffset,
+			                            pEn->_vOffset);
+		}
+	} else
+		// If it has a 2d primitive assigned
+		if (pEn->_pri2d) {
+			switch (pEn->_pri2d) {
+				// Pixel
+			case IND_PIXEL: {
+
+				_render->blitPixel((int)pEn->_x,
+				                   (int)pEn->_y,
+				                   pEn->_r,
+				                   pEn->_g,
+				                   pEn->_b,
+				                   pEn->_a);
+				break;
+			}
+
+			// Regular polygon
+			case IND_REGULAR_POLY: {
+
+				_render->blitRegularPoly((int)pEn->_x,
+				                         (int)pEn->_y,
+				                         pEn->_radius,
+				                         pEn->_numSides,
+				                         pEn->_polyAngle,
+				                         pEn->_r,
+				                         pEn->_g,
+				                         pEn->_b,
+				                         pEn->_a);
+				break;
+			}
+
+			// Rectangle
+			case IND_RECTANGLE: {
+
+				_render->blitRectangle(pEn->_x1,
+				                       pEn->_y1,
+				                       pEn->_x2,
+				                       pEn->_y2,
+				                       pEn->_r,
+				                       pEn->_g,
+				                       pEn->_b,
+				                       pEn->_a);
+				break;
+			}
+
+			// Fill rectangle
+			case IND_FILL_RECTANGLE: {
+				_render->blitFillRectangle(pEn->_x1,
+				                           pEn->_y1,
+				                           pEn->_x2,
+				                           pEn->_y2,
+				                           pEn->_r,
+				                           pEn->_g,
+				                           pEn->_b,
+				                           pEn->_a);
+				break;
+			}
+
+			// Poly2d
+			case IND_POLY2D: {
+
+				_render->blitPoly2d(pEn->_polyPoints,
+				                    pEn->_numLines,
+				                    pEn->_r,
+				                    pEn->_g,
+				                    pEn->_b,
+				                    pEn->_a);
+				break;
+			}
+
+			// Line
+			case IND_LINE: {
+
+				_render->blitLine(pEn->_x1,
+				                  pEn->_y1,
+				                  pEn->_x2,
+				                  pEn->_y2,
+				                  pEn->_r,
+				                  pEn->_g,
+				                  pEn->_b,
+				                  pEn->_a);
+				break;
+			}
+			}
+		} else
+			// If it has a font assigned
+			if (pEn->_font) {
+
+				// The quads of the text are kept by the entity
+				if (!pEn->_textMesh)
+					pEn->_textMesh = new TextMesh();
+				_render->setTextMesh(pEn->_textMesh);
+
+				_render->blitText(pEn->_font,
+				                  pEn->_text,
+				                  (int)pEn->_x,
+				                  (int)pEn->_y,
+				                  pEn->_charSpacing,
+				                  pEn->_lineSpacing,
+				                  pEn->_scaleX,
+				                  pEn->_scaleY,
+				                  pEn->_r,
+				                  pEn->_g,
+				                  pEn->_b,
+				                  pEn->_a,
+				                  pEn->_fadeR,
+				                  pEn->_fadeG,
+				                  pEn->_fadeB,
+				                  pEn->_fadeA,
+				                  pEn->_filter,
+				                  pEn->_so,
+				                  pEn->_ds,
+				                  pEn->_align);
+
+				_render->setTextMesh(NULL);
+			}
+
+	if (mFillStats)
+		pEn->_fillPixels = _render->getCurrentFillPixels() - mFillPixels;
+}
+
+/*
+==================
+Calculates and sets the transformation of an entity (its space attributes have been modified)
+==================
+*/
+void IND_Entity2dManager::setEntityTransform(IND_Entity2d *pEn) {
+	pEn->_updateTransFlag = 0;
+
+	int mWidthTemp = 0;
+	int mHeightTemp = 0;
+
+	// ---- We obtain the width and height of the animation or the surface -----
+
+	if (pEn->_su) {
+		mWidthTemp  = pEn->_su->getWidth();
+		mHeightTemp = pEn->_su->getHeight();
+	} else {
+		mWidthTemp  = pEn->_an->getFrameWidth(pEn->_sequence, pEn->_playback._frame);
+		mHeightTemp = pEn->_an->getFrameHeight(pEn->_sequence, pEn->_playback._frame);
+	}
+
+	// ----- Transformations -----
+
+	_render->setTransform2d((int)pEn->_x,
+	                        (int)pEn->_y,
+	                        pEn->_angleX,
+	                        pEn->_angleY,
+	                        pEn->_angleZ,
+	                        pEn->_scaleX,
+	                        pEn->_scaleY,
+	                        pEn->_axisCalX,
+	                        pEn->_axisCalY,
+	                        pEn->_mirrorX,
+	                        pEn->_mirrorY,
+	                        mWidthTemp,
+	                        mHeightTemp,
+	                        &pEn->_mat);
+}
+
+/*
+==================
+Renders a layer in two passes: the opaque entities from the front to the back, writing their depth,
+and then the rest of the entities from the back to the front, tested against the depth of the opaque
+ones. The alpha tested entities are drawn in both passes, for the translucent pixels of their edges.
+Each entity gets its own depth from its position in the sorted list, so the pixels that were drawn
+in the opaque pass are only covered by the entities that are in front of them, like when the layer
+is drawn from the back to the front.
+==================
+*/
+void IND_Entity2dManager::renderOpaqueFirst(vector <IND_Entity2d *> *pList, bool pUpdate) {
+	vector <IND_Entity2d *> *mList = pList;
+	int mNumEntities = static_cast<int>(mList->size());
+
+	// Transformations and animations are updated once, before both passes
+	int mNumOpaque = 0;
+	for (int i = 0; i < mNumEntities; i++) {
+		IND_Entity2d *mEn = (*mList) [i];
+		if (!mEn->_show || (!mEn->_su && !mEn->_an))
+			continue;
+
+		if (mEn->_updateTransFlag)
+			setEntityTransform(mEn);
+		if (!mEn->_su && pUpdate)
+			updateEntity(mEn, _render->getAnimationClock());
+
+		if (isOpaqueEntity(mEn))
+			mNumOpaque++;
+	}
+
+	// Back to front only
+	if (!mNumOpaque || !_render->beginOpaquePass()) {
+		for (int i = 0; i < mNumEntities; i++) {
+			if ((*mList) [i]->_show)
+				renderEntity((*mList) [i], false);
+		}
+		return;
+	}
+
+	// Opaque pass, front to back
+	for (int i = mNumEntities - 1; i >= 0; i--) {
+		IND_Entity2d *mEn = (*mList) [i];
+		if (mEn->_show && isOpaqueEntity(mEn)) {
+			_render->setDepth(static_cast<float>(mNumEntities - i) / (mNumEntities + 1));
+			renderEntity(mEn, false);
+		}
+	}
+
+	_render->endOpaquePass();
+
+	// Translucent pass, back to front. The fully opaque entities were completely drawn in the opaque pass.
+	for (int i = 0; i < mNumEntities; i++) {
+		IND_Entity2d *mEn = (*mList) [i];
+		if (mEn->_show && getEntityAlphaClass(mEn) != IND_ALPHA_CLASS_OPAQUE) {
+			_render->setDepth(static_cast<float>(mNumEntities - i) / (mNumEntities + 1));
+			renderEntity(mEn, false);
+		}
+	}
+
+	_render->endDepthPasses();
+}
+
+/*
+==================
+Selects the entities of a layer that are in the area seen by the camera, using the spatial index of
+the layer. First, the bounds of the entities that have changed since the last frame are calculated
+again. Returns the whole layer if the renderer can't calculate the visible area.
+==================
+*/
+vector <IND_Entity2d *> *IND_Entity2dManager::selectVisible(int pLayer) {
+	SpatialGrid *mGrid = _layerGrids [pLayer];
+
+	vector <IND_Entity2d *> *mDirty = mGrid->getDirty();
+	for (size_t i = 0; i < mDirty->size(); i++)
+		updateSpatialBounds(mGrid, (*mDirty) [i]);
+	mGrid->clearDirty();
+
+	IND_Vector3 mMin, mMax;
+	if (!_render->getVisibleArea(&mMin, &mMax)) {
+		_layerCulled [pLayer] = 0;
+		return _listEntities2d[pLayer];
+	}
+
+	_listVisible.clear();
+	mGrid->query(mMin._x, mMin._y, mMax._x, mMax._y, &_listVisible);
+	_layerCulled [pLayer] = static_cast<int>(_listEntities2d[pLayer]->size() - _listVisible.size());
+
+	return &_listVisible;
+}
+
+/*
+==================
+Calculates the world bounding box of an entity (the corners of its surface or of the biggest frame of
+its sequence, transformed by its world matrix) and updates it in the spatial index
+==================
+*/
+void IND_Entity2dManager::updateSpatialBounds(SpatialGrid *pGrid, IND_Entity2d *pEn) {
+	// Primitives and fonts are always drawn
+	if (!pEn->_su && !pEn->_an) {
+		pGrid->updateUnbounded(pEn);
+		return;
+	}
+
+	if (pEn->_updateTransFlag)
+		setEntityTransform(pEn);
+
+	int mWidth = 0;
+	int mHeight = 0;
+	if (pEn->_su) {
+		mWidth = pEn->_su->getWidth();
+		mHeight = pEn->_su->getHeight();
+	} else {
+		unsigned int mNumFrames = pEn->_an->getNumFrames(pEn->_sequence);
+		for (unsigned int i = 0; i < mNumFrames; i++) {
+			int mFrameWidth = static_cast<int>(pEn->_an->getFrameOffsetX(pEn->_sequence, i)) + pEn->_an->getFrameWidth(pEn->_sequence, i);
+			int mFrameHeight = static_cast<int>(pEn->_an->getFrameOffsetY(pEn->_sequence, i)) + pEn->_an->getFrameHeight(pEn->_sequence, i);
+			if (mFrameWidth > mWidth) mWidth = mFrameWidth;
+			if (mFrameHeight > mHeight) mHeight = mFrameHeight;
+		}
+	}
+
+	// Regions can be bigger than the image when they are wrapped
+	if (pEn->_regionWidth > mWidth) mWidth = pEn->_regionWidth;
+	if (pEn->_regionHeight > mHeight) mHeight = pEn->_regionHeight;
+
+	IND_Vector3 mCorners [4];
+	mCorners [0] = IND_Vector3(0.0f, 0.0f, 0.0f);
+	mCorners [1] = IND_Vector3(static_cast<float>(mWidth), 0.0f, 0.0f);
+	mCorners [2] = IND_Vector3(0.0f, static_cast<float>(mHeight), 0.0f);
+	mCorners [3] = IND_Vector3(static_cast<float>(mWidth), static_cast<float>(mHeight), 0.0f);
+
+	float mMinX = 0.0f, mMinY = 0.0f, mMaxX = 0.0f, mMaxY = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		_math->transformVector3DbyMatrix4D(mCorners [i], pEn->_mat);
+		if (!i || mCorners [i]._x < mMinX) mMinX = mCorners [i]._x;
+		if (!i || mCorners [i]._y < mMinY) mMinY = mCorners [i]._y;
+		if (!i || mCorners [i]._x > mMaxX) mMaxX = mCorners [i]._x;
+		if (!i || mCorners [i]._y > mMaxY) mMaxY = mCorners [i]._y;
+	}
+
+	pGrid->update(pEn, mMinX, mMinY, mMaxX, mMaxY);
+}
+
+/*
+==================
+Returns true if an entity can be drawn in the opaque pass: a surface or the actual frame of an
+animation that isn't translucent, without alpha, fade or other blending types
+==================
+*/
+bool IND_Entity2dManager::isOpaqueEntity(IND_Entity2d *pEn) {
+	return getEntityAlphaClass(pEn) != IND_ALPHA_CLASS_TRANSLUCENT;
+}
+
+/*
+==================
+Returns the alpha class of the surface or of the actual frame of the animation of an entity, or
+IND_ALPHA_CLASS_TRANSLUCENT if the entity has alpha, fade or other blending types, or no surface
+==================
+*/
+IND_AlphaClass IND_Entity2dManager::getEntityAlphaClass(IND_Entity2d *pEn) {
+	if (pEn->_a != 255 || pEn->_fadeA != 255 || pEn->_so || pEn->_ds)
+		return IND_ALPHA_CLASS_TRANSLUCENT;
+
+	IND_Surface *mSurface = pEn->_su;
+	if (!mSurface && pEn->_an)
+		mSurface = pEn->_an->getSurface(pEn->_an->getFramePosInVec(pEn->_sequence, pEn->_playback._frame));
+
+	return mSurface ? mSurface->getAlphaClass() : IND_ALPHA_CLASS_TRANSLUCENT;
+}
+
+/*
+==================
+Advances the animation of an entity: actual frame, elapsed time and replays
+==================
+*/
+void IND_Entity2dManager::updateEntity(IND_Entity2d *pEn, double pClock) {
+	int mFrame = pEn->_playback._frame;
+
+	// Returns -1 when the sequence finishes
+	if (pEn->_an->updateSequence(pEn->_sequence, &pEn->_playback, pClock) != -1) {
+		if (pEn->_playback._frame != mFrame)
+			pEn->_updateCacheFlag = 1;
+		return;
+	}
+
+	// Animation is looping
+	if (pEn->_numReplays == -1) {
+		// Reset the animation
+		pEn->_playback._frame = 0;
+	}
+	// There are replays
+	else if (pEn->_numReplays > 0) {
+		// Reset animation
+		pEn->_playback._frame = 0;
+
+		// Decrease the number of replays
+		pEn->_numReplays--;
+	}
+	// There are no replays: the last frame stays
+
+	if (pEn->_playback._frame != mFrame)
+		pEn->_updateCacheFlag = 1;
+}
+
+/*
+==================
+Updates the entities [pFirst, pLast) of the update list
+==================
+*/
+void IND_Entity2dManager::updateEntities(int pFirst, int pLast, double pClock) {
+	int mLast = pLast < static_cast<int>(_listUpdate.size()) ? pLast : static_cast<int>(_listUpdate.size());
+	for (int i = pFirst; i < mLast; i++)
+		updateEntity(_listUpdate [i], pClock);
+}
+
+/*
+==================
+Update thread (see UPDATE_WORKER)
+==================
+*/
+int IND_Entity2dManager::updateThread(void *pWorker) {
+	UPDATE_WORKER *mWorker = static_cast<UPDATE_WORKER *>(pWorker);
+
+	for (;;) {
+		SDL_SemWait(mWorker->_start);
+		if (mWorker->_quit)
+			break;
+
+		mWorker->_manager->updateEntities(mWorker->_first, mWorker->_last, mWorker->_clock);
+		SDL_SemPost(mWorker->_done);
+	}
+
+	return 0;
+}
+
+/*
+==================
+Finishes the update threads
+==================
+*/
+void IND_Entity2dManager::freeUpdateThreads() {
+	vector <UPDATE_WORKER *>::iterator mIter;
+	for (mIter  = _listUpdateWorkers.begin();
+	        mIter != _listUpdateWorkers.end();
+	        mIter++) {
+		(*mIter)->_quit = true;
+		SDL_SemPost((*mIter)->_start);
+		SDL_WaitThread((*mIter)->_thread, NULL);
+		SDL_DestroySemaphore((*mIter)->_start);
+		SDL_DestroySemaphore((*mIter)->_done);
+		DISPOSE(*mIter);
+	}
+
+	_listUpdateWorkers.clear();
+	_numUpdateThreads = 1;
+}
+
 /*
 ==================
 Check the collision between bounding areas
@@ -778,6 +1390,9 @@ Inserts object into the manager in a certain layer
 */
 void IND_Entity2dManager::addToList(int pLayer, IND_Entity2d *pNewEntity2d) {
 	_listEntities2d[pLayer]->push_back(pNewEntity2d);
+
+	if (_layerGrids [pLayer])
+		_layerGrids [pLayer]->insert(pNewEntity2d);
 }
 
 
@@ -799,8 +1414,17 @@ Init manager vars
 ==================
 */
 void IND_Entity2dManager::initVars() {
-	for (int i = 0; i < NUM_LAYERS; i++)
+	for (int i = 0; i < NUM_LAYERS; i++) {
 		_listEntities2d [i] = new vector <IND_Entity2d *>;
+		_layerFillPixels [i] = 0;
+		_layerCaches [i] = NULL;
+		_layerGrids [i] = NULL;
+		_layerCulled [i] = 0;
+	}
+
+	_updatePass = false;
+	_updateClock = 0.0;
+	_numUpdateThreads = 1;
 }
 
 
@@ -814,6 +1438,9 @@ void IND_Entity2dManager::freeVars() {
 	vector <IND_Entity2d *>::iterator mEntityListIter;
 
 	for (int i = 0; i < NUM_LAYERS; i++) {
+		// Free spatial index
+		DISPOSE(_layerGrids [i]);
+
 		for (mEntityListIter  = _listEntities2d[i]->begin();
 		        mEntityListIter != _listEntities2d[i]->end();
 		        mEntityListIter++) {
@@ -830,6 +1457,12 @@ void IND_Entity2dManager::freeVars() {
 
 		// Free list
 		DISPOSE(_listEntities2d[i]);
+
+		// Free render target
+		if (_layerCaches [i]) {
+			DISPOSEMANAGED(_layerCaches [i]->_surface);
+			DISPOSE(_layerCaches [i]);
+		}
 	}
 }
 
@@ -207,6 +207,10 @@ bool IND_FontManager::addMudFont(IND_Font		*pNewFont,
 
 	pNewFont->setSurface(mNewSurface);
 
+	// ----- Lookup table of the letters -----
+
+	pNewFont->buildLetterLookup();
+
 	// ----- Puts the object into the manager -----
 
 	addToList(pNewFont);
@@ -248,6 +252,11 @@ bool IND_FontManager::addAngelcodeFont(IND_Font     *pNewFont,
         return 0;
     
     
+    // ----- Lookup table of the letters -----
+    
+	pNewFont->buildLetterLookup();
+    
+    
     // ----- Puts the object into the manager -----
     
 	addToList(pNewFont);
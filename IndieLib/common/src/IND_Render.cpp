@@ -35,6 +35,8 @@
 #include "Global.h"
 #include "IND_Math.h"
 #include "IND_SurfaceManager.h"
+#include "IND_Surface.h"
+#include "IND_Animation.h"
 #include "IND_Timer.h"
 #include "IND_Render.h"
 #include "dependencies/SDL-2.0/include/SDL.h"
@@ -241,6 +243,13 @@ void IND_Render::beginScene() {
 	_last = (currenttime - _lastTime);
 	_lastTime = currenttime;
 
+	// Fixed time step (deterministic animations)
+	if (_fixedFrameTime > 0.0f)
+		_last = _fixedFrameTime;
+
+	// All the animations of this frame use the same clock
+	_animationClock += _last;
+
 	// ----- Fps counter ------
 
 	_fpsCounter++;
@@ -253,6 +262,24 @@ void IND_Render::beginScene() {
 		_fpsCounter = 0;
 	}
 
+	// ----- Texture uploads counter -----
+
+	_lastUploadBytes = _uploadBytes;
+	_lastUploadTime = _uploadTime;
+	_uploadBytes = 0;
+	_uploadTime = 0.0f;
+
+	_lastTrimmedPixels = _trimmedPixels;
+	_trimmedPixels = 0;
+
+	// ----- Fill rate statistics -----
+
+	if (_fillStats) {
+		for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+			_lastFillPixels [i] = _wrappedRenderer->getFillPixels(i);
+		_wrappedRenderer->resetFillStats();
+	}
+
 	// Set culling region
 	reCalculateFrustrumPlanes();
 
@@ -397,15 +424,25 @@ int IND_Render::blitAnimation(IND_Animation *pAn,
                               bool pToggleWrap,
                               float pUOffset,
                               float pVOffset) {
-	return (_wrappedRenderer->blitAnimation(pAn,
-	                                        pSequence,
-	                                        pX,
-	                                        pY,
-	                                        pWidth,
-	                                        pHeight,
-	                                        pToggleWrap,
-	                                        pUOffset,
-	                                        pVOffset));
+	// Advance the sequence using the clock of this frame
+	int mFinish = pAn->updateSequence(pSequence, _animationClock);
+
+	if (!pX && !pY && !pWidth && !pHeight)
+		addTrimmedPixels(pAn, pSequence, pAn->getActualFramePos(pSequence));
+
+	if (!_wrappedRenderer->blitAnimation(pAn,
+	                                     pSequence,
+	                                     pAn->getActualFramePos(pSequence),
+	                                     pX,
+	                                     pY,
+	                                     pWidth,
+	                                     pHeight,
+	                                     pToggleWrap,
+	                                     pUOffset,
+	                                     pVOffset))
+		return 0;
+
+	return mFinish;
 }
 /**@}*/
 
@@ -470,6 +507,7 @@ Using this method is equivalent to using:
 - IND_Entity2d::setSurface()
 */
 void IND_Render::blitSurface(IND_Surface *pSu) {
+	addTrimmedPixels(pSu);
 	_wrappedRenderer->blitSurface(pSu);
 }
 
@@ -1391,6 +1429,208 @@ void IND_Render::resetNumDiscardedObjects()      {
 	_wrappedRenderer->resetNumDiscardedObjects();
 }
 
+/**
+@b Parameters:
+
+@arg <b>pFillStats</b>          True for enabling the fill rate statistics
+@arg <b>pHeatmap</b>            True for drawing the overdraw heatmap too
+
+@b Operation:
+
+Enables or disables the fill rate statistics. When they are enabled, the area on the screen of each quad
+of a surface or animation that is drawn (its bounding rectangle, clipped to the viewport) is counted, split
+by its blending (see ::IND_FillBlend). The pixels of the last frame are returned by IND_Render::getFillPixelsInt()
+and IND_Render::getOverdraw(), and also by IND_Entity2dManager::getFillPixelsInt() for each layer and by
+IND_Entity2d::getFillPixelsInt() for each entity, so the layers and entities that cost more pixels can be found.
+
+With @b pHeatmap, each quad is also added, with additive blending, into an offscreen texture of the size of
+the viewport. The texture is drawn on the screen with IND_Render::blitOverdrawHeatmap(): the more times a pixel
+is drawn, the brighter it is (red, yellow and white).
+
+The statistics slow down the rendering, so they should only be used for profiling. Returns 0 (false) if the
+renderer doesn't support them, or the heatmap when it can't be created (only the OpenGL renderer supports them).
+*/
+bool IND_Render::setFillStats(bool pFillStats, bool pHeatmap) {
+	for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+		_lastFillPixels [i] = 0;
+
+	_fillStats = _wrappedRenderer->setFillStats(pFillStats, pHeatmap);
+	return _fillStats == pFillStats;
+}
+
+/**
+@b Operation:
+
+This function returns the number of pixels drawn during the last frame (see IND_Render::setFillStats()).
+*/
+int IND_Render::getFillPixelsInt() {
+	int mPixels = 0;
+	for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+		mPixels += _lastFillPixels [i];
+
+	return mPixels;
+}
+
+/**
+@b Parameters:
+
+@arg <b>pBlend</b>              Blending of the pixels. See ::IND_FillBlend
+
+@b Operation:
+
+This function returns the number of pixels drawn with a blending during the last frame (see IND_Render::setFillStats()).
+*/
+int IND_Render::getFillPixelsInt(IND_FillBlend pBlend) {
+	if (pBlend < 0 || pBlend >= IND_FILL_BLEND_MODES)
+		return 0;
+
+	return _lastFillPixels [pBlend];
+}
+
+/**
+@b Operation:
+
+This function returns the overdraw of the last frame: the pixels drawn divided by the pixels of the
+viewport (see IND_Render::setFillStats()). An overdraw of 3 means that each pixel was drawn 3 times.
+*/
+float IND_Render::getOverdraw() {
+	int mArea = getViewPortWidth() * getViewPortHeight();
+	if (!mArea)
+		return 0.0f;
+
+	return static_cast<float>(getFillPixelsInt()) / static_cast<float>(mArea);
+}
+
+/**
+@b Operation:
+
+Draws the overdraw heatmap of the current frame over the viewport (see IND_Render::setFillStats()).
+It should be called after drawing all the entities, before IND_Render::endScene(). Returns 0 (false)
+if the heatmap is not enabled.
+*/
+bool IND_Render::blitOverdrawHeatmap() {
+	return _wrappedRenderer->blitOverdrawHeatmap();
+}
+
+/**
+@b Parameters:
+
+@arg <b>pProgrammable</b>       True for drawing with the programmable 2d renderer, false for the fixed pipeline
+
+@b Operation:
+
+Enables or disables the programmable 2d renderer. Surfaces, regions, wrapped surfaces, animations and text are
+drawn with shaders (OpenGL 3.3) instead of the fixed pipeline, and give the same images. Their quads are kept in
+a vertex buffer, already transformed, with the tint, transparency and fade of each entity as the color of the
+vertices. So consecutive quads of the same texture are drawn at once, even when they have different transforms
+or colors. The quads are drawn when the texture, the blending or the culling changes, and before drawing
+primitives or changing the camera. The camera and the projection are kept in a uniform buffer, that is
+only updated when they change.
+
+The programmable renderer doesn't use the fixed state: the alpha test is done in the fragment shader and the
+transforms are only taken from the uniform buffer and the vertices. The OpenGL context is still a compatibility
+one, because the fixed pipeline (primitives, 3d and the default 2d renderer) shares it.
+
+Drawing in the same order the entities that share a texture (an atlas, see IND_AnimationManager::setAtlas())
+gives the biggest batches.
+
+Returns 0 (false) if the programmable renderer can't be enabled (only the OpenGL renderer supports it, and it
+needs OpenGL 3.3).
+*/
+bool IND_Render::setProgrammable2d(bool pProgrammable) {
+	return _wrappedRenderer->setProgrammable2d(pProgrammable) == pProgrammable;
+}
+
+/**
+@b Operation:
+
+This function returns true if the programmable 2d renderer is enabled (see IND_Render::setProgrammable2d()).
+*/
+bool IND_Render::isProgrammable2d() {
+	return _wrappedRenderer->isProgrammable2d();
+}
+
+/**
+@b Parameters:
+
+@arg <b>pDirectory</b>          Existing directory where the linked shader programs are kept, or NULL for no cache
+
+@b Operation:
+
+Sets a cache on disk for the shader programs of the renderer (GL_ARB_get_program_binary). The first time a
+program is linked its binary is written to the directory, and the next runs load it instead of compiling
+the sources. The name of each binary is a hash of the sources and the vendor, chip and version of the driver,
+so a new driver doesn't load the binaries of the previous one. When the binary is missing or the driver
+rejects it, the program is compiled from the sources again. The time spent loading, compiling and linking
+each program is written to the debug log.
+
+It has to be called before enabling the programmable 2d renderer (see IND_Render::setProgrammable2d()).
+Only the OpenGL renderer supports it, and only when the driver has the extension.
+*/
+void IND_Render::setProgramBinaryCache(const char *pDirectory) {
+	_wrappedRenderer->setProgramBinaryCache(pDirectory);
+}
+
+/**
+@b Parameters:
+
+@arg <b>pDistanceField</b>      True if the next surfaces are signed distance fields, false for normal surfaces
+
+@b Operation:
+
+Sets if the alpha channel of the surfaces drawn next is a signed distance field instead of their coverage: 0.5
+on the edge of the shape, more inside and less outside (i.e. the glyphs of IND_TTF_Font::setDistanceField()).
+The edges stay sharp at any scale or zoom of the camera. With the programmable 2d renderer (see
+IND_Render::setProgrammable2d()) the edges are antialiased and can have an outline and a shadow (see
+IND_Render::setDistanceFieldOutline2d() and IND_Render::setDistanceFieldShadow2d()). With the fixed pipeline
+the pixels outside the edge are discarded with the alpha test, without antialiasing or effects.
+
+It isn't reset by IND_Render::setRainbow2d(), call it again with false after drawing the distance fields.
+
+Returns 0 (false) if distance fields are not supported (only the OpenGL renderer supports them).
+*/
+bool IND_Render::setDistanceField2d(bool pDistanceField) {
+	return _wrappedRenderer->setDistanceField2d(pDistanceField) == pDistanceField;
+}
+
+/**
+@b Parameters:
+
+@arg <b>pWidth</b>              Width of the outline, in units of the distance field (0 = no outline, 0.5 = up to the end of the field)
+@arg <b>pR</b>                  Byte R (Red) of the outline
+@arg <b>pG</b>                  Byte G (Green) of the outline
+@arg <b>pB</b>                  Byte B (Blue) of the outline
+@arg <b>pA</b>                  Byte A (Transparency) of the outline
+
+@b Operation:
+
+Sets the outline drawn around the distance fields (see IND_Render::setDistanceField2d()). Only the programmable
+2d renderer draws it.
+*/
+void IND_Render::setDistanceFieldOutline2d(float pWidth, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA) {
+	_wrappedRenderer->setDistanceFieldOutline2d(pWidth, pR, pG, pB, pA);
+}
+
+/**
+@b Parameters:
+
+@arg <b>pOffsetX</b>            Horizontal offset of the shadow, in texels of the distance field
+@arg <b>pOffsetY</b>            Vertical offset of the shadow, in texels of the distance field
+@arg <b>pR</b>                  Byte R (Red) of the shadow
+@arg <b>pG</b>                  Byte G (Green) of the shadow
+@arg <b>pB</b>                  Byte B (Blue) of the shadow
+@arg <b>pA</b>                  Byte A (Transparency) of the shadow (0 = no shadow)
+
+@b Operation:
+
+Sets the shadow drawn behind the distance fields (see IND_Render::setDistanceField2d()). The shadow is cut at
+the border of each surface, so the offset shouldn't be bigger than the spread of the field. Only the
+programmable 2d renderer draws it.
+*/
+void IND_Render::setDistanceFieldShadow2d(float pOffsetX, float pOffsetY, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA) {
+	_wrappedRenderer->setDistanceFieldShadow2d(pOffsetX, pOffsetY, pR, pG, pB, pA);
+}
+
 // --------------------------------------------------------------------------------
 //							        Private methods
 // --------------------------------------------------------------------------------
@@ -1448,6 +1688,16 @@ void IND_Render::reCalculateFrustrumPlanes() {
 	_wrappedRenderer->reCalculateFrustrumPlanes();
 }
 
+/*
+==================
+World bounding rectangle of the area seen by the camera. Returns 0 if the underlying renderer can't
+calculate it (then nothing can be discarded before transforming it).
+==================
+*/
+bool IND_Render::getVisibleArea(IND_Vector3 *pMin, IND_Vector3 *pMax) {
+	return _wrappedRenderer->getVisibleArea(pMin, pMax);
+}
+
 /*
  ==================
  Blits a bounding circle area
@@ -1467,4 +1717,168 @@ void IND_Render::blitCollisionLine(int pPosX1, int pPosY1, int pPosX2, int pPosY
 	_wrappedRenderer->blitCollisionLine(pPosX1, pPosY1, pPosX2, pPosY2, pR, pG, pB, pA, pIndWorldMatrix);
 }
 
+/*
+ ==================
+ Accounts texture data uploaded by the texture builder during the current frame
+ ==================
+ */
+void IND_Render::addTextureUpload(int pBytes, float pTime) {
+	_uploadBytes += pBytes;
+	_uploadTime += pTime;
+}
+
+
+/*
+==================
+Counts the pixels of a surface that are not drawn because its transparent borders were trimmed
+==================
+*/
+void IND_Render::addTrimmedPixels(IND_Surface *pSu) {
+	if (pSu->isTrimmed())
+		_trimmedPixels += pSu->getWidth() * pSu->getHeight() - pSu->getTrimWidth() * pSu->getTrimHeight();
+}
+
+
+/*
+==================
+Counts the pixels of a frame of an animation that are not drawn because its transparent borders
+were trimmed (in its own surface or in an atlas page)
+==================
+*/
+void IND_Render::addTrimmedPixels(IND_Animation *pAn, unsigned int pSequence, unsigned int pFrame) {
+	int mX = 0, mY = 0, mWidth = 0, mHeight = 0, mDrawX, mDrawY;
+	if (pAn->getFrameAtlas(pSequence, pFrame, &mX, &mY, &mWidth, &mHeight, &mDrawX, &mDrawY)) {
+		_trimmedPixels += pAn->getFrameWidth(pSequence, pFrame) * pAn->getFrameHeight(pSequence, pFrame) - mWidth * mHeight;
+	} else {
+		IND_Surface *mSurface = pAn->getFrameSurface(pSequence, pFrame);
+		if (mSurface)
+			addTrimmedPixels(mSurface);
+	}
+}
+
+
+/*
+==================
+Blits a frame of a sequence of an animation. The animation is not advanced (entities keep their
+own playback, see IND_Entity2dManager::update()). Returns 0 if the frame can't be blitted.
+==================
+*/
+int IND_Render::blitAnimationFrame(IND_Animation *pAn,
+                                   unsigned int pSequence,
+                                   unsigned int pFrame,
+                                   int pX,
+                                   int pY,
+                                   int pWidth,
+                                   int pHeight,
+                                   bool pToggleWrap,
+                                   float pUOffset,
+                                   float pVOffset) {
+	if (!pX && !pY && !pWidth && !pHeight)
+		addTrimmedPixels(pAn, pSequence, pFrame);
+
+	return _wrappedRenderer->blitAnimation(pAn,
+	                                       pSequence,
+	                                       pFrame,
+	                                       pX,
+	                                       pY,
+	                                       pWidth,
+	                                       pHeight,
+	                                       pToggleWrap,
+	                                       pUOffset,
+	                                       pVOffset);
+}
+
+/*
+==================
+Starts the opaque pass of a layer (see IND_Entity2dManager::setOpaqueFirst()): the depth buffer is
+cleared and the fully opaque pixels of the next blits write their depth. Returns 0 if the renderer
+doesn't support it.
+==================
+*/
+bool IND_Render::beginOpaquePass() {
+	return _wrappedRenderer->beginOpaquePass();
+}
+
+/*
+==================
+Finishes the opaque pass. The next blits are depth tested against the opaque pixels, without
+writing their depth, until endDepthPasses() is called. The statistics count the blits of both passes:
+the alpha tested entities are drawn in both of them.
+==================
+*/
+void IND_Render::endOpaquePass() {
+	_wrappedRenderer->endOpaquePass();
+}
+
+/*
+==================
+Sets the depth (0 = nearest, 1 = farthest) of the next blits of the opaque and translucent passes
+==================
+*/
+void IND_Render::setDepth(float pDepth) {
+	_wrappedRenderer->setDepth(pDepth);
+}
+
+/*
+==================
+Restores the default state (no depth test) after the translucent pass
+==================
+*/
+void IND_Render::endDepthPasses() {
+	_wrappedRenderer->endDepthPasses();
+}
+
+/*
+==================
+Returns the pixels drawn in the current frame, when the fill rate statistics are enabled
+==================
+*/
+int IND_Render::getCurrentFillPixels() {
+	int mPixels = 0;
+	for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+		mPixels += _wrappedRenderer->getFillPixels(i);
+
+	return mPixels;
+}
+
+/*
+==================
+Starts drawing into a render target (a surface that covers the viewport plus pMargin pixels in each
+side, seen by the actual camera, which is returned in pCamera). Returns 0 if the renderer doesn't
+support render targets.
+==================
+*/
+bool IND_Render::beginRenderTarget(IND_Surface *pSu, int pMargin, IND_Matrix *pCamera) {
+	return _wrappedRenderer->beginRenderTarget(pSu, pMargin, pCamera);
+}
+
+/*
+==================
+Finishes drawing into a render target
+==================
+*/
+void IND_Render::endRenderTarget() {
+	_wrappedRenderer->endRenderTarget();
+}
+
+/*
+==================
+Blits a render target drawn with the camera pCamera. Returns 0 if the actual camera has been rotated,
+zoomed or moved more than pMargin pixels, so the render target has to be drawn again.
+==================
+*/
+bool IND_Render::blitRenderTarget(IND_Surface *pSu, const IND_Matrix &pCamera, int pMargin) {
+	return _wrappedRenderer->blitRenderTarget(pSu, pCamera, pMargin);
+}
+
+/*
+==================
+Sets the mesh kept by the entity whose text is blitted next (NULL after blitting it). The mesh is only built
+again when the text, the font, the alignment, the spacing or the scale change.
+==================
+*/
+void IND_Render::setTextMesh(TextMesh *pMesh) {
+	_wrappedRenderer->setTextMesh(pMesh);
+}
+
 /** @endcond */
@@ -26,6 +26,10 @@
 
 /** @cond DOCUMENT_PRIVATEAPI */
 
+#include "Defines.h"
+
+#if defined (INDIERENDER_GLES_IOS) || defined (INDIERENDER_OPENGL)
+
 #include "IND_ShaderManager.h"
 #include "IND_ShaderProgram.h"
 #include "Global.h"
@@ -85,4 +89,6 @@ IND_ShaderProgram* IND_ShaderManager::getProgram (const char* programName) {
     return  NULL;
 }
 
+#endif //INDIERENDER_GLES_IOS || INDIERENDER_OPENGL
+
 /** @endcond */
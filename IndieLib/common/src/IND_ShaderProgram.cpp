@@ -23,17 +23,23 @@
  *
  *****************************************************************************************/
 
-#include "IND_ShaderProgram.h"
-
 #include "Defines.h"
+
+#if defined (INDIERENDER_GLES_IOS) || defined (INDIERENDER_OPENGL)
+
+#include "IND_ShaderProgram.h"
 #include "Global.h"
+#include <stdio.h>
+#include <vector>
 
+#ifdef INDIERENDER_GLES_IOS
 #include <OpenGLES/ES2/gl.h>
 #include <OpenGLES/ES2/glext.h>
+#endif
 
 struct IND_ShaderProgramImpl {
     
-    IND_ShaderProgramImpl() : _program(0), _vertexShader(0), _fragmentShader (0) {}
+    IND_ShaderProgramImpl() : _program(0), _vertexShader(0), _fragmentShader (0), _fromBinary(false), _linked(false) {}
     
     bool compileShader(const char* codeBuffer, GLuint type, GLuint *handle) {
         if (!codeBuffer || !handle) return false;
@@ -48,6 +54,22 @@ struct IND_ShaderProgramImpl {
         return status;
     }
     
+    string linkLog(GLuint handle) {
+        GLint logLength = 0;
+        string log;
+        
+        glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &logLength);
+        
+        if (logLength >= 1) {
+            char *logBytes = (char*)malloc(logLength);
+            glGetProgramInfoLog(handle, logLength, NULL, logBytes);
+            log = string(logBytes);
+            free(logBytes);
+        }
+        
+        return log;
+    }
+    
     string compileLog(GLuint handle) {
         GLint logLength = 0;
         string log;
@@ -67,9 +89,10 @@ struct IND_ShaderProgramImpl {
     string shaderSource(GLuint handle) {
         GLsizei length;
         glGetShaderiv(handle, GL_SHADER_SOURCE_LENGTH, &length);
-        GLchar src[length];
-        glGetShaderSource(handle, length, NULL, src);
-        return string(src);
+        if (length < 1) return string();
+        vector<GLchar> src(length);
+        glGetShaderSource(handle, length, NULL, &src[0]);
+        return string(&src[0]);
     }
     
     GLint numberOfUniformsInProgram(GLuint program) {
@@ -84,12 +107,113 @@ struct IND_ShaderProgramImpl {
         return numChars;
     }
     
+    // FNV-1a hash of the sources and the driver, the name of the binary in the cache
+    string binaryFileName(const char* vertexShader, const char* fragmentShader) {
+        const char* parts [3] = {vertexShader, fragmentShader, _driverId.c_str()};
+        unsigned long long hash = 14695981039346656037ULL;
+        
+        for (int i = 0; i < 3; ++i) {
+            //The terminator is hashed too, so the parts can't be mixed
+            const unsigned char* c = reinterpret_cast<const unsigned char*>(parts[i]);
+            do {
+                hash ^= *c;
+                hash *= 1099511628211ULL;
+            } while (*c++);
+        }
+        
+        char name [32];
+        sprintf(name, "/%08x%08x.glbin", static_cast<unsigned int>(hash >> 32), static_cast<unsigned int>(hash));
+        return _cacheDirectory + name;
+    }
+    
+    bool binaryCacheAvailable() {
+#ifdef INDIERENDER_OPENGL
+        if (_cacheDirectory.empty() || !GLEW_ARB_get_program_binary) return false;
+        
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+#else
+        //Program binaries are an extension in GLES 2
+        return false;
+#endif
+    }
+    
+    // Creates the program from the cached binary. The driver rejects it if it was updated
+    bool loadBinary() {
+#ifdef INDIERENDER_OPENGL
+        FILE* file = fopen(_cacheFile.c_str(), "rb");
+        if (!file) return false;
+        
+        GLenum format = 0;
+        vector<unsigned char> binary;
+        bool read = (fread(&format, sizeof(format), 1, file) == 1);
+        if (read) {
+            fseek(file, 0, SEEK_END);
+            long length = ftell(file) - static_cast<long>(sizeof(format));
+            fseek(file, sizeof(format), SEEK_SET);
+            read = (length > 0);
+            if (read) {
+                binary.resize(length);
+                read = (fread(&binary[0], 1, length, file) == static_cast<size_t>(length));
+            }
+        }
+        fclose(file);
+        if (!read) return false;
+        
+        _program = glCreateProgram();
+        if (!_program) return false;
+        
+        glProgramBinary(_program, format, &binary[0], static_cast<GLsizei>(binary.size()));
+        GLint status;
+        glGetProgramiv(_program, GL_LINK_STATUS, &status);
+        if (!status) {
+            glDeleteProgram(_program);
+            _program = 0;
+            return false;
+        }
+        
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    void saveBinary() {
+#ifdef INDIERENDER_OPENGL
+        GLint length = 0;
+        glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        
+        vector<unsigned char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(_program, length, NULL, &format, &binary[0]);
+        
+        FILE* file = fopen(_cacheFile.c_str(), "wb");
+        if (!file) {
+            g_debug->header("Shader program binary not written to the cache:", DebugApi::LogHeaderWarning);
+            g_debug->dataChar(_cacheFile, true);
+            return;
+        }
+        fwrite(&format, sizeof(format), 1, file);
+        fwrite(&binary[0], 1, length, file);
+        fclose(file);
+#endif
+    }
+    
     typedef map<string,IND_GLSLShaderUniform*> UniformsMap;
     UniformsMap _uniformsMap;
     
     GLuint _program;
     GLuint _vertexShader;
     GLuint _fragmentShader;
+    
+    // Binary cache
+    string _cacheDirectory;
+    string _driverId;
+    string _cacheFile;
+    bool _fromBinary;
+    bool _linked;
 };
 
 
@@ -102,60 +226,120 @@ void IND_ShaderProgram::end() {
         glDeleteProgram(_impl->_program);
     }
     
+    for (UniformsMap::iterator it = _uniformsMap.begin(); it != _uniformsMap.end(); ++it) {
+        DISPOSEMANAGED(it->second);
+    }
+    _uniformsMap.clear();
+    
     DISPOSE(_impl);
 }
 
+void IND_ShaderProgram::setBinaryCache(const char* directory, const char* driverId) {
+    _impl->_cacheDirectory = directory ? directory : "";
+    _impl->_driverId = driverId ? driverId : "";
+}
+
 bool IND_ShaderProgram::compile(const char* vertexShader, const char* fragmentShader) {
     if (!vertexShader || !fragmentShader) return false;
     
     bool success = false;
     
+    //A binary of the same sources linked before with this driver skips the compilation
+    if (_impl->binaryCacheAvailable()) {
+        _impl->_cacheFile = _impl->binaryFileName(vertexShader, fragmentShader);
+        
+        g_debug->header("Loading shader program binary", DebugApi::LogHeaderBegin);
+        g_debug->header("File:", DebugApi::LogHeaderInfo);
+        g_debug->dataChar(_impl->_cacheFile, true);
+        _impl->_fromBinary = _impl->loadBinary();
+        if (_impl->_fromBinary) {
+            g_debug->header("Shader program binary loaded", DebugApi::LogHeaderEnd);
+            return true;
+        }
+        g_debug->header("No valid binary in the cache, compiling the sources", DebugApi::LogHeaderEnd);
+    }
+    
+    //Every block is closed with an END, also when it fails, so the log keeps its indentation
     g_debug->header("Compiling vertex shader", DebugApi::LogHeaderBegin);
     success = _impl->compileShader(vertexShader, GL_VERTEX_SHADER, &_impl->_vertexShader);
     if (!success) {
+        g_debug->header("Vertex shader not compiled:", DebugApi::LogHeaderWarning);
         g_debug->dataChar(_impl->shaderSource(_impl->_vertexShader), true);
         g_debug->dataChar(_impl->compileLog(_impl->_vertexShader), true);
-        g_debug->header("Error compiling vertex shader", DebugApi::LogHeaderError);
-    } else {
-        g_debug->header("Compiling vertex shader finished", DebugApi::LogHeaderEnd);
+        g_debug->header("Error compiling vertex shader", DebugApi::LogHeaderEnd);
+        return false;
     }
+    g_debug->header("Compiling vertex shader finished", DebugApi::LogHeaderEnd);
     
     g_debug->header("Compiling fragment shader", DebugApi::LogHeaderBegin);
-    success = success && _impl->compileShader(fragmentShader, GL_FRAGMENT_SHADER, &_impl->_fragmentShader);
+    success = _impl->compileShader(fragmentShader, GL_FRAGMENT_SHADER, &_impl->_fragmentShader);
     if (!success) {
+        g_debug->header("Fragment shader not compiled:", DebugApi::LogHeaderWarning);
         g_debug->dataChar(_impl->shaderSource(_impl->_fragmentShader), true);
         g_debug->dataChar(_impl->compileLog(_impl->_fragmentShader), true);
-        g_debug->header("Error compiling fragment shader", DebugApi::LogHeaderError);
-    } else {
-        g_debug->header("Compiling fragment shader finished", DebugApi::LogHeaderEnd);
+        g_debug->header("Error compiling fragment shader", DebugApi::LogHeaderEnd);
+        return false;
     }
+    g_debug->header("Compiling fragment shader finished", DebugApi::LogHeaderEnd);
     
-    return success;
+    return true;
 }
 
 bool  IND_ShaderProgram::link() {
+    if (_impl->_linked) return true;
+    
+    //Loaded from the binary cache, already linked
+    if (_impl->_fromBinary) {
+        readProgramUniforms();
+        _impl->_linked = true;
+        return true;
+    }
+    
     if (!_impl->_vertexShader || !_impl->_fragmentShader ) return false;
-    if (_impl->_program) return true;
     
     _impl->_program = glCreateProgram();
     if (!_impl->_program) return false;
     
+    g_debug->header("Linking shader program", DebugApi::LogHeaderBegin);
+    
     glAttachShader(_impl->_program, _impl->_vertexShader);
     glAttachShader(_impl->_program, _impl->_fragmentShader);
     
+    bool cache = !_impl->_cacheFile.empty();
+#ifdef INDIERENDER_OPENGL
+    if (cache)
+        glProgramParameteri(_impl->_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+    
     glLinkProgram(_impl->_program);
     GLint status;
     glGetProgramiv(_impl->_program, GL_LINK_STATUS, &status);
     
     if (!status) {
-        g_debug->header("Error linking shader program", DebugApi::LogHeaderError);
-        g_debug->dataChar(_impl->compileLog(_impl->_program), true);
+        g_debug->header("Shader program not linked:", DebugApi::LogHeaderWarning);
+        g_debug->dataChar(_impl->linkLog(_impl->_program), true);
+        g_debug->header("Error linking shader program", DebugApi::LogHeaderEnd);
         return false;
     }
     
     glDeleteShader(_impl->_vertexShader);
     glDeleteShader(_impl->_fragmentShader);
     
+    if (cache)
+        _impl->saveBinary();
+    
+    readProgramUniforms();
+    _impl->_linked = true;
+    
+    g_debug->header("Linking shader program finished", DebugApi::LogHeaderEnd);
+    return true;
+}
+
+bool IND_ShaderProgram::isFromBinaryCache() {
+    return _impl->_fromBinary;
+}
+
+void IND_ShaderProgram::readProgramUniforms() {
     GLint uniformsCount = _impl->numberOfUniformsInProgram(_impl->_program);
     GLint maxNameLength = _impl->maxUniformNameLength(_impl->_program);
     char* uniformName = (char*)malloc( sizeof(char) * maxNameLength );
@@ -175,8 +359,6 @@ bool  IND_ShaderProgram::link() {
     }
     
     free(uniformName);
-    
-    return true;
 }
 
 void IND_ShaderProgram::use() {
@@ -200,71 +382,28 @@ void IND_ShaderProgram::setSingleUniformValue(const void* value, const char* uni
     
     if (!uniform) return;
     
-    GLint location = uniform->_glLocation;
-    switch( uniform->getType() )
-    {
-        case IND_GLSLShaderUniform::UniformTypeFloat:
-            glUniform1fv(location, 1, static_cast<const GLfloat*>(value));
-            break;
-        case IND_GLSLShaderUniform::UniformTypeFloatMatrix:
-            switch (uniform->matrixSize()) {
-                case 2:
-                    glUniformMatrix2fv(location, 1, false, static_cast<const GLfloat*>(value));
-                    break;
-                case 3:
-                    glUniformMatrix3fv(location, 1, false, static_cast<const GLfloat*>(value));
-                    break;
-                case 4:
-                    glUniformMatrix4fv(location, 1, false, static_cast<const GLfloat*>(value));
-                    break;
-                default:
-                    break;
-            }
-            break;
-        case IND_GLSLShaderUniform::UniformTypeFloatVector:
-            switch (uniform->arrayLength()) {
-                case 2:
-                    glUniform2fv(location, 1, static_cast<const GLfloat*>(value));
-                    break;
-                case 3:
-                    glUniform3fv(location, 1, static_cast<const GLfloat*>(value));
-                    break;
-                case 4:
-                    glUniform4fv(location, 1, static_cast<const GLfloat*>(value));
-                    break;
-                default:
-                    break;
-            }
-            break;
-        case IND_GLSLShaderUniform::UniformTypeInteger:
-            glUniform1iv(location, 1, static_cast<const GLint*>(value));
-            break;
-        case IND_GLSLShaderUniform::UniformTypeIntVector:
-            switch (uniform->arrayLength()) {
-                case 2:
-                    glUniform2iv(location, 1, static_cast<const GLint*>(value));
-                    break;
-                case 3:
-                    glUniform3iv(location, 1, static_cast<const GLint*>(value));
-                    break;
-                case 4:
-                    glUniform4iv(location, 1, static_cast<const GLint*>(value));
-                    break;
-                default:
-                    break;
-            }
-            break;
-        case IND_GLSLShaderUniform::UniformTypeSampler2D:
-            glUniform1iv(location, 1, static_cast<const GLint*>(value));
-            break;
-        default:
-            break;
-    }
-    
+    uniform->setValue(value);
 }
 
 int IND_ShaderProgram::getPositionForVertexAttribute(const char *vertextAttribureName) {
     return glGetAttribLocation(_impl->_program, vertextAttribureName);
 }
 
+bool IND_ShaderProgram::bindUniformBlock(const char* blockName, unsigned int bindingPoint) {
+#ifdef INDIERENDER_OPENGL
+    if (!_impl->_program) return false;
+    
+    GLuint index = glGetUniformBlockIndex(_impl->_program, blockName);
+    if (GL_INVALID_INDEX == index) return false;
+    
+    glUniformBlockBinding(_impl->_program, index, bindingPoint);
+    return true;
+#else
+    //Uniform blocks are not available in GLES 2
+    return false;
+#endif
+}
+
+#endif //INDIERENDER_GLES_IOS || INDIERENDER_OPENGL
+
 
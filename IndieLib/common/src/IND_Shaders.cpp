@@ -30,11 +30,19 @@ const char* IND_Program_PerVertexRGBAColor = "IND_Program_PerVertexRGBAColor";
 const char* IND_Program_Simple2DTexture = "IND_Program_Simple2DTexture";
 const char* IND_Program_2DTexture_RGBATint = "IND_Program_2DTexture_RGBATint";
 const char* IND_Program_2DTexture_RGBAFade = "IND_FragmentShader_2DTexture_RGBAFade";
+const char* IND_Program_Batched2DTexture = "IND_Program_Batched2DTexture";
+const char* IND_Program_Batched2DDistanceField = "IND_Program_Batched2DDistanceField";
 
 const char* IND_Uniform_MVMatrix = "uMVmatrix";
 const char* IND_Uniform_PMatrix = "uPMatrix";
 const char* IND_Uniform_RGBAColor = "uColor";
 const char* IND_Uniform_SpriteTexture = "uTexture";
+const char* IND_Uniform_AlphaReference = "uAlphaRef";
+const char* IND_Uniform_OutlineWidth = "uOutlineWidth";
+const char* IND_Uniform_OutlineColor = "uOutlineColor";
+const char* IND_Uniform_ShadowOffset = "uShadowOffset";
+const char* IND_Uniform_ShadowColor = "uShadowColor";
+const char* IND_UniformBlock_Matrices2d = "IND_Matrices2d";
 const char* IND_VertexAttribute_Position = "aPosition";
 const char* IND_VertexAttribute_RGBAColor = "aRGBAColor";
 const char* IND_VertexAttribute_TexCoord = "aTexCoord";
@@ -186,3 +194,90 @@ gl_FragColor = vec4(color,texColor.a * uColor.a) ;   \n\
 ";
 
 
+
+// GLSL 3.30 (desktop core profile). The vertices are already in world coordinates, so quads of
+// different entities can share a batch. The camera and projection come from a uniform block.
+// The attributes have fixed locations, so all the batched programs share the vertex array.
+const char* IND_VertexShader_Batched2DTexture =
+"                                                   \n\
+#version 330 core                                   \n\
+layout(std140) uniform IND_Matrices2d {             \n\
+    mat4 uViewMatrix;                               \n\
+    mat4 uProjectionMatrix;                         \n\
+};                                                  \n\
+layout(location = 0) in vec3 aPosition;             \n\
+layout(location = 1) in vec2 aTexCoord;             \n\
+layout(location = 2) in vec4 aRGBAColor;            \n\
+out vec2 varTexCoord;                               \n\
+out vec4 varFragmentColor;                          \n\
+\n\
+void main()                                         \n\
+{                                                   \n\
+    vec4 pos4 = vec4(aPosition, 1.0);               \n\
+    gl_Position = uProjectionMatrix * uViewMatrix * pos4;\n\
+    varTexCoord = aTexCoord;                        \n\
+    varFragmentColor = aRGBAColor;                  \n\
+}                                                   \n\
+";
+
+// Same as GL_MODULATE, the alpha reference discards the pixels that the alpha test would discard
+const char* IND_FragmentShader_Batched2DTexture =
+"                                                   \n\
+#version 330 core                                   \n\
+in vec2 varTexCoord;                                \n\
+in vec4 varFragmentColor;                           \n\
+uniform sampler2D uTexture;                         \n\
+uniform float uAlphaRef;                            \n\
+out vec4 fragColor;                                 \n\
+\n\
+void main()                                         \n\
+{                                                   \n\
+    vec4 color = texture(uTexture, varTexCoord) * varFragmentColor;\n\
+    if (color.a < uAlphaRef)                        \n\
+        discard;                                    \n\
+    fragColor = color;                              \n\
+}                                                   \n\
+";
+
+// The alpha of the texture is a signed distance field (0.5 on the edge). The edge is antialiased over
+// the width of a pixel on the screen, so it stays sharp at any scale. The outline is drawn between the
+// edge and the edge moved out by uOutlineWidth, and the shadow is the outer shape moved by
+// uShadowOffset texels, behind the rest.
+const char* IND_FragmentShader_Batched2DDistanceField =
+"                                                   \n\
+#version 330 core                                   \n\
+in vec2 varTexCoord;                                \n\
+in vec4 varFragmentColor;                           \n\
+uniform sampler2D uTexture;                         \n\
+uniform float uAlphaRef;                            \n\
+uniform float uOutlineWidth;                        \n\
+uniform vec4 uOutlineColor;                         \n\
+uniform vec2 uShadowOffset;                         \n\
+uniform vec4 uShadowColor;                          \n\
+out vec4 fragColor;                                 \n\
+\n\
+void main()                                         \n\
+{                                                   \n\
+    float dist = texture(uTexture, varTexCoord).a;  \n\
+    float smoothing = max(fwidth(dist) * 0.5, 0.001);\n\
+    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);\n\
+    float outerEdge = 0.5 - max(uOutlineWidth, 0.0);\n\
+    vec4 color = vec4(varFragmentColor.rgb, fill);  \n\
+    if (uOutlineWidth > 0.0) {                      \n\
+        float outline = smoothstep(outerEdge - smoothing, outerEdge + smoothing, dist);\n\
+        color = vec4(mix(uOutlineColor.rgb, varFragmentColor.rgb, fill), outline * mix(uOutlineColor.a, 1.0, fill));\n\
+    }                                               \n\
+    if (uShadowColor.a > 0.0) {                     \n\
+        vec2 shadowCoord = varTexCoord - uShadowOffset / vec2(textureSize(uTexture, 0));\n\
+        float shadowDist = texture(uTexture, shadowCoord).a;\n\
+        float shadow = smoothstep(outerEdge - smoothing, outerEdge + smoothing, shadowDist) * uShadowColor.a;\n\
+        float alpha = color.a + shadow * (1.0 - color.a);\n\
+        color.rgb = (color.rgb * color.a + uShadowColor.rgb * shadow * (1.0 - color.a)) / max(alpha, 0.001);\n\
+        color.a = alpha;                            \n\
+    }                                               \n\
+    color.a *= varFragmentColor.a;                  \n\
+    if (color.a < uAlphaRef)                        \n\
+        discard;                                    \n\
+    fragColor = color;                              \n\
+}                                                   \n\
+";
@@ -34,6 +34,7 @@
 #include "Global.h"
 #include "IND_SpriterEntity.h"
 #include "dependencies/SpriterParser/Animation.h"
+#include "SpriterClip.h"
 
 
 // --------------------------------------------------------------------------------
@@ -63,6 +64,14 @@ IND_SpriterEntity::IND_SpriterEntity()  {
 
 
 IND_SpriterEntity::~IND_SpriterEntity() {
+    for (unsigned int i = 0; i < _clips->size(); i++) {
+        _clips->at(i)->forgetPose(_pose);
+        if (_clips->at(i)->removeUser()) {
+            delete _clips->at(i);
+        }
+    }
+    delete _clips;
+    delete _pose;
 }
 
 
@@ -106,12 +115,17 @@ void IND_SpriterEntity::initAttrib() {
 	_name       = NULL;
     _surfaces   = new SurfaceToFileMap;
     _animations = new std::vector<Animation *>();
+    _clips      = new std::vector<SpriterClip *>();
+    _pose       = new SpriterPose();
+    
+    _posX                   = 400;
+    _posY                   = 500;
     
     _currentAnimation       = -1;       // TODO: ??
     _currentKey             = -1;       // TODO: ??
     _currentTime            = -1;       // TODO: ??
     
-    _drawBones              = false;    // TODO: support this in a later version
+    _drawBones              = false;
     _drawObjectpositions    = false;    // TODO: support this in a later version
 }
 
@@ -132,6 +146,41 @@ Animation* IND_SpriterEntity::addAnimation(int id, const char* name, int length,
     return aniPtr;
 }
 
+/*
+==================
+Flattens the parsed animations for playback. Called once the whole entity is parsed.
+==================
+*/
+void IND_SpriterEntity::buildClips() {
+    for (unsigned int i = _clips->size(); i < _animations->size(); i++) {
+        SpriterClip *clipPtr = new SpriterClip();
+        clipPtr->build(_animations->at(i), _surfaces);
+        clipPtr->addUser();
+        _clips->push_back(clipPtr);
+    }
+}
+
+/*
+==================
+Makes this entity an instance of another one: the surfaces, the animations and the clips are shared, so the
+entities playing the same animation in the same time evaluate it once per frame
+==================
+*/
+void IND_SpriterEntity::shareData(IND_SpriterEntity *pSource) {
+    delete _surfaces;
+    delete _animations;
+    
+    _id         = pSource->_id;
+    _name       = pSource->_name;
+    _surfaces   = pSource->_surfaces;
+    _animations = pSource->_animations;
+    
+    for (unsigned int i = 0; i < pSource->_clips->size(); i++) {
+        pSource->_clips->at(i)->addUser();
+        _clips->push_back(pSource->_clips->at(i));
+    }
+}
+
 
 
 /** @endcond */
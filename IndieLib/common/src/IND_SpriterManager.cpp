@@ -39,6 +39,8 @@
 #include "IND_Surface.h"
 #include "IND_SurfaceManager.h"
 #include "IND_Render.h"
+#include "SpriterClip.h"
+#include <math.h>
 //#ifdef linux
 #include <string>
 //#endif
@@ -147,6 +149,25 @@ bool IND_SpriterManager::addSpriterFile(const char *pSCMLFileName){
 	return 0;
 }
 
+/**
+ * Returns a new entity that plays the animations of the entity passed as a parameter, or NULL if
+ * the manager is not initialized. The surfaces and the animations are shared, and the entities playing
+ * the same animation in the same time only evaluate it once per frame.
+ * @param pSource				Pointer to a Spriter Entity object of the manager.
+ */
+IND_SpriterEntity* IND_SpriterManager::addSpriterInstance(IND_SpriterEntity *pSource) {
+	if (!_ok || !pSource) {
+		writeMessage();
+		return NULL;
+	}
+
+	IND_SpriterEntity *sEnt = IND_SpriterEntity::newSpriterEntity();
+	sEnt->shareData(pSource);
+	addToList(sEnt);
+
+	return sEnt;
+}
+
 
 
 // --------------------------------------------------------------------------------
@@ -302,11 +323,25 @@ bool IND_SpriterManager::parseSpriterData(const char *pSCMLFileName) {
                                                                   toInt(eMKey->Attribute("time"))
                                                                  );
 				
+				TiXmlElement *eBone_ref = 0;
+				eBone_ref = eMKey->FirstChildElement("bone_ref");
+				
+				while (eBone_ref){
+                    sMKey->addBoneref(toInt(eBone_ref->Attribute("id")),
+                                      toInt(eBone_ref->Attribute("parent"), -1),
+                                      toInt(eBone_ref->Attribute("timeline")),
+                                      toInt(eBone_ref->Attribute("key"))
+                                     );
+					
+					eBone_ref = eBone_ref->NextSiblingElement("bone_ref");
+				}
+				
 				TiXmlElement *eObject_ref = 0;
 				eObject_ref = eMKey->FirstChildElement("object_ref");
 				
 				while (eObject_ref){
                     sMKey->addObjectref(toInt(eObject_ref->Attribute("id")),
+                                        toInt(eObject_ref->Attribute("parent"), -1),
                                         toInt(eObject_ref->Attribute("timeline")),
                                         toInt(eObject_ref->Attribute("key")),
                                         toInt(eObject_ref->Attribute("z_index"))
@@ -320,18 +355,18 @@ bool IND_SpriterManager::parseSpriterData(const char *pSCMLFileName) {
 				eObject = eMKey->FirstChildElement("object");
 				
 				while (eObject){
-                    sMKey->addObject(  toInt(eObject_ref->Attribute("id")),
-                                             eObject_ref->Attribute("object_type"),
-                                       toInt(eObject_ref->Attribute("folder")),
-                                       toInt(eObject_ref->Attribute("file")),
-                                     toFloat(eObject_ref->Attribute("x")),
-                                     toFloat(eObject_ref->Attribute("y")),
-                                     toFloat(eObject_ref->Attribute("pivot_x")),
-                                     toFloat(eObject_ref->Attribute("pivot_y")),
-                                     toFloat(eObject_ref->Attribute("angle")),
-                                     toFloat(eObject_ref->Attribute("scale_x")),
-                                     toFloat(eObject_ref->Attribute("scale_y")),
-                                     toFloat(eObject_ref->Attribute("a"))
+                    sMKey->addObject(  toInt(eObject->Attribute("id")),
+                                             eObject->Attribute("object_type"),
+                                       toInt(eObject->Attribute("folder")),
+                                       toInt(eObject->Attribute("file")),
+                                     toFloat(eObject->Attribute("x")),
+                                     toFloat(eObject->Attribute("y")),
+                                     toFloat(eObject->Attribute("pivot_x")),
+                                     toFloat(eObject->Attribute("pivot_y"), 1.f),
+                                     toFloat(eObject->Attribute("angle")),
+                                     toFloat(eObject->Attribute("scale_x"), 1.f),
+                                     toFloat(eObject->Attribute("scale_y"), 1.f),
+                                     toFloat(eObject->Attribute("a"), 1.f)
                                     );
 					
 					eObject = eObject->NextSiblingElement("object");
@@ -361,7 +396,7 @@ bool IND_SpriterManager::parseSpriterData(const char *pSCMLFileName) {
                     
                     TimelineKey *sTKey = sTimeline->addKey(toInt(eTKey->Attribute("id")),
                                                            toInt(eTKey->Attribute("time")),
-                                                           toInt(eTKey->Attribute("spin"))
+                                                           toInt(eTKey->Attribute("spin"), 1)
                                                           );
                     
 
@@ -375,16 +410,38 @@ bool IND_SpriterManager::parseSpriterData(const char *pSCMLFileName) {
                                                  toFloat(eTimelineObject->Attribute("x")),
                                                  toFloat(eTimelineObject->Attribute("y")),
                                                  toFloat(eTimelineObject->Attribute("pivot_x")),
-                                                 toFloat(eTimelineObject->Attribute("pivot_y")),
+                                                 toFloat(eTimelineObject->Attribute("pivot_y"), 1.f),
                                                  toFloat(eTimelineObject->Attribute("angle")),
-                                                 toFloat(eTimelineObject->Attribute("scale_x")),
-                                                 toFloat(eTimelineObject->Attribute("scale_y")),
-                                                 toFloat(eTimelineObject->Attribute("a"))
+                                                 toFloat(eTimelineObject->Attribute("scale_x"), 1.f),
+                                                 toFloat(eTimelineObject->Attribute("scale_y"), 1.f),
+                                                 toFloat(eTimelineObject->Attribute("a"), 1.f)
                                                 );
                         
                         
                         eTimelineObject = eTimelineObject->NextSiblingElement("object");
 
+                    }
+                    
+                    // Bones are kept as objects without image (folder and file -1) and pivot
+                    TiXmlElement *eTimelineBone = 0;
+					eTimelineBone = eTKey->FirstChildElement("bone");
+					
+                    while (eTimelineBone) {
+                    
+                        sTKey->addTimelineObject(-1,
+                                                 -1,
+                                                 toFloat(eTimelineBone->Attribute("x")),
+                                                 toFloat(eTimelineBone->Attribute("y")),
+                                                 0.f,
+                                                 0.f,
+                                                 toFloat(eTimelineBone->Attribute("angle")),
+                                                 toFloat(eTimelineBone->Attribute("scale_x"), 1.f),
+                                                 toFloat(eTimelineBone->Attribute("scale_y"), 1.f),
+                                                 toFloat(eTimelineBone->Attribute("a"), 1.f)
+                                                );
+                        
+                        eTimelineBone = eTimelineBone->NextSiblingElement("bone");
+
                     }
                     
                     
@@ -401,6 +458,7 @@ bool IND_SpriterManager::parseSpriterData(const char *pSCMLFileName) {
 			eAnimation = eAnimation->NextSiblingElement("animation");
 		}
 
+        sEnt->buildClips();
 
         _listSpriterEntity->push_back(sEnt);
 
@@ -457,6 +515,7 @@ void IND_SpriterManager::initVars() {
     _timer->start();
     _deltaTime = 0.0;
     _lastTime = 0.0;
+    _frame = 0;
 }
 
 
@@ -487,20 +546,20 @@ void IND_SpriterManager::freeVars() {
 
 /*
 ==================
-Char to int helper method
+Char to int helper method, with the value of a missing attribute
 ==================
 */
-int IND_SpriterManager::toInt(const char* input) {
-        return ( input ) ? atoi(input) : 0;
+int IND_SpriterManager::toInt(const char* input, int defaultValue) {
+        return ( input ) ? atoi(input) : defaultValue;
 }
 
 /*
 ==================
-Char to float helper method
+Char to float helper method, with the value of a missing attribute
 ==================
 */
-float IND_SpriterManager::toFloat(const char* input) {
-        return ( input ) ? static_cast<float>(atoi(input)) : 0.f;
+float IND_SpriterManager::toFloat(const char* input, float defaultValue) {
+        return ( input ) ? static_cast<float>(atof(input)) : defaultValue;
 }
 
 /* =======================================================================================================
@@ -516,13 +575,18 @@ void IND_SpriterManager::renderEntities() {
     
     _lastTime = currentTime;
     
+    _frame++;
+    
     
     for (unsigned i=0; i < _listSpriterEntity->size(); i++) {
+        IND_SpriterEntity *ent = (*_listSpriterEntity)[i];
         
-        updateCurrentTime(_listSpriterEntity->at(i), _deltaTime);
-        updateCurrentKey(_listSpriterEntity->at(i));
+        if (!updateCurrentTime(ent, _deltaTime)) {
+            continue;
+        }
+        updateCurrentKey(ent);
         
-        draw(_listSpriterEntity->at(i));
+        draw(ent);
         
     }
 
@@ -530,61 +594,64 @@ void IND_SpriterManager::renderEntities() {
 
 
 void  IND_SpriterManager::draw(IND_SpriterEntity *ent) {
-    if (ent->_currentAnimation < 0 || ent->_currentKey < 0 || ent->_currentTime < 0 ){
+    if (ent->_currentKey < 0) {
         return;
     }
     
-    std::vector <MainlineObject *> *mainlineObjects = ent->getAnimations()->at(ent->_currentAnimation)->getMainline()->getKeys()->at(ent->_currentKey)->getObjects();
-    
-    std::vector <MainlineObjectref *> *mainlineObjectrefs = ent->getAnimations()->at(ent->_currentAnimation)->getMainline()->getKeys()->at(ent->_currentKey)->getObjectrefs();
-    
+    // Evaluated in the pose of the entity, unless another entity already evaluated the same time in this frame
+    const SpriterPose &pose = (*ent->_clips)[ent->_currentAnimation]->getPose(ent->_currentKey, ent->_currentTime, _frame, ent->_pose);
     
-    for (unsigned i=0; i < mainlineObjects->size(); i++) {
-        drawPersistentObject(ent, mainlineObjectrefs->at(i));
+    // Persistent objects first, then the timeline objects by z index
+    for (unsigned i=0; i < pose._sprites.size(); i++) {
+        drawSprite(ent, pose._sprites[i]);
     }
     
-    
-    for (unsigned i=0; i < mainlineObjectrefs->size(); i++) {
-        drawTransientObject(ent, mainlineObjectrefs->at(i));
+    if (ent->_drawBones) {
+        for (unsigned i=0; i < pose._bones.size(); i++) {
+            drawBone(ent, pose, i);
+        }
     }
     
 }
 
 
-void  IND_SpriterManager::drawTransientObject(IND_SpriterEntity *ent, MainlineObjectref *mObjectref) {
-    TimelineObject *tObject = getTimelineObject(ent, mObjectref->timeline, mObjectref->key);
-    
-    IND_Surface *surface = getSurface(ent, tObject->folder, tObject->file);
+void  IND_SpriterManager::drawSprite(IND_SpriterEntity *ent, const SpriterSprite &sprite) {
+    IND_Surface *surface = sprite._surface;
+    if (!surface) {
+        return;
+    }
     
-    g_debug->header(surface->getTypeString(), DebugApi::LogHeaderError);
+    const SpriterSpatial &spatial = sprite._spatial;
     
     IND_Matrix mMatrix = IND_Matrix(); // TODO: do we need this?
     
-	int objx = static_cast<int>(tObject->x);
-    int objy = static_cast<int>(tObject->y);
-    int tempx = objx + 400;
-    int tempy = objy <= 0 ? (500 + objy) : (500 - objy);
-    
-    float axisCalX = (tObject->pivot_x * ((float)surface->getWidth())  * -1.0f );
-    float axisCalY = ((1 - tObject->pivot_y) * ((float)surface->getHeight()) * -1.0f );
+    // Spriter is y up
+    int tempx = ent->_posX + static_cast<int>(spatial._x);
+    int tempy = ent->_posY - static_cast<int>(spatial._y);
     
-    //TimelineKey *tKey = getAnimations()->at(_currentAnimation)->getTimeLines()->at(mObjectref->timeline)->getKeys()->at(mObjectref->key);
+    float axisCalX = (sprite._pivotX * ((float)surface->getWidth())  * -1.0f );
+    float axisCalY = ((1 - sprite._pivotY) * ((float)surface->getHeight()) * -1.0f );
     
-    float newangle = (tObject->angle < 0.0f) ? (tObject->angle + 360.0f) : (360.0f - tObject->angle);
-
-    
-    //cout << "tObject->x"  << tObject->x << " , tObject->y " << tObject->y << " ";
-    //cout << "tObject->pivot_x "  << tObject->pivot_x << " , tObject->pivot_y " << tObject->pivot_y <<  " ";
-    //cout << "axisCalX "  << axisCalX << " , axisCalY " << axisCalY << '\n';
+    // Spriter angles are counter clockwise, and the interpolated ones can be out of 0..360
+    float newangle = fmodf(360.0f - spatial._angle, 360.0f);
+    if (newangle < 0.0f) {
+        newangle += 360.0f;
+    }
     
+    int alpha = static_cast<int>(spatial._alpha * 255.0f + 0.5f);
+    if (alpha < 0) {
+        alpha = 0;
+    } else if (alpha > 255) {
+        alpha = 255;
+    }
     
     _render->setTransform2d(tempx,                      // x pos  note: we start in 0,0 (corner of screen)
                             tempy,                      // y pos
                             0.f,                          // Angle x
                             0.f,                          // Angle y
                             newangle,                   // Angle z
-                            1.f,                          // Scale x
-                            1.f,                          // Scale y
+                            spatial._scaleX,            // Scale x
+                            spatial._scaleY,            // Scale y
                             static_cast<int>(axisCalX),                   // Axis cal x
                             static_cast<int>(axisCalY),                   // Axis cal y
                             false,                          // Mirror x
@@ -604,7 +671,7 @@ void  IND_SpriterManager::drawTransientObject(IND_SpriterEntity *ent, MainlineOb
                           255,                          // R Component	for tinting
                           255,                          // G Component	for tinting
                           255,                          // B Component	for tinting
-                          255,                          // A Component	for tinting
+                          static_cast<unsigned char>(alpha),   // A Component	for tinting
                           0,                            // R Component	for fading to a color
                           0,                            // G Component	for fading to a color
                           0,                            // B Component	for fading to a color
@@ -619,60 +686,36 @@ void  IND_SpriterManager::drawTransientObject(IND_SpriterEntity *ent, MainlineOb
 }
 
 
-void  IND_SpriterManager::drawPersistentObject(IND_SpriterEntity *ent, MainlineObjectref *mObjectref) {
-    // TODO: MFK, implement this
-}
-
-
-void IND_SpriterManager::drawBone(IND_SpriterEntity *ent, MainlineObjectref *mObjectref) {
-    // TODO: support this in a later version
-}
-
-
-void IND_SpriterManager::updateCurrentTime(IND_SpriterEntity *ent, double deltaTime) {
-    ent->_currentTime = ent->_currentTime + deltaTime; // TODO: is it ok to do the double to int cast here? ... and what about if we have passed the duration of the animation?
-}
-
-
-void IND_SpriterManager::updateCurrentKey(IND_SpriterEntity *ent) {
-    std::vector <MainlineKey *> *mainlineKeys = ent->getAnimations()->at(ent->_currentAnimation)->getMainline()->getKeys();
-    
-    for (unsigned i=0; i < mainlineKeys->size(); i++) {
-        if (mainlineKeys->at(i)->getTime() <= ent->_currentTime) {     // TODO: here again with the messy cast....
-            ent->_currentKey = i;
-        }
-        else {
-            cout << "(mainlinkeytime, currentimemessured) : ";
-            cout << mainlineKeys->at(i)->getTime();
-            cout << " , ";
-            cout << ent->_currentTime;
-            cout << "  ." << endl;
-            
-            break;
-        }
-
+void IND_SpriterManager::drawBone(IND_SpriterEntity *ent, const SpriterPose &pose, unsigned int boneIndex) {
+    const SpriterBone &bone = pose._bones[boneIndex];
+    if (bone._parent < 0) {
+        return;
     }
     
-
-}
-
-TimelineObject* IND_SpriterManager::getTimelineObject(IND_SpriterEntity *ent,int timelineId, int keyId) {
-    return ent->getAnimations()->at(ent->_currentAnimation)->getTimeLines()->at(timelineId)->getKeys()->at(keyId)->getObjects()->at(0); // TODO : is there allways one object here? ( we're using an array )
+    const SpriterSpatial &from = pose._bones[bone._parent]._world;
+    const SpriterSpatial &to = bone._world;
+    
+    _render->setIdentityTransform2d();
+    _render->blitLine(ent->_posX + static_cast<int>(from._x),
+                      ent->_posY - static_cast<int>(from._y),
+                      ent->_posX + static_cast<int>(to._x),
+                      ent->_posY - static_cast<int>(to._y),
+                      255, 255, 0, 255);
 }
 
 
-IND_Surface* IND_SpriterManager::getSurface(IND_SpriterEntity *ent, int folderId, int fileId) {
-    Fileref ref = Fileref(static_cast<unsigned int>(folderId), static_cast<unsigned int>(fileId));
+bool IND_SpriterManager::updateCurrentTime(IND_SpriterEntity *ent, double deltaTime) {
+    if (ent->_currentAnimation < 0 || ent->_currentAnimation >= static_cast<int>(ent->_clips->size())) {
+        return false;
+    }
     
-    // Find the first matching key. (we should only have one)
-    IND_SpriterEntity::SurfaceToFileMap::iterator res = ent->_surfaces->find(ref);
+    // Looping animations start again, the others stay in the last frame
+    ent->_currentTime = (*ent->_clips)[ent->_currentAnimation]->wrapTime(ent->_currentTime + deltaTime);
     
-    if(res != ent->_surfaces->end()) {
-        return res->second;
-    }
-    else {
-        return NULL;
-    }
+    return true;
 }
 
 
+void IND_SpriterManager::updateCurrentKey(IND_SpriterEntity *ent) {
+    ent->_currentKey = (*ent->_clips)[ent->_currentAnimation]->advanceCursor(ent->_currentKey, ent->_currentTime);
+}
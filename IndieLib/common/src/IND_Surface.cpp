@@ -213,6 +213,48 @@ int IND_Surface::getSpareY() {
 	return _surface->_attributes._spareY;
 }
 
+/**
+ * Returns true if the transparent borders of the surface were trimmed when it was created.
+ */
+bool IND_Surface::isTrimmed() {
+	return _surface->_attributes._trimWidth != 0;
+}
+
+/**
+ * Returns the horizontal position of the part of the surface kept in textures.
+ */
+int IND_Surface::getTrimX() {
+	return _surface->_attributes._trimX;
+}
+
+/**
+ * Returns the vertical position of the part of the surface kept in textures.
+ */
+int IND_Surface::getTrimY() {
+	return _surface->_attributes._trimY;
+}
+
+/**
+ * Returns the width of the part of the surface kept in textures.
+ */
+int IND_Surface::getTrimWidth() {
+	return isTrimmed() ? _surface->_attributes._trimWidth : _surface->_attributes._width;
+}
+
+/**
+ * Returns the height of the part of the surface kept in textures.
+ */
+int IND_Surface::getTrimHeight() {
+	return isTrimmed() ? _surface->_attributes._trimHeight : _surface->_attributes._height;
+}
+
+/**
+ * Returns the alpha class of the surface (opaque, alpha tested or translucent). See ::IND_AlphaClass.
+ */
+IND_AlphaClass IND_Surface::getAlphaClass() {
+	return _surface->_attributes._alphaClass;
+}
+
 /**
  * Sets a grid to the ::IND_Surface object. A grid is just a mesh which vertices
  * can be moved in order to deform the graphical object. You can set grids of different levels
@@ -245,6 +287,9 @@ bool IND_Surface::setGrid(int pNumBlocksX, int pNumBlocksY) {
 	// Only 1-texture-IND_Surfaces allowed
 	if (getNumTextures() != 1) return 0;
 
+	// The texture of a trimmed surface doesn't cover the whole surface
+	if (isTrimmed()) return 0;
+
 	// Reset attributes
 	_surface->_attributes._isHaveGrid        = 1;
 	_surface->_attributes._blocksX           = pNumBlocksX;
@@ -555,6 +600,31 @@ void IND_Surface::release() {
     freeTextureData();
 }
 
+/*
+==================
+Converts a region of a trimmed surface into a region of its textures. pX, pY, pWidth and pHeight
+receive the region (in surface coordinates) and return it clipped to the part of the image kept
+in textures, in texture coordinates. pDrawX and pDrawY return where the clipped region is drawn,
+relative to the origin of the region. Returns false if nothing of the region is kept.
+==================
+*/
+bool IND_Surface::clipRegion(int *pX, int *pY, int *pWidth, int *pHeight, int *pDrawX, int *pDrawY) {
+	ATTRIBUTES &mAttributes = _surface->_attributes;
+	int mX0 = *pX > mAttributes._trimX ? *pX : mAttributes._trimX;
+	int mY0 = *pY > mAttributes._trimY ? *pY : mAttributes._trimY;
+	int mX1 = *pX + *pWidth < mAttributes._trimX + getTrimWidth() ? *pX + *pWidth : mAttributes._trimX + getTrimWidth();
+	int mY1 = *pY + *pHeight < mAttributes._trimY + getTrimHeight() ? *pY + *pHeight : mAttributes._trimY + getTrimHeight();
+
+	*pDrawX = mX0 - *pX;
+	*pDrawY = mY0 - *pY;
+	*pX = mX0 - mAttributes._trimX;
+	*pY = mY0 - mAttributes._trimY;
+	*pWidth = mX1 > mX0 ? mX1 - mX0 : 0;
+	*pHeight = mY1 > mY0 ? mY1 - mY0 : 0;
+
+	return *pWidth && *pHeight;
+}
+
 /*
 ==================
 Private sets
@@ -608,6 +678,8 @@ void IND_Surface::freeTextureData() {
         }//LOOP END
 #endif
 #ifdef INDIERENDER_OPENGL
+		if (_surface->_framebuffer)
+			glDeleteFramebuffers(1, &_surface->_framebuffer);
 		glDeleteTextures(numTextures,_surface->_texturesArray);
 #endif
 	}
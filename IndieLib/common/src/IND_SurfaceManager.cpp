@@ -38,6 +38,7 @@
 #include "IND_Surface.h"
 #include "TextureDefinitions.h"
 #include "IND_Image.h"
+#include "CompressedImageHelper.h"
 #include <assert.h>
 
 #ifdef INDIERENDER_DIRECTX
@@ -157,11 +158,20 @@ by loading the image directly from the file.
 
 Graphic formats supported (Thanks to http://freeimage.sourceforge.net ):
 bmp, png, tga, jpg and pcx.
+
+If there is a pre-compressed variant of the file (same name with .dds extension, DXT1, DXT5 or BC7,
+see tools/texture_cooker) it is loaded instead, and uploaded without decompressing it when the
+renderer supports the format. Otherwise DXT1 / DXT5 data is decoded, and BC7 falls back to the
+original file.
 */
 bool IND_SurfaceManager::add(IND_Surface    *pNewSurface,
                              const char    *pName,
                              IND_Type        pType,
                              IND_Quality     pQuality) {
+	// Pre-compressed variant of the image
+	if (addCompressed(pNewSurface, pName, pType, pQuality))
+		return 1;
+
 	// Loads the image
 	IND_Image *mNewImage = IND_Image::newImage();
 
@@ -421,6 +431,11 @@ bool IND_SurfaceManager::clone(IND_Surface *pNewSurface, IND_Surface *pSurfaceTo
 	pNewSurface->_surface->_attributes._heightBlock = pSurfaceToClone->_surface->_attributes._heightBlock;
 	pNewSurface->_surface->_attributes._isHaveSurface = pSurfaceToClone->_surface->_attributes._isHaveSurface;
 	pNewSurface->_surface->_attributes._isHaveGrid = pSurfaceToClone->_surface->_attributes._isHaveGrid;
+	pNewSurface->_surface->_attributes._trimX = pSurfaceToClone->_surface->_attributes._trimX;
+	pNewSurface->_surface->_attributes._trimY = pSurfaceToClone->_surface->_attributes._trimY;
+	pNewSurface->_surface->_attributes._trimWidth = pSurfaceToClone->_surface->_attributes._trimWidth;
+	pNewSurface->_surface->_attributes._trimHeight = pSurfaceToClone->_surface->_attributes._trimHeight;
+	pNewSurface->_surface->_attributes._alphaClass = pSurfaceToClone->_surface->_attributes._alphaClass;
 
 	// Reference to texture
 	pNewSurface->_surface->_texturesArray =  pSurfaceToClone->_surface->_texturesArray;
@@ -481,6 +496,25 @@ bool IND_SurfaceManager::remove(IND_Surface *pSu) {
 }
 
 
+/**
+@b parameters:
+
+@arg @b pTrim           True for trimming the transparent borders of the surfaces.
+
+@b Operation:
+
+Sets if the transparent borders of the ::IND_ALPHA surfaces created after calling this method are trimmed.
+The textures of a trimmed surface only store the rectangle of the image that has visible pixels, and the
+surface is drawn with a quad of that rectangle, so the empty borders don't cost fill rate. The size of the
+surface and its position on the screen don't change. Trimmed surfaces can be blitted entirely or by regions,
+but they can't be wrapped or have a grid (see IND_Surface::setGrid()). The pixels saved on each frame can
+be checked with IND_Render::getTrimmedPixelsInt().
+*/
+void IND_SurfaceManager::setTrim(bool pTrim) {
+	_trim = pTrim;
+}
+
+
 // --------------------------------------------------------------------------------
 //										Private methods
 // --------------------------------------------------------------------------------
@@ -510,12 +544,41 @@ bool IND_SurfaceManager::addMain(IND_Surface    *pNewSurface,
 
 	//Convert image if needed
 	convertImage(pImage,pType,pQuality);
+
+	//Transparent borders are left out of the textures
+	int mTrimX = 0;
+	int mTrimY = 0;
+	IND_Image *mTrimmedImage = NULL;
+	if (_trim && IND_ALPHA == pType)
+		mTrimmedImage = trimImage(pImage, &mTrimX, &mTrimY);
+
+	//Texture data of the surface is going to be replaced
+	addTextureMemory(pNewSurface, -1);
+	size_t mMemoryBefore = _textureMemory;
 	
-	if (_textureBuilder->createNewTexture(pNewSurface, pImage, pBlockSizeX, pBlockSizeY)) {
+	if (_textureBuilder->createNewTexture(pNewSurface, mTrimmedImage ? mTrimmedImage : pImage, pBlockSizeX, pBlockSizeY)) {
 		//TODO: ERROR DEBUG FILE
 	}
 	assert(pNewSurface);
 
+	pNewSurface->_surface->_attributes._alphaClass = classifyImage(mTrimmedImage ? mTrimmedImage : pImage, pType);
+
+	if (mTrimmedImage) {
+		setTrimmed(pNewSurface, pImage->getWidth(), pImage->getHeight(), mTrimX, mTrimY);
+		_imageManager->remove(mTrimmedImage);
+
+		g_debug->header("Trimmed to (x, y | width x height):", DebugApi::LogHeaderInfo);
+		g_debug->dataInt(mTrimX, 0);
+		g_debug->dataChar(",", 0);
+		g_debug->dataInt(mTrimY, 0);
+		g_debug->dataChar("|", 0);
+		g_debug->dataInt(pNewSurface->getTrimWidth(), 0);
+		g_debug->dataChar("x", 0);
+		g_debug->dataInt(pNewSurface->getTrimHeight(), 1);
+	}
+
+	addTextureMemory(pNewSurface, 1);
+
 	// ----- Puts the object into the manager  -----
 
 	addToList(pNewSurface);
@@ -529,6 +592,13 @@ bool IND_SurfaceManager::addMain(IND_Surface    *pNewSurface,
 	g_debug->header("Quality:", DebugApi::LogHeaderInfo);
 	g_debug->dataChar(pNewSurface->getQualityString(), 1);
 
+	g_debug->header("Alpha class:", DebugApi::LogHeaderInfo);
+	switch (pNewSurface->getAlphaClass()) {
+		case IND_ALPHA_CLASS_OPAQUE: g_debug->dataChar("Opaque", 1); break;
+		case IND_ALPHA_CLASS_TESTED: g_debug->dataChar("Alpha tested", 1); break;
+		default: g_debug->dataChar("Translucent", 1); break;
+	}
+
 	g_debug->header("Image size:", DebugApi::LogHeaderInfo);
 	g_debug->dataInt(pNewSurface->_surface->_attributes._width, 0);
 	g_debug->dataChar("x", 0);
@@ -549,10 +619,17 @@ bool IND_SurfaceManager::addMain(IND_Surface    *pNewSurface,
 	g_debug->dataChar("x", 0);
 	g_debug->dataInt(pNewSurface->_surface->_attributes._spareY, 1);
 
-	//TODO: LOG % NOT USED
-	//g_debug->Header ("Not used percentage:", DebugApi::LogHeaderInfo);
-	//g_debug->DataFloat (pNewSurface->_surface->_attributes., 0);
-	//g_debug->DataChar ("%", 1);
+	g_debug->header("Texture memory (bytes):", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(pNewSurface->_surface->_attributes._textureMemory, 1);
+
+	g_debug->header("Not used percentage:", DebugApi::LogHeaderInfo);
+	g_debug->dataFloat(pNewSurface->_surface->_attributes._notUsedProportion, 0);
+	g_debug->dataChar("%", 1);
+
+	g_debug->header("Total texture memory (KB, before | after):", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(static_cast<int>(mMemoryBefore / 1024), 0);
+	g_debug->dataChar("|", 0);
+	g_debug->dataInt(static_cast<int>(_textureMemory / 1024), 1);
 
 	g_debug->header("Surface created", DebugApi::LogHeaderEnd);
 
@@ -560,6 +637,176 @@ bool IND_SurfaceManager::addMain(IND_Surface    *pNewSurface,
 }
 
 
+/*
+==================
+Returns a copy of the rectangle of an image that has visible pixels, and in pTrimX and pTrimY the
+position of the rectangle (from the upper-left corner). Returns NULL when there is nothing to trim,
+the image is fully transparent or it has no 8 bit alpha channel.
+==================
+*/
+IND_Image *IND_SurfaceManager::trimImage(IND_Image *pImage, int *pTrimX, int *pTrimY) {
+	if (pImage->getBytespp() != 4)
+		return NULL;
+
+	int mWidth = pImage->getWidth();
+	int mHeight = pImage->getHeight();
+	unsigned char *mPixels = pImage->getPointer();
+
+	// Bounding rectangle of the visible pixels (image lines, bottom-up)
+	int mX0 = mWidth, mY0 = mHeight, mX1 = 0, mY1 = 0;
+	for (int y = 0; y < mHeight; y++) {
+		unsigned char *mLine = mPixels + y * mWidth * 4;
+		for (int x = 0; x < mWidth; x++) {
+			if (mLine [x * 4 + 3]) {
+				if (x < mX0) mX0 = x;
+				if (x >= mX1) mX1 = x + 1;
+				if (y < mY0) mY0 = y;
+				if (y >= mY1) mY1 = y + 1;
+			}
+		}
+	}
+
+	if (mX1 <= mX0 || mY1 <= mY0)
+		return NULL;
+	if (!mX0 && !mY0 && mX1 == mWidth && mY1 == mHeight)
+		return NULL;
+
+	IND_Image *mTrimmedImage = IND_Image::newImage();
+	if (!_imageManager->add(mTrimmedImage, mX1 - mX0, mY1 - mY0, IND_RGBA)) {
+		DISPOSEMANAGED(mTrimmedImage);
+		return NULL;
+	}
+
+	unsigned char *mDst = mTrimmedImage->getPointer();
+	for (int y = mY0; y < mY1; y++) {
+		memcpy(mDst + (y - mY0) * (mX1 - mX0) * 4, mPixels + (y * mWidth + mX0) * 4, (mX1 - mX0) * 4);
+	}
+
+	*pTrimX = mX0;
+	*pTrimY = mHeight - mY1;
+	return mTrimmedImage;
+}
+
+
+/*
+==================
+Checks the alpha channel of an image: opaque if all the pixels are opaque, alpha tested if they are
+opaque or fully transparent, and translucent otherwise. Images without an 8 bit alpha channel are
+only opaque when the surface type is ::IND_OPAQUE.
+==================
+*/
+IND_AlphaClass IND_SurfaceManager::classifyImage(IND_Image *pImage, IND_Type pType) {
+	if (IND_OPAQUE == pType)
+		return IND_ALPHA_CLASS_OPAQUE;
+	if (pImage->getBytespp() != 4)
+		return IND_ALPHA_CLASS_TRANSLUCENT;
+
+	int mNumPixels = pImage->getWidth() * pImage->getHeight();
+	unsigned char *mPixels = pImage->getPointer();
+
+	IND_AlphaClass mClass = IND_ALPHA_CLASS_OPAQUE;
+	for (int i = 0; i < mNumPixels; i++) {
+		unsigned char mAlpha = mPixels [i * 4 + 3];
+		if (!mAlpha)
+			mClass = IND_ALPHA_CLASS_TESTED;
+		else if (mAlpha != 255)
+			return IND_ALPHA_CLASS_TRANSLUCENT;
+	}
+
+	return mClass;
+}
+
+
+/*
+==================
+Marks a surface created from a trimmed image. The surface gets the size of the whole image and its
+quads are moved to the position of the trimmed rectangle, so it is drawn at the same place.
+==================
+*/
+void IND_SurfaceManager::setTrimmed(IND_Surface *pSu, int pWidth, int pHeight, int pTrimX, int pTrimY) {
+	ATTRIBUTES &mAttributes = pSu->_surface->_attributes;
+	mAttributes._trimX = pTrimX;
+	mAttributes._trimY = pTrimY;
+	mAttributes._trimWidth = mAttributes._width;
+	mAttributes._trimHeight = mAttributes._height;
+	mAttributes._width = pWidth;
+	mAttributes._height = pHeight;
+
+	for (int i = 0; i < mAttributes._numBlocks * 4; i++) {
+		pSu->_surface->_vertexArray [i]._pos._x += pTrimX;
+		pSu->_surface->_vertexArray [i]._pos._y += pTrimY;
+	}
+}
+
+
+/*
+==================
+Creates the surface from the pre-compressed (.dds) variant of an image file, if it exists.
+Returns 0 (false) when there is no usable variant, so the original file has to be loaded.
+==================
+*/
+bool IND_SurfaceManager::addCompressed(IND_Surface    *pNewSurface,
+                                       const char    *pName,
+                                       IND_Type        pType,
+                                       IND_Quality     pQuality) {
+	if (!_ok || !pNewSurface || !pName)
+		return 0;
+
+	// Grey qualities need the pixels
+	if (IND_GREY_8 == pQuality || IND_GREY_16 == pQuality)
+		return 0;
+
+	char mCompressedName [MAX_TOKEN];
+	CompressedImageHelper::getCompressedName(pName, mCompressedName);
+
+	COMPRESSED_IMAGE mImage;
+	if (!CompressedImageHelper::loadDDS(mCompressedName, &mImage))
+		return 0;
+
+	g_debug->header("Creating surface", DebugApi::LogHeaderBegin);
+	g_debug->header("From compressed image:", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(mCompressedName, 0);
+	g_debug->dataChar(CompressedImageHelper::getFormatName(mImage._format), 1);
+
+	bool mOk = 0;
+
+	//Texture data of the surface is going to be replaced
+	addTextureMemory(pNewSurface, -1);
+
+	if (_textureBuilder->createNewCompressedTexture(pNewSurface, &mImage, pType)) {
+		// The pixels are not checked, so the surface is translucent unless it was requested opaque
+		pNewSurface->_surface->_attributes._alphaClass = (IND_OPAQUE == pType) ? IND_ALPHA_CLASS_OPAQUE : IND_ALPHA_CLASS_TRANSLUCENT;
+		addTextureMemory(pNewSurface, 1);
+		addToList(pNewSurface);
+
+		g_debug->header("Texture memory (bytes):", DebugApi::LogHeaderInfo);
+		g_debug->dataInt(pNewSurface->_surface->_attributes._textureMemory, 1);
+		g_debug->header("Surface created", DebugApi::LogHeaderEnd);
+		mOk = 1;
+	} else {
+		addTextureMemory(pNewSurface, 1);
+		g_debug->header("Compressed format not supported by the renderer", DebugApi::LogHeaderWarning);
+		g_debug->header("Surface not created", DebugApi::LogHeaderEnd);
+
+		// Decoded by software into an image
+		if (CompressedImageHelper::canDecode(mImage._format)) {
+			IND_Image *mNewImage = IND_Image::newImage();
+			if (_imageManager->add(mNewImage, mImage._width, mImage._height, IND_RGBA)) {
+				CompressedImageHelper::decode(&mImage, mNewImage->getPointer());
+				mOk = addMain(pNewSurface, mNewImage, 0, 0, pType, pQuality);
+			} else {
+				DISPOSEMANAGED(mNewImage);
+			}
+			_imageManager->remove(mNewImage);
+		}
+	}
+
+	CompressedImageHelper::freeImage(&mImage);
+
+	return mOk;
+}
+
+
 /*
 ==================
 This function returns 1 (true) if the parameter surface object exists and it returns in
@@ -627,10 +874,49 @@ Deletes object from the manager
 */
 void IND_SurfaceManager::delFromlist(IND_Surface *pSu) {
 	_listSurfaces->remove(pSu);
+	addTextureMemory(pSu, -1);
 	DISPOSEMANAGED(pSu);
 }
 
 
+/*
+==================
+Adds (pSign = 1) or substracts (pSign = -1) the texture memory of a surface to the counters
+==================
+*/
+void IND_SurfaceManager::addTextureMemory(IND_Surface *pSu, int pSign) {
+	if (!pSu->_surface)
+		return;
+
+	size_t mMemory = static_cast<size_t>(pSu->_surface->_attributes._textureMemory);
+	size_t mWasted = static_cast<size_t>(getWastedTextureMemory(pSu));
+	if (pSign > 0) {
+		_textureMemory += mMemory;
+		_textureMemoryWasted += mWasted;
+	} else {
+		_textureMemory -= mMemory;
+		_textureMemoryWasted -= mWasted;
+	}
+}
+
+
+/*
+==================
+Bytes of the textures of a surface that are spare areas
+==================
+*/
+int IND_SurfaceManager::getWastedTextureMemory(IND_Surface *pSu) {
+	ATTRIBUTES &mAttributes = pSu->_surface->_attributes;
+	int mBlocksPixels = mAttributes._numBlocks * mAttributes._widthBlock * mAttributes._heightBlock;
+	if (!mBlocksPixels)
+		return 0;
+
+	// Compressed textures use less than a byte per pixel
+	double mBytespp = (double) mAttributes._textureMemory / mBlocksPixels;
+	return mAttributes._textureMemory - (int) (pSu->getTrimWidth() * pSu->getTrimHeight() * mBytespp);
+}
+
+
 /*
 ==================
 Writes a message in the log that the object was not initialized
@@ -704,6 +990,8 @@ Init manager vars
 */
 void IND_SurfaceManager::initVars() {
 	_listSurfaces = new list <IND_Surface *>;
+	_textureMemory = 0;
+	_textureMemoryWasted = 0;
 }
 
 
@@ -34,10 +34,14 @@
 #include "IND_TTF_Font.h"
 //#include "IND_TTF_FontManager.h"
 #include "FreeTypeHandle.h"
+#include "GlyphRasterizer.h"
+
+#include <set>
+#include <stdio.h>
+#include <wchar.h>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include FT_OUTLINE_H
 
 //! wrap of the TrueType library, so that the Indielib user does not need to include this.
 class free_type_impl {
@@ -53,6 +57,10 @@ public:
     friend class IND_TTF_Font;
 };
 
+// Char cache generations are unique across all the fonts, so a layout can't match
+// a different font allocated at the same address
+static unsigned int s_cacheGeneration = 0;
+
 
 // --------------------------------------------------------------------------------
 //							  Initialization / Destruction
@@ -74,6 +82,18 @@ IND_TTF_Font::IND_TTF_Font( free_type_ptr_wrapped_impl *freetype_wrapped, IND_Re
     _fYHotSpot              = 0.5f;
     _bBold                  = false;
     _bItalic                = false;
+    _cacheGeneration        = ++s_cacheGeneration;
+    _bAsyncCache            = false;
+    _rasterizer             = NULL;
+    _bDistanceField         = false;
+    _iSpread                = 4;
+    _fOutlineWidth          = 0.0f;
+    _clrOutline             = 0;
+    _btOutlineTrans         = 0;
+    _fShadowX               = 0.0f;
+    _fShadowY               = 0.0f;
+    _clrShadow              = 0;
+    _btShadowTrans          = 0;
 
     _impl = new free_type_impl();               // TODO: remember to delete this
     _impl->_FTLib = freetype_wrapped->_FTLib;
@@ -120,11 +140,18 @@ bool IND_TTF_Font::loadTTFFontFromDisk(const std::string& strname, const std::st
 
 	_bBold = bBold;
 	_bItalic = bItalic;
+
+	if (_bAsyncCache)
+		setAsyncCache(true);
 	
 	return true;
 }
 
 void IND_TTF_Font::unloadFont() {
+	// the worker has its own face, stop it before the cache goes away
+	delete _rasterizer;
+	_rasterizer = NULL;
+
 	clearAllCache();
 
 	if (_impl->_Face) {
@@ -149,6 +176,9 @@ bool IND_TTF_Font::isCharCached(wchar_t charCode) {
 }
 
 void IND_TTF_Font::clearAllCache() {
+	// layouts hold surfaces of the cached chars
+	_cacheGeneration = ++s_cacheGeneration;
+
 	while (!_FontCharCache.empty()) {
 		CharCacheNode* pNode = _FontCharCache.begin()->second;
 		_FontCharCache.erase(_FontCharCache.begin());
@@ -163,6 +193,132 @@ void IND_TTF_Font::clearAllCache() {
 	}
 }
 
+bool IND_TTF_Font::setAsyncCache(bool basync) {
+	_bAsyncCache = basync;
+
+	if (!basync) {
+		delete _rasterizer;
+		_rasterizer = NULL;
+		return true;
+	}
+
+	if (_rasterizer || !_impl->_Face)
+		return true;
+
+	_rasterizer = new GlyphRasterizer();
+	if (!_rasterizer->start(_strFilePath, _CharHeight, _bBold, _bItalic, _bDistanceField ? _iSpread : 0)) {
+		// keep caching in the render thread
+		delete _rasterizer;
+		_rasterizer = NULL;
+		_bAsyncCache = false;
+		return false;
+	}
+
+	return true;
+}
+
+void IND_TTF_Font::prewarm(const std::wstring& str) {
+	for (std::size_t i = 0; i < str.length(); i++) {
+		switch (str[i]) {
+		case L' ':
+		case L'\t':
+		case L'\r':
+		case L'\n':
+			continue;
+		}
+		requestCharCache(str[i]);
+	}
+}
+
+bool IND_TTF_Font::prewarmFromFile(const std::string& strpath) {
+	FILE *pFile = fopen(strpath.c_str(), "rb");
+	if (!pFile)
+		return false;
+
+	std::string sBytes;
+	char buffer[4096];
+	std::size_t nRead;
+	while ((nRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+		sBytes.append(buffer, nRead);
+	fclose(pFile);
+
+	// decode UTF-8, each char only once
+	std::set<wchar_t> chars;
+	std::size_t i = 0;
+	while (i < sBytes.length()) {
+		unsigned int c = (unsigned char)sBytes[i];
+		int nTrail = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+		if (nTrail)
+			c &= 0x3F >> nTrail;
+		i++;
+
+		for (int t = 0; t < nTrail && i < sBytes.length(); t++, i++)
+			c = (c << 6) | ((unsigned char)sBytes[i] & 0x3F);
+
+		// skip the byte order mark and what doesn't fit in a wchar_t
+		if (c != 0xFEFF && c <= (unsigned int)WCHAR_MAX)
+			chars.insert((wchar_t)c);
+	}
+
+	prewarm(std::wstring(chars.begin(), chars.end()));
+	return true;
+}
+
+int IND_TTF_Font::uploadRasterizedGlyphs(int iMaxGlyphs) {
+	if (!_rasterizer)
+		return 0;
+
+	int nUploaded = 0;
+	while (nUploaded < iMaxGlyphs) {
+		RasterizedGlyph *pGlyph = _rasterizer->popReady();
+		if (!pGlyph)
+			break;
+
+		// a glyph that can't be uploaded is not requested again
+		if (!isCharCached(pGlyph->_charCode)) {
+			if (addGlyphToCache(*pGlyph))
+				nUploaded++;
+			else
+				_rasterizer->setMissing(pGlyph->_charCode);
+		}
+
+		delete pGlyph;
+	}
+
+	return nUploaded;
+}
+
+void IND_TTF_Font::setDistanceField(bool bsdf, int iSpread) {
+	if (iSpread < 1)
+		iSpread = 1;
+	if (bsdf == _bDistanceField && (!bsdf || iSpread == _iSpread))
+		return;
+
+	_bDistanceField = bsdf;
+	_iSpread = iSpread;
+
+	// the cached glyphs and the worker were made for the other mode
+	delete _rasterizer;
+	_rasterizer = NULL;
+	clearAllCache();
+
+	if (_bAsyncCache)
+		setAsyncCache(true);
+}
+
+void IND_TTF_Font::setDistanceFieldOutline(float fWidth, uint32_t clrOutline, byte btTrans) {
+	_fOutlineWidth = fWidth;
+	_clrOutline = clrOutline;
+	_btOutlineTrans = btTrans;
+}
+
+void IND_TTF_Font::setDistanceFieldShadow(float fOffsetX, float fOffsetY, uint32_t clrShadow, byte btTrans) {
+	_fShadowX = fOffsetX;
+	_fShadowY = fOffsetY;
+	_clrShadow = clrShadow;
+	_btShadowTrans = btTrans;
+}
+
 
 bool IND_TTF_Font::drawText(const std::wstring& s, float x, float y, uint32_t clrFont, bool bFlipX, bool bFlipY,
 							float fZRotate, byte btTrans, bool bKerning, bool bUnderl) {
@@ -177,6 +333,8 @@ bool IND_TTF_Font::drawText(const std::wstring& s, float x, float y, uint32_t cl
 	//std::size_t Length = s.length();
 	float original_Pen_x = x;
 
+	beginGlyphs();
+
 	for (std::size_t i = 0; i < s.length(); ++i) {
 		
         //Special cases
@@ -203,7 +361,7 @@ bool IND_TTF_Font::drawText(const std::wstring& s, float x, float y, uint32_t cl
 		}
 
 		if (_bAutoCache)
-			buildCharCache(s[i]);
+			requestCharCache(s[i]);
 
 		pNode = getCharCacheNode(s[i]);
 		if (!pNode) {
@@ -224,6 +382,8 @@ bool IND_TTF_Font::drawText(const std::wstring& s, float x, float y, uint32_t cl
 		previousGlyph = pNode->charGlyphIndex;
 	}
 
+	endGlyphs();
+
 	// Draw underline
 	if(bUnderl && ((penX - original_Pen_x) > 0.1f)) {
 		doDrawBorder(original_Pen_x, penX, penY + _CharHeight, clrFont, btTrans);
@@ -240,22 +400,33 @@ bool IND_TTF_Font::drawText(const std::wstring& s, float x, float y, uint32_t cl
 // -3	-	vertical layout is not supported by current font face
 int IND_TTF_Font::drawTextEx(const std::wstring& sText, float fLeft, float fTop, float fRight, float fBottom,
 					uint32_t nFormat, uint32_t clrFont, uint32_t clrBorder, uint32_t clrBack,byte btBorderTrans, 
-					byte btBackTrans,bool bFlipX, bool bFlipY, float fZRotate, byte btTrans,bool bKerning, bool bUnderl) {
-	//1. Check parameters
-	if(fLeft >= fRight || fTop >= fBottom)
-		return 0;
-	float fAreaWidth = fRight - fLeft;
-	float fAreaHeight = fBottom - fTop;
-
-	if(fAreaWidth < _CharWidth || fAreaHeight < _CharHeight) {
-		return -1;
+					byte btBackTrans,bool bFlipX, bool bFlipY, float fZRotate, byte btTrans,bool bKerning, bool bUnderl,
+					TextLayout *pLayout) {
+	if(!pLayout)
+		pLayout = &_scratchLayout;
+
+	//1. Lay out the text again only if the cached layout doesn't match this call
+	bool bApplyKerning = _bHasKerning && bKerning && !bFlipX && !bFlipY && fZRotate == 0;
+	if(	pLayout->pFont != this ||
+		pLayout->generation != _cacheGeneration ||
+		pLayout->fLeft != fLeft || pLayout->fTop != fTop ||
+		pLayout->fRight != fRight || pLayout->fBottom != fBottom ||
+		pLayout->nFormat != nFormat ||
+		pLayout->bKerning != bApplyKerning ||
+		pLayout->bUnderl != bUnderl ||
+		pLayout->sText != sText) {
+		buildTextLayout(*pLayout, sText, fLeft, fTop, fRight, fBottom, nFormat, bFlipX, bFlipY, fZRotate,
+						bKerning, bUnderl);
+
+		// stamped afterwards, auto caching while laying out bumps the generation
+		pLayout->pFont = this;
+		pLayout->generation = _cacheGeneration;
+		pLayout->bKerning = bApplyKerning;
 	}
 
-	//the format must contain one para for horizontal align and one for vertical
-	if( !(nFormat & (DT_EX_LEFT | DT_EX_CENTER | DT_EX_RIGHT)) ||
-		!(nFormat & (DT_EX_TOP | DT_EX_VCENTER | DT_EX_BOTTOM)))
-		return -2;
-	
+	if(pLayout->result == 0 || pLayout->result == -1 || pLayout->result == -2)
+		return pLayout->result;
+
 	//2. Display background if reauired
 	if(nFormat & DT_EX_BACKCOLOR) {
 		byte r,g,b;
@@ -270,176 +441,23 @@ int IND_TTF_Font::drawTextEx(const std::wstring& sText, float fLeft, float fTop,
 											r,g,b,btBackTrans);
 	}
 
+	if(pLayout->result != 1)
+		return pLayout->result;
 
-	bool bVertical = false;
-	//3. check vertical layout
-	if(nFormat & DT_EX_VERTICAL) {
-        // vertical layout
-		// mainly for you guys speaking Chinese, Japanese and Korean
-		if(!FT_HAS_VERTICAL(_impl->_Face)){
-            // ooops, font face doesn't support vertical layout
-			return -3;
-		}
-		bVertical = true;
-	}
-	
-	// 4. check the right to left property
-	bool bR2L = false;
-	if(nFormat & DT_EX_RTOLREADING) {
-        // right to left reading
-		// mainly for you guys speaking Arabic
-		bR2L = true;
-	}
-
-	// 5. check the line wrap property
-	bool bWrap = false;
-	if(nFormat & DT_EX_LINEWRAP) {
-        // do the line wrap
-		bWrap = true;
-	}
-	
-	// 6. text format
-	float fTextWidth, fTextHeight;
-	int iTotalLines;
-	std::wstring sTarget = textFormat( sText, bVertical?fAreaHeight:fAreaWidth, fTextWidth, fTextHeight,
-										iTotalLines, bWrap,bFlipX, bFlipY, fZRotate, btTrans, bKerning,
-										bUnderl);
-	// determin the proper start point
-	float pen_X, pen_Y, start_X, start_Y;
-	start_X = fLeft;
-	start_Y = fTop;
-	if(bVertical)
-	{	
-		if(nFormat & DT_EX_LEFT)
-		{
-			if(bR2L)
-			{
-				start_X = fLeft + fTextHeight;
-			}
-		}
-		else if(nFormat & DT_EX_CENTER)
-		{
-			if(bR2L)
-			{
-				start_X = fRight - (fAreaWidth - fTextHeight) / 2;
-			}
-			else
-			{
-				start_X = fLeft + (fAreaWidth - fTextHeight) / 2;
-			}
-		}
-		else if(nFormat & DT_EX_RIGHT)
-		{
-			if(bR2L)
-			{
-				start_X = fRight;// - (fAreaWidth - fTextHeight);
-			}
-			else
-			{
-				start_X = fRight - fTextHeight;
-			}
-		}	
-	}
-	else
-	{
-		if(nFormat & DT_EX_VCENTER)
-		{
-			start_Y = fTop  + (fAreaHeight - fTextHeight) / 2;
-		}
-		else if(nFormat & DT_EX_BOTTOM)
-		{
-			start_Y = fBottom  - fTextHeight;
-		}
+	//3. draw the laid out glyphs and underlines
+	beginGlyphs();
+	for (std::size_t i = 0; i < pLayout->glyphs.size(); i++) {
+		const TextLayout::GlyphRun &glyph = pLayout->glyphs[i];
+		blitGlyph(glyph.pSurface, glyph.x, glyph.y, clrFont, bFlipX, bFlipY, fZRotate, btTrans);
 	}
-	// 7. draw the string content
-	std::size_t start = 0, end = 0, line = 0;
-	std::wstring curline;
-
-	while ( end < sTarget.length())
-	{
-		end = sTarget.find_first_of(L'\n', start);
-		if(end == std::wstring::npos)
-		{// no '\n found'
-			end = sTarget.length();
-		}
-		curline = sTarget.substr(start, end - start);
-        start = end + 1;
-		
-		if(bVertical)
-		{
-			if(bR2L)
-			{
-				pen_X = start_X - _CharWidth * line;
-			}
-			else
-			{
-				pen_X = start_X + _CharWidth * line;
-			}
-
-			if(nFormat & DT_EX_TOP)
-			{
-				pen_Y = fTop;
-			}
-			else if(nFormat & DT_EX_VCENTER)
-			{
-				pen_Y = fTop  + (fAreaHeight - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
-			}
-			else if(nFormat & DT_EX_BOTTOM)
-			{
-				pen_Y = fTop  + fAreaHeight - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning);
-			}
-            else{
-                pen_Y = 0.0f; // TODO: this is added to fix "warning C4701: potentially uninitialized local variable 'pen_Y'"
-
-            }
-		}
-		else
-		{
-			pen_X = fLeft;
-			pen_Y = start_Y + (float)(_CharHeight * line);
-
-			if(nFormat & DT_EX_LEFT)
-			{
-				if(bR2L)
-				{
-					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning));
-				}
-				else
-				{
-					pen_X = fLeft;
-				}
-			}
-			else if(nFormat & DT_EX_CENTER)
-			{
-				if(bR2L)
-				{
-					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
-				}
-				else
-				{
-					pen_X = fLeft + (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
-				}
-			}
-			else if(nFormat & DT_EX_RIGHT)
-			{
-				if(bR2L)
-				{
-					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning));
-				}
-				else
-				{
-					pen_X = fLeft + fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning);
-				}
-			}	
-		}
+	endGlyphs();
 
-		// draw this line
-		drawTextLineEx(curline, pen_X, pen_Y, fLeft, fTop, fRight, fBottom, clrFont, bVertical, bR2L, bFlipX,
-						bFlipY, fZRotate, btTrans, bKerning, bUnderl);
-		line++;
+	for (std::size_t i = 0; i < pLayout->underlines.size(); i++) {
+		const TextLayout::UnderlineRun &underline = pLayout->underlines[i];
+		doDrawBorder(underline.xStart, underline.xEnd, underline.y, clrFont, btTrans);
 	}
 
-	//8. Display border if reauired
+	//4. Display border if reauired
 	if(nFormat & DT_EX_BORDER) {
 		byte r,g,b;
 		r = clrBorder & 0xFF;
@@ -465,26 +483,43 @@ int IND_TTF_Font::drawTextEx(const std::wstring& sText, float fLeft, float fTop,
 bool IND_TTF_Font::renderChar(wchar_t charCode, float x, float y, uint32_t clrFont, bool bFlipX, bool bFlipY,
 							   float fZRotate, byte btTrans, bool bKerning, bool bUnderl) {
 	if (_bAutoCache)
-		buildCharCache(charCode);
+		requestCharCache(charCode);
 
 	CharCacheNode* pNode = getCharCacheNode(charCode);
 	if (!pNode || !pNode->pSurface)
 		return false;
 
-	float origin_x, origin_y;
-	origin_x = x;
-	origin_y = y;
+	blitGlyph(pNode->pSurface, x + pNode->charLeftBearing, y + _fFaceAscender - pNode->charTopBearing,
+			  clrFont, bFlipX, bFlipY, fZRotate, btTrans);
 
-	x += pNode->charLeftBearing;
-	y += _fFaceAscender - pNode->charTopBearing;
-	
+	return true;
+}
+
+void IND_TTF_Font::beginGlyphs() {
+	if (!_bDistanceField)
+		return;
+
+	_pIndieRender->setDistanceField2d(true);
+	_pIndieRender->setDistanceFieldOutline2d(_fOutlineWidth, _clrOutline & 0xFF, (_clrOutline >> 8) & 0xFF,
+											 (_clrOutline >> 16) & 0xFF, _btOutlineTrans);
+	_pIndieRender->setDistanceFieldShadow2d(_fShadowX, _fShadowY, _clrShadow & 0xFF, (_clrShadow >> 8) & 0xFF,
+											(_clrShadow >> 16) & 0xFF, _btShadowTrans);
+}
+
+void IND_TTF_Font::endGlyphs() {
+	if (_bDistanceField)
+		_pIndieRender->setDistanceField2d(false);
+}
+
+void IND_TTF_Font::blitGlyph(IND_Surface *pSurface, float x, float y, uint32_t clrFont, bool bFlipX, bool bFlipY,
+							  float fZRotate, byte btTrans) {
 	//Bliting the font surfaces to screen
 	// 1) We apply the world space transformation (translation, rotation, scaling).
 	// If you want to recieve the transformation in a single matrix you can pass
 	// and IND_Matrix object by reference.
 
-	int mWidth = pNode->pSurface->getWidth();
-	int mHeight = pNode->pSurface->getHeight();
+	int mWidth = pSurface->getWidth();
+	int mHeight = pSurface->getHeight();
 
 	/*
 	if( (x + mWidth  <= 0) || (y + mHeight <= 0) ||
@@ -538,9 +573,7 @@ bool IND_TTF_Font::renderChar(wchar_t charCode, float x, float y, uint32_t clrFo
 
 	// 3) Blit the IND_Surface
 	//m_pIndieLib->Render->BlitRegionSurface(theGlyph->pSurface, (int)x, (int)y, mWidth,mHeight);
-	_pIndieRender->blitSurface(pNode->pSurface);
-	
-	return true;
+	_pIndieRender->blitSurface(pSurface);
 }
 
 
@@ -548,46 +581,40 @@ bool IND_TTF_Font::buildCharCache(wchar_t charCode) {
 	if (isCharCached(charCode))
 		return true;
 
-	CharCacheNode* pNode = new CharCacheNode;
-	//////////
-	//init the struct pointers
-	pNode->pSurface = NULL;
-	//////////
-	pNode->charCode = charCode;
-	pNode->charGlyphIndex = FT_Get_Char_Index(_impl->_Face, charCode);
-
-	if (pNode->charGlyphIndex == 0) {
-		delete pNode;
+	RasterizedGlyph glyph;
+	if (!rasterizeGlyph(_impl->_Face, _bBold, _bItalic ? &_impl->_matItalic : NULL, _bDistanceField ? _iSpread : 0,
+						charCode, &glyph))
 		return false;
-	}
 
-	FT_Load_Char(_impl->_Face, charCode, FT_LOAD_DEFAULT /*| FT_LOAD_NO_BITMAP*/);
+	return addGlyphToCache(glyph);
+}
 
-	// Bold
-	if(_bBold) {
-		int strength = 1 << 6;
-		FT_Outline_Embolden(&_impl->_Face->glyph->outline, strength);
-	}
+bool IND_TTF_Font::requestCharCache(wchar_t charCode) {
+	if (!_rasterizer)
+		return buildCharCache(charCode);
 
-	// Italic
-	if(_bItalic) {
-		// set transformation 
-		FT_Outline_Transform(&_impl->_Face->glyph->outline, &_impl->_matItalic);
-	}
-	
+	if (isCharCached(charCode))
+		return true;
 
-	if(FT_Render_Glyph(_impl->_Face->glyph, FT_RENDER_MODE_NORMAL)) {
-		delete pNode;
-		return false;
-	}
+	// skipped until the worker has rasterized it and uploadRasterizedGlyphs() has built its surface
+	_rasterizer->request(charCode);
+	return false;
+}
 
+bool IND_TTF_Font::addGlyphToCache(const RasterizedGlyph& glyph) {
 	// build an image
 	IND_Image *pImage = IND_Image::newImage();
 	assert(pImage);
 
-	// render the glyph image to IND_Image
-	if(!renderGlyph(_impl, pImage)) // &_impl->_Face->glyph->bitmap, pImage
+	// render the glyph image to IND_Image (on failure it is not in the manager)
+	if(!renderGlyph(glyph, pImage)) {
+		DISPOSEMANAGED(pImage);
 		return false;
+	}
+
+	CharCacheNode* pNode = new CharCacheNode;
+	pNode->charCode = glyph._charCode;
+	pNode->charGlyphIndex = glyph._glyphIndex;
 		
 	//building the surface from image
 	pNode->pSurface = IND_Surface::newSurface();
@@ -607,11 +634,12 @@ bool IND_TTF_Font::buildCharCache(wchar_t charCode) {
 		return false;
 	}
 
-	pNode->charLeftBearing = _impl->_Face->glyph->bitmap_left;
-	pNode->charTopBearing = _impl->_Face->glyph->bitmap_top;
-	pNode->charAdvance = _impl->_Face->glyph->advance.x / 64;
+	pNode->charLeftBearing = glyph._left;
+	pNode->charTopBearing = glyph._top;
+	pNode->charAdvance = glyph._advance;
 	
-	_FontCharCache.insert(std::pair<wchar_t, CharCacheNode*>(charCode, pNode));
+	_FontCharCache.insert(std::pair<wchar_t, CharCacheNode*>(glyph._charCode, pNode));
+	_cacheGeneration = ++s_cacheGeneration;
 
 	//cache entry built
 	return true;
@@ -625,52 +653,18 @@ IND_TTF_Font::CharCacheNode* IND_TTF_Font::getCharCacheNode(wchar_t charCode) {
 		return it->second;
 }
 
-bool IND_TTF_Font::renderGlyph(free_type_impl* impl, IND_Image *pImage) {
-	
-    //free_type_impl* impl
-    
-    FT_Bitmap* ftBMP = &impl->_Face->glyph->bitmap;
-    
-    uint32_t glyphWidth = ftBMP->width;
-	uint32_t glyphHeight = ftBMP->rows;
-
-	if (glyphWidth == 0 || glyphHeight == 0)
+bool IND_TTF_Font::renderGlyph(const RasterizedGlyph& glyph, IND_Image *pImage) {
+	if (glyph._width == 0 || glyph._height == 0)
 		return false;
 
-	_pIndieImageManager->add(pImage, glyphWidth, glyphHeight, IND_RGBA);
-	if(pImage == NULL)
+	if (!_pIndieImageManager->add(pImage, glyph._width, glyph._height, IND_RGBA))
 		return false;
 
-	byte *pSrc = ftBMP->buffer;
-	/*
-	byte r,g,b;
-	r = m_FontColor & 0xFF;
-	g = (m_FontColor >> 8) & 0xFF;
-	b = (m_FontColor >> 16) & 0xFF;
-	*/
+	const byte *pSrc = &glyph._alpha[0];
 
-	for(uint32_t x = 0 ; x <  glyphWidth; x++) {
-		
-        for(uint32_t y = 0 ; y <  glyphHeight; y++) {
-			
-            switch (ftBMP->pixel_mode) {
-				
-                case FT_PIXEL_MODE_GRAY:
-					//pImage->PutPixel(x, y, r,g,b,pSrc[y * glyphWidth + x]);
-					pImage->putPixel(x, y, 255,255,255,pSrc[y * glyphWidth + x]);
-					break;
-				case FT_PIXEL_MODE_MONO:
-					pSrc = ftBMP->buffer + (y * ftBMP->pitch);
-					if((pSrc [x / 8] & (0x80 >> (x & 7))))
-						//pImage->PutPixel(x, y, r,g,b,0xFF);
-						pImage->putPixel(x, y, 255,255,255,0xFF);
-					else
-						//pImage->PutPixel(x, y, r,g,b,0x00);
-						pImage->putPixel(x, y, 255,255,255,0x00);
-					break;
-				default:
-					break;
-			}
+	for(int y = 0 ; y <  glyph._height; y++) {
+		for(int x = 0 ; x <  glyph._width; x++) {
+			pImage->putPixel(x, y, 255,255,255,pSrc[y * glyph._width + x]);
 		}
 	}
 	
@@ -756,7 +750,7 @@ std::wstring IND_TTF_Font::textFormat(	const std::wstring& sText, float &fLineWi
 			continue;
 		}
 		if (_bAutoCache)
-			buildCharCache(sText[i]);
+			requestCharCache(sText[i]);
 
 		pNode = getCharCacheNode(sText[i]);
 		if (!pNode)
@@ -839,9 +833,214 @@ IND_TTF_Font::uint32_t IND_TTF_Font::getLineWidth(const std::wstring& sText, boo
 	return nRet;
 }
 
-void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float penY, float fL, float fT,
-							  float fR, float fB, uint32_t clrFont,bool bVertical, bool bR2L,bool bFlipX, 
-							  bool bFlipY, float fZRotate, byte btTrans, bool bKerning, bool bUnderl) {
+void IND_TTF_Font::buildTextLayout(TextLayout &layout, const std::wstring& sText, float fLeft, float fTop, float fRight,
+									float fBottom, uint32_t nFormat, bool bFlipX, bool bFlipY, float fZRotate, bool bKerning,
+									bool bUnderl) {
+	layout.sText = sText;
+	layout.fLeft = fLeft;
+	layout.fTop = fTop;
+	layout.fRight = fRight;
+	layout.fBottom = fBottom;
+	layout.nFormat = nFormat;
+	layout.bUnderl = bUnderl;
+	layout.glyphs.clear();
+	layout.underlines.clear();
+
+	//1. Check parameters
+	if(fLeft >= fRight || fTop >= fBottom) {
+		layout.result = 0;
+		return;
+	}
+	float fAreaWidth = fRight - fLeft;
+	float fAreaHeight = fBottom - fTop;
+
+	if(fAreaWidth < _CharWidth || fAreaHeight < _CharHeight) {
+		layout.result = -1;
+		return;
+	}
+
+	//the format must contain one para for horizontal align and one for vertical
+	if( !(nFormat & (DT_EX_LEFT | DT_EX_CENTER | DT_EX_RIGHT)) ||
+		!(nFormat & (DT_EX_TOP | DT_EX_VCENTER | DT_EX_BOTTOM))) {
+		layout.result = -2;
+		return;
+	}
+
+	bool bVertical = false;
+	//2. check vertical layout
+	if(nFormat & DT_EX_VERTICAL) {
+        // vertical layout
+		// mainly for you guys speaking Chinese, Japanese and Korean
+		if(!FT_HAS_VERTICAL(_impl->_Face)){
+            // ooops, font face doesn't support vertical layout
+			layout.result = -3;
+			return;
+		}
+		bVertical = true;
+	}
+	
+	// 3. check the right to left property
+	bool bR2L = false;
+	if(nFormat & DT_EX_RTOLREADING) {
+        // right to left reading
+		// mainly for you guys speaking Arabic
+		bR2L = true;
+	}
+
+	// 4. check the line wrap property
+	bool bWrap = false;
+	if(nFormat & DT_EX_LINEWRAP) {
+        // do the line wrap
+		bWrap = true;
+	}
+	
+	// 5. text format
+	float fTextWidth, fTextHeight;
+	int iTotalLines;
+	std::wstring sTarget = textFormat( sText, bVertical?fAreaHeight:fAreaWidth, fTextWidth, fTextHeight,
+										iTotalLines, bWrap,bFlipX, bFlipY, fZRotate, 255, bKerning,
+										bUnderl);
+	// determin the proper start point
+	float pen_X, pen_Y, start_X, start_Y;
+	start_X = fLeft;
+	start_Y = fTop;
+	if(bVertical)
+	{	
+		if(nFormat & DT_EX_LEFT)
+		{
+			if(bR2L)
+			{
+				start_X = fLeft + fTextHeight;
+			}
+		}
+		else if(nFormat & DT_EX_CENTER)
+		{
+			if(bR2L)
+			{
+				start_X = fRight - (fAreaWidth - fTextHeight) / 2;
+			}
+			else
+			{
+				start_X = fLeft + (fAreaWidth - fTextHeight) / 2;
+			}
+		}
+		else if(nFormat & DT_EX_RIGHT)
+		{
+			if(bR2L)
+			{
+				start_X = fRight;// - (fAreaWidth - fTextHeight);
+			}
+			else
+			{
+				start_X = fRight - fTextHeight;
+			}
+		}	
+	}
+	else
+	{
+		if(nFormat & DT_EX_VCENTER)
+		{
+			start_Y = fTop  + (fAreaHeight - fTextHeight) / 2;
+		}
+		else if(nFormat & DT_EX_BOTTOM)
+		{
+			start_Y = fBottom  - fTextHeight;
+		}
+	}
+	// 6. lay out the string content
+	std::size_t start = 0, end = 0, line = 0;
+	std::wstring curline;
+
+	while ( end < sTarget.length())
+	{
+		end = sTarget.find_first_of(L'\n', start);
+		if(end == std::wstring::npos)
+		{// no '\n found'
+			end = sTarget.length();
+		}
+		curline = sTarget.substr(start, end - start);
+        start = end + 1;
+		
+		if(bVertical)
+		{
+			if(bR2L)
+			{
+				pen_X = start_X - _CharWidth * line;
+			}
+			else
+			{
+				pen_X = start_X + _CharWidth * line;
+			}
+
+			if(nFormat & DT_EX_TOP)
+			{
+				pen_Y = fTop;
+			}
+			else if(nFormat & DT_EX_VCENTER)
+			{
+				pen_Y = fTop  + (fAreaHeight - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
+			}
+			else if(nFormat & DT_EX_BOTTOM)
+			{
+				pen_Y = fTop  + fAreaHeight - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning);
+			}
+            else{
+                pen_Y = 0.0f; // TODO: this is added to fix "warning C4701: potentially uninitialized local variable 'pen_Y'"
+
+            }
+		}
+		else
+		{
+			pen_X = fLeft;
+			pen_Y = start_Y + (float)(_CharHeight * line);
+
+			if(nFormat & DT_EX_LEFT)
+			{
+				if(bR2L)
+				{
+					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning));
+				}
+				else
+				{
+					pen_X = fLeft;
+				}
+			}
+			else if(nFormat & DT_EX_CENTER)
+			{
+				if(bR2L)
+				{
+					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
+				}
+				else
+				{
+					pen_X = fLeft + (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning)) / 2;
+				}
+			}
+			else if(nFormat & DT_EX_RIGHT)
+			{
+				if(bR2L)
+				{
+					pen_X = fRight - (fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning));
+				}
+				else
+				{
+					pen_X = fLeft + fAreaWidth - getLineWidth(curline, bFlipX, bFlipY, fZRotate, bKerning);
+				}
+			}	
+		}
+
+		// lay out this line
+		layoutTextLineEx(layout, curline, pen_X, pen_Y, fLeft, fTop, fRight, fBottom, bVertical, bR2L, bFlipX,
+						bFlipY, fZRotate, bKerning, bUnderl);
+		line++;
+	}
+
+	layout.result = 1;
+}
+
+void IND_TTF_Font::layoutTextLineEx(TextLayout &layout, const std::wstring& sText, float penX, float penY, float fL,
+								 float fT, float fR, float fB, bool bVertical, bool bR2L,bool bFlipX, 
+								 bool bFlipY, float fZRotate, bool bKerning, bool bUnderl) {
 	uint32_t previousGlyph = 0;
 	FT_Vector Delta;
 
@@ -912,8 +1111,7 @@ void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float p
 					(penX <= fR) &&
 					(penY >= fT ) && 
 					((penY + pNode->charAdvance) <= fB))
-					renderChar(sText[i], penX - _CharWidth, penY, clrFont, bFlipX, bFlipY, fZRotate, btTrans,
-								bKerning, bUnderl);
+					addGlyphRun(layout, pNode, penX - _CharWidth, penY);
 			}
 			else
 			{
@@ -921,8 +1119,7 @@ void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float p
 					((penX + _CharWidth) <= fR) &&
 					(penY >= fT ) && 
 					((penY + pNode->charAdvance) <= fB))
-					renderChar(sText[i], penX, penY, clrFont, bFlipX, bFlipY, fZRotate, btTrans,
-								bKerning, bUnderl);
+					addGlyphRun(layout, pNode, penX, penY);
 			}
 		}
 		else
@@ -933,8 +1130,7 @@ void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float p
 					(penX <= fR) &&
 					(penY >= fT ) && 
 					((penY + _CharHeight) <= fB))
-					renderChar(sText[i], penX - pNode->charAdvance, penY, clrFont, bFlipX, bFlipY, fZRotate, btTrans,
-								bKerning, bUnderl);
+					addGlyphRun(layout, pNode, penX - pNode->charAdvance, penY);
 			}
 			else
 			{
@@ -942,8 +1138,7 @@ void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float p
 					((penX + pNode->charAdvance) <= fR) &&
 					(penY >= fT ) &&
 					((penY + _CharHeight) <= fB))
-					renderChar(sText[i], penX, penY, clrFont, bFlipX, bFlipY, fZRotate, btTrans,
-								bKerning, bUnderl);
+					addGlyphRun(layout, pNode, penX, penY);
 			}
 		}		
 
@@ -963,10 +1158,25 @@ void IND_TTF_Font::drawTextLineEx(const std::wstring& sText, float penX, float p
 	// Draw underline
 	if(bUnderl && !bVertical && ((penX - original_Pen_x) > 0.1f))
 	{
-		doDrawBorder(original_Pen_x, penX, penY + _CharHeight, clrFont, btTrans);
+		TextLayout::UnderlineRun underline;
+		underline.xStart = original_Pen_x;
+		underline.xEnd = penX;
+		underline.y = penY + _CharHeight;
+		layout.underlines.push_back(underline);
 	}
 }
 
+void IND_TTF_Font::addGlyphRun(TextLayout &layout, CharCacheNode *pNode, float x, float y) {
+	if (!pNode->pSurface)
+		return;
+
+	TextLayout::GlyphRun glyph;
+	glyph.pSurface = pNode->pSurface;
+	glyph.x = x + pNode->charLeftBearing;
+	glyph.y = y + _fFaceAscender - pNode->charTopBearing;
+	layout.glyphs.push_back(glyph);
+}
+
 void IND_TTF_Font::doDrawBorder(float fX_s, float fX_e, float fY, uint32_t clr, byte btTrans) {
 	byte r,g,b;
 	r = clr & 0xFF;
@@ -50,7 +50,8 @@ IND_TTF_FontManager::IND_TTF_FontManager(void)
 _pIndieRender(NULL),
 _pIndieImageManager(NULL),
 _pIndieSurfaceManager(NULL),
-_freetype(NULL)
+_freetype(NULL),
+_glyphUploadBudget(8)
 {
 }
 
@@ -426,6 +427,101 @@ void IND_TTF_FontManager::setFontScale(const std::string& strFontName, float sx,
 	}
 }
 
+/**
+ * Sets if the chars that are missing in the cache of a font are rasterized in a worker thread instead
+ * of when the text is drawn. Those chars are skipped until renderAllTexts() builds their surfaces, up to
+ * the budget set with setGlyphUploadBudget() in each frame. Returns false if the worker thread can't be
+ * started, then the chars are still cached when they are drawn.
+ *
+ * @param strFontName				Name of the font.
+ * @param ba                        True for caching in the worker thread.
+ */
+bool IND_TTF_FontManager::setFontAsyncCache(const std::string& strFontName, bool ba) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		return pFont->setAsyncCache(ba);
+
+	return false;
+}
+
+/**
+ * Caches the chars of a string before they are drawn, in the worker thread if async cache is on
+ * (see setFontAsyncCache()).
+ *
+ * @param strFontName				Name of the font.
+ * @param s                         Chars to cache, i.e. the character set of a language.
+ */
+void IND_TTF_FontManager::prewarmFont(const std::string& strFontName, const std::wstring& s) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		pFont->prewarm(s);
+}
+
+/**
+ * Caches all the chars used in a UTF-8 text file before they are drawn, in the worker thread if
+ * async cache is on (see setFontAsyncCache()). Returns false if the file can't be read.
+ *
+ * @param strFontName				Name of the font.
+ * @param strPath                   Path of the file, i.e. a locale file with the texts of the game.
+ */
+bool IND_TTF_FontManager::prewarmFontFromFile(const std::string& strFontName, const std::string& strPath) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		return pFont->prewarmFromFile(strPath);
+
+	return false;
+}
+
+/**
+ * Sets if the glyphs of a font are cached as signed distance fields instead of their coverage. They are
+ * rasterized once, at the size of the font, and stay sharp when they are drawn bigger or smaller (see
+ * setFontScale()) or the camera zooms, so a single font serves all the sizes of a typeface. With the
+ * programmable 2d renderer (see IND_Render::setProgrammable2d()) the edges are antialiased and the glyphs
+ * can have an outline and a shadow, with the fixed pipeline the edges are hard. Only the OpenGL renderer
+ * draws distance fields. The glyphs already cached are rasterized again.
+ *
+ * @param strFontName				Name of the font.
+ * @param bsdf                      True for distance fields.
+ * @param iSpread                   Margin of the fields around each glyph, in pixels. Bigger spreads allow
+ *                                  wider outlines and shadows, and smaller sizes.
+ */
+void IND_TTF_FontManager::setFontDistanceField(const std::string& strFontName, bool bsdf, int iSpread) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		pFont->setDistanceField(bsdf, iSpread);
+}
+
+/**
+ * Sets the outline of a font with distance fields (see setFontDistanceField()).
+ *
+ * @param strFontName				Name of the font.
+ * @param fWidth                    Width of the outline, in units of the field: 0 = no outline,
+ *                                  0.5 = the whole spread.
+ * @param clrOutline                Color of the outline (see RGBCOLOR).
+ * @param btTrans                   Transparency of the outline.
+ */
+void IND_TTF_FontManager::setFontOutline(const std::string& strFontName, float fWidth, uint32_t clrOutline, byte btTrans) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		pFont->setDistanceFieldOutline(fWidth, clrOutline, btTrans);
+}
+
+/**
+ * Sets the shadow of a font with distance fields (see setFontDistanceField()).
+ *
+ * @param strFontName				Name of the font.
+ * @param fOffsetX                  Horizontal offset of the shadow, in pixels of the glyphs (up to the spread).
+ * @param fOffsetY                  Vertical offset of the shadow, in pixels of the glyphs (up to the spread).
+ * @param clrShadow                 Color of the shadow (see RGBCOLOR).
+ * @param btTrans                   Transparency of the shadow, 0 = no shadow.
+ */
+void IND_TTF_FontManager::setFontShadow(const std::string& strFontName, float fOffsetX, float fOffsetY,
+										uint32_t clrShadow, byte btTrans) {
+	IND_TTF_Font *pFont = getFontByName(strFontName);
+	if(pFont)
+		pFont->setDistanceFieldShadow(fOffsetX, fOffsetY, clrShadow, btTrans);
+}
+
 /**
  * TODO:describtion
  *
@@ -496,6 +592,11 @@ void IND_TTF_FontManager::drawTextEx(uint32_t uiIndex, const std::string& strFon
  * TODO:describtion
  */
 void IND_TTF_FontManager::renderAllTexts() {
+	// build the surfaces of the glyphs rasterized by the worker threads, within the budget
+	int nBudget = _glyphUploadBudget;
+	for(IND_TTF_FontListIterator it = _FontList.begin() ; it != _FontList.end() && nBudget > 0 ; it++)
+		nBudget -= it->second->uploadRasterizedGlyphs(nBudget);
+
 	// render simple text from DrawText method
 	DrawTextRequestNode *pReq = NULL;
 	for(DTRListIterator it = _DTRList.begin() ; it != _DTRList.end() ; it++) {
@@ -510,7 +611,8 @@ void IND_TTF_FontManager::renderAllTexts() {
 							pReq->fZRotate,
 							pReq->btTransparency,
 							pReq->bUseKerning,
-							pReq->bUnderline);
+							pReq->bUnderline,
+							&pReq->layout);
 		else
 			doDrawText(pReq->sFont, pReq->sText, pReq->xPos, pReq->yPos,
 					pReq->clrFont, 
@@ -556,12 +658,13 @@ int IND_TTF_FontManager::doDrawTextEx(const std::string& strFontName,const std::
 									float fLeft, float fTop, float fRight, float fBottom, 
 									uint32_t nFormat, uint32_t clrFont, uint32_t clrBorder, uint32_t clrBack,
 									byte btBorderTrans, byte btBackTrans, bool bFlipX, bool bFlipY, 
-									float fZRotate, byte btTrans, bool bKerning, bool bUnderl) {
+									float fZRotate, byte btTrans, bool bKerning, bool bUnderl,
+									IND_TTF_Font::TextLayout *pLayout) {
 	IND_TTF_Font *pFont = getFontByName(strFontName);
 	if(pFont)
 		pFont->drawTextEx(	sText, fLeft, fTop, fRight, fBottom, nFormat, clrFont, clrBorder,
 							clrBack,btBorderTrans, btBackTrans,
-							bFlipX,bFlipY,fZRotate,btTrans,bKerning,bUnderl);
+							bFlipX,bFlipY,fZRotate,btTrans,bKerning,bUnderl,pLayout);
 
 	return 0;
 }
@@ -0,0 +1,97 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+#include "Defines.h"
+
+#if defined (INDIERENDER_GLES_IOS) || defined (INDIERENDER_OPENGL)
+
+#include "IND_UniformBuffer.h"
+#include "Global.h"
+#include <string.h>
+
+bool IND_UniformBuffer::create(int size, unsigned int bindingPoint) {
+#ifdef INDIERENDER_OPENGL
+    if (size <= 0) return false;
+    if (!GLEW_VERSION_3_1 && !GLEW_ARB_uniform_buffer_object) {
+        g_debug->header("Uniform buffers are not supported", DebugApi::LogHeaderWarning);
+        return false;
+    }
+    
+    end();
+    
+    _data.assign(size, 0);
+    _bindingPoint = bindingPoint;
+    
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, &_data[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    
+    //The binding point is global, the programs refer to it (not to the buffer)
+    glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _buffer);
+    return true;
+#else
+    //Uniform blocks are not available in GLES 2
+    return false;
+#endif
+}
+
+void IND_UniformBuffer::setData(const void* data, int offset, int size) {
+#ifdef INDIERENDER_OPENGL
+    if (!_buffer || !data || offset < 0 || size <= 0 || offset + size > getSize()) return;
+    
+    //Range of bytes that changed
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    int first = 0;
+    while (first < size && bytes[first] == _data[offset + first]) {
+        ++first;
+    }
+    if (first == size) return;
+    
+    int last = size - 1;
+    while (last > first && bytes[last] == _data[offset + last]) {
+        --last;
+    }
+    
+    memcpy(&_data[offset + first], bytes + first, last - first + 1);
+    
+    glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset + first, last - first + 1, bytes + first);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+#endif
+}
+
+void IND_UniformBuffer::end() {
+#ifdef INDIERENDER_OPENGL
+    if (_buffer) {
+        glDeleteBuffers(1, &_buffer);
+    }
+#endif
+    
+    _buffer = 0;
+    _data.clear();
+}
+
+#endif //INDIERENDER_GLES_IOS || INDIERENDER_OPENGL
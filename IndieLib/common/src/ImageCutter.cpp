@@ -99,13 +99,22 @@ void ImageCutter::fillInfoSurface(IND_Image *pImage,
 	// Block size is equal to the maximun allowed by the card
 	int mBlockSize = _maxTextureSize;
 
-	// Width and height of the are to be rendered in
-	pI->_widthBlock   = powerOfTwo(_width);
-	pI->_heightBlock  = powerOfTwo(_height);
+	if (_nonPowerOfTwo) {
+		// Blocks are exactly sized. If width and height are higher than allowed, the image is
+		// divided in equal blocks, so the spare area is, at most, one pixel per block.
+		int mBlocksX = (_width  + mBlockSize - 1) / mBlockSize;
+		int mBlocksY = (_height + mBlockSize - 1) / mBlockSize;
+		pI->_widthBlock   = (_width  + mBlocksX - 1) / mBlocksX;
+		pI->_heightBlock  = (_height + mBlocksY - 1) / mBlocksY;
+	} else {
+		// Width and height of the are to be rendered in
+		pI->_widthBlock   = powerOfTwo(_width);
+		pI->_heightBlock  = powerOfTwo(_height);
 
-	// If width and height are higher than allowed, the block will be smaller
-	if (pI->_widthBlock  > mBlockSize)  pI->_widthBlock  = mBlockSize;
-	if (pI->_heightBlock > mBlockSize)  pI->_heightBlock = mBlockSize;
+		// If width and height are higher than allowed, the block will be smaller
+		if (pI->_widthBlock  > mBlockSize)  pI->_widthBlock  = mBlockSize;
+		if (pI->_heightBlock > mBlockSize)  pI->_heightBlock = mBlockSize;
+	}
 
 	// If the user has choosen a size block, we change the values
 	if (pBlockSizeX != 0) {
@@ -178,25 +187,67 @@ void ImageCutter::cutBlock(unsigned char *pPtrBlock,
 
 	int mSizeBlock = pWidthBlock * pHeightBlock * pBpp;
 	*pNewBlock = new unsigned char [mSizeBlock];
-	memset(*pNewBlock, 0, mSizeBlock);
 
 	// ----- Copy the block -----
 
-	// Initial position
-	unsigned char *mInitPosition = *pNewBlock;
+	cutBlockTo(pPtrBlock, pWidthImage, pWidthBlock, pHeightBlock, pSpareX, pSpareY, pBpp, *pNewBlock);
+}
+
+
+/**
+ * Cuts a block of an image in memory into a destination buffer provided by the caller
+ * (for example, a mapped pixel buffer). The spare area of the block is filled with zeros.
+ *  @param pPtrBlock		first pixel of the block in the image
+ *  @param pWidthImage		width of the image (pixels)
+ *  @param pWidthBlock		width of the block (pixels)
+ *  @param pHeightBlock		height of the block (pixels)
+ *  @param pSpareX		right spare area of the block (pixels)
+ *  @param pSpareY		upper spare area of the block (pixels)
+ *  @param pBpp			bytes per pixel
+ *  @param pDestBlock		destination, at least pWidthBlock * pHeightBlock * pBpp bytes
+ */
+void ImageCutter::cutBlockTo(unsigned char *pPtrBlock,
+                             int pWidthImage,
+                             int pWidthBlock,
+                             int pHeightBlock,
+                             int pSpareX,
+                             int pSpareY,
+                             int pBpp,
+                             unsigned char *pDestBlock) {
+	int mLineBytes = (pWidthBlock * pBpp) - (pSpareX * pBpp);
+	int mSpareBytes = pSpareX * pBpp;
 
 	// Cut
 	for (int i = 0; i < pHeightBlock - pSpareY; i++) {
 		// We cut one line
-		memcpy(*pNewBlock, pPtrBlock, (pWidthBlock * pBpp) - (pSpareX * pBpp));
+		memcpy(pDestBlock, pPtrBlock, mLineBytes);
+		if (mSpareBytes)
+			memset(pDestBlock + mLineBytes, 0, mSpareBytes);
 
 		// Following line
 		pPtrBlock += pWidthImage * pBpp;
-		*pNewBlock += pWidthBlock * pBpp;
+		pDestBlock += pWidthBlock * pBpp;
+	}
+
+	// Spare lines
+	if (pSpareY)
+		memset(pDestBlock, 0, pSpareY * pWidthBlock * pBpp);
+}
+
+
+/**
+ * Returns a scratch buffer of at least pSize bytes. The buffer is owned by the cutter and
+ * reused between calls, so it only grows up to the biggest block cut.
+ *  @param pSize		size needed (bytes)
+ */
+unsigned char *ImageCutter::getScratchBuffer(int pSize) {
+	if (pSize > _scratchSize) {
+		DISPOSEARRAY(_scratch);
+		_scratch = new unsigned char [pSize];
+		_scratchSize = pSize;
 	}
 
-	// Return the initial position
-	*pNewBlock = mInitPosition;
+	return _scratch;
 }
 
 
@@ -251,7 +302,9 @@ void ImageCutter::fillQualityAndType(IND_Image* pImage, INFO_SURFACE *pI) {
  * Init variables.
  */
 void ImageCutter::initVars() {
-
+	_nonPowerOfTwo = false;
+	_scratch = NULL;
+	_scratchSize = 0;
 }
 
 
@@ -259,7 +312,8 @@ void ImageCutter::initVars() {
  * Free variables.
  */
 void ImageCutter::freeVars() {
-
+	DISPOSEARRAY(_scratch);
+	_scratchSize = 0;
 }
 
 /** @endcond */
@@ -0,0 +1,135 @@
+/*****************************************************************************************
+ * File: MappedFile.cpp
+ * Desc: Class to encapsulate a read only memory mapped file
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "MappedFile.h"
+
+#if defined (PLATFORM_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+//Maps the whole file in memory. The pages are read by the system when they are accessed.
+bool MappedFile::open(const char *pName) {
+	close();
+
+#ifdef PLATFORM_WIN32
+	HANDLE mFile = CreateFileA(pName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == mFile)
+		return false;
+
+	DWORD mSize = GetFileSize(mFile, NULL);
+	HANDLE mMapping = (mSize && INVALID_FILE_SIZE != mSize) ? CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	if (!mMapping) {
+		CloseHandle(mFile);
+		return false;
+	}
+
+	_data = static_cast<unsigned char *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!_data) {
+		CloseHandle(mMapping);
+		CloseHandle(mFile);
+		return false;
+	}
+
+	_size = static_cast<int>(mSize);
+	_file = mFile;
+	_mapping = mMapping;
+#else
+	int mFile = ::open(pName, O_RDONLY);
+	if (mFile < 0)
+		return false;
+
+	struct stat mStat;
+	if (fstat(mFile, &mStat) != 0 || mStat.st_size <= 0) {
+		::close(mFile);
+		return false;
+	}
+
+	void *mData = mmap(NULL, mStat.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+
+	// The mapping stays valid after closing the descriptor
+	::close(mFile);
+
+	if (MAP_FAILED == mData)
+		return false;
+
+	_data = static_cast<unsigned char *>(mData);
+	_size = static_cast<int>(mStat.st_size);
+#endif
+
+	return true;
+}
+
+//Unmaps the file
+void MappedFile::close() {
+	if (!_data)
+		return;
+
+#ifdef PLATFORM_WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(static_cast<HANDLE>(_mapping));
+	CloseHandle(static_cast<HANDLE>(_file));
+#else
+	munmap(_data, _size);
+#endif
+
+	_data = NULL;
+	_size = 0;
+	_file = NULL;
+	_mapping = NULL;
+}
+
+//Modification time of a file, in seconds since 1970 (only the low 32 bits), or 0 if the file doesn't exist
+unsigned int MappedFile::getModificationTime(const char *pName) {
+#ifdef PLATFORM_WIN32
+	WIN32_FILE_ATTRIBUTE_DATA mData;
+	if (!GetFileAttributesExA(pName, GetFileExInfoStandard, &mData))
+		return 0;
+
+	// 100 ns intervals since 1601
+	unsigned long long mTime = (static_cast<unsigned long long>(mData.ftLastWriteTime.dwHighDateTime) << 32) | mData.ftLastWriteTime.dwLowDateTime;
+	return static_cast<unsigned int>(mTime / 10000000ULL - 11644473600ULL);
+#else
+	struct stat mStat;
+	if (stat(pName, &mStat) != 0)
+		return 0;
+
+	return static_cast<unsigned int>(mStat.st_mtime);
+#endif
+}
+
+/** @endcond */
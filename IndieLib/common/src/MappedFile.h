@@ -0,0 +1,90 @@
+/*****************************************************************************************
+ * File: MappedFile.h
+ * Desc: Class to encapsulate a read only memory mapped file
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _MAPPEDFILE
+#define _MAPPEDFILE
+
+//Library dependencies
+
+#include "Defines.h"
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+class MappedFile {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	MappedFile():
+		_data(NULL),
+		_size(0),
+		_file(NULL),
+		_mapping(NULL) {
+	}
+	~MappedFile() {
+		close();
+	}
+
+	//----- GET/SET FUNCTIONS -----
+
+	const unsigned char *getData() {
+		return _data;
+	}
+	int getSize() {
+		return _size;
+	}
+
+	//----- OTHER FUNCTIONS -----
+
+	bool open(const char *pName);
+	void close();
+
+	static unsigned int getModificationTime(const char *pName);
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	unsigned char *_data;
+	int _size;
+	void *_file;            // Win32 file and mapping handles
+	void *_mapping;
+
+	//----- INTERNAL FUNCTIONS -----
+
+	// Not copyable, it owns the mapping
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+};
+
+/** @endcond */
+
+#endif
@@ -0,0 +1,250 @@
+/*****************************************************************************************
+ * File: SpatialGrid.cpp
+ * Desc: Grid of cells with the entities of a layer, for selecting the visible ones
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+
+#include "SpatialGrid.h"
+#include "IND_Entity2d.h"
+#include <math.h>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+//Adds an entity to the grid. It has no bounds (always visible) until update() is called.
+void SpatialGrid::insert(IND_Entity2d *pEn) {
+	const float mHuge = 1.0e30f;
+	pEn->_spatialGrid = this;
+	pEn->_spatialLarge = 1;
+	pEn->_spatialStamp = 0;
+	pEn->_spatialBox [0] = pEn->_spatialBox [1] = -mHuge;
+	pEn->_spatialBox [2] = pEn->_spatialBox [3] = mHuge;
+	_large.push_back(pEn);
+
+	pEn->_spatialDirty = 0;
+	markDirty(pEn);
+}
+
+//Removes an entity from the grid
+void SpatialGrid::remove(IND_Entity2d *pEn) {
+	if (pEn->_spatialGrid != this)
+		return;
+
+	unlink(pEn);
+	if (pEn->_spatialDirty)
+		eraseFrom(&_dirty, pEn);
+
+	pEn->_spatialGrid = NULL;
+	pEn->_spatialDirty = 0;
+}
+
+//Sets the world bounding box of an entity. The cells are only changed when the box covers different cells.
+void SpatialGrid::update(IND_Entity2d *pEn, float pMinX, float pMinY, float pMaxX, float pMaxY) {
+	pEn->_spatialBox [0] = pMinX;
+	pEn->_spatialBox [1] = pMinY;
+	pEn->_spatialBox [2] = pMaxX;
+	pEn->_spatialBox [3] = pMaxY;
+
+	bool mLarge = (pMaxX - pMinX) > static_cast<float>(_cellSize) * SPATIAL_MAX_CELLS ||
+	              (pMaxY - pMinY) > static_cast<float>(_cellSize) * SPATIAL_MAX_CELLS;
+
+	int mCells [4] = {0, 0, 0, 0};
+	if (!mLarge) {
+		mCells [0] = cellCoord(pMinX);
+		mCells [1] = cellCoord(pMinY);
+		mCells [2] = cellCoord(pMaxX);
+		mCells [3] = cellCoord(pMaxY);
+		mLarge = (mCells [2] - mCells [0] + 1) * (mCells [3] - mCells [1] + 1) > SPATIAL_MAX_CELLS;
+	}
+
+	// Same cells
+	if (mLarge && pEn->_spatialLarge)
+		return;
+	if (!mLarge && !pEn->_spatialLarge &&
+	        mCells [0] == pEn->_spatialCells [0] && mCells [1] == pEn->_spatialCells [1] &&
+	        mCells [2] == pEn->_spatialCells [2] && mCells [3] == pEn->_spatialCells [3])
+		return;
+
+	unlink(pEn);
+	pEn->_spatialLarge = mLarge;
+	for (int i = 0; i < 4; i++)
+		pEn->_spatialCells [i] = mCells [i];
+	link(pEn);
+}
+
+//Sets an entity without bounds (always visible)
+void SpatialGrid::updateUnbounded(IND_Entity2d *pEn) {
+	const float mHuge = 1.0e30f;
+	update(pEn, -mHuge, -mHuge, mHuge, mHuge);
+}
+
+//Adds an entity to the list of entities whose bounds have to be calculated again
+void SpatialGrid::markDirty(IND_Entity2d *pEn) {
+	if (pEn->_spatialDirty)
+		return;
+
+	pEn->_spatialDirty = 1;
+	_dirty.push_back(pEn);
+}
+
+//Clears the list of dirty entities, once their bounds have been calculated again
+void SpatialGrid::clearDirty() {
+	for (size_t i = 0; i < _dirty.size(); i++)
+		_dirty [i]->_spatialDirty = 0;
+
+	_dirty.clear();
+}
+
+//Adds to pResult the entities whose bounds intersect a rectangle, each one only once
+void SpatialGrid::query(float pMinX, float pMinY, float pMaxX, float pMaxY, vector <IND_Entity2d *> *pResult) {
+	_stamp++;
+
+	for (size_t i = 0; i < _large.size(); i++)
+		testAndAdd(_large [i], pMinX, pMinY, pMaxX, pMaxY, pResult);
+
+	int mX1 = cellCoord(pMinX);
+	int mY1 = cellCoord(pMinY);
+	int mX2 = cellCoord(pMaxX);
+	int mY2 = cellCoord(pMaxY);
+
+	// When the rectangle covers more cells than the ones that have entities, they are tested directly
+	double mNumCells = (static_cast<double>(mX2) - mX1 + 1) * (static_cast<double>(mY2) - mY1 + 1);
+	if (mNumCells > static_cast<double>(_cells.size())) {
+		map <long long, CELL>::iterator mIter;
+		for (mIter = _cells.begin(); mIter != _cells.end(); mIter++) {
+			int mX = static_cast<int>(mIter->first & 0xffffffff);
+			int mY = static_cast<int>(mIter->first >> 32);
+			if (mX < mX1 || mX > mX2 || mY < mY1 || mY > mY2)
+				continue;
+
+			CELL &mCell = mIter->second;
+			for (size_t i = 0; i < mCell.size(); i++)
+				testAndAdd(mCell [i], pMinX, pMinY, pMaxX, pMaxY, pResult);
+		}
+		return;
+	}
+
+	for (int mY = mY1; mY <= mY2; mY++) {
+		for (int mX = mX1; mX <= mX2; mX++) {
+			map <long long, CELL>::iterator mIter = _cells.find(cellKey(mX, mY));
+			if (mIter == _cells.end())
+				continue;
+
+			CELL &mCell = mIter->second;
+			for (size_t i = 0; i < mCell.size(); i++)
+				testAndAdd(mCell [i], pMinX, pMinY, pMaxX, pMaxY, pResult);
+		}
+	}
+}
+
+//Removes all the entities from the grid
+void SpatialGrid::clear() {
+	map <long long, CELL>::iterator mIter;
+	for (mIter = _cells.begin(); mIter != _cells.end(); mIter++) {
+		for (size_t i = 0; i < mIter->second.size(); i++)
+			mIter->second [i]->_spatialGrid = NULL;
+	}
+	for (size_t i = 0; i < _large.size(); i++)
+		_large [i]->_spatialGrid = NULL;
+	for (size_t i = 0; i < _dirty.size(); i++)
+		_dirty [i]->_spatialDirty = 0;
+
+	_cells.clear();
+	_large.clear();
+	_dirty.clear();
+}
+
+//Links an entity to its cells
+void SpatialGrid::link(IND_Entity2d *pEn) {
+	if (pEn->_spatialLarge) {
+		_large.push_back(pEn);
+		return;
+	}
+
+	for (int mY = pEn->_spatialCells [1]; mY <= pEn->_spatialCells [3]; mY++) {
+		for (int mX = pEn->_spatialCells [0]; mX <= pEn->_spatialCells [2]; mX++)
+			_cells [cellKey(mX, mY)].push_back(pEn);
+	}
+}
+
+//Unlinks an entity from its cells. Empty cells are removed.
+void SpatialGrid::unlink(IND_Entity2d *pEn) {
+	if (pEn->_spatialLarge) {
+		eraseFrom(&_large, pEn);
+		return;
+	}
+
+	for (int mY = pEn->_spatialCells [1]; mY <= pEn->_spatialCells [3]; mY++) {
+		for (int mX = pEn->_spatialCells [0]; mX <= pEn->_spatialCells [2]; mX++) {
+			map <long long, CELL>::iterator mIter = _cells.find(cellKey(mX, mY));
+			if (mIter == _cells.end())
+				continue;
+
+			eraseFrom(&mIter->second, pEn);
+			if (mIter->second.empty())
+				_cells.erase(mIter);
+		}
+	}
+}
+
+//Removes an entity from a list, without keeping the order
+void SpatialGrid::eraseFrom(CELL *pCell, IND_Entity2d *pEn) {
+	for (size_t i = 0; i < pCell->size(); i++) {
+		if ((*pCell) [i] == pEn) {
+			(*pCell) [i] = pCell->back();
+			pCell->pop_back();
+			return;
+		}
+	}
+}
+
+//Adds an entity to pResult if its bounds intersect the rectangle and it hasn't been added yet
+void SpatialGrid::testAndAdd(IND_Entity2d *pEn, float pMinX, float pMinY, float pMaxX, float pMaxY, vector <IND_Entity2d *> *pResult) {
+	if (pEn->_spatialStamp == _stamp)
+		return;
+
+	pEn->_spatialStamp = _stamp;
+	if (pEn->_spatialBox [0] > pMaxX || pEn->_spatialBox [2] < pMinX ||
+	        pEn->_spatialBox [1] > pMaxY || pEn->_spatialBox [3] < pMinY)
+		return;
+
+	pResult->push_back(pEn);
+}
+
+//Cell of a coordinate, clamped so huge coordinates don't overflow
+int SpatialGrid::cellCoord(float pCoord) {
+	float mCell = floorf(pCoord / static_cast<float>(_cellSize));
+	if (mCell < -1.0e9f)
+		return -1000000000;
+	if (mCell > 1.0e9f)
+		return 1000000000;
+
+	return static_cast<int>(mCell);
+}
+
+/** @endcond */
@@ -0,0 +1,116 @@
+/*****************************************************************************************
+ * File: SpatialGrid.h
+ * Desc: Grid of cells with the entities of a layer, for selecting the visible ones
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _SPATIALGRID
+#define _SPATIALGRID
+
+//Library dependencies
+
+#include "Defines.h"
+#include <map>
+#include <vector>
+
+using namespace std;
+
+class IND_Entity2d;
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// Entities that cover more cells are kept in a list that is always tested
+#define SPATIAL_MAX_CELLS 64
+
+// Each entity is linked to all the cells covered by its world bounding box (see IND_Entity2d::_spatialCells).
+// The entities tell the grid when their bounds change (IND_Entity2d::spatialChanged()), and the owner of
+// the grid calculates the new bounds of the dirty entities before each query.
+class SpatialGrid {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	SpatialGrid(int pCellSize):
+		_cellSize(pCellSize),
+		_stamp(0) {
+	}
+	~SpatialGrid() {
+		clear();
+	}
+
+	//----- GET/SET FUNCTIONS -----
+
+	int getCellSize() {
+		return _cellSize;
+	}
+	vector <IND_Entity2d *> *getDirty() {
+		return &_dirty;
+	}
+
+	//----- OTHER FUNCTIONS -----
+
+	void insert(IND_Entity2d *pEn);
+	void remove(IND_Entity2d *pEn);
+	void update(IND_Entity2d *pEn, float pMinX, float pMinY, float pMaxX, float pMaxY);
+	void updateUnbounded(IND_Entity2d *pEn);
+	void markDirty(IND_Entity2d *pEn);
+	void clearDirty();
+	void query(float pMinX, float pMinY, float pMaxX, float pMaxY, vector <IND_Entity2d *> *pResult);
+	void clear();
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	typedef vector <IND_Entity2d *> CELL;
+
+	int _cellSize;
+	unsigned int _stamp;                    // Incremented in each query, for returning each entity only once
+	map <long long, CELL> _cells;           // Cells that have entities, by their coordinates (see cellKey())
+	CELL _large;                            // Entities that cover too many cells, or without bounds
+	CELL _dirty;                            // Entities whose bounds have to be calculated again
+
+	//----- INTERNAL FUNCTIONS -----
+
+	void link(IND_Entity2d *pEn);
+	void unlink(IND_Entity2d *pEn);
+	void eraseFrom(CELL *pCell, IND_Entity2d *pEn);
+	void testAndAdd(IND_Entity2d *pEn, float pMinX, float pMinY, float pMaxX, float pMaxY, vector <IND_Entity2d *> *pResult);
+	int  cellCoord(float pCoord);
+	long long cellKey(int pX, int pY) {
+		return (static_cast<long long>(pY) << 32) | static_cast<unsigned int>(pX);
+	}
+
+	// Not copyable, the entities point to it
+	SpatialGrid(const SpatialGrid &);
+	SpatialGrid &operator=(const SpatialGrid &);
+};
+
+/** @endcond */
+
+#endif
@@ -0,0 +1,415 @@
+/*****************************************************************************************
+ * File: SpriterClip.cpp
+ * Desc: Spriter animation flattened into time-sorted key arrays, for playback
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+
+#include "SpriterClip.h"
+#include "IND_SpriterEntity.h"
+#include "IND_Math.h"
+#include <algorithm>
+#include <math.h>
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+//Copies an object of the file (timeline or mainline object, they have the same fields) into a key
+template <class T>
+static void flattenObject(const T *pObject, map <Fileref, IND_Surface *> *pSurfaces, SpriterKey *pKey) {
+	map <Fileref, IND_Surface *>::iterator mIter = pSurfaces->find(Fileref(static_cast<unsigned int>(pObject->folder),
+	                                                                        static_cast<unsigned int>(pObject->file)));
+	pKey->_surface = (mIter != pSurfaces->end()) ? mIter->second : NULL;
+	pKey->_pivotX = pObject->pivot_x;
+	pKey->_pivotY = pObject->pivot_y;
+	pKey->_spatial._x = pObject->x;
+	pKey->_spatial._y = pObject->y;
+	pKey->_spatial._angle = pObject->angle;
+	pKey->_spatial._scaleX = pObject->scale_x;
+	pKey->_spatial._scaleY = pObject->scale_y;
+	pKey->_spatial._alpha = pObject->a;
+}
+
+//The angle goes the way of the spin of the first key
+void SpriterClip::lerpSpatial(const SpriterSpatial &pA, const SpriterSpatial &pB, int pSpin, float pT, SpriterSpatial *pOut) {
+	float mAngleB = pB._angle;
+	if (pSpin == 0)
+		mAngleB = pA._angle;
+	else if (pSpin > 0 && mAngleB < pA._angle)
+		mAngleB += 360.0f;
+	else if (pSpin < 0 && mAngleB > pA._angle)
+		mAngleB -= 360.0f;
+
+	pOut->_x = pA._x + (pB._x - pA._x) * pT;
+	pOut->_y = pA._y + (pB._y - pA._y) * pT;
+	pOut->_angle = pA._angle + (mAngleB - pA._angle) * pT;
+	pOut->_scaleX = pA._scaleX + (pB._scaleX - pA._scaleX) * pT;
+	pOut->_scaleY = pA._scaleY + (pB._scaleY - pA._scaleY) * pT;
+	pOut->_alpha = pA._alpha + (pB._alpha - pA._alpha) * pT;
+}
+
+//Transform of a child in the space of the entity, from the transform of its parent
+void SpriterClip::composeSpatial(const SpriterSpatial &pParent, const SpriterSpatial &pLocal, SpriterSpatial *pOut) {
+	float mX = pLocal._x * pParent._scaleX;
+	float mY = pLocal._y * pParent._scaleY;
+	float mRadians = pParent._angle * PI / 180.0f;
+	float mSin = sinf(mRadians);
+	float mCos = cosf(mRadians);
+
+	pOut->_x = pParent._x + mX * mCos - mY * mSin;
+	pOut->_y = pParent._y + mX * mSin + mY * mCos;
+	pOut->_angle = pParent._angle + ((pParent._scaleX * pParent._scaleY < 0.0f) ? -pLocal._angle : pLocal._angle);
+	pOut->_scaleX = pParent._scaleX * pLocal._scaleX;
+	pOut->_scaleY = pParent._scaleY * pLocal._scaleY;
+	pOut->_alpha = pParent._alpha * pLocal._alpha;
+}
+
+static bool sameSpatial(const SpriterSpatial &pA, const SpriterSpatial &pB) {
+	return pA._x == pB._x &&
+	       pA._y == pB._y &&
+	       pA._angle == pB._angle &&
+	       pA._scaleX == pB._scaleX &&
+	       pA._scaleY == pB._scaleY &&
+	       pA._alpha == pB._alpha;
+}
+
+//Points a reference of the mainline to the sorted keys. Returns false if the timeline or the key don't exist.
+static bool remapRef(const vector <vector <unsigned int> > &pRemap, int pTimeline, int pKey, SpriterRef *pRef) {
+	if (pTimeline < 0 || pTimeline >= static_cast<int>(pRemap.size()) ||
+	    pKey < 0 || pKey >= static_cast<int>(pRemap [pTimeline].size()))
+		return false;
+
+	pRef->_timeline = static_cast<unsigned int>(pTimeline);
+	pRef->_key = pRemap [pTimeline] [pKey];
+	pRef->_zIndex = 0;
+	pRef->_parent = -1;
+	return true;
+}
+
+static bool lessZIndex(const SpriterRef &pA, const SpriterRef &pB) {
+	return pA._zIndex < pB._zIndex;
+}
+
+//Sorts the bones of a mainline key so the parents come first. pOrder gets the index in pBones of each sorted
+//bone, and pParents the index in pOrder of its parent (-1 for a root). A bone is added once its parent is.
+//Bones whose timeline or key doesn't exist (pNumKeys has the number of keys of each timeline) are skipped and
+//their children become roots, and so are the bones of a cycle, which never get their parent added.
+void SpriterClip::sortBones(const vector <MainlineBoneref *> &pBones, const vector <unsigned int> &pNumKeys, vector <unsigned int> *pOrder, vector <int> *pParents) {
+	int mNumBones = static_cast<int>(pBones.size());
+	map <int, int> mIdIndex;                        // Index in pBones of each bone id
+	for (int i = 0; i < mNumBones; i++)
+		mIdIndex [pBones [i]->id] = i;
+
+	vector <int> mSorted(mNumBones, -1);            // Index in pOrder, -1 if not added yet, -2 if skipped
+	pOrder->clear();
+	pParents->clear();
+
+	bool mProgress = true;
+	while (mProgress) {
+		mProgress = false;
+		for (int i = 0; i < mNumBones; i++) {
+			if (mSorted [i] != -1)
+				continue;
+
+			const MainlineBoneref *mBone = pBones [i];
+			map <int, int>::const_iterator mParentIter = mIdIndex.find(mBone->parent);
+			int mParent = (mParentIter != mIdIndex.end() && mParentIter->second != i) ? mParentIter->second : -1;
+			if (mParent >= 0 && mSorted [mParent] == -1)
+				continue;
+
+			mProgress = true;
+			if (mBone->timeline < 0 || mBone->timeline >= static_cast<int>(pNumKeys.size()) ||
+			    mBone->key < 0 || mBone->key >= static_cast<int>(pNumKeys [mBone->timeline])) {
+				mSorted [i] = -2;
+				continue;
+			}
+
+			mSorted [i] = static_cast<int>(pOrder->size());
+			pOrder->push_back(static_cast<unsigned int>(i));
+			pParents->push_back(mParent >= 0 ? max(mSorted [mParent], -1) : -1);
+		}
+	}
+}
+
+//Reads the tree of the parser. The keys of the file are sorted by time, the references of the mainline
+//point to the sorted keys, and the bones of each mainline key are sorted so the parents come first.
+void SpriterClip::build(Animation *pAnimation, map <Fileref, IND_Surface *> *pSurfaces) {
+	_length = pAnimation->getLength();
+	_looping = pAnimation->isLooping();
+	_mainKeys.clear();
+	_bones.clear();
+	_refs.clear();
+	_objects.clear();
+	_keys.clear();
+	_timelineStart.clear();
+
+	// ----- Timelines -----
+
+	vector <Timeline *> *mTimelines = pAnimation->getTimeLines();
+	vector <vector <unsigned int> > mRemap(mTimelines->size());    // Index in _keys (from the first key of the timeline) of each key of the file
+	vector <unsigned int> mNumKeys(mTimelines->size());
+
+	for (unsigned int i = 0; i < mTimelines->size(); i++) {
+		_timelineStart.push_back(static_cast<unsigned int>(_keys.size()));
+
+		vector <TimelineKey *> *mFileKeys = (*mTimelines) [i]->getKeys();
+		vector <pair <int, unsigned int> > mOrder;
+		for (unsigned int j = 0; j < mFileKeys->size(); j++)
+			mOrder.push_back(make_pair((*mFileKeys) [j]->getTime(), j));
+		sort(mOrder.begin(), mOrder.end());
+
+		mRemap [i].resize(mFileKeys->size());
+		mNumKeys [i] = static_cast<unsigned int>(mFileKeys->size());
+		for (unsigned int j = 0; j < mOrder.size(); j++) {
+			TimelineKey *mFileKey = (*mFileKeys) [mOrder [j].second];
+			mRemap [i] [mOrder [j].second] = j;
+
+			SpriterKey mKey;
+			mKey._time = mFileKey->getTime();
+			mKey._spin = mFileKey->getSpin();
+			if (mFileKey->getObjects()->empty()) {
+				SpriterSpatial mIdentity = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+				mKey._surface = NULL;
+				mKey._pivotX = 0.0f;
+				mKey._pivotY = 1.0f;
+				mKey._spatial = mIdentity;
+			} else {
+				flattenObject(mFileKey->getObjects()->front(), pSurfaces, &mKey);
+			}
+			_keys.push_back(mKey);
+		}
+	}
+	_timelineStart.push_back(static_cast<unsigned int>(_keys.size()));
+
+	// ----- Mainline -----
+
+	vector <MainlineKey *> *mFileMainKeys = pAnimation->getMainline()->getKeys();
+	vector <pair <int, unsigned int> > mOrder;
+	for (unsigned int i = 0; i < mFileMainKeys->size(); i++)
+		mOrder.push_back(make_pair((*mFileMainKeys) [i]->getTime(), i));
+	sort(mOrder.begin(), mOrder.end());
+
+	for (unsigned int i = 0; i < mOrder.size(); i++) {
+		MainlineKey *mFileKey = (*mFileMainKeys) [mOrder [i].second];
+
+		SpriterMainKey mMainKey;
+		mMainKey._time = mFileKey->getTime();
+		mMainKey._firstBone = static_cast<unsigned int>(_bones.size());
+		mMainKey._firstRef = static_cast<unsigned int>(_refs.size());
+		mMainKey._firstObject = static_cast<unsigned int>(_objects.size());
+
+		// The parents of the file are bone ids, the ones of the clip are indices in the sorted bones
+		vector <MainlineBoneref *> *mFileBones = mFileKey->getBonerefs();
+		vector <unsigned int> mBoneOrder;
+		vector <int> mBoneParents;
+		sortBones(*mFileBones, mNumKeys, &mBoneOrder, &mBoneParents);
+
+		map <int, int> mBoneIndex;                      // Index in the sorted bones of each bone id
+		for (unsigned int j = 0; j < mBoneOrder.size(); j++) {
+			MainlineBoneref *mFileBone = (*mFileBones) [mBoneOrder [j]];
+			SpriterRef mRef;
+			remapRef(mRemap, mFileBone->timeline, mFileBone->key, &mRef);
+			mRef._parent = mBoneParents [j];
+			mBoneIndex [mFileBone->id] = static_cast<int>(j);
+			_bones.push_back(mRef);
+		}
+
+		vector <MainlineObjectref *> *mFileRefs = mFileKey->getObjectrefs();
+		for (unsigned int j = 0; j < mFileRefs->size(); j++) {
+			MainlineObjectref *mFileRef = (*mFileRefs) [j];
+			SpriterRef mRef;
+			if (!remapRef(mRemap, mFileRef->timeline, mFileRef->key, &mRef))
+				continue;
+
+			mRef._zIndex = mFileRef->z_index;
+			map <int, int>::iterator mParentIter = mBoneIndex.find(mFileRef->parent);
+			if (mParentIter != mBoneIndex.end())
+				mRef._parent = mParentIter->second;
+			_refs.push_back(mRef);
+		}
+		stable_sort(_refs.begin() + mMainKey._firstRef, _refs.end(), lessZIndex);
+
+		vector <MainlineObject *> *mFileObjects = mFileKey->getObjects();
+		for (unsigned int j = 0; j < mFileObjects->size(); j++) {
+			SpriterKey mObject;
+			mObject._time = mMainKey._time;
+			mObject._spin = 0;
+			flattenObject((*mFileObjects) [j], pSurfaces, &mObject);
+			_objects.push_back(mObject);
+		}
+
+		mMainKey._numBones = static_cast<unsigned int>(_bones.size()) - mMainKey._firstBone;
+		mMainKey._numRefs = static_cast<unsigned int>(_refs.size()) - mMainKey._firstRef;
+		mMainKey._numObjects = static_cast<unsigned int>(_objects.size()) - mMainKey._firstObject;
+		_mainKeys.push_back(mMainKey);
+	}
+}
+
+//Brings the time of the entity into the animation: looping animations start again, the others stay in the end
+double SpriterClip::wrapTime(double pTime) const {
+	if (_length <= 0 || pTime <= 0.0)
+		return 0.0;
+	if (pTime < _length)
+		return pTime;
+	if (!_looping)
+		return static_cast<double>(_length);
+
+	return fmod(pTime, static_cast<double>(_length));
+}
+
+//Returns the mainline key of the time. The search starts from the current key, and only starts again from
+//the first key when the time went back.
+int SpriterClip::advanceCursor(int pKey, double pTime) const {
+	int mNumKeys = static_cast<int>(_mainKeys.size());
+	if (!mNumKeys)
+		return -1;
+
+	if (pKey < 0 || pKey >= mNumKeys || _mainKeys [pKey]._time > pTime)
+		pKey = 0;
+	while (pKey + 1 < mNumKeys && _mainKeys [pKey + 1]._time <= pTime)
+		pKey++;
+
+	return pKey;
+}
+
+//Evaluates the bones of a mainline key in topological order, and then fills the objects in the order they
+//are drawn: the persistent objects, and then the timeline objects by z index. The world transform of a bone
+//is only computed again when its local transform or the world transform of its parent changed since the last
+//evaluation of the pose, and all the objects attached to the bone use it.
+void SpriterClip::evaluate(int pKey, double pTime, SpriterPose *pPose) const {
+	// The bones of another mainline key, or of another clip, are other bones
+	bool mNewKey = (pPose->_clip != this || pPose->_key != pKey);
+	pPose->_clip = this;
+	pPose->_key = pKey;
+	pPose->_time = pTime;
+	pPose->_sprites.clear();
+
+	if (pKey < 0 || pKey >= static_cast<int>(_mainKeys.size())) {
+		pPose->_bones.clear();
+		return;
+	}
+
+	const SpriterMainKey &mMainKey = _mainKeys [pKey];
+	if (mNewKey)
+		pPose->_bones.resize(mMainKey._numBones);
+
+	for (unsigned int i = 0; i < mMainKey._numBones; i++) {
+		const SpriterRef &mRef = _bones [mMainKey._firstBone + i];
+		SpriterBone &mBone = pPose->_bones [i];
+
+		SpriterSprite mSample;
+		sampleRef(mRef, pTime, &mSample);
+
+		bool mParentDirty = mRef._parent >= 0 && pPose->_bones [mRef._parent]._dirty;
+		mBone._dirty = mNewKey || mParentDirty || !sameSpatial(mBone._local, mSample._spatial);
+		if (!mBone._dirty)
+			continue;
+
+		mBone._parent = mRef._parent;
+		mBone._local = mSample._spatial;
+		if (mRef._parent >= 0)
+			composeSpatial(pPose->_bones [mRef._parent]._world, mBone._local, &mBone._world);
+		else
+			mBone._world = mBone._local;
+	}
+
+	for (unsigned int i = 0; i < mMainKey._numObjects; i++) {
+		const SpriterKey &mObject = _objects [mMainKey._firstObject + i];
+		SpriterSprite mSprite;
+		mSprite._surface = mObject._surface;
+		mSprite._pivotX = mObject._pivotX;
+		mSprite._pivotY = mObject._pivotY;
+		mSprite._spatial = mObject._spatial;
+		pPose->_sprites.push_back(mSprite);
+	}
+
+	for (unsigned int i = 0; i < mMainKey._numRefs; i++) {
+		const SpriterRef &mRef = _refs [mMainKey._firstRef + i];
+		SpriterSprite mSprite;
+		sampleRef(mRef, pTime, &mSprite);
+		if (mRef._parent >= 0) {
+			SpriterSpatial mLocal = mSprite._spatial;
+			composeSpatial(pPose->_bones [mRef._parent]._world, mLocal, &mSprite._spatial);
+		}
+		pPose->_sprites.push_back(mSprite);
+	}
+}
+
+//Returns the pose of the time. If another entity evaluated the same time in this frame its pose is returned,
+//else the pose of the entity is evaluated (only if it is of another time). The pose of the other entity is only
+//read: each entity keeps the world transforms of its own bones, whatever time the others play. The entity
+//calls forgetPose() before deleting its pose, so the clip never keeps a pose that doesn't exist.
+const SpriterPose &SpriterClip::getPose(int pKey, double pTime, unsigned int pFrame, SpriterPose *pPose) {
+	if (_sharedPose && _sharedFrame == pFrame && _sharedPose->_clip == this && _sharedPose->_key == pKey && _sharedPose->_time == pTime)
+		return *_sharedPose;
+
+	if (pPose->_clip != this || pPose->_key != pKey || pPose->_time != pTime)
+		evaluate(pKey, pTime, pPose);
+
+	_sharedPose = pPose;
+	_sharedFrame = pFrame;
+	return *pPose;
+}
+
+//Interpolates a timeline object between its key and the next key of the timeline. After the last key
+//of a looping animation, the next key is the first one, one length later.
+void SpriterClip::sampleRef(const SpriterRef &pRef, double pTime, SpriterSprite *pSprite) const {
+	unsigned int mFirst = _timelineStart [pRef._timeline];
+	unsigned int mEnd = _timelineStart [pRef._timeline + 1];
+	const SpriterKey &mKeyA = _keys [mFirst + pRef._key];
+
+	pSprite->_surface = mKeyA._surface;
+	pSprite->_pivotX = mKeyA._pivotX;
+	pSprite->_pivotY = mKeyA._pivotY;
+	pSprite->_spatial = mKeyA._spatial;
+
+	const SpriterKey *mKeyB;
+	double mTimeB;
+	if (mFirst + pRef._key + 1 < mEnd) {
+		mKeyB = &_keys [mFirst + pRef._key + 1];
+		mTimeB = mKeyB->_time;
+	} else if (_looping && mEnd - mFirst > 1) {
+		mKeyB = &_keys [mFirst];
+		mTimeB = mKeyB->_time + _length;
+	} else {
+		return;
+	}
+
+	double mSpan = mTimeB - mKeyA._time;
+	if (mSpan <= 0.0)
+		return;
+
+	float mT = static_cast<float>((pTime - mKeyA._time) / mSpan);
+	if (mT < 0.0f)
+		mT = 0.0f;
+	else if (mT > 1.0f)
+		mT = 1.0f;
+
+	lerpSpatial(mKeyA._spatial, mKeyB->_spatial, mKeyA._spin, mT, &pSprite->_spatial);
+}
+
+/** @endcond */
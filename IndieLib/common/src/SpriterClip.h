@@ -0,0 +1,200 @@
+/*****************************************************************************************
+ * File: SpriterClip.h
+ * Desc: Spriter animation flattened into time-sorted key arrays, for playback
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _SPRITERCLIP
+#define _SPRITERCLIP
+
+#include <map>
+#include <vector>
+#include <stddef.h>
+
+using namespace std;
+
+class Animation;
+class IND_Surface;
+struct Fileref;
+struct MainlineBoneref;
+class SpriterClip;
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// Position, angle (degrees, counter clockwise), scale and alpha (0..1) of an object, in Spriter space (y up)
+struct SpriterSpatial {
+	float _x;
+	float _y;
+	float _angle;
+	float _scaleX;
+	float _scaleY;
+	float _alpha;
+};
+
+// Key of a timeline, with the surface already resolved
+struct SpriterKey {
+	int _time;
+	int _spin;                  // Direction of the rotation to the next key: 1, -1, or 0 (no rotation)
+	IND_Surface *_surface;
+	float _pivotX;
+	float _pivotY;
+	SpriterSpatial _spatial;
+};
+
+// Object or bone of a timeline referenced by a mainline key
+struct SpriterRef {
+	unsigned int _timeline;
+	unsigned int _key;          // Index in the keys of the timeline (not the key id of the file)
+	int _zIndex;
+	int _parent;                // Index of the parent bone in the bones of the mainline key, or -1
+};
+
+// Mainline key. The bones, the references and the persistent objects are ranges of the arrays of the clip.
+struct SpriterMainKey {
+	int _time;
+	unsigned int _firstBone;
+	unsigned int _numBones;
+	unsigned int _firstRef;
+	unsigned int _numRefs;
+	unsigned int _firstObject;
+	unsigned int _numObjects;
+};
+
+// Object ready to be drawn
+struct SpriterSprite {
+	IND_Surface *_surface;
+	float _pivotX;
+	float _pivotY;
+	SpriterSpatial _spatial;    // In the space of the entity
+};
+
+// Bone of a pose
+struct SpriterBone {
+	int _parent;
+	bool _dirty;                // The world transform changed in the last evaluation
+	SpriterSpatial _local;      // In the space of the parent
+	SpriterSpatial _world;      // In the space of the entity
+};
+
+// Animation evaluated in a time. The bones are in topological order (the parents first). Each entity has its
+// own pose, so the bones keep the world transforms of the last time that entity evaluated.
+class SpriterPose {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	SpriterPose():
+		_clip(NULL),
+		_key(-1),
+		_time(-1.0) {
+	}
+
+	//----- PUBLIC VARIABLES ------
+
+	const SpriterClip *_clip;               // Clip that evaluated the pose
+	int _key;
+	double _time;
+	vector <SpriterBone> _bones;
+	vector <SpriterSprite> _sprites;        // In the order they are drawn
+};
+
+// The tree of the parser is only read once, when the clip is built. Playing uses a cursor (the index of the
+// current mainline key) that only moves forward until the time wraps, and interpolates each object between
+// its key and the next key of the same timeline.
+// The clip is shared by the entities created from the same one (see IND_SpriterManager::addSpriterInstance()).
+// It remembers the last pose evaluated in the frame, so the entities playing the animation in the same time
+// only evaluate it once.
+class SpriterClip {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	SpriterClip():
+		_users(0),
+		_length(0),
+		_looping(true),
+		_sharedPose(NULL),
+		_sharedFrame(0) {
+	}
+
+	//----- OTHER FUNCTIONS -----
+
+	void build(Animation *pAnimation, map <Fileref, IND_Surface *> *pSurfaces);
+
+	double wrapTime(double pTime) const;
+	int advanceCursor(int pKey, double pTime) const;
+	void evaluate(int pKey, double pTime, SpriterPose *pPose) const;
+	const SpriterPose &getPose(int pKey, double pTime, unsigned int pFrame, SpriterPose *pPose);
+
+	//Stops sharing the pose of an entity that is going to be deleted
+	void forgetPose(const SpriterPose *pPose) {
+		if (_sharedPose == pPose)
+			_sharedPose = NULL;
+	}
+
+	static void sortBones(const vector <MainlineBoneref *> &pBones, const vector <unsigned int> &pNumKeys, vector <unsigned int> *pOrder, vector <int> *pParents);
+	static void lerpSpatial(const SpriterSpatial &pA, const SpriterSpatial &pB, int pSpin, float pT, SpriterSpatial *pOut);
+	static void composeSpatial(const SpriterSpatial &pParent, const SpriterSpatial &pLocal, SpriterSpatial *pOut);
+
+	bool isEmpty() const {
+		return _mainKeys.empty();
+	}
+
+	void addUser() {
+		_users++;
+	}
+
+	//Returns true when the last entity stops using the clip
+	bool removeUser() {
+		return --_users == 0;
+	}
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	int _users;                                 // Entities that use the clip
+	int _length;                                // Length in milliseconds
+	bool _looping;
+	vector <SpriterMainKey> _mainKeys;          // Sorted by time
+	vector <SpriterRef> _bones;                 // Sorted in topological order inside the range of each mainline key
+	vector <SpriterRef> _refs;                  // Sorted by z index inside the range of each mainline key
+	vector <SpriterKey> _objects;               // Persistent objects of the mainline keys
+	vector <SpriterKey> _keys;                  // Keys of all the timelines, sorted by time inside each timeline
+	vector <unsigned int> _timelineStart;       // First key of each timeline in _keys, plus the end
+	const SpriterPose *_sharedPose;             // Last pose evaluated, shared by the entities in the same frame
+	unsigned int _sharedFrame;                  // Frame in which _sharedPose was evaluated
+
+	//----- INTERNAL FUNCTIONS -----
+
+	void sampleRef(const SpriterRef &pRef, double pTime, SpriterSprite *pSprite) const;
+};
+
+/** @endcond */
+
+#endif
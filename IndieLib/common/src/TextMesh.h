@@ -0,0 +1,116 @@
+/*****************************************************************************************
+ * File: TextMesh.h
+ * Desc: Quads of the characters of a text, kept between frames
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#ifndef _TEXTMESH
+#define _TEXTMESH
+
+//Library dependencies
+
+#include "Defines.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class IND_Font;
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// The quads are in the space of the text (the transform of the text moves them). The mesh is built again
+// only when the text or the attributes that place the characters change: a text that doesn't change is
+// drawn at once, without searching the letters or measuring the lines again.
+class TextMesh {
+public:
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+
+	TextMesh():
+		_font(NULL),
+		_align(IND_LEFT),
+		_offset(0),
+		_lineSpacing(0),
+		_scaleX(1.0f),
+		_scaleY(1.0f),
+		_valid(false) {
+	}
+
+	//----- OTHER FUNCTIONS -----
+
+	bool isValid(IND_Font *pFo, const char *pText, IND_Align pAlign, int pOffset, int pLineSpacing, float pScaleX, float pScaleY) {
+		return _valid &&
+		       _font == pFo &&
+		       _align == pAlign &&
+		       _offset == pOffset &&
+		       _lineSpacing == pLineSpacing &&
+		       _scaleX == pScaleX &&
+		       _scaleY == pScaleY &&
+		       _text == pText;
+	}
+
+	void setKey(IND_Font *pFo, const char *pText, IND_Align pAlign, int pOffset, int pLineSpacing, float pScaleX, float pScaleY) {
+		_font = pFo;
+		_text = pText;
+		_align = pAlign;
+		_offset = pOffset;
+		_lineSpacing = pLineSpacing;
+		_scaleX = pScaleX;
+		_scaleY = pScaleY;
+		_valid = true;
+	}
+
+	void invalidate() {
+		_valid = false;
+	}
+
+	//----- PUBLIC VARIABLES ------
+
+	vector <CUSTOMVERTEX2D> _vertices;      // 4 per character, in the order of a triangle strip
+	vector <unsigned int> _indices;         // 2 triangles per character
+	float _min [2];                         // Bounding rectangle of the quads (x, y)
+	float _max [2];
+
+private:
+
+	//----- INTERNAL VARIABLES -----
+
+	IND_Font *_font;
+	string _text;
+	IND_Align _align;
+	int _offset;
+	int _lineSpacing;
+	float _scaleX;
+	float _scaleY;
+	bool _valid;
+};
+
+/** @endcond */
+
+#endif
@@ -38,6 +38,7 @@
 
 class IND_Surface;
 class IND_Image;
+struct COMPRESSED_IMAGE;
 
 /** @cond DOCUMENT_PRIVATEAPI */
 
@@ -52,6 +53,12 @@ public:
 	                              IND_Image       *pImage,
 	                              int             pBlockSizeX,
 	                              int             pBlockSizeY) = 0;
+
+	// Creates the texture straight from block compressed data. Returns false when the
+	// renderer can't use the format, so the caller can decode the data instead.
+	virtual bool createNewCompressedTexture(IND_Surface      *pNewSurface,
+	                                        COMPRESSED_IMAGE *pImage,
+	                                        IND_Type         pType) = 0;
 };
 
 /** @endcond */
@@ -74,7 +74,14 @@ struct structAttributes {
 		_widthBlock(0),
 		_heightBlock(0),
 		_isHaveSurface(false),
-		_isHaveGrid(false){}
+		_isHaveGrid(false),
+		_textureMemory(0),
+		_notUsedProportion(0.0f),
+		_trimX(0),
+		_trimY(0),
+		_trimWidth(0),
+		_trimHeight(0),
+		_alphaClass(IND_ALPHA_CLASS_TRANSLUCENT){}
 
     IND_Type    _type;                      // Surface type
     IND_Quality _quality;                   // Color quality
@@ -90,13 +97,20 @@ struct structAttributes {
     int         _heightBlock;               // Block height
     bool        _isHaveSurface;             // Surface loaded or not
     bool        _isHaveGrid;
+    int         _textureMemory;             // Bytes allocated in textures (including spare areas)
+    float       _notUsedProportion;         // Percentage of the textures that are spare areas
+    int         _trimX;                     // Transparent border trimmed at the left and top of the image
+    int         _trimY;
+    int         _trimWidth;                 // Size of the part of the image kept in textures (0 if not trimmed)
+    int         _trimHeight;
+    IND_AlphaClass _alphaClass;             // Opaque, alpha tested or translucent (see IND_AlphaClass)
 };
 typedef struct structAttributes ATTRIBUTES;
 
 // TYPE
 struct SURFACE {
-    SURFACE() : _vertexArray(NULL), _texturesArray(NULL){}
-    SURFACE(int pNumBlocks, int numVertices) : _vertexArray(NULL), _texturesArray(NULL) {
+    SURFACE() : _vertexArray(NULL), _texturesArray(NULL), _framebuffer(0){}
+    SURFACE(int pNumBlocks, int numVertices) : _vertexArray(NULL), _texturesArray(NULL), _framebuffer(0) {
         // This buffer will be used for drawing the IND_Surface using DrawPrimitiveUp
         _vertexArray = new CUSTOMVERTEX2D[numVertices];
         // Each block, needs a texture. We use an array of textures in order to store them.
@@ -110,6 +124,7 @@ struct SURFACE {
     }
 	CUSTOMVERTEX2D *_vertexArray;       // Vertex array (store the blocks (quads) of the IND_Surface
 	TEXTURE *_texturesArray;            // Texture array (one texture per block)
+	unsigned int _framebuffer;          // Framebuffer of the render targets (0 for the rest of surfaces)
 	ATTRIBUTES _attributes;             // Attributes
 };
 
@@ -290,6 +290,7 @@ public:
 
 	int blitAnimation(IND_Animation *pAn,
 	                  unsigned int pSequence,
+	                  unsigned int pFrame,
 	                  int pX, int pY,
 	                  int pWidth, int pHeight,
 	                  bool pToggleWrap,
@@ -327,6 +328,59 @@ public:
 	// ----- Rendering steps -----
 	void reCalculateFrustrumPlanes();
 
+	// Opaque and translucent passes are not supported (the layers are drawn back to front)
+	bool beginOpaquePass()      {
+		return false;
+	}
+	void endOpaquePass()      { }
+	void setDepth(float pDepth)      { }
+	void endDepthPasses()      { }
+
+	// Text meshes are not supported, the text is placed again in each blit
+	void setTextMesh(TextMesh *pMesh)      { }
+
+	// Fill rate statistics are not supported
+	bool setFillStats(bool pFillStats, bool pHeatmap)      {
+		return false;
+	}
+	int getFillPixels(IND_FillBlend pBlend)      {
+		return 0;
+	}
+	void resetFillStats()      { }
+	bool blitOverdrawHeatmap()      {
+		return false;
+	}
+
+	// The programmable 2d renderer is not supported
+	bool setProgrammable2d(bool pProgrammable)      {
+		return false;
+	}
+	bool isProgrammable2d()      {
+		return false;
+	}
+	void setProgramBinaryCache(const char *pDirectory)      { }
+
+	// Distance fields are not supported
+	bool setDistanceField2d(bool pDistanceField)      {
+		return false;
+	}
+	void setDistanceFieldOutline2d(float pWidth, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA)      { }
+	void setDistanceFieldShadow2d(float pOffsetX, float pOffsetY, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA)      { }
+
+	// Render targets are not supported
+	bool beginRenderTarget(IND_Surface *pSu, int pMargin, IND_Matrix *pCamera)      {
+		return false;
+	}
+	void endRenderTarget()      { }
+	bool blitRenderTarget(IND_Surface *pSu, const IND_Matrix &pCamera, int pMargin)      {
+		return false;
+	}
+
+	// The visible area is not calculated, the entities are only discarded by the frustum culling
+	bool getVisibleArea(IND_Vector3 *pMin, IND_Vector3 *pMax)      {
+		return false;
+	}
+
 	// ----- Atributtes -----
 
 	//This function returns the x position of the actual viewport
@@ -95,6 +95,8 @@ bool DirectXTextureBuilder::createNewTexture(IND_Surface *pNewSurface,
 	pNewSurface->_surface->_attributes._width            = mI._widthImage;
 	pNewSurface->_surface->_attributes._height           = mI._heightImage;
 	pNewSurface->_surface->_attributes._isHaveSurface    = 1;
+	pNewSurface->_surface->_attributes._textureMemory    = mI._blocksX * mI._blocksY * mI._widthBlock * mI._heightBlock * pImage->getBytespp();
+	pNewSurface->_surface->_attributes._notUsedProportion = mI._notUsedProportion;
 
 	// Current position of the vertex
 	int mPosX = 0;
@@ -244,6 +246,18 @@ bool DirectXTextureBuilder::createNewTexture(IND_Surface *pNewSurface,
 	return success;
 }
 
+/*
+==================
+Texture (IND_Surface) creation from block compressed data. Not supported by this renderer yet:
+the surface manager decodes the data and uses createNewTexture() instead.
+==================
+*/
+bool DirectXTextureBuilder::createNewCompressedTexture(IND_Surface      *pNewSurface,
+        COMPRESSED_IMAGE *pImage,
+        IND_Type         pType) {
+	return false;
+}
+
 /*
 ==================
 Creates a texture
@@ -50,6 +50,10 @@ public:
 	                              int             pBlockSizeX,
 	                              int             pBlockSizeY) ;
 
+	virtual bool createNewCompressedTexture(IND_Surface      *pNewSurface,
+	                                        COMPRESSED_IMAGE *pImage,
+	                                        IND_Type         pType);
+
 private:
 	// ----- Private Objects ------
 	ImageCutter *_cutter;
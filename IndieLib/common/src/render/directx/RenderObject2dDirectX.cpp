@@ -147,15 +147,26 @@ void DirectXRender::blitRegionSurface(IND_Surface *pSu,
 			pY < 0 || pY + pHeight > pSu->getHeight()) {
 			correctParams = false;
 		}
+
+		// Trimmed surface, only the part of the region kept in the texture is drawn
+		int mDrawX = 0;
+		int mDrawY = 0;
+		if (correctParams && pSu->isTrimmed()) {
+			correctParams = pSu->clipRegion(&pX, &pY, &pWidth, &pHeight, &mDrawX, &mDrawY);
+		}
+		float mX0 (static_cast<float>(mDrawX));
+		float mY0 (static_cast<float>(mDrawY));
+		float mX1 (static_cast<float>(mDrawX + pWidth));
+		float mY1 (static_cast<float>(mDrawY + pHeight));
 		
 		if (correctParams) {
 			// ----- Transform 4 vertices of the quad into world space coordinates -----
 
 			D3DXVECTOR4 mP1, mP2, mP3, mP4;
-			Transform4Vertices(static_cast<float>(pWidth), 0.0f,
-							   static_cast<float>(pWidth), static_cast<float>(pHeight),
-							   0.0f, 0.0f,
-							   0.0f, static_cast<float>(pHeight),
+			Transform4Vertices(mX1, mY0,
+							   mX1, mY1,
+							   mX0, mY0,
+							   mX0, mY1,
 							   &mP1, &mP2, &mP3, &mP4);
 
 			IND_Vector3 mP1_f3(mP1.x,mP1.y,mP1.z);
@@ -177,10 +188,10 @@ void DirectXRender::blitRegionSurface(IND_Surface *pSu,
 
 			// Prepare the quad that is going to be blitted
 			// Calculates the position and mapping coords for that block
-			fillVertex2d(&_vertices2d [0], static_cast<float>(pWidth), 0, (static_cast<float>(pX + pWidth) / pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pSu->getSpareY()) / pSu->getHeightBlock())));
-			fillVertex2d(&_vertices2d [1], static_cast<float>(pWidth), static_cast<float>(pHeight), (static_cast<float>(pX + pWidth) / pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pHeight + pSu->getSpareY()) / pSu->getHeightBlock())));
-			fillVertex2d(&_vertices2d [2], 0.0f, 0.0f, static_cast<float>(pX) / static_cast<float>(pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pSu->getSpareY())  / pSu->getHeightBlock())));
-			fillVertex2d(&_vertices2d [3], 0.0f, static_cast<float>(pHeight), (static_cast<float>(pX)/ pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pHeight + pSu->getSpareY()) / pSu->getHeightBlock())));
+			fillVertex2d(&_vertices2d [0], mX1, mY0, (static_cast<float>(pX + pWidth) / pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pSu->getSpareY()) / pSu->getHeightBlock())));
+			fillVertex2d(&_vertices2d [1], mX1, mY1, (static_cast<float>(pX + pWidth) / pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pHeight + pSu->getSpareY()) / pSu->getHeightBlock())));
+			fillVertex2d(&_vertices2d [2], mX0, mY0, static_cast<float>(pX) / static_cast<float>(pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pSu->getSpareY())  / pSu->getHeightBlock())));
+			fillVertex2d(&_vertices2d [3], mX0, mY1, (static_cast<float>(pX)/ pSu->getWidthBlock()), (1.0f - (static_cast<float>(pY + pHeight + pSu->getSpareY()) / pSu->getHeightBlock())));
 
 			// Quad blitting
 			_info._device->SetFVF(D3DFVF_CUSTOMVERTEX2D);
@@ -196,7 +207,8 @@ bool DirectXRender::blitWrapSurface(IND_Surface *pSu,
                                     float pUDisplace,
                                     float pVDisplace) {
 	bool correctParams = true;
-	if (pSu->getNumTextures() != 1) {
+	// The texture of a trimmed surface doesn't cover the whole surface, so it can't be wrapped
+	if (pSu->getNumTextures() != 1 || pSu->isTrimmed()) {
 		correctParams = false; 
 	}
 
@@ -258,6 +270,7 @@ bool DirectXRender::blitWrapSurface(IND_Surface *pSu,
 }
 
 int DirectXRender::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
+                                 unsigned int pFrame,
                                  int pX, int pY,
                                  int pWidth, int pHeight,
                                  bool pToggleWrap,
@@ -270,55 +283,48 @@ int DirectXRender::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
 	}
 
 	if (correctParams) {
-		if (!pAn->getIsActive(pSequence)) {
-			pAn->getSequenceTimer(pSequence)->start();
-			pAn->setIsActive(pSequence, 1);
-		}
-
 		// Current world matrix
 		D3DXMATRIX mMatWorld, mTrans;
 		_info._device->GetTransform(D3DTS_WORLD, &mMatWorld);
 
-		// If the time of a frame have passed, go to the next frame
-		if (pAn->getSequenceTimer(pSequence)->getTicks() > (unsigned long) pAn->getActualFrameTime(pSequence)) {
-			// Put timer to zero
-			pAn->getSequenceTimer(pSequence)->start();
-
-			// Point to the next frame increasing the counter
-			int i = pAn->getActualFramePos(pSequence);
-			pAn->setActualFramePos(pSequence, i + 1);
-
-			// If the counter is higher than the number of frames of the sequence, we put it to zero
-			if (pAn->getActualFramePos(pSequence) > pAn->getNumFrames(pSequence) - 1) {
-				pAn->setActualFramePos(pSequence, pAn->getNumFrames(pSequence) - 1);
-				pAn->setIsActive(pSequence, 0);
-				mFinish = -1;
-			}
-		}
-
 		// ----- OffsetX y OffsetY -----
 
 		D3DXMatrixTranslation(&mTrans,
-							  static_cast<float>(pAn->getActualOffsetX(pSequence)),
-							  static_cast<float>(pAn->getActualOffsetY(pSequence)),
+							  static_cast<float>(pAn->getFrameOffsetX(pSequence, pFrame)),
+							  static_cast<float>(pAn->getFrameOffsetY(pSequence, pFrame)),
 							  0);
 		D3DXMatrixMultiply(&mMatWorld, &mMatWorld, &mTrans);
 		_info._device->SetTransform(D3DTS_WORLD, &mMatWorld);
 
 		// ----- Blitting -----
 
+		// Frame packed into an atlas page, blits its rectangle of the page
+		int mX = pX, mY = pY, mWidth = pWidth, mHeight = pHeight, mDrawX, mDrawY;
+		IND_Surface *mAtlas = pAn->getFrameAtlas(pSequence, pFrame, &mX, &mY, &mWidth, &mHeight, &mDrawX, &mDrawY);
+		if (mAtlas) {
+			// The page can't be wrapped
+			if (pToggleWrap && (pWidth || pHeight))
+				return 0;
+			D3DXMatrixTranslation(&mTrans, static_cast<float>(mDrawX), static_cast<float>(mDrawY), 0);
+			D3DXMatrixMultiply(&mMatWorld, &mMatWorld, &mTrans);
+			_info._device->SetTransform(D3DTS_WORLD, &mMatWorld);
+			if (mWidth && mHeight)
+				blitRegionSurface(mAtlas, mX, mY, mWidth, mHeight);
+			return mFinish;
+		}
+
 		// Blits all the IND_Surface (all the blocks)
 		if (!pX && !pY && !pWidth && !pHeight) {
-			blitSurface(pAn->getActualSurface(pSequence));
+			blitSurface(pAn->getFrameSurface(pSequence, pFrame));
 		} else {
 			if (!pToggleWrap) { // Blits a region of the IND_Surface
-				if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+				if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 					return 0;
-				blitRegionSurface(pAn->getActualSurface(pSequence), pX, pY, pWidth, pHeight);
+				blitRegionSurface(pAn->getFrameSurface(pSequence, pFrame), pX, pY, pWidth, pHeight);
 			} else {// Blits a wrapping IND_Surface
-				if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+				if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 					return 0;
-				blitWrapSurface(pAn->getActualSurface(pSequence), pWidth, pHeight, pUDisplace, pVDisplace);
+				blitWrapSurface(pAn->getFrameSurface(pSequence, pFrame), pWidth, pHeight, pUDisplace, pVDisplace);
 			}
 		}
 	}
@@ -1,6 +1,6 @@
 /*****************************************************************************************
  * File: IND_GLShaderUniform.cpp
- * Desc: TODO
+ * Desc: Uniform of a GLSL program, with typed setters that skip redundant uploads
  ****************************************************************************************/
 
 /*********************************** The zlib License ************************************
@@ -31,9 +31,10 @@
 
 #include "Defines.h"
 
-#ifdef INDIERENDER_GLES_IOS
+#if defined (INDIERENDER_GLES_IOS) || defined (INDIERENDER_OPENGL)
 
 #include "IND_GLShaderUniform.h"
+#include <string.h>
 
 IND_GLSLShaderUniform::UniformType IND_GLSLShaderUniform::getType() {
     
@@ -116,4 +117,104 @@ int IND_GLSLShaderUniform::matrixSize() {
     return length;
 }
 
-#endif //INDIERENDER_GLES_IOS
+bool IND_GLSLShaderUniform::changed(const void* value, int bytes) {
+    if (bytes <= 0 || bytes > static_cast<int>(sizeof(_cachedValue))) return true;
+    
+    if (_cachedBytes == bytes && !memcmp(_cachedValue, value, bytes)) return false;
+    
+    memcpy(_cachedValue, value, bytes);
+    _cachedBytes = bytes;
+    return true;
+}
+
+void IND_GLSLShaderUniform::setInt(GLint value) {
+    if (!changed(&value, sizeof(GLint))) return;
+    glUniform1i(_glLocation, value);
+}
+
+void IND_GLSLShaderUniform::setFloat(GLfloat value) {
+    if (!changed(&value, sizeof(GLfloat))) return;
+    glUniform1f(_glLocation, value);
+}
+
+void IND_GLSLShaderUniform::setIntVector(const GLint* values) {
+    int length = arrayLength();
+    if (!changed(values, length * sizeof(GLint))) return;
+    
+    switch (length) {
+        case 2:
+            glUniform2iv(_glLocation, 1, values);
+            break;
+        case 3:
+            glUniform3iv(_glLocation, 1, values);
+            break;
+        case 4:
+            glUniform4iv(_glLocation, 1, values);
+            break;
+        default:
+            break;
+    }
+}
+
+void IND_GLSLShaderUniform::setFloatVector(const GLfloat* values) {
+    int length = arrayLength();
+    if (!changed(values, length * sizeof(GLfloat))) return;
+    
+    switch (length) {
+        case 2:
+            glUniform2fv(_glLocation, 1, values);
+            break;
+        case 3:
+            glUniform3fv(_glLocation, 1, values);
+            break;
+        case 4:
+            glUniform4fv(_glLocation, 1, values);
+            break;
+        default:
+            break;
+    }
+}
+
+void IND_GLSLShaderUniform::setMatrix(const GLfloat* values) {
+    int size = matrixSize();
+    if (!changed(values, size * size * sizeof(GLfloat))) return;
+    
+    switch (size) {
+        case 2:
+            glUniformMatrix2fv(_glLocation, 1, false, values);
+            break;
+        case 3:
+            glUniformMatrix3fv(_glLocation, 1, false, values);
+            break;
+        case 4:
+            glUniformMatrix4fv(_glLocation, 1, false, values);
+            break;
+        default:
+            break;
+    }
+}
+
+void IND_GLSLShaderUniform::setValue(const void* value) {
+    switch (getType()) {
+        case UniformTypeFloat:
+            setFloat(*static_cast<const GLfloat*>(value));
+            break;
+        case UniformTypeFloatMatrix:
+            setMatrix(static_cast<const GLfloat*>(value));
+            break;
+        case UniformTypeFloatVector:
+            setFloatVector(static_cast<const GLfloat*>(value));
+            break;
+        case UniformTypeInteger:
+        case UniformTypeSampler2D:
+            setInt(*static_cast<const GLint*>(value));
+            break;
+        case UniformTypeIntVector:
+            setIntVector(static_cast<const GLint*>(value));
+            break;
+        default:
+            break;
+    }
+}
+
+#endif //INDIERENDER_GLES_IOS || INDIERENDER_OPENGL
@@ -350,7 +350,7 @@ void OpenGLES2Render::getInfo() {
     const GLubyte* vendor = glGetString(GL_VENDOR);
     strcpy(_info._vendor,(char*)vendor);
     const GLubyte* renderer = glGetString(GL_RENDERER);
-    strcpy(_info._vendor,(char*)renderer);
+    strcpy(_info._renderer,(char*)renderer);
     const GLubyte* version = glGetString(GL_VERSION);
     strcpy (_info._version,(char*)version);
   
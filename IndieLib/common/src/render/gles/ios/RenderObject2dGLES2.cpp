@@ -99,7 +99,8 @@ bool OpenGLES2Render::blitWrapSurface(IND_Surface *pSu,
                                       int pBlitHeight,
                                       float pUOffset,
                                       float pVOffset) {
-    if (pSu->getNumTextures() != 1) {
+    // The texture of a trimmed surface doesn't cover the whole surface, so it can't be wrapped
+    if (pSu->getNumTextures() != 1 || pSu->isTrimmed()) {
         return false;
     }
     
@@ -171,6 +172,17 @@ void OpenGLES2Render::blitRegionSurface(IND_Surface *pSu,
             pY < 0 || pY + pHeight > pSu->getHeight()) {
             return;
 		}
+
+        // Trimmed surface, only the part of the region kept in the texture is drawn
+        float drawX (0.0f);
+        float drawY (0.0f);
+        if (pSu->isTrimmed()) {
+            int mDrawX, mDrawY;
+            if (!pSu->clipRegion(&pX, &pY, &pWidth, &pHeight, &mDrawX, &mDrawY))
+                return;
+            drawX = static_cast<float>(mDrawX);
+            drawY = static_cast<float>(mDrawY);
+        }
         
         
         _tex2dState._wrapT = GL_CLAMP_TO_EDGE;
@@ -190,10 +202,10 @@ void OpenGLES2Render::blitRegionSurface(IND_Surface *pSu,
             float bWidth (static_cast<float>(pSu->getWidthBlock()));
             float bHeight (static_cast<float>(pSu->getHeightBlock()));
             float spareY (static_cast<float>(pSu->getSpareY()));
-            fillVertex2d(&_vertices2d [0], width, 0.0f, ((x + width) / bWidth), (1.0f - ((y + spareY) / bHeight)));
-            fillVertex2d(&_vertices2d [1], width, height, (x + width) / bWidth, (1.0f - ((y + height + spareY) / bHeight)));
-            fillVertex2d(&_vertices2d [2], 0.0f, 0.0f , (x/bWidth), (1.0f - ((y+ spareY) / bHeight)));
-            fillVertex2d(&_vertices2d [3], 0.0f, height, (x/bWidth), (1.0f - (y + height + spareY) / bHeight));
+            fillVertex2d(&_vertices2d [0], drawX + width, drawY, ((x + width) / bWidth), (1.0f - ((y + spareY) / bHeight)));
+            fillVertex2d(&_vertices2d [1], drawX + width, drawY + height, (x + width) / bWidth, (1.0f - ((y + height + spareY) / bHeight)));
+            fillVertex2d(&_vertices2d [2], drawX, drawY, (x/bWidth), (1.0f - ((y+ spareY) / bHeight)));
+            fillVertex2d(&_vertices2d [3], drawX, drawY + height, (x/bWidth), (1.0f - (y + height + spareY) / bHeight));
             
             glActiveTexture(GL_TEXTURE0);
             
@@ -230,6 +242,7 @@ void OpenGLES2Render::blitTexturedQuad(CUSTOMVERTEX2D* pVertexes) {
 }
 
 int OpenGLES2Render::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
+                                   unsigned int pFrame,
                                 int pX, int pY,
                                 int pWidth, int pHeight,
                                 bool pToggleWrap,
@@ -239,49 +252,41 @@ int OpenGLES2Render::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
 	int mFinish = 1;
 
 	if (pSequence < pAn->getNumSequences()) {
-		if (!pAn->getIsActive(pSequence)) {
-			pAn->getSequenceTimer(pSequence)->start();
-			pAn->setIsActive(pSequence, 1);
-		}
-
-		// If the time of a frame have passed, go to the next frame
-		if (pAn->getSequenceTimer(pSequence)->getTicks() > (unsigned long) pAn->getActualFrameTime(pSequence)) {
-			// Put timer to zero
-			pAn->getSequenceTimer(pSequence)->start();
-
-			// Point to the next frame increasing the counter
-			int i = pAn->getActualFramePos(pSequence);
-			pAn->setActualFramePos(pSequence, i + 1);
-
-			// If the counter is higher than the number of frames of the sequence, we put it to zero
-			if (pAn->getActualFramePos(pSequence) > pAn->getNumFrames(pSequence) - 1) {
-				pAn->setActualFramePos(pSequence, pAn->getNumFrames(pSequence) - 1);
-				pAn->setIsActive(pSequence, 0);
-				mFinish = -1;
-			}
-		}
-		
         IND_Matrix translation;
-        _math.matrix4DSetTranslation(translation,static_cast<float>(pAn->getActualOffsetX(pSequence)),
-                                      static_cast<float>(pAn->getActualOffsetY(pSequence)),
+        _math.matrix4DSetTranslation(translation,static_cast<float>(pAn->getFrameOffsetX(pSequence, pFrame)),
+                                      static_cast<float>(pAn->getFrameOffsetY(pSequence, pFrame)),
                                       0.0f);
         _math.matrix4DMultiplyInPlace(_modelToWorld, translation);
+
+		// Frame packed into an atlas page, blits its rectangle of the page
+		int mX = pX, mY = pY, mWidth = pWidth, mHeight = pHeight, mDrawX, mDrawY;
+		IND_Surface *mAtlas = pAn->getFrameAtlas(pSequence, pFrame, &mX, &mY, &mWidth, &mHeight, &mDrawX, &mDrawY);
+		if (mAtlas) {
+			// The page can't be wrapped
+			if (pToggleWrap && (pWidth || pHeight))
+				return 0;
+			_math.matrix4DSetTranslation(translation, static_cast<float>(mDrawX), static_cast<float>(mDrawY), 0.0f);
+			_math.matrix4DMultiplyInPlace(_modelToWorld, translation);
+			if (mWidth && mHeight)
+				blitRegionSurface(mAtlas, mX, mY, mWidth, mHeight);
+			return mFinish;
+		}
         
 		// Blits all the IND_Surface (all the blocks)
 		if (!pX && !pY && !pWidth && !pHeight) {
-			blitSurface(pAn->getActualSurface(pSequence));
+			blitSurface(pAn->getFrameSurface(pSequence, pFrame));
 		} else
 			// Blits a region of the IND_Surface
 			if (!pToggleWrap) {
-				if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+				if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 					return 0;
-				blitRegionSurface(pAn->getActualSurface(pSequence), pX, pY, pWidth, pHeight);
+				blitRegionSurface(pAn->getFrameSurface(pSequence, pFrame), pX, pY, pWidth, pHeight);
 		}
 		// Blits a wrapping IND_Surface
 		else {
-			if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+			if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 				return 0;
-			blitWrapSurface(pAn->getActualSurface(pSequence), pWidth, pHeight, pUOffset, pVOffset);
+			blitWrapSurface(pAn->getFrameSurface(pSequence, pFrame), pWidth, pHeight, pUOffset, pVOffset);
 		}
 	}
 
@@ -47,6 +47,8 @@
 #include "IND_Font.h"
 #include "IND_Animation.h"
 #include "IND_Camera2d.h"
+#include "IND_Surface.h"
+#include "TextureDefinitions.h"
 #include "platform/OSOpenGLManager.h"
 
 //Constants
@@ -171,6 +173,8 @@ void OpenGLRender::endScene() {
 	if (!_ok)
 		return;
 
+	flushBatch2d();
+
 	//Swap memory buffers (OS-dependant)
 	_osOpenGLMgr->presentBuffer();
 
@@ -201,9 +205,87 @@ void OpenGLRender::getNumDiscardedObjectsString(char *pBuffer)      {
 	IND_Math::itoa(_numDiscardedObjects, pBuffer);
 }
 
+bool OpenGLRender::setFillStats(bool pFillStats, bool pHeatmap) {
+	_fillStats = pFillStats;
+	for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+		_fillPixels [i] = 0;
+
+	if (pFillStats && pHeatmap) {
+		if (!createHeatmap()) {
+			g_debug->header("Overdraw heatmap not supported", DebugApi::LogHeaderWarning);
+		}
+	} else {
+		freeHeatmap();
+	}
+
+	return _fillStats;
+}
+
+void OpenGLRender::resetFillStats() {
+	for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+		_fillPixels [i] = 0;
+
+	if (!_heatmapFramebuffer)
+		return;
+
+	//The heatmap follows the size of the viewport
+	if (_heatmapWidth != _info._viewPortWidth || _heatmapHeight != _info._viewPortHeight) {
+		freeHeatmap();
+		if (!createHeatmap())
+			return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _heatmapFramebuffer);
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool OpenGLRender::blitOverdrawHeatmap() {
+	if (!_heatmapFramebuffer)
+		return false;
+
+	flushBatch2d();
+
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glDisable(GL_BLEND);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	setGLClientStateToTexturing();
+	glBindTexture(GL_TEXTURE_2D, _heatmapTexture);
+
+	//Whole viewport, in clip coordinates
+	CUSTOMVERTEX2D mQuad [4];
+	fillVertex2d(&mQuad [0], 1.0f, 1.0f, 1.0f, 1.0f);
+	fillVertex2d(&mQuad [1], 1.0f, -1.0f, 1.0f, 0.0f);
+	fillVertex2d(&mQuad [2], -1.0f, 1.0f, 0.0f, 1.0f);
+	fillVertex2d(&mQuad [3], -1.0f, -1.0f, 0.0f, 0.0f);
+	glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &mQuad[0]._pos._x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &mQuad[0]._texCoord._u);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+	return true;
+}
+
 void OpenGLRender::end() {
 	if (_ok) {
 		g_debug->header("Finalizing OpenGL", DebugApi::LogHeaderBegin);
+		freeHeatmap();
+		freeProgrammable2d();
 		_osOpenGLMgr->endOpenGLContext();
 		freeVars();
 		g_debug->header("OpenGL finalized ", DebugApi::LogHeaderEnd);
@@ -285,11 +367,302 @@ bool OpenGLRender::checkGLExtensions() {
 
 	strcpy(_info._version, MINIMUM_OPENGL_VERSION_STRING);
 
+	//Optional extensions used for texture uploads
+	_info._pixelBufferObjects = (GLEW_ARB_pixel_buffer_object && GLEW_ARB_sync);
+	_info._textureStorage = (GLEW_ARB_texture_storage == GL_TRUE);
+	_info._rgb565Textures = (GLEW_VERSION_4_1 || GLEW_ARB_ES2_compatibility);
+
+	//Non power of two textures (core since 2.0)
+	_info._npotTextures = (GLEW_VERSION_2_0 || GLEW_ARB_texture_non_power_of_two);
+
+	//Compressed texture formats (pre-compressed .dds files)
+	_info._s3tcTextures = (GLEW_EXT_texture_compression_s3tc == GL_TRUE);
+	_info._bptcTextures = (GLEW_ARB_texture_compression_bptc == GL_TRUE);
+
+	//Offscreen render targets (core since 3.0)
+	_info._framebufferObjects = (GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object);
+
 	//TODO: Other extensions
 
 	return true;
 }
 
+/*
+==================
+Counts the pixels of a quad that has been drawn, from the bounding rectangle (in world coordinates)
+used for culling it. The rectangle is taken to the screen with the camera and clipped to the viewport.
+The quad is also added to the overdraw heatmap.
+==================
+*/
+void OpenGLRender::addFill(const IND_Vector3 &pMin, const IND_Vector3 &pMax, CUSTOMVERTEX2D *pQuad) {
+	// Blits of the opaque pass are drawn again later
+	if (_opaquePass)
+		return;
+
+	IND_Vector3 mCorners [4] = { IND_Vector3(pMin._x, pMin._y, 0.0f), IND_Vector3(pMax._x, pMin._y, 0.0f),
+	                             IND_Vector3(pMin._x, pMax._y, 0.0f), IND_Vector3(pMax._x, pMax._y, 0.0f) };
+
+	float mMinX = 0.0f, mMinY = 0.0f, mMaxX = 0.0f, mMaxY = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		_math.transformVector3DbyMatrix4D(mCorners [i], _cameraMatrix);
+		if (!i || mCorners [i]._x < mMinX) mMinX = mCorners [i]._x;
+		if (!i || mCorners [i]._x > mMaxX) mMaxX = mCorners [i]._x;
+		if (!i || mCorners [i]._y < mMinY) mMinY = mCorners [i]._y;
+		if (!i || mCorners [i]._y > mMaxY) mMaxY = mCorners [i]._y;
+	}
+
+	//The viewport is centered in the camera
+	float mHalfWidth = static_cast<float>(_info._viewPortWidth) / 2.0f;
+	float mHalfHeight = static_cast<float>(_info._viewPortHeight) / 2.0f;
+	if (mMinX < -mHalfWidth) mMinX = -mHalfWidth;
+	if (mMaxX > mHalfWidth) mMaxX = mHalfWidth;
+	if (mMinY < -mHalfHeight) mMinY = -mHalfHeight;
+	if (mMaxY > mHalfHeight) mMaxY = mHalfHeight;
+
+	if (mMaxX > mMinX && mMaxY > mMinY)
+		_fillPixels [_fillBlend] += static_cast<int>((mMaxX - mMinX) * (mMaxY - mMinY) + 0.5f);
+
+	if (!_heatmapFramebuffer)
+		return;
+
+	//Each quad adds the same amount to the heatmap: red saturates after 8 quads, green after 16 and blue after 32
+	GLint mFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mFramebuffer);
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_VIEWPORT_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, _heatmapFramebuffer);
+	glViewport(0, 0, _heatmapWidth, _heatmapHeight);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glColor4f(1.0f / 8.0f, 1.0f / 16.0f, 1.0f / 32.0f, 1.0f);
+	glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pQuad[0]._pos._x);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glPopAttrib();
+}
+
+/*
+==================
+Creates the offscreen target of the overdraw heatmap
+==================
+*/
+bool OpenGLRender::createHeatmap() {
+	if (_heatmapFramebuffer)
+		return true;
+	if (!_info._framebufferObjects || _info._viewPortWidth <= 0 || _info._viewPortHeight <= 0)
+		return false;
+
+	glGenTextures(1, &_heatmapTexture);
+	glBindTexture(GL_TEXTURE_2D, _heatmapTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _info._viewPortWidth, _info._viewPortHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glGenFramebuffers(1, &_heatmapFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _heatmapFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _heatmapTexture, 0);
+	bool mComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!mComplete) {
+		freeHeatmap();
+		return false;
+	}
+
+	_heatmapWidth = _info._viewPortWidth;
+	_heatmapHeight = _info._viewPortHeight;
+	return true;
+}
+
+/*
+==================
+Frees the offscreen target of the overdraw heatmap
+==================
+*/
+void OpenGLRender::freeHeatmap() {
+	if (_heatmapFramebuffer)
+		glDeleteFramebuffers(1, &_heatmapFramebuffer);
+	if (_heatmapTexture)
+		glDeleteTextures(1, &_heatmapTexture);
+
+	_heatmapFramebuffer = 0;
+	_heatmapTexture = 0;
+	_heatmapWidth = 0;
+	_heatmapHeight = 0;
+}
+
+/*
+==================
+Starts drawing into a render target that covers the viewport plus a margin in each side, seen by the
+actual camera (the camera is returned in pCamera). The target is created or resized if needed.
+Returns false if render targets are not supported.
+==================
+*/
+bool OpenGLRender::beginRenderTarget(IND_Surface *pSu, int pMargin, IND_Matrix *pCamera) {
+	if (!_info._framebufferObjects || _renderTarget)
+		return false;
+
+	int mWidth = _info._viewPortWidth + pMargin * 2;
+	int mHeight = _info._viewPortHeight + pMargin * 2;
+	if (!pSu->_surface || !pSu->_surface->_framebuffer || pSu->getWidth() != mWidth || pSu->getHeight() != mHeight) {
+		if (!createRenderTarget(pSu, mWidth, mHeight))
+			return false;
+	}
+
+	flushBatch2d();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, pSu->_surface->_framebuffer);
+	glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT);
+	glViewport(0, 0, mWidth, mHeight);
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	//Same camera, bigger projection
+	perspectiveOrtho(static_cast<float>(mWidth), static_cast<float>(mHeight), 2048.0f, -2048.0f);
+
+	_renderTarget = true;
+	*pCamera = _cameraMatrix;
+	return true;
+}
+
+/*
+==================
+Finishes drawing into a render target, and restores the viewport
+==================
+*/
+void OpenGLRender::endRenderTarget() {
+	if (!_renderTarget)
+		return;
+
+	flushBatch2d();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glPopAttrib();
+	perspectiveOrtho(static_cast<float>(_info._viewPortWidth), static_cast<float>(_info._viewPortHeight), 2048.0f, -2048.0f);
+	reCalculateFrustrumPlanes();
+
+	_renderTarget = false;
+}
+
+/*
+==================
+Blits a render target drawn with the camera pCamera. It can only be done if the actual camera has only
+been moved, less than the margin of the target. Returns false if the target has to be drawn again.
+==================
+*/
+bool OpenGLRender::blitRenderTarget(IND_Surface *pSu, const IND_Matrix &pCamera, int pMargin) {
+	if (!pSu->_surface || !pSu->_surface->_framebuffer)
+		return false;
+
+	//Movement of the camera, in pixels of the screen
+	IND_Vector3 mOrigin0(0.0f, 0.0f, 0.0f), mAxisX0(1.0f, 0.0f, 0.0f), mAxisY0(0.0f, 1.0f, 0.0f);
+	IND_Vector3 mOrigin1(0.0f, 0.0f, 0.0f), mAxisX1(1.0f, 0.0f, 0.0f), mAxisY1(0.0f, 1.0f, 0.0f);
+	IND_Matrix mCamera0 (pCamera);
+	_math.transformVector3DbyMatrix4D(mOrigin0, mCamera0);
+	_math.transformVector3DbyMatrix4D(mAxisX0, mCamera0);
+	_math.transformVector3DbyMatrix4D(mAxisY0, mCamera0);
+	_math.transformVector3DbyMatrix4D(mOrigin1, _cameraMatrix);
+	_math.transformVector3DbyMatrix4D(mAxisX1, _cameraMatrix);
+	_math.transformVector3DbyMatrix4D(mAxisY1, _cameraMatrix);
+
+	//Rotation or zoom of the camera changed
+	const float mEpsilon = 0.0001f;
+	if (fabs((mAxisX1._x - mOrigin1._x) - (mAxisX0._x - mOrigin0._x)) > mEpsilon ||
+	    fabs((mAxisX1._y - mOrigin1._y) - (mAxisX0._y - mOrigin0._y)) > mEpsilon ||
+	    fabs((mAxisY1._x - mOrigin1._x) - (mAxisY0._x - mOrigin0._x)) > mEpsilon ||
+	    fabs((mAxisY1._y - mOrigin1._y) - (mAxisY0._y - mOrigin0._y)) > mEpsilon)
+		return false;
+
+	float mMoveX = mOrigin1._x - mOrigin0._x;
+	float mMoveY = mOrigin1._y - mOrigin0._y;
+	if (fabs(mMoveX) > pMargin || fabs(mMoveY) > pMargin)
+		return false;
+
+	flushBatch2d();
+
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glTranslatef(mMoveX, mMoveY, 0.0f);
+
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	setGLClientStateToTexturing();
+
+	glBindTexture(GL_TEXTURE_2D, pSu->_surface->_texturesArray[0]);
+	glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pSu->_surface->_vertexArray[0]._pos._x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pSu->_surface->_vertexArray[0]._texCoord._u);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glPopMatrix();
+	glPopAttrib();
+
+	_numrenderedObjects++;
+	return true;
+}
+
+/*
+==================
+Creates the texture and the framebuffer of a render target. The quad of the surface is in the space
+of the camera (centered in the viewport), so it is drawn with the camera that rendered it.
+==================
+*/
+bool OpenGLRender::createRenderTarget(IND_Surface *pSu, int pWidth, int pHeight) {
+	pSu->freeTextureData();
+	pSu->_surface = new SURFACE(1, 4);
+
+	ATTRIBUTES &mAttributes = pSu->_surface->_attributes;
+	mAttributes._type = IND_ALPHA;
+	mAttributes._quality = IND_32;
+	mAttributes._numTextures = 1;
+	mAttributes._width = mAttributes._widthBlock = pWidth;
+	mAttributes._height = mAttributes._heightBlock = pHeight;
+	mAttributes._blocksX = mAttributes._blocksY = mAttributes._numBlocks = 1;
+	mAttributes._isHaveSurface = 1;
+	mAttributes._textureMemory = pWidth * pHeight * 4;
+
+	float mHalfWidth = static_cast<float>(pWidth) / 2.0f;
+	float mHalfHeight = static_cast<float>(pHeight) / 2.0f;
+	fillVertex2d(&pSu->_surface->_vertexArray [0], mHalfWidth, -mHalfHeight, 1.0f, 0.0f);
+	fillVertex2d(&pSu->_surface->_vertexArray [1], mHalfWidth, mHalfHeight, 1.0f, 1.0f);
+	fillVertex2d(&pSu->_surface->_vertexArray [2], -mHalfWidth, -mHalfHeight, 0.0f, 0.0f);
+	fillVertex2d(&pSu->_surface->_vertexArray [3], -mHalfWidth, mHalfHeight, 0.0f, 1.0f);
+
+	glGenTextures(1, &pSu->_surface->_texturesArray [0]);
+	glBindTexture(GL_TEXTURE_2D, pSu->_surface->_texturesArray [0]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pWidth, pHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glGenFramebuffers(1, &pSu->_surface->_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, pSu->_surface->_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pSu->_surface->_texturesArray [0], 0);
+	bool mComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!mComplete) {
+		g_debug->header("Render target not supported", DebugApi::LogHeaderWarning);
+		pSu->freeTextureData();
+		return false;
+	}
+
+	return true;
+}
+
 /*
 ==================
 Free memory
@@ -310,7 +683,7 @@ void OpenGLRender::getInfo() {
     const GLubyte* vendor = glGetString(GL_VENDOR);
     strcpy(_info._vendor,(char*)vendor);
     const GLubyte* renderer = glGetString(GL_RENDERER);
-    strcpy(_info._vendor,(char*)renderer);
+    strcpy(_info._renderer,(char*)renderer);
     const GLubyte* version = glGetString(GL_VERSION);
     strcpy (_info._version,(char*)version);
     
@@ -356,7 +729,31 @@ void OpenGLRender::writeInfo() {
 	g_debug->dataChar("x", 0);
 	g_debug->dataInt(_info._maxTextureSize, 1);
 	g_debug->header("Texture units:" , DebugApi::LogHeaderInfo);
-	g_debug->dataInt(_info._textureUnits, 0);
+	g_debug->dataInt(_info._textureUnits, 1);
+
+	// ----- Texture uploads -----
+
+	g_debug->header("Pixel buffer objects:", DebugApi::LogHeaderInfo);
+	if (_info._pixelBufferObjects)
+		g_debug->dataChar("Yes", 1);
+	else
+		g_debug->dataChar("No", 1);
+
+	g_debug->header("Immutable texture storage:", DebugApi::LogHeaderInfo);
+	if (_info._textureStorage)
+		g_debug->dataChar("Yes", 1);
+	else
+		g_debug->dataChar("No", 1);
+
+	g_debug->header("Non power of two textures:", DebugApi::LogHeaderInfo);
+	if (_info._npotTextures)
+		g_debug->dataChar("Yes", 1);
+	else
+		g_debug->dataChar("No", 1);
+
+	g_debug->header("Compressed textures (DXT1/DXT5, BC7):", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(_info._s3tcTextures ? "Yes," : "No,", 0);
+	g_debug->dataChar(_info._bptcTextures ? "Yes" : "No", 1);
 
 
 	// ----- Vertex Shader version  -----
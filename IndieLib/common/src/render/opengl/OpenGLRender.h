@@ -12,6 +12,7 @@
  * - RenderPrimitive2dOpenGL.cpp
  * - RenderText2dOpenGL.cpp
  * - RenderCollision2dOpenGL.cpp
+ * - RenderProgrammable2dOpenGL.cpp
  *****************************************************************************************/
 
 /*********************************** The zlib License ************************************
@@ -46,10 +47,14 @@
 // ----- Includes -----
 
 #include <string.h>
+#include <string>
+#include <map>
+#include <vector>
 #include "Defines.h"
 #include "IND_Math.h"
 #include "IND_Render.h"
 #include "IND_Vector2.h"
+#include "TextMesh.h"
 
 // ----- Forward Declarations -----
 
@@ -67,6 +72,10 @@ class IND_Animation;
 class IND_Camera2d;
 class IND_Camera3d;
 class OSOpenGLManager;
+class IND_ShaderManager;
+class IND_ShaderProgram;
+class IND_GLSLShaderUniform;
+class IND_UniformBuffer;
 
 // ----- Libs -----
 
@@ -75,6 +84,16 @@ class OSOpenGLManager;
 // ----- Defines ------
 
 #define MAX_PIXELS 2048
+#define MAX_BATCH_VERTICES 6144         // 1024 quads (2 triangles each)
+#define MAX_PRIMITIVE_VERTICES 6144     // Primitives are batched as points, lines or triangles
+#define MATRICES_2D_BINDING 0           // Binding point of the uniform block with the 2d camera and projection
+
+// Vertex of the programmable 2d renderer (position in world coordinates)
+struct BATCHVERTEX2D {
+	float _x, _y, _z;
+	float _u, _v;
+	unsigned char _color [4];
+};
 
 struct InfoStruct {
     InfoStruct():
@@ -88,7 +107,14 @@ struct InfoStruct {
     _antialiasing(0),
     _maxTextureSize(0),
     _textureUnits(0),
-    _pointPixelScale(1.0f){
+    _pointPixelScale(1.0f),
+    _pixelBufferObjects(false),
+    _textureStorage(false),
+    _rgb565Textures(false),
+    _npotTextures(false),
+    _s3tcTextures(false),
+    _bptcTextures(false),
+    _framebufferObjects(false){
         strcpy(_version, "NO DATA");
         strcpy(_vendor, "NO DATA");
         strcpy(_renderer, "NO DATA");
@@ -107,6 +133,13 @@ struct InfoStruct {
     int _maxTextureSize;
     int _textureUnits;
     float _pointPixelScale;
+    bool _pixelBufferObjects;   //Streaming uploads through GL_PIXEL_UNPACK_BUFFER (with sync objects)
+    bool _textureStorage;       //Immutable texture storage (glTexStorage2D)
+    bool _rgb565Textures;       //GL_RGB565 sized internal format (ES2 compatibility, core since 4.1)
+    bool _npotTextures;         //Non power of two textures
+    bool _s3tcTextures;         //DXT1 / DXT5 compressed textures
+    bool _bptcTextures;         //BC7 compressed textures
+    bool _framebufferObjects;   //Offscreen render targets (glGenFramebuffers)
 };
 
 struct TextureSamplerState {
@@ -140,8 +173,49 @@ public:
 		_ok(false),
     	_numrenderedObjects(0),
     	_numDiscardedObjects(0),
-		_doubleBuffer(false)
-	{ }
+		_doubleBuffer(false),
+		_opaquePass(false),
+		_fillStats(false),
+		_fillBlend(IND_FILL_BLEND),
+		_heatmapFramebuffer(0),
+		_heatmapTexture(0),
+		_heatmapWidth(0),
+		_heatmapHeight(0),
+		_renderTarget(false),
+		_programmable2d(false),
+		_shaderManager(NULL),
+		_batchProgram(NULL),
+		_batchVertexArray(0),
+		_batchVertexBuffer(0),
+		_alphaRefUniform(NULL),
+		_matricesBuffer(NULL),
+		_matricesDirty(true),
+		_batchNumVertices(0),
+		_batchTexture(0),
+		_batchState(-1),
+		_distanceField(false),
+		_batchDistanceField(false),
+		_distanceFieldProgram(NULL),
+		_dfAlphaRefUniform(NULL),
+		_dfOutlineWidthUniform(NULL),
+		_dfOutlineColorUniform(NULL),
+		_dfShadowOffsetUniform(NULL),
+		_dfShadowColorUniform(NULL),
+		_dfOutlineWidth(0.0f),
+		_primNumVertices(0),
+		_primMode(GL_POINTS),
+		_primAlpha(255),
+		_entityTextMesh(NULL)
+	{
+		for (int i = 0; i < 4; i++) {
+			_batchColor [i] = 255;
+			_dfOutlineColor [i] = 0.0f;
+			_dfShadowColor [i] = 0.0f;
+		}
+		_dfShadowOffset [0] = _dfShadowOffset [1] = 0.0f;
+		for (int i = 0; i < IND_FILL_BLEND_MODES; i++)
+			_fillPixels [i] = 0;
+	}
 	~OpenGLRender()              {
 		end();
 	}
@@ -344,6 +418,7 @@ public:
 
 	int blitAnimation(IND_Animation *pAn,
 	                  unsigned int pSequence,
+	                  unsigned int pFrame,
 	                  int pX, int pY,
 	                  int pWidth, int pHeight,
 	                  bool pToggleWrap,
@@ -372,8 +447,24 @@ public:
 	              IND_BlendingType pSo,
 	              IND_BlendingType pDs,
 	              IND_Align pAlign);
+	void setTextMesh(TextMesh *pMesh)      {
+		_entityTextMesh = pMesh;
+	}
 
 
+	// ----- Programmable 2d renderer -----
+
+	bool setProgrammable2d(bool pProgrammable);
+	bool isProgrammable2d()      {
+		return _programmable2d;
+	}
+	void setProgramBinaryCache(const char *pDirectory)      {
+		_programBinaryCache = pDirectory ? pDirectory : "";
+	}
+	bool setDistanceField2d(bool pDistanceField);
+	void setDistanceFieldOutline2d(float pWidth, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
+	void setDistanceFieldShadow2d(float pOffsetX, float pOffsetY, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA);
+
 	void blit3dMesh(IND_3dMesh *p3dMesh);
 	void set3dMeshSequence(IND_3dMesh *p3dMesh, unsigned int pIndex);	
 	
@@ -450,7 +541,14 @@ private:
 
 	//Blitting helpers
 	void fillPixel(PIXEL *pPixel, float pX, float pY,  float pR, float pG, float pB, float pA);
+	void fillPixel(PIXEL *pPixel, const IND_Matrix &pMatrix, float pX, float pY,  float pR, float pG, float pB, float pA);
+	PIXEL *addPrimitive2d(GLenum pMode, int pNumVertices, unsigned char pA);
+	void flushPrimitives2d();
+	const float *getCircleTable(int pSides);
 	void fillVertex2d(CUSTOMVERTEX2D *pVertex2d, float pX, float pY, float pU, float pV);
+	void drawQuad2d(GLuint pTexture, GLint pWrap, CUSTOMVERTEX2D *pQuad);
+	void translate2d(float pX, float pY);
+	void loadModelView2d();
 	void setForPrimitive(unsigned char pA, bool pResetTransform);
 
 	void blitGridQuad    (int pAx, int pAy,
@@ -464,9 +562,11 @@ private:
 	//Text rendering helpers
 	int getLongInPixels(IND_Font *pFo, char *pText, int pPos, int pOffset);
     
-    void blitCharsMudFont(IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing);
+    void buildTextMesh(TextMesh *pMesh, IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing);
+    
+    void addTextQuad(TextMesh *pMesh, IND_Surface *pSu, int pX, int pY, int pWidth, int pHeight, float pDrawX, float pDrawY);
     
-    void blitCharsAngelCodeFont(IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing);
+    void blitTextMesh(TextMesh *pMesh, IND_Surface *pSu);
 
 	//Setup helper
 	bool resetViewport(int pWitdh, int pHeight);
@@ -484,9 +584,43 @@ private:
 	void blitCollisionCircle(int pPosX, int pPosY, int pRadius, float pScale, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pWorldMatrix);
 	void blitCollisionLine(int pPosX1, int pPosY1, int pPosX2, int pPosY2,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pIndWorldMatrix);
 
+	// ---- Opaque and translucent passes ----
+
+	bool beginOpaquePass();
+	void endOpaquePass();
+	void setDepth(float pDepth);
+	void endDepthPasses();
+
+	// ---- Fill rate statistics ----
+
+	bool setFillStats(bool pFillStats, bool pHeatmap);
+	int getFillPixels(IND_FillBlend pBlend) {
+		return _fillPixels [pBlend];
+	}
+	void resetFillStats();
+	bool blitOverdrawHeatmap();
+	void addFill(const IND_Vector3 &pMin, const IND_Vector3 &pMax, CUSTOMVERTEX2D *pQuad);
+	bool createHeatmap();
+	void freeHeatmap();
+
+	// ---- Render targets ----
+
+	bool beginRenderTarget(IND_Surface *pSu, int pMargin, IND_Matrix *pCamera);
+	void endRenderTarget();
+	bool blitRenderTarget(IND_Surface *pSu, const IND_Matrix &pCamera, int pMargin);
+	bool createRenderTarget(IND_Surface *pSu, int pWidth, int pHeight);
+
+	// ---- Programmable 2d renderer ----
+
+	bool createProgrammable2d();
+	IND_ShaderProgram *createBatchProgram2d(const char *pFragmentShader, const char *pName);
+	void freeProgrammable2d();
+	void flushBatch2d();
+
 	// ---- Culling helpers ----
 
 	void reCalculateFrustrumPlanes();
+	bool getVisibleArea(IND_Vector3 *pMin, IND_Vector3 *pMax);
 	void transformVerticesToWorld(float pX1, float pY1,
 											float pX2, float pY2,
 											float pX3, float pY3,
@@ -511,6 +645,55 @@ private:
 
 	bool _doubleBuffer;
 
+	// Opaque pass
+	bool _opaquePass;
+
+	// Fill rate statistics (pixels of the current frame and blending set by setRainbow2d)
+	bool _fillStats;
+	int _fillPixels [IND_FILL_BLEND_MODES];
+	IND_FillBlend _fillBlend;
+
+	// Overdraw heatmap (offscreen target of the size of the viewport)
+	GLuint _heatmapFramebuffer;
+	GLuint _heatmapTexture;
+	int _heatmapWidth;
+	int _heatmapHeight;
+
+	// Drawing into a render target (the alpha is accumulated for blending the target later)
+	bool _renderTarget;
+
+	// Programmable 2d renderer. The quads are kept until the texture or the GL state changes, and
+	// drawn at once from a vertex buffer. The color of each vertex is the one set by setRainbow2d.
+	bool _programmable2d;
+	IND_ShaderManager *_shaderManager;
+	IND_ShaderProgram *_batchProgram;
+	GLuint _batchVertexArray;
+	GLuint _batchVertexBuffer;
+	IND_GLSLShaderUniform *_alphaRefUniform;
+	IND_UniformBuffer *_matricesBuffer;     // Uniform buffer with the camera and the projection
+	std::string _programBinaryCache;        // Directory of the linked programs (empty for no cache)
+	bool _matricesDirty;
+	BATCHVERTEX2D _batchVertices [MAX_BATCH_VERTICES];
+	int _batchNumVertices;
+	GLuint _batchTexture;
+	TextureSamplerState _batchSampler;
+	int _batchState;                        // GL state of the batch (blending, culling, passes)
+	unsigned char _batchColor [4];
+
+	// Distance fields (see setDistanceField2d). The programmable renderer draws their batches with
+	// another program, the fixed pipeline discards the pixels outside the edge with the alpha test.
+	bool _distanceField;
+	bool _batchDistanceField;
+	IND_ShaderProgram *_distanceFieldProgram;
+	IND_GLSLShaderUniform *_dfAlphaRefUniform;
+	IND_GLSLShaderUniform *_dfOutlineWidthUniform;
+	IND_GLSLShaderUniform *_dfOutlineColorUniform;
+	IND_GLSLShaderUniform *_dfShadowOffsetUniform;
+	IND_GLSLShaderUniform *_dfShadowColorUniform;
+	float _dfOutlineWidth;
+	float _dfOutlineColor [4];
+	float _dfShadowOffset [2];
+	float _dfShadowColor [4];
 	
 	struct InfoStruct _info;
     
@@ -521,11 +704,28 @@ private:
 
     //Current 'camera' matrix
     IND_Matrix _cameraMatrix;
+
+	//Current projection matrix
+	IND_Matrix _projectionMatrix;
     
 	// ----- Primitives vertices -----
 
-	// Temporal buffer of pixels for drawing primitives
-	PIXEL _pixels [MAX_PIXELS];
+	// Batch of primitives, in world coordinates. They are drawn at once when the mode (points, lines or
+	// triangles) or the blending changes, and before anything else is drawn.
+	PIXEL _primVertices [MAX_PRIMITIVE_VERTICES];
+	int _primNumVertices;
+	GLenum _primMode;
+	unsigned char _primAlpha;
+
+	// Cos and sin of the vertices of the regular polygons and circles, by number of sides
+	std::map<int, std::vector<float> > _circleTables;
+
+	// ----- Text meshes -----
+
+	// Mesh of the entity whose text is blitted (see IND_Entity2d::_textMesh), or NULL for the last
+	// text blitted directly
+	TextMesh *_entityTextMesh;
+	TextMesh _textMesh;
 
 	// ----- Vertex array -----
 
@@ -40,7 +40,10 @@
 #include "IND_Surface.h"
 #include "TextureDefinitions.h"
 #include "IND_Image.h"
+#include "IND_Timer.h"
 #include "ImageCutter.h"
+#include "CompressedImageHelper.h"
+#include <string.h>
 
 
 
@@ -51,11 +54,23 @@ OpenGLTextureBuilder::OpenGLTextureBuilder(IND_ImageManager *imagemgr, IND_Rende
 	// Image cutter
 	_cutter = new ImageCutter();
 	_cutter->init(imagemgr, _render->getMaxTextureSize());
+
+#ifdef INDIERENDER_OPENGL
+	// Exactly sized textures, when the renderer allows them
+	_cutter->setNonPowerOfTwo(_render->_wrappedRenderer->_info._npotTextures);
+
+	// Pixel buffers are created on first use
+	_nextPixelBuffer = 0;
+#endif
 }
 
 OpenGLTextureBuilder::~OpenGLTextureBuilder() {
 	// Free cutter object
 	DISPOSE(_cutter);
+
+#ifdef INDIERENDER_OPENGL
+	freePixelBuffers();
+#endif
 }
 
 /*
@@ -99,6 +114,8 @@ bool OpenGLTextureBuilder::createNewTexture(IND_Surface  *pNewSurface,
 	pNewSurface->_surface->_attributes._width            = mI._widthImage;
 	pNewSurface->_surface->_attributes._height           = mI._heightImage;
 	pNewSurface->_surface->_attributes._isHaveSurface    = 1;
+	pNewSurface->_surface->_attributes._textureMemory    = mI._numBlocks * mI._widthBlock * mI._heightBlock * pImage->getBytespp();
+	pNewSurface->_surface->_attributes._notUsedProportion = mI._notUsedProportion;
     
     assert(pNewSurface->_surface->_texturesArray); //Should have allocated textures array!
     glGenTextures(mI._numBlocks,pNewSurface->_surface->_texturesArray);
@@ -138,6 +155,11 @@ bool OpenGLTextureBuilder::createNewTexture(IND_Surface  *pNewSurface,
 	int mActualSpareY (0);
 	int mSrcBytespp = pImage->getBytespp(); 
 
+	// Upload measuring
+	IND_Timer mUploadTimer;
+	mUploadTimer.start();
+	int mUploadBytes = 0;
+
 	// ----- Cutting blocks -----
 
 	// We iterate the blocks starting from the lower row
@@ -205,38 +227,21 @@ bool OpenGLTextureBuilder::createNewTexture(IND_Surface  *pNewSurface,
 			              mActualU,                                   // U mapping coordinate
 			              mActualV);                                  // V mapping coordinate
 
-			// Cuts a block from the image (bitmap)
-			unsigned char *mTempBlock = 0;
-			_cutter->cutBlock(mPtrBlock,
-			                  mI._widthImage,
-			                  mI._widthBlock,
-			                  mI._heightBlock,
-			                  mActualSpareX,
-			                  mActualSpareY,
-			                  mSrcBytespp,
-			                  &mTempBlock);
-
-			// We create a texture using the cut bitmap block
-			glBindTexture(GL_TEXTURE_2D,pNewSurface->_surface->_texturesArray[mCont]);
-			glTexImage2D(GL_TEXTURE_2D,
-						0,
-						mInternalFormat,
-			        mI._widthBlock,
-			        mI._heightBlock,
-						0,
-						mFormat,
-						mType,
-						mTempBlock);
-
-			// Free the bitmap cutted block
-			DISPOSEARRAY(mTempBlock);
-
-			GLenum glerror = glGetError();
-			if (glerror) {
+			// We create a texture using the bitmap block
+			if (!uploadBlock(pNewSurface->_surface->_texturesArray[mCont],
+			                 mPtrBlock,
+			                 &mI,
+			                 mActualSpareX,
+			                 mActualSpareY,
+			                 mSrcBytespp,
+			                 mInternalFormat,
+			                 mFormat,
+			                 mType)) {
 				g_debug->header("OpenGL error while assigning texture to buffer", DebugApi::LogHeaderError);
 				//TODO: Test error and mem. leaks 
 				return false;
 			}
+			mUploadBytes += mI._widthBlock * mI._heightBlock * mSrcBytespp;
 
 			// ----- Advance -----
 
@@ -269,6 +274,99 @@ bool OpenGLTextureBuilder::createNewTexture(IND_Surface  *pNewSurface,
 		}
 	} //LOOP END - All blocks (Y coords)
 
+	// ----- Upload statistics -----
+
+	float mUploadTime = static_cast<float>(mUploadTimer.getTicks());
+	_render->addTextureUpload(mUploadBytes, mUploadTime);
+
+	g_debug->header("Texture upload:", DebugApi::LogHeaderInfo);
+	g_debug->dataInt(mUploadBytes, 0);
+	g_debug->dataChar("bytes in", 0);
+	g_debug->dataFloat(mUploadTime, 0);
+	g_debug->dataChar("ms", 1);
+
+	return true;
+}
+
+/*
+==================
+Texture (IND_Surface) creation from block compressed data. The data is uploaded as is, in a
+single texture, so the renderer must support the format, the size of the image and (when
+the size is not power of two) non power of two textures. Returns false otherwise.
+==================
+*/
+bool OpenGLTextureBuilder::createNewCompressedTexture(IND_Surface      *pNewSurface,
+        COMPRESSED_IMAGE *pImage,
+        IND_Type         pType) {
+	GLenum mGLFormat = getGLCompressedFormat(pImage->_format, pType);
+	if (!mGLFormat || !pImage->_data)
+		return false;
+
+	int mMaxTextureSize = _render->getMaxTextureSize();
+	if (pImage->_width > mMaxTextureSize || pImage->_height > mMaxTextureSize)
+		return false;
+
+	bool mPowerOfTwo = !(pImage->_width & (pImage->_width - 1)) && !(pImage->_height & (pImage->_height - 1));
+	if (!mPowerOfTwo && !_render->_wrappedRenderer->_info._npotTextures)
+		return false;
+
+	pNewSurface->freeTextureData(); //Guard against using same texture data all over again in same surface
+	pNewSurface->_surface = new SURFACE(1, 4);
+	pNewSurface->_surface->_attributes._type             = pType;
+	pNewSurface->_surface->_attributes._quality          = IND_32;
+	pNewSurface->_surface->_attributes._blocksX          = 1;
+	pNewSurface->_surface->_attributes._blocksY          = 1;
+	pNewSurface->_surface->_attributes._spareX           = 0;
+	pNewSurface->_surface->_attributes._spareY           = 0;
+	pNewSurface->_surface->_attributes._numBlocks        = 1;
+	pNewSurface->_surface->_attributes._numTextures      = 1;
+	pNewSurface->_surface->_attributes._isHaveGrid       = 0;
+	pNewSurface->_surface->_attributes._widthBlock       = pImage->_width;
+	pNewSurface->_surface->_attributes._heightBlock      = pImage->_height;
+	pNewSurface->_surface->_attributes._width            = pImage->_width;
+	pNewSurface->_surface->_attributes._height           = pImage->_height;
+	pNewSurface->_surface->_attributes._isHaveSurface    = 1;
+	pNewSurface->_surface->_attributes._textureMemory    = pImage->_size;
+
+	IND_Timer mUploadTimer;
+	mUploadTimer.start();
+
+	// DDS files store the upper row first, while the textures of createNewTexture() start from the lower one.
+	// DXT blocks are flipped before the upload. The rest (BC7 blocks can't be flipped without decoding them)
+	// are uploaded as they are, and flipped with the texture coordinates of the surface.
+	bool mFlipped = CompressedImageHelper::flipRows(pImage);
+
+	glGenTextures(1, pNewSurface->_surface->_texturesArray);
+	glBindTexture(GL_TEXTURE_2D, pNewSurface->_surface->_texturesArray[0]);
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, mGLFormat, pImage->_width, pImage->_height, 0, pImage->_size, pImage->_data);
+
+	if (GL_NO_ERROR != glGetError()) {
+		g_debug->header("OpenGL error while creating compressed texture", DebugApi::LogHeaderError);
+		pNewSurface->freeTextureData();
+		// The caller may still decode the image
+		if (mFlipped)
+			CompressedImageHelper::flipRows(pImage);
+		return false;
+	}
+
+	push4Vertices(pNewSurface->_surface->_vertexArray, 0, 0, pImage->_height, 0, pImage->_width, pImage->_height, 1.0f, 1.0f);
+	if (!mFlipped) {
+		for (int i = 0; i < 4; i++)
+			pNewSurface->_surface->_vertexArray[i]._texCoord._v = 1.0f - pNewSurface->_surface->_vertexArray[i]._texCoord._v;
+	}
+
+	// ----- Upload statistics -----
+
+	float mUploadTime = static_cast<float>(mUploadTimer.getTicks());
+	_render->addTextureUpload(pImage->_size, mUploadTime);
+
+	g_debug->header("Compressed texture upload:", DebugApi::LogHeaderInfo);
+	g_debug->dataChar(CompressedImageHelper::getFormatName(pImage->_format), 0);
+	g_debug->dataInt(pImage->_size, 0);
+	g_debug->dataChar("bytes in", 0);
+	g_debug->dataFloat(mUploadTime, 0);
+	g_debug->dataChar("ms", 1);
+
 	return true;
 }
 
@@ -276,6 +374,256 @@ bool OpenGLTextureBuilder::createNewTexture(IND_Surface  *pNewSurface,
 //									Private methods
 // --------------------------------------------------------------------------------
 
+/*
+==================
+Uploads one block of the image to an already generated texture. The useful area of the block
+is read straight from the image (using the unpack row length), or copied once into the next
+buffer of the pixel buffers ring when the renderer supports it, so the transfer to the card
+is done by the driver without stalling the caller. Only the spare area is padded.
+==================
+*/
+bool OpenGLTextureBuilder::uploadBlock(GLuint pTexture,
+                                       unsigned char *pPtrBlock,
+                                       INFO_SURFACE *pI,
+                                       int pSpareX,
+                                       int pSpareY,
+                                       int pBytespp,
+                                       GLint pInternalFormat,
+                                       GLint pFormat,
+                                       GLint pType) {
+	glBindTexture(GL_TEXTURE_2D, pTexture);
+
+	// Useful area of the block
+	int mWidth = pI->_widthBlock - pSpareX;
+	int mHeight = pI->_heightBlock - pSpareY;
+
+	// Image lines are not padded
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+#ifdef INDIERENDER_OPENGL
+	if (!allocateTexture(pInternalFormat, pFormat, pType, pI->_widthBlock, pI->_heightBlock)) {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		return false;
+	}
+
+	bool mUploaded = false;
+	if (_render->_wrappedRenderer->_info._pixelBufferObjects) {
+		unsigned char *mMapped = mapPixelBuffer(mWidth * mHeight * pBytespp);
+		if (mMapped) {
+			// Copy the useful area of the block straight into the pixel buffer
+			_cutter->cutBlockTo(pPtrBlock,
+			                    pI->_widthImage,
+			                    mWidth,
+			                    mHeight,
+			                    0,
+			                    0,
+			                    pBytespp,
+			                    mMapped);
+			unmapPixelBuffer();
+
+			// Source is the bound pixel buffer (offset 0)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight, pFormat, pType, 0);
+
+			// Mark the end of the transfer, so the slot is not written while in use
+			PixelBufferSlot &mSlot = _pixelBuffers [(_nextPixelBuffer + PIXEL_BUFFER_RING_SIZE - 1) % PIXEL_BUFFER_RING_SIZE];
+			mSlot._fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			mUploaded = true;
+		}
+
+		// Unbind, so client memory is used as source again
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	if (!mUploaded) {
+		// Upload the sub-rectangle directly from the image
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pI->_widthImage);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mWidth, mHeight, pFormat, pType, pPtrBlock);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+
+	// Spare areas are filled with zeros, as they are read by linear filtering and wrapping
+	if (pSpareX || pSpareY) {
+		int mSpareSizeX = pSpareX * pI->_heightBlock * pBytespp;
+		int mSpareSizeY = mWidth * pSpareY * pBytespp;
+		int mSpareSize = (mSpareSizeX > mSpareSizeY) ? mSpareSizeX : mSpareSizeY;
+		unsigned char *mZeros = _cutter->getScratchBuffer(mSpareSize);
+		memset(mZeros, 0, mSpareSize);
+
+		if (pSpareX)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, mWidth, 0, pSpareX, pI->_heightBlock, pFormat, pType, mZeros);
+		if (pSpareY)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, mHeight, mWidth, pSpareY, pFormat, pType, mZeros);
+	}
+#else
+	// There is no unpack row length in GL ES 2. Unless the block lines are contiguous in the image,
+	// the block is cut into the reusable scratch buffer of the cutter.
+	unsigned char *mBlock = pPtrBlock;
+	if (pSpareX || pSpareY || pI->_widthImage != pI->_widthBlock) {
+		mBlock = _cutter->getScratchBuffer(pI->_widthBlock * pI->_heightBlock * pBytespp);
+		_cutter->cutBlockTo(pPtrBlock,
+		                    pI->_widthImage,
+		                    pI->_widthBlock,
+		                    pI->_heightBlock,
+		                    pSpareX,
+		                    pSpareY,
+		                    pBytespp,
+		                    mBlock);
+	}
+
+	glTexImage2D(GL_TEXTURE_2D,
+	             0,
+	             pInternalFormat,
+	             pI->_widthBlock,
+	             pI->_heightBlock,
+	             0,
+	             pFormat,
+	             pType,
+	             mBlock);
+#endif
+
+	// Restore default unpacking
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	return (GL_NO_ERROR == glGetError());
+}
+
+/*
+==================
+Allocates the storage of the bound texture, without uploading any data. Immutable storage
+is used when available, as the driver doesn't need to keep track of mipmap completeness.
+==================
+*/
+bool OpenGLTextureBuilder::allocateTexture(GLint pInternalFormat, GLint pFormat, GLint pType, int pWidth, int pHeight) {
+#ifdef INDIERENDER_OPENGL
+	if (_render->_wrappedRenderer->_info._textureStorage) {
+		GLint mSizedFormat = getSizedInternalFormat(pFormat, pType);
+		if (GL_NONE != mSizedFormat) {
+			glTexStorage2D(GL_TEXTURE_2D, 1, mSizedFormat, pWidth, pHeight);
+			return (GL_NO_ERROR == glGetError());
+		}
+	}
+#endif
+
+	glTexImage2D(GL_TEXTURE_2D, 0, pInternalFormat, pWidth, pHeight, 0, pFormat, pType, NULL);
+	return (GL_NO_ERROR == glGetError());
+}
+
+/*
+==================
+Sized internal format equivalent to a format / type pair (needed by immutable storage).
+Returns GL_NONE when there is no exact equivalent.
+==================
+*/
+GLint OpenGLTextureBuilder::getSizedInternalFormat(GLint pGLFormat, GLint pGLType) {
+#ifdef INDIERENDER_OPENGL
+	switch (pGLFormat) {
+		case GL_RGBA:
+		case GL_BGRA:
+			if (GL_UNSIGNED_BYTE == pGLType) return GL_RGBA8;
+			if (GL_UNSIGNED_SHORT_4_4_4_4 == pGLType) return GL_RGBA4;
+			break;
+		case GL_RGB:
+		case GL_BGR:
+			if (GL_UNSIGNED_BYTE == pGLType) return GL_RGB8;
+			if (GL_UNSIGNED_SHORT_5_6_5 == pGLType)
+				return _render->_wrappedRenderer->_info._rgb565Textures ? GL_RGB565 : GL_RGB5;
+			break;
+		case GL_LUMINANCE:
+			if (GL_UNSIGNED_BYTE == pGLType) return GL_LUMINANCE8;
+			break;
+		default:
+			break;
+	}
+#endif
+	return GL_NONE;
+}
+
+/*
+==================
+GL internal format of a compressed format, if the renderer supports it (0 otherwise).
+DXT1 images of IND_ALPHA surfaces keep their 1 bit alpha.
+==================
+*/
+GLenum OpenGLTextureBuilder::getGLCompressedFormat(int pFormat, IND_Type pType) {
+#ifdef INDIERENDER_OPENGL
+	InfoStruct &mInfo = _render->_wrappedRenderer->_info;
+	switch (pFormat) {
+		case COMPRESSED_DXT1:
+			if (!mInfo._s3tcTextures)
+				return 0;
+			return (IND_ALPHA == pType) ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case COMPRESSED_DXT5:
+			return mInfo._s3tcTextures ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+		case COMPRESSED_BC7:
+			return mInfo._bptcTextures ? GL_COMPRESSED_RGBA_BPTC_UNORM_ARB : 0;
+		default:
+			break;
+	}
+#endif
+	return 0;
+}
+
+#ifdef INDIERENDER_OPENGL
+/*
+==================
+Takes the next buffer of the ring, binds it as GL_PIXEL_UNPACK_BUFFER and maps it for writing.
+Returns NULL if the buffer can't be mapped.
+==================
+*/
+unsigned char *OpenGLTextureBuilder::mapPixelBuffer(int pSize) {
+	PixelBufferSlot &mSlot = _pixelBuffers [_nextPixelBuffer];
+	_nextPixelBuffer = (_nextPixelBuffer + 1) % PIXEL_BUFFER_RING_SIZE;
+
+	if (!mSlot._buffer) {
+		glGenBuffers(1, &mSlot._buffer);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mSlot._buffer);
+
+	// Wait for the previous transfer from this slot. As the rest of the ring was used meanwhile,
+	// it is usually finished already.
+	if (mSlot._fence) {
+		glClientWaitSync(mSlot._fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(mSlot._fence);
+		mSlot._fence = NULL;
+	}
+
+	if (mSlot._size < pSize) {
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, pSize, NULL, GL_STREAM_DRAW);
+		mSlot._size = pSize;
+	}
+
+	return static_cast<unsigned char *>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+}
+
+/*
+==================
+Unmaps the bound pixel buffer
+==================
+*/
+void OpenGLTextureBuilder::unmapPixelBuffer() {
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+}
+
+/*
+==================
+Frees the ring of pixel buffers
+==================
+*/
+void OpenGLTextureBuilder::freePixelBuffers() {
+	for (int i = 0; i < PIXEL_BUFFER_RING_SIZE; i++) {
+		if (_pixelBuffers [i]._fence) {
+			glDeleteSync(_pixelBuffers [i]._fence);
+			_pixelBuffers [i]._fence = NULL;
+		}
+		if (_pixelBuffers [i]._buffer) {
+			glDeleteBuffers(1, &_pixelBuffers [i]._buffer);
+			_pixelBuffers [i]._buffer = 0;
+			_pixelBuffers [i]._size = 0;
+		}
+	}
+}
+#endif
+
 /*
 ==================
 Return OpenGL format and type depending on IndieLib defined quality and type
@@ -35,6 +35,7 @@
 #include "Defines.h"
 #include "TextureBuilder.h"
 #include "IND_Render.h"
+#include "ImageCutter.h"
 
 #ifdef INDIERENDER_OPENGL
 #include "dependencies/glew-1.9.0/include/GL/glew.h" //Extension loading facilites library
@@ -49,6 +50,10 @@
 #endif
 /** @cond DOCUMENT_PRIVATEAPI */
 
+// Number of pixel buffers used for streaming texture uploads. A buffer is only written again
+// after the rest of the ring has been used, so the transfer from it has usually finished.
+#define PIXEL_BUFFER_RING_SIZE 4
+
 class IND_Image;
 class IND_Surface;
 class ImageCutter;
@@ -66,14 +71,56 @@ public:
 	                              int             pBlockSizeX,
 	                              int             pBlockSizeY) ;
 
+	virtual bool createNewCompressedTexture(IND_Surface      *pNewSurface,
+	                                        COMPRESSED_IMAGE *pImage,
+	                                        IND_Type         pType);
+
 private:
+#ifdef INDIERENDER_OPENGL
+	// Slot of the pixel buffers ring
+	struct PixelBufferSlot {
+		PixelBufferSlot() : _buffer(0), _size(0), _fence(NULL) {}
+		GLuint _buffer;       // GL_PIXEL_UNPACK_BUFFER name
+		int _size;            // Allocated storage (bytes)
+		GLsync _fence;        // Signaled when the last transfer from the buffer is done
+	};
+#endif
+
 	// ----- Private Objects ------
 	ImageCutter *_cutter;
 	IND_Render *_render;
 
+#ifdef INDIERENDER_OPENGL
+	// ----- Pixel buffers ring ------
+	PixelBufferSlot _pixelBuffers [PIXEL_BUFFER_RING_SIZE];
+	int _nextPixelBuffer;
+#endif
+
 	// ----- Private Methods ------
 	void getGLFormat (IND_Surface *pNewSurface, IND_Image* pNewImage, GLint *pGLInternalFormat, GLint *pGLFormat, GLint *pGLType);
 
+	GLint getSizedInternalFormat(GLint pGLFormat, GLint pGLType);
+
+	GLenum getGLCompressedFormat(int pFormat, IND_Type pType);
+
+	bool allocateTexture(GLint pInternalFormat, GLint pFormat, GLint pType, int pWidth, int pHeight);
+
+	bool uploadBlock(GLuint pTexture,
+	                 unsigned char *pPtrBlock,
+	                 INFO_SURFACE *pI,
+	                 int pSpareX,
+	                 int pSpareY,
+	                 int pBytespp,
+	                 GLint pInternalFormat,
+	                 GLint pFormat,
+	                 GLint pType);
+
+#ifdef INDIERENDER_OPENGL
+	unsigned char *mapPixelBuffer(int pSize);
+	void unmapPixelBuffer();
+	void freePixelBuffers();
+#endif
+
 	void pushVertex(CUSTOMVERTEX2D *pVertices,
 	                               int pPosVert,
 	                               int pVx,
@@ -107,6 +107,63 @@ void OpenGLRender::reCalculateFrustrumPlanes() {
 	}
 }
 
+/*
+==================
+Calculates the world bounding rectangle of the area seen by the camera. The extents of the view are
+taken from the orthographic projection, and the corners of the view are taken back to world
+coordinates inverting the 2d part of the camera matrix.
+==================
+*/
+bool OpenGLRender::getVisibleArea(IND_Vector3 *pMin, IND_Vector3 *pMax) {
+	//Read straight from the GL matrix (column major: the translation is in the elements 12 and 13), so
+	//the extents don't depend on where IND_Matrix::readFromArray() stores each element
+	float mProj [16];
+	glGetFloatv(GL_PROJECTION_MATRIX, mProj);
+	float mScaleX = mProj [0];
+	float mScaleY = mProj [5];
+	float mTransX = mProj [12];
+	float mTransY = mProj [13];
+
+	if (mScaleX == 0.0f || mScaleY == 0.0f)
+		return false;
+
+	//Corners of the view, in camera space
+	float mLeft = (-1.0f - mTransX) / mScaleX;
+	float mRight = (1.0f - mTransX) / mScaleX;
+	float mBottom = (-1.0f - mTransY) / mScaleY;
+	float mTop = (1.0f - mTransY) / mScaleY;
+
+	//Camera space = world origin + world axes, after the camera transform
+	IND_Vector3 mOrigin(0.0f, 0.0f, 0.0f), mAxisX(1.0f, 0.0f, 0.0f), mAxisY(0.0f, 1.0f, 0.0f);
+	_math.transformVector3DbyMatrix4D(mOrigin, _cameraMatrix);
+	_math.transformVector3DbyMatrix4D(mAxisX, _cameraMatrix);
+	_math.transformVector3DbyMatrix4D(mAxisY, _cameraMatrix);
+
+	float mA = mAxisX._x - mOrigin._x;
+	float mB = mAxisY._x - mOrigin._x;
+	float mC = mAxisX._y - mOrigin._y;
+	float mD = mAxisY._y - mOrigin._y;
+	float mDet = mA * mD - mB * mC;
+	if (mDet > -0.000001f && mDet < 0.000001f)
+		return false;
+
+	float mCornersX [4] = {mLeft, mRight, mLeft, mRight};
+	float mCornersY [4] = {mBottom, mBottom, mTop, mTop};
+	for (int i = 0; i < 4; i++) {
+		float mX = mCornersX [i] - mOrigin._x;
+		float mY = mCornersY [i] - mOrigin._y;
+		float mWorldX = (mD * mX - mB * mY) / mDet;
+		float mWorldY = (mA * mY - mC * mX) / mDet;
+
+		if (!i || mWorldX < pMin->_x) pMin->_x = mWorldX;
+		if (!i || mWorldY < pMin->_y) pMin->_y = mWorldY;
+		if (!i || mWorldX > pMax->_x) pMax->_x = mWorldX;
+		if (!i || mWorldY > pMax->_y) pMax->_y = mWorldY;
+	}
+
+	return true;
+}
+
 /*
 ==================
 Transforms vertices (supposedly from a quad) to world coordinates using the cached
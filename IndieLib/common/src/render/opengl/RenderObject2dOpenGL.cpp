@@ -76,26 +76,14 @@ void OpenGLRender::blitSurface(IND_Surface *pSu) {
             assert(GL_FALSE != enabled); //Should have texturing enabled
 #endif
 			
-			if (!pSu->isHaveGrid()) {
-				//Texture ID - If it doesn't have a grid, every other block must be blit by 
-				//a different texture in texture array ID. 
-				glBindTexture(GL_TEXTURE_2D,pSu->_surface->_texturesArray[i]);
-			} else {
-				//In a case of rendering a grid. Same texture (but different vertex position)
-				//is rendered all the time. In other words, different pieces of same texture are rendered
-				glBindTexture(GL_TEXTURE_2D,pSu->_surface->_texturesArray[0]);
-			}
-            
-            //Set texture params requested before (via rainbow2d API)
-            setGLBoundTextureParams();
-            
-			//Override CLAMP for texture
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	        
-			glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pSu->_surface->_vertexArray[mCont]._pos._x);
-			glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pSu->_surface->_vertexArray[mCont]._texCoord._u);
-			glDrawArrays(GL_TRIANGLE_STRIP, 0,4);	
+			//Texture ID - If it doesn't have a grid, every other block must be blit by 
+			//a different texture in texture array ID. 
+			//In a case of rendering a grid. Same texture (but different vertex position)
+			//is rendered all the time. In other words, different pieces of same texture are rendered
+			GLuint mTexture = pSu->isHaveGrid() ? pSu->_surface->_texturesArray[0] : pSu->_surface->_texturesArray[i];
+
+			//CLAMP for texture
+			drawQuad2d(mTexture, GL_CLAMP_TO_EDGE, &pSu->_surface->_vertexArray[mCont]);
 	    	
 		#ifdef _DEBUG
 			GLenum glerror = glGetError();
@@ -104,6 +92,9 @@ void OpenGLRender::blitSurface(IND_Surface *pSu) {
 			}
 		#endif
 			_numrenderedObjects++;
+
+			if (_fillStats)
+				addFill(mP1, mP2, &pSu->_surface->_vertexArray[mCont]);
 		}
   		
 		mCont += 4;
@@ -157,6 +148,16 @@ void OpenGLRender::blitRegionSurface(IND_Surface *pSu,
 			pY < 0 || pY + pHeight > pSu->getHeight()) {
 			correctParams = false;
 		}
+
+		// Trimmed surface, only the part of the region kept in the texture is drawn
+		float drawX (0.0f);
+		float drawY (0.0f);
+		if (correctParams && pSu->isTrimmed()) {
+			int mDrawX, mDrawY;
+			correctParams = pSu->clipRegion(&pX, &pY, &pWidth, &pHeight, &mDrawX, &mDrawY);
+			drawX = static_cast<float>(mDrawX);
+			drawY = static_cast<float>(mDrawY);
+		}
 		
 		if (correctParams) {
 			//Only draws first texture block in texture
@@ -169,10 +170,10 @@ void OpenGLRender::blitRegionSurface(IND_Surface *pSu,
 			float bWidth (static_cast<float>(pSu->getWidthBlock()));
 			float bHeight (static_cast<float>(pSu->getHeightBlock()));
 			float spareY (static_cast<float>(pSu->getSpareY()));
-			fillVertex2d(&_vertices2d [0], width, 0.0f, ((x + width) / bWidth), (1.0f - ((y + spareY) / bHeight)));
-			fillVertex2d(&_vertices2d [1], width, height, (x + width) / bWidth, (1.0f - ((y + height + spareY) / bHeight)));
-			fillVertex2d(&_vertices2d [2], 0.0f, 0.0f , (x/bWidth), (1.0f - ((y+ spareY) / bHeight)));
-			fillVertex2d(&_vertices2d [3], 0.0f, height, (x/bWidth), (1.0f - (y + height + spareY) / bHeight));
+			fillVertex2d(&_vertices2d [0], drawX + width, drawY, ((x + width) / bWidth), (1.0f - ((y + spareY) / bHeight)));
+			fillVertex2d(&_vertices2d [1], drawX + width, drawY + height, (x + width) / bWidth, (1.0f - ((y + height + spareY) / bHeight)));
+			fillVertex2d(&_vertices2d [2], drawX, drawY, (x/bWidth), (1.0f - ((y+ spareY) / bHeight)));
+			fillVertex2d(&_vertices2d [3], drawX, drawY + height, (x/bWidth), (1.0f - (y + height + spareY) / bHeight));
 		        
         	//Get vertex world coords, to perform frustrum culling test in world coords
             IND_Vector3 mP1, mP2, mP3, mP4;
@@ -195,18 +196,8 @@ void OpenGLRender::blitRegionSurface(IND_Surface *pSu,
                 assert(GL_FALSE != enabled); //Should have texturing enabled
 #endif
                 
-                glBindTexture(GL_TEXTURE_2D,pSu->_surface->_texturesArray[0]);
-                
-                //Set texture params requested before (via rainbow2d API)
-                setGLBoundTextureParams();
-                
-                //Override CLAMP for texture
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                
-                glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &_vertices2d[0]._pos._x);
-                glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &_vertices2d[0]._texCoord._u);
-                glDrawArrays(GL_TRIANGLE_STRIP, 0,4);
+                //CLAMP for texture
+                drawQuad2d(pSu->_surface->_texturesArray[0], GL_CLAMP_TO_EDGE, &_vertices2d[0]);
 		    	
 #ifdef _DEBUG
 				GLenum glerror = glGetError();
@@ -215,6 +206,9 @@ void OpenGLRender::blitRegionSurface(IND_Surface *pSu,
 				}
 #endif
                 _numrenderedObjects++;
+
+                if (_fillStats)
+                    addFill(mP1, mP2, &_vertices2d[0]);
             }
 		}
 		
@@ -229,7 +223,8 @@ bool OpenGLRender::blitWrapSurface(IND_Surface *pSu,
                                    float pUDisplace,
                                    float pVDisplace) {
    bool correctParams = true;
-   if (pSu->getNumTextures() != 1) {
+   // The texture of a trimmed surface doesn't cover the whole surface, so it can't be wrapped
+   if (pSu->getNumTextures() != 1 || pSu->isTrimmed()) {
 		correctParams = false; 
    }
 
@@ -272,19 +267,12 @@ bool OpenGLRender::blitWrapSurface(IND_Surface *pSu,
            assert(GL_FALSE != enabled); //Should have texturing enabled
 #endif
            
-           glBindTexture(GL_TEXTURE_2D,pSu->_surface->_texturesArray[0]);
-           
-           //Set texture params requested before (via rainbow2d API)
-           setGLBoundTextureParams();
-           
-           //Override CLAMP for texture
-           glTexParameterf(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-           glTexParameterf(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-           
-           glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &_vertices2d[0]._pos._x);
-           glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &_vertices2d[0]._texCoord._u);
-           glDrawArrays(GL_TRIANGLE_STRIP, 0,4);
+           //REPEAT for texture
+           drawQuad2d(pSu->_surface->_texturesArray[0], GL_REPEAT, &_vertices2d[0]);
            _numrenderedObjects++;
+
+           if (_fillStats)
+               addFill(mP1, mP2, &_vertices2d[0]);
        }
    }
 
@@ -293,6 +281,7 @@ bool OpenGLRender::blitWrapSurface(IND_Surface *pSu,
 
 
 int OpenGLRender::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
+                                unsigned int pFrame,
                                 int pX, int pY,
                                 int pWidth, int pHeight,
                                 bool pToggleWrap,
@@ -302,47 +291,37 @@ int OpenGLRender::blitAnimation(IND_Animation *pAn, unsigned int pSequence,
 	int mFinish = 1;
 
 	if (pSequence < pAn->getNumSequences()) {
-		if (!pAn->getIsActive(pSequence)) {
-			pAn->getSequenceTimer(pSequence)->start();
-			pAn->setIsActive(pSequence, 1);
-		}
-
-		// If the time of a frame have passed, go to the next frame
-		if (pAn->getSequenceTimer(pSequence)->getTicks() > (unsigned long) pAn->getActualFrameTime(pSequence)) {
-			// Put timer to zero
-			pAn->getSequenceTimer(pSequence)->start();
-
-			// Point to the next frame increasing the counter
-			int i = pAn->getActualFramePos(pSequence);
-			pAn->setActualFramePos(pSequence, i + 1);
-
-			// If the counter is higher than the number of frames of the sequence, we put it to zero
-			if (pAn->getActualFramePos(pSequence) > pAn->getNumFrames(pSequence) - 1) {
-				pAn->setActualFramePos(pSequence, pAn->getNumFrames(pSequence) - 1);
-				pAn->setIsActive(pSequence, 0);
-				mFinish = -1;
-			}
+		translate2d(static_cast<float>(pAn->getFrameOffsetX(pSequence, pFrame)),
+		            static_cast<float>(pAn->getFrameOffsetY(pSequence, pFrame)));
+
+		// Frame packed into an atlas page, blits its rectangle of the page
+		int mX = pX, mY = pY, mWidth = pWidth, mHeight = pHeight, mDrawX, mDrawY;
+		IND_Surface *mAtlas = pAn->getFrameAtlas(pSequence, pFrame, &mX, &mY, &mWidth, &mHeight, &mDrawX, &mDrawY);
+		if (mAtlas) {
+			// The page can't be wrapped
+			if (pToggleWrap && (pWidth || pHeight))
+				return 0;
+			translate2d(static_cast<float>(mDrawX), static_cast<float>(mDrawY));
+			if (mWidth && mHeight)
+				blitRegionSurface(mAtlas, mX, mY, mWidth, mHeight);
+			return mFinish;
 		}
-		
-		glTranslatef(static_cast<float>(pAn->getActualOffsetX(pSequence)),
-					 static_cast<float>(pAn->getActualOffsetY(pSequence)),
-					 0.0f);
 
 		// Blits all the IND_Surface (all the blocks)
 		if (!pX && !pY && !pWidth && !pHeight) {
-			blitSurface(pAn->getActualSurface(pSequence));
+			blitSurface(pAn->getFrameSurface(pSequence, pFrame));
 		} else
 			// Blits a region of the IND_Surface
 			if (!pToggleWrap) {
-				if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+				if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 					return 0;
-				blitRegionSurface(pAn->getActualSurface(pSequence), pX, pY, pWidth, pHeight);
+				blitRegionSurface(pAn->getFrameSurface(pSequence, pFrame), pX, pY, pWidth, pHeight);
 		}
 		// Blits a wrapping IND_Surface
 		else {
-			if (pAn->getActualSurface(pSequence)->getNumTextures() > 1)
+			if (pAn->getFrameSurface(pSequence, pFrame)->getNumTextures() > 1)
 				return 0;
-			blitWrapSurface(pAn->getActualSurface(pSequence), pWidth, pHeight, pUDisplace, pVDisplace);
+			blitWrapSurface(pAn->getFrameSurface(pSequence, pFrame), pWidth, pHeight, pUDisplace, pVDisplace);
 		}
 	}
 
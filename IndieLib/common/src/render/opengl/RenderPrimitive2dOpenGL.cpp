@@ -58,34 +58,11 @@ void OpenGLRender::blitPixel(int pX,
                              unsigned char pG,
                              unsigned char pB,
                              unsigned char pA) {
-	
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
-	// Fill the PIXEL structure
-	fillPixel (&_pixels [0], static_cast<float>(pX), static_cast<float>(pY), r, g, b, a);
-	
-	// Pixel drawing
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive (pA, true);
-
-	
-    
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_POINTS, 0,1);	
 
-	
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in pixel blitting ", DebugApi::LogHeaderError);
-	}
-#endif	
-
-    //Reenable texturing
-    setGLClientStateToTexturing();
-	
+	// Fill the PIXEL structure
+	PIXEL *mPixels = addPrimitive2d(GL_POINTS, 1, pA);
+	fillPixel(&mPixels [0], static_cast<float>(pX), static_cast<float>(pY), r, g, b, a);
 }
 
 void OpenGLRender::blitLine(int pX1,
@@ -97,31 +74,11 @@ void OpenGLRender::blitLine(int pX1,
                             unsigned char pB,
                             unsigned char pA) {
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
-	//Fill the PIXEL structure
-	fillPixel(&_pixels[0], static_cast<float>(pX1), static_cast<float>(pY1), r, g, b, a);
-	fillPixel(&_pixels[1], static_cast<float>(pX2), static_cast<float>(pY2), r, g, b, a);
 
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive(pA,true);
-
-	//Line blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINES, 0, 2);
-
-	
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in Line blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+	//Fill the PIXEL structure
+	PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+	fillPixel(&mPixels [0], static_cast<float>(pX1), static_cast<float>(pY1), r, g, b, a);
+	fillPixel(&mPixels [1], static_cast<float>(pX2), static_cast<float>(pY2), r, g, b, a);
 }
 
 void OpenGLRender::blitRectangle(int pX1,
@@ -133,34 +90,16 @@ void OpenGLRender::blitRectangle(int pX1,
                                  unsigned char pB,
                                  unsigned char pA) {
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
- 	
-	// Fill PIXEL structures
-	fillPixel (&_pixels [0], static_cast<float>(pX1),static_cast<float>(pY1),      r, g, b,a);
-	fillPixel (&_pixels [1], static_cast<float>(pX2), static_cast<float>(pY1),      r, g, b,a);
-	fillPixel (&_pixels [2], static_cast<float>(pX2), static_cast<float>(pY2),      r, g, b,a);
-	fillPixel (&_pixels [3], static_cast<float>(pX1), static_cast<float>(pY2),      r, g, b,a);
-	fillPixel (&_pixels [4], static_cast<float>(pX1), static_cast<float>(pY1),      r, g, b,a);
-	
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive (pA,true);
 
-	//rectangle blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINE_STRIP, 0, 5);
+	float mX [4] = {static_cast<float>(pX1), static_cast<float>(pX2), static_cast<float>(pX2), static_cast<float>(pX1)};
+	float mY [4] = {static_cast<float>(pY1), static_cast<float>(pY1), static_cast<float>(pY2), static_cast<float>(pY2)};
 
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in rectangle blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+	//LOOP - One line per side
+	for (int i = 0; i < 4; i++) {
+		PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+		fillPixel(&mPixels [0], mX [i], mY [i], r, g, b, a);
+		fillPixel(&mPixels [1], mX [(i + 1) % 4], mY [(i + 1) % 4], r, g, b, a);
+	}//LOOP END
 }
 
 void OpenGLRender::blitFillRectangle(int pX1,
@@ -172,33 +111,15 @@ void OpenGLRender::blitFillRectangle(int pX1,
                                      unsigned char pB,
                                      unsigned char pA) {
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
- 	
-	// Fill PIXEL structures
-	fillPixel (&_pixels [0], static_cast<float>(pX1),static_cast<float>(pY1),      r, g, b,a);
-	fillPixel (&_pixels [1], static_cast<float>(pX2), static_cast<float>(pY1),      r, g, b,a);
-	fillPixel (&_pixels [2], static_cast<float>(pX1), static_cast<float>(pY2),      r, g, b,a);
-	fillPixel (&_pixels [3], static_cast<float>(pX2), static_cast<float>(pY2),      r, g, b,a);
 
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive (pA,true);
-
-	//rectangle blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in rectangle blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+	// Two triangles, with the winding of the strip (x1, y1) (x2, y1) (x1, y2) (x2, y2)
+	PIXEL *mPixels = addPrimitive2d(GL_TRIANGLES, 6, pA);
+	fillPixel(&mPixels [0], static_cast<float>(pX1), static_cast<float>(pY1), r, g, b, a);
+	fillPixel(&mPixels [1], static_cast<float>(pX2), static_cast<float>(pY1), r, g, b, a);
+	fillPixel(&mPixels [2], static_cast<float>(pX1), static_cast<float>(pY2), r, g, b, a);
+	fillPixel(&mPixels [3], static_cast<float>(pX1), static_cast<float>(pY2), r, g, b, a);
+	fillPixel(&mPixels [4], static_cast<float>(pX2), static_cast<float>(pY1), r, g, b, a);
+	fillPixel(&mPixels [5], static_cast<float>(pX2), static_cast<float>(pY2), r, g, b, a);
 }
 
 void OpenGLRender::blitTriangleList(IND_Point *pTrianglePoints,
@@ -207,38 +128,21 @@ void OpenGLRender::blitTriangleList(IND_Point *pTrianglePoints,
                                     unsigned char pG,
                                     unsigned char pB,
                                     unsigned char pA) {
-
-	//TODO: CHECK MAX POLYGONS PER CALL...
 	if (pNumPoints < 3)
 		return;
 
-    float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
-
-	//LOOP - Fill pixels structure
-	for (int i = 0; i < pNumPoints; i++) {
-		fillPixel(&_pixels[i], static_cast<float>(pTrianglePoints[i].x), static_cast<float>(pTrianglePoints[i].y), r, g, b, a);
-	}//LOOP END
-
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive(pA,true);
+	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
 
-	//Triangle strip blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, pNumPoints);
+	//LOOP - The points are a strip: one triangle per point after the second one, keeping the winding
+	for (int i = 2; i < pNumPoints; i++) {
+		int mFirst = (i % 2) ? i - 1 : i - 2;
+		int mSecond = (i % 2) ? i - 2 : i - 1;
 
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in triangle list blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+		PIXEL *mPixels = addPrimitive2d(GL_TRIANGLES, 3, pA);
+		fillPixel(&mPixels [0], static_cast<float>(pTrianglePoints [mFirst].x), static_cast<float>(pTrianglePoints [mFirst].y), r, g, b, a);
+		fillPixel(&mPixels [1], static_cast<float>(pTrianglePoints [mSecond].x), static_cast<float>(pTrianglePoints [mSecond].y), r, g, b, a);
+		fillPixel(&mPixels [2], static_cast<float>(pTrianglePoints [i].x), static_cast<float>(pTrianglePoints [i].y), r, g, b, a);
+	}//LOOP END
 }
 
 
@@ -259,30 +163,10 @@ void OpenGLRender::blitColoredTriangle(int pX1,
     float a(static_cast<float>(pA) / 255.0f);
 	
     // Fill PIXEL structures
-	fillPixel (&_pixels[0], static_cast<float>(pX1), static_cast<float>(pY1), r1, g1, b1, a);
-	fillPixel (&_pixels[1], static_cast<float>(pX2), static_cast<float>(pY2), r2, g2, b2, a);
-	fillPixel (&_pixels[2], static_cast<float>(pX3), static_cast<float>(pY3), r3, g3, b3, a);
-
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive(pA,true);
-
-	//Single Colored Triangle blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in colored triangle blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+	PIXEL *mPixels = addPrimitive2d(GL_TRIANGLES, 3, pA);
+	fillPixel (&mPixels [0], static_cast<float>(pX1), static_cast<float>(pY1), r1, g1, b1, a);
+	fillPixel (&mPixels [1], static_cast<float>(pX2), static_cast<float>(pY2), r2, g2, b2, a);
+	fillPixel (&mPixels [2], static_cast<float>(pX3), static_cast<float>(pY3), r3, g3, b3, a);
 }
 
 
@@ -298,31 +182,13 @@ bool OpenGLRender::blitPoly2d(IND_Point *pPolyPoints,
 
     float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
 
-	// Fill PIXEL structures
-    for (int i = 0; i < pNumLines + 1; i++){
-	    fillPixel (&_pixels [i], static_cast<float>(pPolyPoints [i].x), static_cast<float>(pPolyPoints [i].y), r, g, b,a);
-    }
+	//LOOP - One line from each point to the next one
+    for (int i = 0; i < pNumLines; i++) {
+		PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+	    fillPixel (&mPixels [0], static_cast<float>(pPolyPoints [i].x), static_cast<float>(pPolyPoints [i].y), r, g, b, a);
+	    fillPixel (&mPixels [1], static_cast<float>(pPolyPoints [i + 1].x), static_cast<float>(pPolyPoints [i + 1].y), r, g, b, a);
+    }//LOOP END
 
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-
-	// Color and transformation
-	setForPrimitive(pA,true);
-
-	// Polygon blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINE_STRIP, 0, pNumLines+1);
-
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in triangle poly2d blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
 	return 1;
 }
 
@@ -336,40 +202,34 @@ bool OpenGLRender::blitRegularPoly(int pX,
                                    unsigned char pG,
                                    unsigned char pB,
                                    unsigned char pA) {
-	int x, y, i;
+	if (pN < 1)  return 0;
+
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
 
-	//LOOP - Fill pixels structure
-	for (i = 0; i < pN; i++) {
-		float c = i * 2 * static_cast<float>(PI / pN);
-		x = static_cast<int>(pX + (pRadius * cos(c + _math.angleToRadians(pAngle))));
-		y = static_cast<int>(pY + (pRadius * sin(c + _math.angleToRadians(pAngle))));
+	// The vertices of the polygon without rotation are cached, and rotated by the angle:
+	// cos (c + angle) = cos c cos angle - sin c sin angle, sin (c + angle) = sin c cos angle + cos c sin angle
+	const float *mTable = getCircleTable(pN);
+	float mCos = cosf(_math.angleToRadians(pAngle));
+	float mSin = sinf(_math.angleToRadians(pAngle));
 
-		fillPixel(&_pixels [i], static_cast<float>(x), static_cast<float>(y), r, g, b, a);
-	}//LOOP END
+	float mLastX = 0.0f, mLastY = 0.0f;
 
-	fillPixel(&_pixels [i], pX + (pRadius * cos(_math.angleToRadians(pAngle))), pY + (pRadius * sin(_math.angleToRadians(pAngle))), r, g, b, a);
-	
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
+	//LOOP - Vertices (the first one again at the end, closing the polygon)
+	for (int i = 0; i <= pN; i++) {
+		const float *mVertex = &mTable [(i % pN) * 2];
+		float x = static_cast<float>(static_cast<int>(pX + pRadius * (mVertex [0] * mCos - mVertex [1] * mSin)));
+		float y = static_cast<float>(static_cast<int>(pY + pRadius * (mVertex [1] * mCos + mVertex [0] * mSin)));
 
-	// Color and transformation
-	setForPrimitive(pA,true);
+		if (i) {
+			PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+			fillPixel(&mPixels [0], mLastX, mLastY, r, g, b, a);
+			fillPixel(&mPixels [1], x, y, r, g, b, a);
+		}
 
-	//Polygon blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINE_STRIP, 0, pN+1);
-
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in triangle list blitting ", DebugApi::LogHeaderError);
-	}
-#endif
+		mLastX = x;
+		mLastY = y;
+	}//LOOP END
 
-    //Reenable texturing
-	setGLClientStateToTexturing();
 	return 1;
 }
 
@@ -393,11 +253,27 @@ void OpenGLRender::fillPixel(PIXEL *pPixel,
 	pPixel->_colorA = pA;
 }
 
+void OpenGLRender::fillPixel(PIXEL *pPixel,
+                             const IND_Matrix &pMatrix,
+                             float pX,
+                             float pY,
+                             float pR,
+                             float pG,
+                             float pB,
+                             float pA) {
+	// Pixel, in world coordinates
+	IND_Vector3 mPos(pX, pY, 0.0f);
+	_math.transformVector3DbyMatrix4D(mPos, pMatrix);
+
+	fillPixel(pPixel, mPos._x, mPos._y, pR, pG, pB, pA);
+	pPixel->_z = mPos._z;
+}
+
 
 void OpenGLRender::setForPrimitive(unsigned char pA, bool pResetTransform) {
 	// Transformation reset
 	if (pResetTransform) {
-		setTransform2d(0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0);
+		setIdentityTransform2d();
 	}
 
 	//IF - Totally opaque
@@ -410,31 +286,66 @@ void OpenGLRender::setForPrimitive(unsigned char pA, bool pResetTransform) {
 
 /*
 ==================
-Blits a bounding line
+Reserves the vertices of a primitive in the batch. The batch is drawn first if it has another mode, another
+blending (opaque or transparent) or there is no room left.
 ==================
 */
- void OpenGLRender::blitGridLine (int pPosX1, int pPosY1, int pPosX2, int pPosY2,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA)
-{	
-	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
-	// Filling pixels
-    fillPixel (&_pixels[0], static_cast<float>(pPosX1), static_cast<float>(pPosY1), r, g, b, a);
-    fillPixel (&_pixels[1], static_cast<float>(pPosX2), static_cast<float>(pPosY2), r, g, b, a);
+PIXEL *OpenGLRender::addPrimitive2d(GLenum pMode, int pNumVertices, unsigned char pA) {
+	if (_primNumVertices) {
+		if (pMode != _primMode ||
+		    (pA == 255) != (_primAlpha == 255) ||
+		    _primNumVertices + pNumVertices > MAX_PRIMITIVE_VERTICES)
+			flushPrimitives2d();
+	}
+
+	//A new batch is drawn after the quads of the programmable 2d renderer
+	if (!_primNumVertices)
+		flushBatch2d();
+
+	_primMode = pMode;
+	_primAlpha = pA;
+
+	PIXEL *mVertices = &_primVertices [_primNumVertices];
+	_primNumVertices += pNumVertices;
+	return mVertices;
+}
+
+/*
+==================
+Draws the batch of primitives. It is called before changing the transform, the blending, the camera or
+drawing anything else. The transform and the client state are restored after drawing.
+==================
+*/
+void OpenGLRender::flushPrimitives2d() {
+	if (!_primNumVertices)
+		return;
+
+	//Emptied first, the state changes below also flush the batches
+	int mNumVertices = _primNumVertices;
+	_primNumVertices = 0;
 
 	//Render primitive - No textures
 	setGLClientStateToPrimitive();
-    
-	// Color settings
-    setRainbow2d (IND_OPAQUE, 1, 0, 0, IND_FILTER_POINT, pR, pG, pB, pA, 0, 0, 0, 255, 0, 0);
 
-	//Polygon blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINE_STRIP, 0, 2);
+	// Color
+	setForPrimitive(_primAlpha, false);
+
+	// The vertices are in world coordinates
+	glPushMatrix();
+	float camMatrixArray [16];
+	_cameraMatrix.arrayRepresentation(camMatrixArray);
+	glLoadMatrixf(camMatrixArray);
+
+	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_primVertices[0]._x);
+	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_primVertices[0]._colorR);
+	glDrawArrays(_primMode, 0, mNumVertices);
+
+	glPopMatrix();
 
 #ifdef _DEBUG
     GLenum glerror = glGetError();
 	if (glerror) {
-		g_debug->header("OpenGL error in grid line blitting ", DebugApi::LogHeaderError);
+		g_debug->header("OpenGL error in primitive blitting ", DebugApi::LogHeaderError);
 	}
 #endif
 
@@ -442,6 +353,42 @@ Blits a bounding line
 	setGLClientStateToTexturing();
 }
 
+/*
+==================
+Cos and sin of the vertices of a regular polygon of pSides sides (and radius 1), starting at angle 0.
+They are computed once for each number of sides.
+==================
+*/
+const float *OpenGLRender::getCircleTable(int pSides) {
+	std::vector<float> &mTable = _circleTables [pSides];
+
+	if (mTable.empty()) {
+		mTable.resize(pSides * 2);
+		float mAngle = 2 * PI / pSides;
+		for (int i = 0; i < pSides; i++) {
+			mTable [i * 2] = cosf(mAngle * i);
+			mTable [i * 2 + 1] = sinf(mAngle * i);
+		}
+	}
+
+	return &mTable [0];
+}
+
+/*
+==================
+Blits a bounding line
+==================
+*/
+ void OpenGLRender::blitGridLine (int pPosX1, int pPosY1, int pPosX2, int pPosY2,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA)
+{	
+	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
+
+	// Filling pixels, with the actual transform
+	PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+    fillPixel (&mPixels[0], _modelToWorld, static_cast<float>(pPosX1), static_cast<float>(pPosY1), r, g, b, a);
+    fillPixel (&mPixels[1], _modelToWorld, static_cast<float>(pPosX2), static_cast<float>(pPosY2), r, g, b, a);
+}
+
 /*
 ==================
 Blits quad of the grid of an IND_Surface
@@ -467,41 +414,17 @@ Blits a bounding circle area
 void OpenGLRender::blitCollisionCircle(int pPosX, int pPosY, int pRadius, float pScale,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pIndWorldMatrix) {
 	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
 
-	// Filling pixels
-	float x (0.0f);
-	float y (0.0f);
-	int points (SIDES_PER_CIRCLE + 1);
-	assert(0 != points);
-	float angle (2*PI / SIDES_PER_CIRCLE);
-	for (int i = 0; i <= points ; i++) {
-		x = pPosX + (pRadius * cosf(angle*i));
-		y = pPosY + (pRadius * sinf(angle*i));
-		fillPixel (&_pixels[i], x, y, r, g, b, a);
-	}
-    
-	//Render primitive - No textures
-	setGLClientStateToPrimitive();
-    
-	//Transform
-	setTransform2d(pIndWorldMatrix);
-
-	// Color settings
-    setRainbow2d (IND_OPAQUE, 1, 0, 0, IND_FILTER_POINT, pR, pG, pB, pA, 0, 0, 0, 255, 0, 0);
+	const float *mTable = getCircleTable(SIDES_PER_CIRCLE);
 
-	//Polygon blitting
-	glVertexPointer(3, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._x);
-	glColorPointer(4, GL_FLOAT, sizeof(PIXEL), &_pixels[0]._colorR);
-	glDrawArrays(GL_LINE_STRIP, 0, points);
+	//LOOP - One line per side, with the supplied transform
+	for (int i = 0; i < SIDES_PER_CIRCLE; i++) {
+		const float *mFrom = &mTable [i * 2];
+		const float *mTo = &mTable [((i + 1) % SIDES_PER_CIRCLE) * 2];
 
-#ifdef _DEBUG
-    GLenum glerror = glGetError();
-	if (glerror) {
-		g_debug->header("OpenGL error in circle blitting ", DebugApi::LogHeaderError);
-	}
-#endif
-
-    //Reenable texturing
-	setGLClientStateToTexturing();
+		PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+		fillPixel (&mPixels[0], pIndWorldMatrix, pPosX + pRadius * mFrom [0], pPosY + pRadius * mFrom [1], r, g, b, a);
+		fillPixel (&mPixels[1], pIndWorldMatrix, pPosX + pRadius * mTo [0], pPosY + pRadius * mTo [1], r, g, b, a);
+	}//LOOP END
 }
 
 
@@ -511,11 +434,12 @@ Blits a bounding line
 ==================
 */
 void OpenGLRender::blitCollisionLine(int pPosX1, int pPosY1, int pPosX2, int pPosY2,  unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA, IND_Matrix pIndWorldMatrix) {
+	float r(static_cast<float>(pR) / 255.0f), g(static_cast<float>(pG) / 255.0f), b(static_cast<float>(pB) / 255.0f), a(static_cast<float>(pA) / 255.0f);
 
-	//Transform with supplied matrix
-	setTransform2d(pIndWorldMatrix);
-	//Blit the line 
-	blitGridLine (pPosX1, pPosY1, pPosX2, pPosY2,  pR, pG, pB, pA);
+	//Blit the line, with the supplied transform
+	PIXEL *mPixels = addPrimitive2d(GL_LINES, 2, pA);
+    fillPixel (&mPixels[0], pIndWorldMatrix, static_cast<float>(pPosX1), static_cast<float>(pPosY1), r, g, b, a);
+    fillPixel (&mPixels[1], pIndWorldMatrix, static_cast<float>(pPosX2), static_cast<float>(pPosY2), r, g, b, a);
 }
 
 /** @endcond */
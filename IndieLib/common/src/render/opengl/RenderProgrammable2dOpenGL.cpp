@@ -0,0 +1,420 @@
+/*****************************************************************************************
+ * File: RenderProgrammable2dOpenGL.cpp
+ * Desc: Blitting of 2d objects using shaders and vertex buffers (OpenGL 3.3)
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "Defines.h"
+
+#ifdef INDIERENDER_OPENGL
+
+// ----- Includes -----
+
+#include <stddef.h>
+#include <string.h>
+#include "Global.h"
+#include "OpenGLRender.h"
+#include "IND_ShaderManager.h"
+#include "IND_ShaderProgram.h"
+#include "IND_UniformBuffer.h"
+#include "IND_Shaders.h"
+
+/** @cond DOCUMENT_PRIVATEAPI */
+
+// --------------------------------------------------------------------------------
+//							         Public methods
+// --------------------------------------------------------------------------------
+
+bool OpenGLRender::setProgrammable2d(bool pProgrammable) {
+	flushBatch2d();
+
+	if (pProgrammable && !createProgrammable2d())
+		pProgrammable = false;
+
+	_programmable2d = pProgrammable;
+	_matricesDirty = true;
+
+	//The programmable renderer doesn't use any fixed state: the alpha test is done in the fragment shader,
+	//and the matrix stack isn't kept, so it is loaded again for the fixed pipeline
+	if (_programmable2d)
+		glDisable(GL_ALPHA_TEST);
+	else
+		loadModelView2d();
+
+	return _programmable2d;
+}
+
+bool OpenGLRender::setDistanceField2d(bool pDistanceField) {
+	if (pDistanceField == _distanceField)
+		return _distanceField;
+
+	//The programmable renderer needs the program of the distance fields
+	if (pDistanceField && _programmable2d && !_distanceFieldProgram)
+		return false;
+
+	_distanceField = pDistanceField;
+	return _distanceField;
+}
+
+void OpenGLRender::setDistanceFieldOutline2d(float pWidth, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA) {
+	float mColor [4] = {pR / 255.0f, pG / 255.0f, pB / 255.0f, pA / 255.0f};
+	if (pWidth == _dfOutlineWidth && !memcmp(mColor, _dfOutlineColor, sizeof(mColor)))
+		return;
+
+	//The quads already in the batch keep their outline
+	if (_batchDistanceField)
+		flushBatch2d();
+
+	_dfOutlineWidth = pWidth;
+	memcpy(_dfOutlineColor, mColor, sizeof(mColor));
+}
+
+void OpenGLRender::setDistanceFieldShadow2d(float pOffsetX, float pOffsetY, unsigned char pR, unsigned char pG, unsigned char pB, unsigned char pA) {
+	float mOffset [2] = {pOffsetX, pOffsetY};
+	float mColor [4] = {pR / 255.0f, pG / 255.0f, pB / 255.0f, pA / 255.0f};
+	if (!memcmp(mOffset, _dfShadowOffset, sizeof(mOffset)) && !memcmp(mColor, _dfShadowColor, sizeof(mColor)))
+		return;
+
+	//The quads already in the batch keep their shadow
+	if (_batchDistanceField)
+		flushBatch2d();
+
+	memcpy(_dfShadowOffset, mOffset, sizeof(mOffset));
+	memcpy(_dfShadowColor, mColor, sizeof(mColor));
+}
+
+// --------------------------------------------------------------------------------
+//							       Private methods
+// --------------------------------------------------------------------------------
+
+/*
+==================
+Draws a quad (triangle strip of 4 vertices, in the space of the actual transform). With the fixed pipeline
+it is drawn at once. With the programmable renderer it is added to the batch, in world coordinates and with
+the color set by setRainbow2d, and the batch is drawn first if it uses another texture or sampler state, or
+it isn't a distance field when the quad is (or the other way).
+==================
+*/
+void OpenGLRender::drawQuad2d(GLuint pTexture, GLint pWrap, CUSTOMVERTEX2D *pQuad) {
+	if (!_programmable2d) {
+		glBindTexture(GL_TEXTURE_2D, pTexture);
+
+		//Set texture params requested before (via rainbow2d API)
+		setGLBoundTextureParams();
+
+		//Override wrapping for texture
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, pWrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, pWrap);
+
+		//Distance fields are cut at the edge (the opaque pass already tests the alpha). The test sees the
+		//distance modulated by the alpha of the color, so the edge is scaled the same way.
+		bool mAlphaTest = _distanceField && !_opaquePass;
+		if (mAlphaTest) {
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GEQUAL, 0.5f * _batchColor [3] / 255.0f);
+		}
+
+		glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pQuad[0]._pos._x);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pQuad[0]._texCoord._u);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		if (mAlphaTest)
+			glDisable(GL_ALPHA_TEST);
+		return;
+	}
+
+	if (_batchNumVertices) {
+		if (pTexture != _batchTexture ||
+		    _distanceField != _batchDistanceField ||
+		    pWrap != _batchSampler.wrapS ||
+		    _tex2dState.minFilter != _batchSampler.minFilter ||
+		    _tex2dState.magFilter != _batchSampler.magFilter ||
+		    _batchNumVertices + 6 > MAX_BATCH_VERTICES)
+			flushBatch2d();
+	}
+
+	_batchTexture = pTexture;
+	_batchDistanceField = _distanceField;
+	_batchSampler.minFilter = _tex2dState.minFilter;
+	_batchSampler.magFilter = _tex2dState.magFilter;
+	_batchSampler.wrapS = pWrap;
+	_batchSampler.wrapT = pWrap;
+
+	//The strip is split in two triangles, with the same winding
+	static const int mStrip [6] = {0, 1, 2, 2, 1, 3};
+
+	IND_Vector3 mWorld [4];
+	for (int i = 0; i < 4; i++) {
+		mWorld [i] = IND_Vector3(pQuad [i]._pos._x, pQuad [i]._pos._y, pQuad [i]._pos._z);
+		_math.transformVector3DbyMatrix4D(mWorld [i], _modelToWorld);
+	}
+
+	for (int i = 0; i < 6; i++) {
+		BATCHVERTEX2D *mVertex = &_batchVertices [_batchNumVertices++];
+		const IND_Vector3 &mPos = mWorld [mStrip [i]];
+		mVertex->_x = mPos._x;
+		mVertex->_y = mPos._y;
+		mVertex->_z = mPos._z;
+		mVertex->_u = pQuad [mStrip [i]]._texCoord._u;
+		mVertex->_v = pQuad [mStrip [i]]._texCoord._v;
+		for (int j = 0; j < 4; j++)
+			mVertex->_color [j] = _batchColor [j];
+	}
+}
+
+/*
+==================
+Moves the actual transform (an offset inside the blitted object)
+==================
+*/
+void OpenGLRender::translate2d(float pX, float pY) {
+	IND_Matrix mTrans;
+	_math.matrix4DSetTranslation(mTrans, pX, pY, 0.0f);
+	_math.matrix4DMultiplyInPlace(_modelToWorld, mTrans);
+
+	if (!_programmable2d)
+		glTranslatef(pX, pY, 0.0f);
+}
+
+/*
+==================
+Draws the quads of the batch. The GL state (blending, culling, depth) is the one set when they were added:
+every change of that state draws the batch first.
+==================
+*/
+void OpenGLRender::flushBatch2d() {
+	//The batch of primitives too (only one of them has vertices, adding to one draws the other)
+	flushPrimitives2d();
+
+	if (!_batchNumVertices)
+		return;
+
+	IND_ShaderProgram *mProgram = _batchDistanceField ? _distanceFieldProgram : _batchProgram;
+	mProgram->use();
+	glBindVertexArray(_batchVertexArray);
+
+	//Camera and projection, only when they change
+	if (_matricesDirty) {
+		float mMatrices [32];
+		_cameraMatrix.arrayRepresentation(mMatrices);
+		_projectionMatrix.arrayRepresentation(mMatrices + 16);
+		_matricesBuffer->setData(mMatrices, 0, sizeof(mMatrices));
+		_matricesDirty = false;
+	}
+
+	//The opaque pass only draws the fully opaque pixels (as the alpha test)
+	if (_batchDistanceField) {
+		_dfAlphaRefUniform->setFloat(_opaquePass ? 1.0f : 0.0f);
+		_dfOutlineWidthUniform->setFloat(_dfOutlineWidth);
+		_dfOutlineColorUniform->setFloatVector(_dfOutlineColor);
+		_dfShadowOffsetUniform->setFloatVector(_dfShadowOffset);
+		_dfShadowColorUniform->setFloatVector(_dfShadowColor);
+	} else {
+		_alphaRefUniform->setFloat(_opaquePass ? 1.0f : 0.0f);
+	}
+
+	//The buffer is orphaned, so the driver doesn't wait for the previous batch to be drawn
+	glBindBuffer(GL_ARRAY_BUFFER, _batchVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(_batchVertices), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(BATCHVERTEX2D) * _batchNumVertices, _batchVertices);
+
+	glBindTexture(GL_TEXTURE_2D, _batchTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _batchSampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _batchSampler.magFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _batchSampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _batchSampler.wrapT);
+
+	glDrawArrays(GL_TRIANGLES, 0, _batchNumVertices);
+
+#ifdef _DEBUG
+	GLenum glerror = glGetError();
+	if (glerror) {
+		g_debug->header("OpenGL error in batch blitting ", DebugApi::LogHeaderError);
+	}
+#endif
+
+	//The fixed pipeline draws from client arrays
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	_batchNumVertices = 0;
+}
+
+/*
+==================
+Creates the program, the vertex array and the buffers of the programmable 2d renderer
+==================
+*/
+bool OpenGLRender::createProgrammable2d() {
+	if (_batchProgram)
+		return true;
+
+	if (!GLEW_VERSION_3_3) {
+		g_debug->header("The programmable 2d renderer needs OpenGL 3.3", DebugApi::LogHeaderWarning);
+		return false;
+	}
+
+	g_debug->header("Creating programmable 2d renderer", DebugApi::LogHeaderBegin);
+
+	_shaderManager = new IND_ShaderManager();
+	_shaderManager->init();
+
+	IND_ShaderProgram *mProgram = createBatchProgram2d(IND_FragmentShader_Batched2DTexture, IND_Program_Batched2DTexture);
+	if (!mProgram) {
+		freeProgrammable2d();
+		g_debug->header("Programmable 2d renderer not created", DebugApi::LogHeaderError);
+		return false;
+	}
+
+	GLint mPosition = mProgram->getPositionForVertexAttribute(IND_VertexAttribute_Position);
+	GLint mTexCoord = mProgram->getPositionForVertexAttribute(IND_VertexAttribute_TexCoord);
+	GLint mColor = mProgram->getPositionForVertexAttribute(IND_VertexAttribute_RGBAColor);
+	_alphaRefUniform = mProgram->getUniform(IND_Uniform_AlphaReference);
+	if (mPosition < 0 || mTexCoord < 0 || mColor < 0 || !_alphaRefUniform) {
+		freeProgrammable2d();
+		g_debug->header("Programmable 2d renderer not created", DebugApi::LogHeaderError);
+		return false;
+	}
+
+	//Distance fields (the renderer works without them). The vertex shader is the same, with the
+	//same attribute locations, so they use the same vertex array.
+	_distanceFieldProgram = createBatchProgram2d(IND_FragmentShader_Batched2DDistanceField, IND_Program_Batched2DDistanceField);
+	if (_distanceFieldProgram) {
+		_dfAlphaRefUniform = _distanceFieldProgram->getUniform(IND_Uniform_AlphaReference);
+		_dfOutlineWidthUniform = _distanceFieldProgram->getUniform(IND_Uniform_OutlineWidth);
+		_dfOutlineColorUniform = _distanceFieldProgram->getUniform(IND_Uniform_OutlineColor);
+		_dfShadowOffsetUniform = _distanceFieldProgram->getUniform(IND_Uniform_ShadowOffset);
+		_dfShadowColorUniform = _distanceFieldProgram->getUniform(IND_Uniform_ShadowColor);
+		if (!_dfAlphaRefUniform || !_dfOutlineWidthUniform || !_dfOutlineColorUniform ||
+		    !_dfShadowOffsetUniform || !_dfShadowColorUniform)
+			_distanceFieldProgram = NULL;
+	}
+	if (!_distanceFieldProgram) {
+		g_debug->header("Distance fields are drawn with the alpha test", DebugApi::LogHeaderWarning);
+		_distanceField = false;
+	}
+
+	//Camera and projection, shared by all the programs that declare the block
+	_matricesBuffer = IND_UniformBuffer::newUniformBuffer();
+	if (!_matricesBuffer->create(sizeof(float) * 32, MATRICES_2D_BINDING)) {
+		freeProgrammable2d();
+		g_debug->header("Programmable 2d renderer not created", DebugApi::LogHeaderError);
+		return false;
+	}
+
+	//Vertex layout
+	glGenVertexArrays(1, &_batchVertexArray);
+	glBindVertexArray(_batchVertexArray);
+	glGenBuffers(1, &_batchVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, _batchVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(_batchVertices), NULL, GL_STREAM_DRAW);
+	glEnableVertexAttribArray(mPosition);
+	glVertexAttribPointer(mPosition, 3, GL_FLOAT, GL_FALSE, sizeof(BATCHVERTEX2D), reinterpret_cast<GLvoid *>(offsetof(BATCHVERTEX2D, _x)));
+	glEnableVertexAttribArray(mTexCoord);
+	glVertexAttribPointer(mTexCoord, 2, GL_FLOAT, GL_FALSE, sizeof(BATCHVERTEX2D), reinterpret_cast<GLvoid *>(offsetof(BATCHVERTEX2D, _u)));
+	glEnableVertexAttribArray(mColor);
+	glVertexAttribPointer(mColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BATCHVERTEX2D), reinterpret_cast<GLvoid *>(offsetof(BATCHVERTEX2D, _color)));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	_batchProgram = mProgram;
+	_batchNumVertices = 0;
+	_matricesDirty = true;
+
+	g_debug->header("Programmable 2d renderer created", DebugApi::LogHeaderEnd);
+	return true;
+}
+
+/*
+==================
+Compiles and links a program of the batches: the batched vertex shader with a fragment shader, the uniform
+block of the camera and the sprites drawn from the first texture unit. The program is added to the manager.
+==================
+*/
+IND_ShaderProgram *OpenGLRender::createBatchProgram2d(const char *pFragmentShader, const char *pName) {
+	IND_ShaderProgram *mProgram = IND_ShaderProgram::newShaderProgram();
+	if (!_programBinaryCache.empty()) {
+		std::string mDriver = std::string(_info._vendor) + "|" + _info._renderer + "|" + _info._version;
+		mProgram->setBinaryCache(_programBinaryCache.c_str(), mDriver.c_str());
+	}
+	if (!mProgram->compile(IND_VertexShader_Batched2DTexture, pFragmentShader) ||
+	    !mProgram->link() ||
+	    !mProgram->bindUniformBlock(IND_UniformBlock_Matrices2d, MATRICES_2D_BINDING)) {
+		mProgram->destroy();
+		return NULL;
+	}
+
+	IND_GLSLShaderUniform *mTexture = mProgram->getUniform(IND_Uniform_SpriteTexture);
+	if (!mTexture) {
+		mProgram->destroy();
+		return NULL;
+	}
+	_shaderManager->add(mProgram, pName);
+
+	//Sprites are always drawn from the first texture unit
+	mProgram->use();
+	mTexture->setInt(0);
+	glUseProgram(0);
+
+	return mProgram;
+}
+
+/*
+==================
+Frees the program and the buffers of the programmable 2d renderer
+==================
+*/
+void OpenGLRender::freeProgrammable2d() {
+	if (_batchVertexArray)
+		glDeleteVertexArrays(1, &_batchVertexArray);
+	if (_batchVertexBuffer)
+		glDeleteBuffers(1, &_batchVertexBuffer);
+	DISPOSEMANAGED(_matricesBuffer);
+
+	//The programs (and their uniforms) are owned by the manager
+	DISPOSE(_shaderManager);
+
+	_batchProgram = NULL;
+	_alphaRefUniform = NULL;
+	_distanceFieldProgram = NULL;
+	_dfAlphaRefUniform = NULL;
+	_dfOutlineWidthUniform = NULL;
+	_dfOutlineColorUniform = NULL;
+	_dfShadowOffsetUniform = NULL;
+	_dfShadowColorUniform = NULL;
+	_batchDistanceField = false;
+	_batchVertexArray = 0;
+	_batchVertexBuffer = 0;
+	_batchNumVertices = 0;
+	_programmable2d = false;
+}
+
+/** @endcond */
+
+#endif //INDIERENDER_OPENGL
@@ -40,6 +40,7 @@
 #include "IND_SurfaceManager.h"
 #include "IND_Font.h"
 #include "IND_Surface.h"
+#include "TextureDefinitions.h"
 
 /** @cond DOCUMENT_PRIVATEAPI */
 
@@ -69,28 +70,29 @@ void OpenGLRender::blitText(IND_Font *pFo,
                             IND_Align pAlign) {
 	// ----- Transform -----
 	bool correctParams = true;
-	if(!pFo->getSurface()) {
+	if(!pFo->getSurface() || !pText) {
 		correctParams = false;
 	}
 
 	if (correctParams) {
+		// The text is drawn with the fixed pipeline
+		bool mProgrammable = _programmable2d;
+		flushBatch2d();
+		_programmable2d = false;
+
 		setTransform2d(pX, pY, 0, 0, 0, pScaleX, pScaleY, 0, 0, 0, 0, pFo->getSurface()->getWidthBlock(), pFo->getSurface()->getHeightBlock(), 0);
 		setRainbow2d(pFo->getSurface()->getTypeInt(), 1, 0, 0, pLinearFilter, pR, pG, pB, pA, pFadeR, pFadeG, pFadeB, pFadeA, pSo, pDs);
 
+		// The mesh of the entity, or the one of the texts blitted directly
+		TextMesh *mMesh = _entityTextMesh ? _entityTextMesh : &_textMesh;
+		if (!mMesh->isValid(pFo, pText, pAlign, pOffset, pLineSpacing, pScaleX, pScaleY)) {
+			buildTextMesh(mMesh, pFo, pText, pAlign, pOffset, pScaleX, pScaleY, pLineSpacing);
+			mMesh->setKey(pFo, pText, pAlign, pOffset, pLineSpacing, pScaleX, pScaleY);
+		}
 
-        switch (pFo->getFontType()) {
-            case IND_Font::FONTTYPE_AngelCode:
-                blitCharsAngelCodeFont(pFo, pText, pAlign, pOffset, pScaleX, pScaleY, pLineSpacing);
-                break;
-
-            case IND_Font::FONTTYPE_MudFont:
-                 blitCharsMudFont(pFo, pText, pAlign, pOffset, pScaleX, pScaleY, pLineSpacing);
-                break;
-                
-            default:
-                break;
-        }
+		blitTextMesh(mMesh, pFo->getSurface());
 
+		_programmable2d = mProgrammable;
 	}
 }
 
@@ -99,221 +101,195 @@ void OpenGLRender::blitText(IND_Font *pFo,
 //							         Private methods
 // --------------------------------------------------------------------------------
 
-void OpenGLRender::blitCharsAngelCodeFont(IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing) {
-    
-    // ----- Drawing text   -----
-    
-    unsigned char mChar1;
-    unsigned char mChar2;
-    int mCont1 = 0;
-    int mCont2 = 0;
-    int mTranslationX = 0;
-    int mTranslationY = 0;
-    bool mErrorChar;    // Char that doesn't exist
-    int mSentencePos;
-    int mLongActualSentence;
-    GLfloat mLineTransform[16];  //Maintains a transform inside the entity coord system
-    GLfloat mEntityTransform[16]; //Maintains transform for the whole entity coord system
-    mCont1 = 0;
-    mChar1 = pText [mCont1++];
-    
-    //Store entity transform
-    glGetFloatv(GL_MODELVIEW_MATRIX,mEntityTransform);
-    
-    
-    //LOOP - Blit character by character
-    while (mChar1 != 0) {
-        // If it's a new line or it's the first line
-        if (mChar1 == '\n' || mCont1 == 1) {
-            // First line
-            if (mCont1 == 1) {
-                mSentencePos = 0;
-				//Any other line
-            } else {
-                mSentencePos = mCont1;
-            }
-            
-            // Set the alignment
-            switch (pAlign) {
-                case IND_CENTER: {
-                    mLongActualSentence = static_cast<int>(getLongInPixels(pFo, pText, mSentencePos, pOffset) * pScaleX);
-                    mTranslationX = (int)(mLongActualSentence / 2);
-                    break;
-                }
-                    
-                case IND_RIGHT: {
-                    mLongActualSentence = static_cast<int>(getLongInPixels(pFo, pText, mSentencePos, pOffset) * pScaleX);
-                    mTranslationX = (int)(mLongActualSentence);
-                    
-                    break;
-                }
-                    
-                case IND_LEFT: {
-                    break;
-                }
-            }
-            
-            //Load line transform matrix taking into account entity transform
-            //This effectively resets transform to first character in the new line
-            IND_Matrix transform;
-            _math.matrix4DSetTranslation(transform, static_cast<float>(-mTranslationX), static_cast<float>(mTranslationY), 0.0f);
-            transform.arrayRepresentation(mLineTransform);
-            glLoadMatrixf(mEntityTransform);
-            glMultMatrixf(mLineTransform);
-            mTranslationY += static_cast<int>((pLineSpacing * pScaleY));
-        } //Was first new line or first line
-        
-        // It's a normal character
-        if (mChar1 != '\n') {
-            
-            mErrorChar = 0;
-            mCont2 = 0;
-            mChar2 = pFo->getLetters() [mCont2++]._letter;
-            
-            // Seek its location in the bitmap
-            while (mChar2 != mChar1 && mCont2 < pFo->getNumChars()) {
-                mChar2 = pFo->getLetters() [mCont2++]._letter;
-            }
-            if (mCont2  ==  pFo->getNumChars())
-                mErrorChar = 1;
-            
-            mCont2--;
-            if (!mErrorChar) {
-                
-                // To avoid that Y displacement transform accumulates for every character in the line,
-                // save the untranslated coordinate system.
-                glPushMatrix();
-                
-                float charTranslateY = static_cast<float>(pFo->getLetters()[mCont2]._yOffset);
-                glTranslatef(0.0f, charTranslateY ,0.0f);
-
-                //#warning lookout
-                //mvTransformPresetState();  //Need to preset transform state, as the blit operation will reset the state!!!!
-                blitRegionSurface(pFo->getSurface(),
-                                  pFo->getLetters() [mCont2]._x,
-                                  pFo->getLetters() [mCont2]._y,
-                                  pFo->getLetters() [mCont2]._width,
-                                  pFo->getLetters() [mCont2]._height);
-                
-                // Restore the untranslated coordinate system.
-                glPopMatrix();
-            }
-            
-            //X displacement of the character.
-            //X displacement transform accumulates for every character in the line
-            float charTranslateX = ((pFo->getLetters() [mCont2]._width) + pOffset) * pScaleX;
-            glTranslatef(charTranslateX,0.0f,0.0f);
-        }//Was normal character
-        
-        // Advance one character
-        mChar1 = pText [mCont1++];
-    }//LOOP END - Blit character by character
-    
+/*
+==================
+Builds the quads of the characters of a text. Each line starts at the left (IND_LEFT), the center (IND_CENTER)
+or the right (IND_RIGHT) of the text, and the lines are pLineSpacing * pScaleY apart. The characters that the
+font doesn't have are skipped.
+==================
+*/
+void OpenGLRender::buildTextMesh(TextMesh *pMesh, IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing) {
+	pMesh->_vertices.clear();
+	pMesh->_indices.clear();
+
+	IND_Surface *mSu = pFo->getSurface();
+	bool mAngelCode = (IND_Font::FONTTYPE_AngelCode == pFo->getFontType());
+	int mTranslationY = 0;
+	int mCont = 0;
+
+	//LOOP - Lines
+	while (true) {
+		// Set the alignment
+		int mTranslationX = 0;
+		switch (pAlign) {
+			case IND_CENTER: {
+				int mLongActualSentence = static_cast<int>(getLongInPixels(pFo, pText, mCont, pOffset) * pScaleX);
+				mTranslationX = (int)(mLongActualSentence / 2);
+				break;
+			}
+
+			case IND_RIGHT: {
+				mTranslationX = static_cast<int>(getLongInPixels(pFo, pText, mCont, pOffset) * pScaleX);
+				break;
+			}
+
+			case IND_LEFT: {
+				break;
+			}
+		}
+
+		float mPenX = static_cast<float>(-mTranslationX);
+		float mPenY = static_cast<float>(mTranslationY);
+		mTranslationY += static_cast<int>((pLineSpacing * pScaleY));
+
+		//LOOP - Characters of the line
+		for (; pText [mCont] != '\0' && pText [mCont] != '\n'; mCont++) {
+			IND_Font::LETTER *mLetter = pFo->getLetter(static_cast<unsigned char>(pText [mCont]));
+			if (!mLetter)
+				continue;
+
+			// AngelCode letters have their own vertical offset, MudFont letters have a 1 pixel border
+			if (mAngelCode) {
+				addTextQuad(pMesh, mSu, mLetter->_x, mLetter->_y, mLetter->_width, mLetter->_height,
+				            mPenX, mPenY + static_cast<float>(mLetter->_yOffset));
+			} else {
+				addTextQuad(pMesh, mSu, mLetter->_x + 1, mLetter->_y + 1, mLetter->_width - 1, mLetter->_height - 1,
+				            mPenX, mPenY);
+			}
+
+			//X displacement of the character
+			mPenX += ((mLetter->_width) + pOffset) * pScaleX;
+		}//LOOP END - Characters of the line
+
+		if (pText [mCont] == '\0')
+			break;
+
+		// Skip the '\n'
+		mCont++;
+	}//LOOP END - Lines
 }
 
+/*
+==================
+Adds the quad of a region of the font bitmap (as blitRegionSurface() draws it) at pDrawX, pDrawY
+==================
+*/
+void OpenGLRender::addTextQuad(TextMesh *pMesh, IND_Surface *pSu, int pX, int pY, int pWidth, int pHeight, float pDrawX, float pDrawY) {
+	if (pSu->getNumTextures() > 1 ||
+		pX < 0 || pX + pWidth > pSu->getWidth() ||
+		pY < 0 || pY + pHeight > pSu->getHeight())
+		return;
+
+	// Trimmed surface, only the part of the region kept in the texture is drawn
+	if (pSu->isTrimmed()) {
+		int mDrawX, mDrawY;
+		if (!pSu->clipRegion(&pX, &pY, &pWidth, &pHeight, &mDrawX, &mDrawY))
+			return;
+		pDrawX += static_cast<float>(mDrawX);
+		pDrawY += static_cast<float>(mDrawY);
+	}
+
+	float x (static_cast<float>(pX));
+	float y (static_cast<float>(pY));
+	float height (static_cast<float>(pHeight));
+	float width (static_cast<float>(pWidth));
+	float bWidth (static_cast<float>(pSu->getWidthBlock()));
+	float bHeight (static_cast<float>(pSu->getHeightBlock()));
+	float spareY (static_cast<float>(pSu->getSpareY()));
+
+	unsigned int mFirst = static_cast<unsigned int>(pMesh->_vertices.size());
+	pMesh->_vertices.resize(mFirst + 4);
+	CUSTOMVERTEX2D *mQuad = &pMesh->_vertices [mFirst];
+	fillVertex2d(&mQuad [0], pDrawX + width, pDrawY, ((x + width) / bWidth), (1.0f - ((y + spareY) / bHeight)));
+	fillVertex2d(&mQuad [1], pDrawX + width, pDrawY + height, (x + width) / bWidth, (1.0f - ((y + height + spareY) / bHeight)));
+	fillVertex2d(&mQuad [2], pDrawX, pDrawY, (x/bWidth), (1.0f - ((y+ spareY) / bHeight)));
+	fillVertex2d(&mQuad [3], pDrawX, pDrawY + height, (x/bWidth), (1.0f - (y + height + spareY) / bHeight));
 
-void OpenGLRender::blitCharsMudFont(IND_Font *pFo, char *pText, IND_Align pAlign, int pOffset, float pScaleX, float pScaleY, int pLineSpacing) {
-    
-    // ----- Drawing text   -----
-    
-    unsigned char mChar1;
-    unsigned char mChar2;
-    int mCont1 = 0;
-    int mCont2 = 0;
-    int mTranslationX = 0;
-    int mTranslationY = 0;
-    bool mErrorChar;    // Char that doesn't exist
-    int mSentencePos;
-    int mLongActualSentence;
-    GLfloat mLineTransform[16];  //Maintains a transform inside the entity coord system
-    GLfloat mEntityTransform[16]; //Maintains transform for the whole entity coord system
-    mCont1 = 0;
-    mChar1 = pText [mCont1++];
-    
-    //Store entity transform
-    glGetFloatv(GL_MODELVIEW_MATRIX,mEntityTransform);
-    
-    
-    //LOOP - Blit character by character
-    while (mChar1 != 0) {
-        // If it's a new line or it's the first line
-        if (mChar1 == '\n' || mCont1 == 1) {
-            // First line
-            if (mCont1 == 1) {
-                mSentencePos = 0;
-				//Any other line
-            } else {
-                mSentencePos = mCont1;
-            }
-            
-            // Set the alignment
-            switch (pAlign) {
-                case IND_CENTER: {
-                    mLongActualSentence = static_cast<int>(getLongInPixels(pFo, pText, mSentencePos, pOffset) * pScaleX);
-                    mTranslationX = (int)(mLongActualSentence / 2);
-                    break;
-                }
-                    
-                case IND_RIGHT: {
-                    mLongActualSentence = static_cast<int>(getLongInPixels(pFo, pText, mSentencePos, pOffset) * pScaleX);
-                    mTranslationX = (int)(mLongActualSentence);
-                    
-                    break;
-                }
-                    
-                case IND_LEFT: {
-                    break;
-                }
-            }
-            
-            //Load line transform matrix taking into account entity transform
-            //This effectively resets transform to first character in the new line
-            IND_Matrix transform;
-            _math.matrix4DSetTranslation(transform, static_cast<float>(-mTranslationX), static_cast<float>(mTranslationY), 0.0f);
-            transform.arrayRepresentation(mLineTransform);
-            glLoadMatrixf(mEntityTransform);
-            glMultMatrixf(mLineTransform);
-            mTranslationY += static_cast<int>((pLineSpacing * pScaleY));
-        } //Was first new line or first line
-        
-        // It's a normal character
-        if (mChar1 != '\n') {
-            
-            mErrorChar = 0;
-            mCont2 = 0;
-            mChar2 = pFo->getLetters() [mCont2++]._letter;
-            
-            // Seek its location in the bitmap
-            while (mChar2 != mChar1 && mCont2 < pFo->getNumChars()) {
-                mChar2 = pFo->getLetters() [mCont2++]._letter;
-            }
-            if (mCont2  ==  pFo->getNumChars())
-                mErrorChar = 1;
-            
-            mCont2--;
-            if (!mErrorChar) {
-                //#warning lookout
-                //mvTransformPresetState();  //Need to preset transform state, as the blit operation will reset the state!!!!
-                blitRegionSurface(pFo->getSurface(),
-                                  pFo->getLetters() [mCont2]._x + 1,
-                                  pFo->getLetters() [mCont2]._y + 1,
-                                  pFo->getLetters() [mCont2]._width - 1,
-                                  pFo->getLetters() [mCont2]._height - 1);
-            }
-            
-            //Displacement of the character.
-            //Displacement transform accumulates for every character in the line
-            float charTranslateX = ((pFo->getLetters() [mCont2]._width) + pOffset) * pScaleX;
-            glTranslatef(charTranslateX,0.0f,0.0f);
-        }//Was normal character
-        
-        // Advance one character
-        mChar1 = pText [mCont1++];
-    }//LOOP END - Blit character by character
+	//The strip is split in two triangles, with the same winding
+	static const unsigned int mStrip [6] = {0, 1, 2, 2, 1, 3};
+	for (int i = 0; i < 6; i++)
+		pMesh->_indices.push_back(mFirst + mStrip [i]);
 
+	// Bounding rectangle
+	if (!mFirst) {
+		pMesh->_min [0] = pDrawX;
+		pMesh->_min [1] = pDrawY;
+		pMesh->_max [0] = pDrawX + width;
+		pMesh->_max [1] = pDrawY + height;
+	} else {
+		if (pDrawX < pMesh->_min [0]) pMesh->_min [0] = pDrawX;
+		if (pDrawY < pMesh->_min [1]) pMesh->_min [1] = pDrawY;
+		if (pDrawX + width > pMesh->_max [0]) pMesh->_max [0] = pDrawX + width;
+		if (pDrawY + height > pMesh->_max [1]) pMesh->_max [1] = pDrawY + height;
+	}
 }
 
+/*
+==================
+Draws all the quads of a text mesh at once, with the actual transform
+==================
+*/
+void OpenGLRender::blitTextMesh(TextMesh *pMesh, IND_Surface *pSu) {
+	if (pMesh->_indices.empty())
+		return;
+
+	//Get the bounds in world coords, to perform frustrum culling test in world coords
+	IND_Vector3 mP1, mP2, mP3, mP4;
+	transformVerticesToWorld(pMesh->_min [0], pMesh->_min [1],
+	                         pMesh->_max [0], pMesh->_min [1],
+	                         pMesh->_min [0], pMesh->_max [1],
+	                         pMesh->_max [0], pMesh->_max [1],
+	                         &mP1, &mP2, &mP3, &mP4);
+	_math.calculateBoundingRectangle(&mP1, &mP2, &mP3, &mP4);
+
+	//Discard bounding rectangle using frustum culling if possible
+	if (!_math.cullFrustumBox(mP1, mP2, _frustrumPlanes)) {
+		_numDiscardedObjects++;
+		return;
+	}
+
+	if (_programmable2d) {
+		//Added to the batch, transformed with the actual transform (the matrix stack isn't used)
+		for (size_t i = 0; i < pMesh->_vertices.size(); i += 4)
+			drawQuad2d(pSu->_surface->_texturesArray[0], GL_CLAMP_TO_EDGE, &pMesh->_vertices [i]);
+	} else {
+		glBindTexture(GL_TEXTURE_2D, pSu->_surface->_texturesArray[0]);
 
+		//Set texture params requested before (via rainbow2d API)
+		setGLBoundTextureParams();
+
+		//CLAMP for texture
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glVertexPointer(3, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pMesh->_vertices [0]._pos._x);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(CUSTOMVERTEX2D), &pMesh->_vertices [0]._texCoord._u);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(pMesh->_indices.size()), GL_UNSIGNED_INT, &pMesh->_indices [0]);
+
+#ifdef _DEBUG
+		GLenum glerror = glGetError();
+		if (glerror) {
+			g_debug->header("OpenGL error in text blitting ", DebugApi::LogHeaderError);
+		}
+#endif
+	}
+
+	_numrenderedObjects++;
+
+	//The pixels of each character
+	if (_fillStats) {
+		for (size_t i = 0; i < pMesh->_vertices.size(); i += 4) {
+			CUSTOMVERTEX2D *mQuad = &pMesh->_vertices [i];
+			transformVerticesToWorld(mQuad [0]._pos._x, mQuad [0]._pos._y,
+			                         mQuad [1]._pos._x, mQuad [1]._pos._y,
+			                         mQuad [2]._pos._x, mQuad [2]._pos._y,
+			                         mQuad [3]._pos._x, mQuad [3]._pos._y,
+			                         &mP1, &mP2, &mP3, &mP4);
+			_math.calculateBoundingRectangle(&mP1, &mP2, &mP3, &mP4);
+			addFill(mP1, mP2, mQuad);
+		}
+	}
+}
 
 /*
 ==================
@@ -322,28 +298,12 @@ A sentence is an array of chars that ends in \n or \0
 ==================
 */
 int OpenGLRender::getLongInPixels(IND_Font *pFo, char *pText, int pPos, int pOffset) {
-	unsigned char mChar1;
-	unsigned char mChar2;
-	int mCont1 = pPos;
-	int mCont2 = 0;
-	bool mErrorChar;    // Error when nonexistant char
-
 	int mWidthSentence = 0;
-	mChar1 = pText [mCont1++];
-	while (mChar1 != '\0' && mChar1 != '\n') {
-		mErrorChar = 0;
-		mCont2 = 0;
-		mChar2 = pFo->getLetters() [mCont2++]._letter;
-
-		// Search the position
-		while (mChar2 != mChar1 && mCont2 < pFo->getNumChars()) mChar2 = pFo->getLetters() [mCont2++]._letter;
-		if (mCont2  ==  pFo->getNumChars())
-			mErrorChar = 1;
-
-		if (!mErrorChar)
-			mWidthSentence += pFo->getLetters() [mCont2 - 1]._width + pOffset;
 
-		mChar1 = pText [mCont1++];
+	for (int mCont = pPos; pText [mCont] != '\0' && pText [mCont] != '\n'; mCont++) {
+		IND_Font::LETTER *mLetter = pFo->getLetter(static_cast<unsigned char>(pText [mCont]));
+		if (mLetter)
+			mWidthSentence += mLetter->_width + pOffset;
 	}
 
 	return mWidthSentence;
@@ -66,9 +66,13 @@ bool OpenGLRender::setViewPort2d(int pX,
 	_info._viewPortHeight = pHeight;
     _info._viewPortApectRatio = static_cast<float>(pWidth/pHeight);
 
+	flushBatch2d();
+
 	//Clear projection matrix
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
+	_math.matrix4DSetIdentity(_projectionMatrix);
+	_matricesDirty = true;
 
 	//Define the viewport
 	glViewport(static_cast<GLint>(pX),
@@ -83,6 +87,9 @@ bool OpenGLRender::setViewPort2d(int pX,
 
 
 void OpenGLRender::setCamera2d(IND_Camera2d *pCamera2d) {
+	//The quads of the batch are drawn with the previous camera
+	flushBatch2d();
+
 	// ----- Lookat matrix -----
 	//Rotate that axes in Z by the camera angle
 	//Roll is rotation around the z axis (_look)
@@ -124,6 +131,7 @@ void OpenGLRender::setCamera2d(IND_Camera2d *pCamera2d) {
     float cam[16];
 	glGetFloatv(GL_MODELVIEW_MATRIX, cam);
     _cameraMatrix.readFromArray(cam);
+    _matricesDirty = true;
     
 	// ----- Projection Matrix -----
 	//Setup a 2d projection (orthogonal)
@@ -155,6 +163,8 @@ void OpenGLRender::setTransform2d(int pX,
                                   int pWidth,
                                   int pHeight,
                                   IND_Matrix *pMatrix) {
+	//The pending primitives are drawn before the next object
+	flushPrimitives2d();
 
 	//Temporal holders for all accumulated transforms
 	IND_Matrix totalTrans;
@@ -255,15 +265,7 @@ void OpenGLRender::setTransform2d(int pX,
 	_modelToWorld = totalTrans;
 
 	//Apply the changes to the GL matrix stack (model view)
-    //Camera transform
-    float camMatrixArray [16];
-    _cameraMatrix.arrayRepresentation(camMatrixArray);
-    glLoadMatrixf(camMatrixArray);
-    
-    //Actual object transform
-    float matrixArray [16];
-    totalTrans.arrayRepresentation(matrixArray);
-	glMultMatrixf(matrixArray);
+	loadModelView2d();
 
 	// ----- Return World Matrix (in IndieLib format) ----
 	//Transformations have been applied where needed
@@ -273,28 +275,39 @@ void OpenGLRender::setTransform2d(int pX,
 }
 
 void OpenGLRender::setTransform2d(IND_Matrix &pMatrix) {
-	// ----- Applies the transformation -----
-    float camMatrixArray [16];
-    _cameraMatrix.arrayRepresentation(camMatrixArray);
-    glLoadMatrixf(camMatrixArray);
-    
-    //Object transform
-    float matrixArray [16];
-    pMatrix.arrayRepresentation(matrixArray);
-	glMultMatrixf(matrixArray);
+	flushPrimitives2d();
 
-	//Finally cache the change
+	// ----- Applies the transformation -----
 	_modelToWorld = pMatrix;
+	loadModelView2d();
 }
 
 void OpenGLRender::setIdentityTransform2d ()  {
+	flushPrimitives2d();
+
 	// ----- Applies the transformation -----
+	_math.matrix4DSetIdentity(_modelToWorld);
+	loadModelView2d();
+}
+
+/*
+==================
+Loads the camera and the actual transform into the GL matrix stack (model view), for the fixed pipeline.
+The programmable 2d renderer doesn't use the matrix stack: the vertices are transformed with the actual
+transform when they are added to the batch, and the camera and the projection are in the uniform buffer.
+==================
+*/
+void OpenGLRender::loadModelView2d() {
+	if (_programmable2d)
+		return;
+
 	float camMatrixArray [16];
-    _cameraMatrix.arrayRepresentation(camMatrixArray);
-    glLoadMatrixf(camMatrixArray);
+	_cameraMatrix.arrayRepresentation(camMatrixArray);
+	glLoadMatrixf(camMatrixArray);
 
-	//Finally cache the change
-	_math.matrix4DSetIdentity(_modelToWorld);
+	float matrixArray [16];
+	_modelToWorld.arrayRepresentation(matrixArray);
+	glMultMatrixf(matrixArray);
 }
 
 void OpenGLRender::setRainbow2d(IND_Type pType,
@@ -317,6 +330,23 @@ void OpenGLRender::setRainbow2d(IND_Type pType,
 		pA = 255;
 	}
 
+	flushPrimitives2d();
+
+	bool mBlended = (IND_OPAQUE != pType || pA != 255 || pFadeA != 255);
+
+	// ----- Programmable 2d renderer -----
+	// The quads of the batch are drawn before changing the GL state they use (the color goes in the vertices)
+	int mState = (pType << 8) |
+	             (pCull ? 0x01 : 0) |
+	             ((pMirrorX != pMirrorY) ? 0x02 : 0) |
+	             (mBlended ? 0x04 : 0) |
+	             (_renderTarget ? 0x08 : 0) |
+	             (_opaquePass ? 0x10 : 0);
+	if (mState != _batchState) {
+		flushBatch2d();
+		_batchState = mState;
+	}
+
 	//Setup neutral 'blend' for texture stage
 	float blendR, blendG, blendB, blendA;
 	blendR = blendG = blendB = blendA = 1.0f;
@@ -371,6 +401,7 @@ void OpenGLRender::setRainbow2d(IND_Type pType,
             glDisable(GL_ALPHA_TEST);
             glEnable(GL_BLEND);
             glBlendFunc(GL_ONE, GL_ZERO);
+            glColor4f(blendR, blendG, blendB, blendA);
             
             // Tinting
             if (pR != 255 || pG != 255 || pB != 255) {
@@ -449,7 +480,31 @@ void OpenGLRender::setRainbow2d(IND_Type pType,
 	}
 	}
 
+	// ----- Vertex color of the programmable 2d renderer -----
+	_batchColor [0] = static_cast<unsigned char>(blendR * 255.0f + 0.5f);
+	_batchColor [1] = static_cast<unsigned char>(blendG * 255.0f + 0.5f);
+	_batchColor [2] = static_cast<unsigned char>(blendB * 255.0f + 0.5f);
+	_batchColor [3] = static_cast<unsigned char>(blendA * 255.0f + 0.5f);
+
+	// ----- Fill rate statistics -----
+	_fillBlend = mBlended ? IND_FILL_BLEND : IND_FILL_REPLACE;
 
+	// ----- Render targets -----
+	// The alpha of the blended pixels is accumulated, so the target can be blended later (premultiplied)
+	if (_renderTarget && mBlended && (IND_OPAQUE == pType || IND_ALPHA == pType)) {
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	// ----- Opaque pass -----
+	// Only the fully opaque pixels are drawn (and write their depth). They give the same color with
+	// or without blending. The programmable 2d renderer tests the alpha in the fragment shader.
+	if (_opaquePass) {
+		if (!_programmable2d) {
+			glEnable(GL_ALPHA_TEST);
+			glAlphaFunc(GL_GEQUAL, 1.0f);
+		}
+		glDisable(GL_BLEND);
+	}
 }
 
 void OpenGLRender::setDefaultGLState() {
@@ -471,7 +526,51 @@ void OpenGLRender::setDefaultGLState() {
     setGLClientStateToTexturing();
 }
 
+bool OpenGLRender::beginOpaquePass() {
+	flushBatch2d();
+
+	GLint mDepthBits = 0;
+	glGetIntegerv(GL_DEPTH_BITS, &mDepthBits);
+	if (!mDepthBits)
+		return false;
+
+	_opaquePass = true;
+
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	return true;
+}
+
+void OpenGLRender::endOpaquePass() {
+	flushBatch2d();
+	_opaquePass = false;
+
+	//The translucent pass is tested against the opaque pixels, but it doesn't write depth
+	glDisable(GL_ALPHA_TEST);
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+}
+
+void OpenGLRender::setDepth(float pDepth) {
+	flushBatch2d();
+
+	//All the vertices of the next blits get the same depth, whatever their z
+	glDepthRange(pDepth, pDepth);
+}
+
+void OpenGLRender::endDepthPasses() {
+	flushBatch2d();
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	glDepthRange(0.0, 1.0);
+}
+
 void OpenGLRender::setGLClientStateToPrimitive() {
+    //Primitives are drawn with the fixed pipeline, after the quads of the batch
+    flushBatch2d();
+    
     glDisable(GL_TEXTURE_2D);
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
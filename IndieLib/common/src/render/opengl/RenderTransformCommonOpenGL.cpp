@@ -48,6 +48,8 @@
 void   OpenGLRender::clearViewPort(unsigned char pR,
                                    unsigned char pG,
                                    unsigned char pB) {
+	flushBatch2d();
+
 	//Clear color buffer
 	glClearColor(static_cast<GLclampf>(pR / 255.0f),
 	             static_cast<GLclampf>(pG / 255.0f),
@@ -82,11 +84,16 @@ void OpenGLRender::perspectiveFov(float pFov, float pAspect, float pNearClipping
 }
 
 void OpenGLRender::perspectiveOrtho(float pWidth, float pHeight, float pNearClippingPlane, float pFarClippingPlane) {
+	//The quads of the batch are drawn with the previous projection
+	flushBatch2d();
+
 	//Projection matrix modification
 	glMatrixMode(GL_PROJECTION);
 	IND_Matrix orthoMatrix;
 	_math.matrix4DOrthographicProjectionLH(-pWidth/2,pWidth/2,-pHeight/2,pHeight/2,pNearClippingPlane,pFarClippingPlane,orthoMatrix);
 	glLoadMatrixf(reinterpret_cast<GLfloat *>(&orthoMatrix));
+	_projectionMatrix = orthoMatrix;
+	_matricesDirty = true;
 	
 	//float m[16];
 	//glGetFloatv(GL_PROJECTION_MATRIX, m);
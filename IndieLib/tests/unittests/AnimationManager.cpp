@@ -0,0 +1,139 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+#include "dependencies/unittest++/src/UnitTest++.h"
+#include "CIndieLib.h"
+#include "IND_Animation.h"
+#include "IND_AnimationManager.h"
+#include "IND_Image.h"
+#include "src/AnimationBundle.h"
+#include <stdio.h>
+#include <stddef.h>
+
+struct fixture {
+    fixture() {
+        iLib = CIndieLib::instance();
+        iLib->init();
+        testAnimation = IND_Animation::newAnimation();
+    }
+    ~fixture() {
+        iLib->end();
+        
+    }
+    IND_Animation *testAnimation;
+    CIndieLib* iLib;
+};
+
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_ADDEXISTING_ADDOK) {
+	CHECK(iLib->_animationManager->addToImage(testAnimation, "animations/sword_master.xml"));
+}
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_ADDNONEXISTING_ADDFAILS) {
+	CHECK(!iLib->_animationManager->addToImage(testAnimation, "BADBADBAD.xml"));
+}
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_SAVEBUNDLE_LOADSSAMEANIMATION) {
+	iLib->_animationManager->addToImage(testAnimation, "animations/sword_master.xml");
+
+	CHECK(iLib->_animationManager->saveBundle("animations/sword_master.xml", "animations/test_bundle.anb"));
+
+	IND_Animation *bundleAnimation = IND_Animation::newAnimation();
+	CHECK(iLib->_animationManager->addToImage(bundleAnimation, "animations/test_bundle.anb"));
+	CHECK_EQUAL(testAnimation->getNumTotalFrames(), bundleAnimation->getNumTotalFrames());
+	CHECK_EQUAL(testAnimation->getNumSequences(), bundleAnimation->getNumSequences());
+	CHECK_EQUAL(testAnimation->getNumFrames(0), bundleAnimation->getNumFrames(0));
+	CHECK_EQUAL(testAnimation->getHighWidth(0), bundleAnimation->getHighWidth(0));
+	CHECK_EQUAL(testAnimation->getImage(0)->getHeight(), bundleAnimation->getImage(0)->getHeight());
+
+	remove("animations/test_bundle.anb");
+}
+
+// Script time stored in the bundle
+static unsigned int readBundleScriptTime(const char *bundle) {
+	unsigned int scriptTime = 0;
+	FILE *file = fopen(bundle, "rb");
+	if (file) {
+		fseek(file, offsetof(BUNDLE_HEADER, _scriptTime), SEEK_SET);
+		if (fread(&scriptTime, sizeof(scriptTime), 1, file) != 1)
+			scriptTime = 0;
+		fclose(file);
+	}
+	return scriptTime;
+}
+
+// Pretends the bundle was made from an older version of the script
+static bool makeBundleStale(const char *bundle) {
+	unsigned int oldTime = 1;
+	FILE *file = fopen(bundle, "r+b");
+	if (!file)
+		return false;
+	fseek(file, offsetof(BUNDLE_HEADER, _scriptTime), SEEK_SET);
+	bool written = (fwrite(&oldTime, sizeof(oldTime), 1, file) == 1);
+	fclose(file);
+	return written;
+}
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_STALEBUNDLE_SCRIPTPARSED) {
+	CHECK(iLib->_animationManager->saveBundle("animations/sword_master.xml", "animations/sword_master.anb"));
+	CHECK(makeBundleStale("animations/sword_master.anb"));
+
+	// Adding doesn't write the bundle by default
+	CHECK(!iLib->_animationManager->isRebuildBundles());
+	CHECK(iLib->_animationManager->addToImage(testAnimation, "animations/sword_master.xml"));
+	CHECK(testAnimation->getNumTotalFrames() > 1);
+	CHECK_EQUAL(1u, readBundleScriptTime("animations/sword_master.anb"));
+
+	remove("animations/sword_master.anb");
+}
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_STALEBUNDLE_MADEAGAINWHENASKED) {
+	CHECK(iLib->_animationManager->saveBundle("animations/sword_master.xml", "animations/sword_master.anb"));
+	unsigned int scriptTime = readBundleScriptTime("animations/sword_master.anb");
+	CHECK(makeBundleStale("animations/sword_master.anb"));
+
+	iLib->_animationManager->setRebuildBundles(true);
+	CHECK(iLib->_animationManager->addToImage(testAnimation, "animations/sword_master.xml"));
+	iLib->_animationManager->setRebuildBundles(false);
+	CHECK(testAnimation->getNumTotalFrames() > 1);
+	CHECK_EQUAL(scriptTime, readBundleScriptTime("animations/sword_master.anb"));
+
+	remove("animations/sword_master.anb");
+}
+
+TEST_FIXTURE(fixture,ANIMATIONMANAGER_ADDTOATLAS_FRAMESSHAREPAGE) {
+	IND_Animation *imageAnimation = IND_Animation::newAnimation();
+	iLib->_animationManager->addToImage(imageAnimation, "animations/sword_master.xml");
+
+	iLib->_animationManager->setAtlas(true, true);
+	CHECK(iLib->_animationManager->addToSurface(testAnimation, "animations/sword_master.xml", IND_ALPHA, IND_32));
+	iLib->_animationManager->setAtlas(false, false);
+
+	CHECK(testAnimation->getNumTotalFrames() > 1);
+	CHECK(testAnimation->getSurface(0) == testAnimation->getSurface(1));
+	IND_Image *frameImage = imageAnimation->getImage(imageAnimation->getFramePosInVec(0, 0));
+	CHECK_EQUAL(frameImage->getWidth(), testAnimation->getFrameWidth(0, 0));
+	CHECK_EQUAL(frameImage->getHeight(), testAnimation->getFrameHeight(0, 0));
+}
@@ -0,0 +1,188 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "dependencies/unittest++/src/UnitTest++.h"
+#include "dependencies/FreeImage/Dist/FreeImage.h"
+#include "src/CompressedImageHelper.h"
+#include <stdio.h>
+#include <string.h>
+
+// 8x8 image, rows starting from the lower one (as FreeImage bitmaps): the upper half is opaque red, the lower half transparent blue
+static void fillTestPixels(unsigned char *pPixels) {
+	for (int y = 0; y < 8; y++) {
+		for (int x = 0; x < 8; x++) {
+			unsigned char *mPixel = pPixels + (y * 8 + x) * 4;
+			bool mUpper = (y >= 4);
+			mPixel[FI_RGBA_RED] = mUpper ? 255 : 0;
+			mPixel[FI_RGBA_GREEN] = 0;
+			mPixel[FI_RGBA_BLUE] = mUpper ? 0 : 255;
+			mPixel[FI_RGBA_ALPHA] = mUpper ? 255 : 0;
+		}
+	}
+}
+
+TEST(COMPRESSEDIMAGE_ENCODE_FIRSTBLOCKISUPPERROW) {
+	unsigned char mPixels [8 * 8 * 4];
+	fillTestPixels(mPixels);
+
+	COMPRESSED_IMAGE mImage;
+	CHECK(CompressedImageHelper::encode(mPixels, 8, 8, COMPRESSED_DXT5, &mImage));
+
+	// Decoding only the first row of blocks gives the upper half of the image
+	COMPRESSED_IMAGE mFirstRow = mImage;
+	mFirstRow._height = 4;
+	unsigned char mDecoded [8 * 4 * 4];
+	CHECK(CompressedImageHelper::decode(&mFirstRow, mDecoded));
+	CHECK_EQUAL(255, mDecoded[FI_RGBA_RED]);
+	CHECK_EQUAL(0, mDecoded[FI_RGBA_BLUE]);
+	CHECK_EQUAL(255, mDecoded[FI_RGBA_ALPHA]);
+
+	CompressedImageHelper::freeImage(&mImage);
+}
+
+TEST(COMPRESSEDIMAGE_COOKANDLOAD_DECODESSAMEPIXELS) {
+	unsigned char mPixels [8 * 8 * 4];
+	fillTestPixels(mPixels);
+
+	int mFormats [] = {COMPRESSED_DXT1, COMPRESSED_DXT5};
+	for (int i = 0; i < 2; i++) {
+		COMPRESSED_IMAGE mCooked;
+		CHECK(CompressedImageHelper::encode(mPixels, 8, 8, mFormats[i], &mCooked));
+		CHECK(CompressedImageHelper::saveDDS("test_cooked.dds", &mCooked));
+
+		COMPRESSED_IMAGE mLoaded;
+		CHECK(CompressedImageHelper::loadDDS("test_cooked.dds", &mLoaded));
+		CHECK_EQUAL(mFormats[i], mLoaded._format);
+		CHECK_EQUAL(8, mLoaded._width);
+		CHECK_EQUAL(8, mLoaded._height);
+		CHECK_EQUAL(mCooked._size, mLoaded._size);
+		CHECK(0 == memcmp(mCooked._data, mLoaded._data, mCooked._size));
+
+		unsigned char mDecoded [8 * 8 * 4];
+		CHECK(CompressedImageHelper::decode(&mLoaded, mDecoded));
+		for (int p = 0; p < 8 * 8; p++) {
+			CHECK_EQUAL(mPixels[p * 4 + FI_RGBA_RED], mDecoded[p * 4 + FI_RGBA_RED]);
+			CHECK_EQUAL(mPixels[p * 4 + FI_RGBA_BLUE], mDecoded[p * 4 + FI_RGBA_BLUE]);
+		}
+		if (COMPRESSED_DXT5 == mFormats[i]) {
+			CHECK_EQUAL(255, mDecoded[(7 * 8) * 4 + FI_RGBA_ALPHA]);
+			CHECK_EQUAL(0, mDecoded[FI_RGBA_ALPHA]);
+		}
+
+		CompressedImageHelper::freeImage(&mCooked);
+		CompressedImageHelper::freeImage(&mLoaded);
+		remove("test_cooked.dds");
+	}
+}
+
+TEST(COMPRESSEDIMAGE_FLIPROWS_MIRRORSDECODEDIMAGE) {
+	unsigned char mPixels [8 * 8 * 4];
+	fillTestPixels(mPixels);
+
+	// A gradient inside the blocks, so the rows of each block are flipped too
+	for (int y = 0; y < 8; y++)
+		mPixels[(y * 8) * 4 + FI_RGBA_GREEN] = (unsigned char)(y * 32);
+
+	int mFormats [] = {COMPRESSED_DXT1, COMPRESSED_DXT5};
+	for (int i = 0; i < 2; i++) {
+		COMPRESSED_IMAGE mImage;
+		CompressedImageHelper::encode(mPixels, 8, 8, mFormats[i], &mImage);
+		unsigned char mDecoded [8 * 8 * 4];
+		CompressedImageHelper::decode(&mImage, mDecoded);
+
+		CHECK(CompressedImageHelper::flipRows(&mImage));
+		unsigned char mFlipped [8 * 8 * 4];
+		CompressedImageHelper::decode(&mImage, mFlipped);
+		for (int y = 0; y < 8; y++)
+			CHECK(0 == memcmp(mDecoded + y * 8 * 4, mFlipped + (7 - y) * 8 * 4, 8 * 4));
+
+		CompressedImageHelper::freeImage(&mImage);
+	}
+}
+
+TEST(COMPRESSEDIMAGE_FLIPROWS_REJECTSUNALIGNEDHEIGHT) {
+	unsigned char mPixels [8 * 8 * 4];
+	fillTestPixels(mPixels);
+
+	COMPRESSED_IMAGE mImage;
+	CompressedImageHelper::encode(mPixels, 8, 6, COMPRESSED_DXT1, &mImage);
+	unsigned char mFirstBlock [8];
+	memcpy(mFirstBlock, mImage._data, 8);
+
+	CHECK(!CompressedImageHelper::flipRows(&mImage));
+	CHECK(0 == memcmp(mFirstBlock, mImage._data, 8));
+
+	CompressedImageHelper::freeImage(&mImage);
+}
+
+// Writes a 8x8 DXT1 .dds keeping only the first pDataBytes of its data
+static void saveTestDDS(const char *pName, int pDataBytes) {
+	unsigned char mPixels [8 * 8 * 4];
+	fillTestPixels(mPixels);
+
+	COMPRESSED_IMAGE mImage;
+	CompressedImageHelper::encode(mPixels, 8, 8, COMPRESSED_DXT1, &mImage);
+	mImage._size = pDataBytes;
+	CompressedImageHelper::saveDDS(pName, &mImage);
+	CompressedImageHelper::freeImage(&mImage);
+}
+
+// Overwrites the (little endian) header field at pOffset of a .dds file
+static void patchDDS(const char *pName, long pOffset, unsigned int pValue) {
+	unsigned char mValue [4] = {(unsigned char)(pValue & 0xFF), (unsigned char)((pValue >> 8) & 0xFF),
+	                            (unsigned char)((pValue >> 16) & 0xFF), (unsigned char)((pValue >> 24) & 0xFF)};
+	FILE *mFile = fopen(pName, "r+b");
+	fseek(mFile, pOffset, SEEK_SET);
+	fwrite(mValue, 1, 4, mFile);
+	fclose(mFile);
+}
+
+TEST(COMPRESSEDIMAGE_LOADDDS_REJECTSHEADERBIGGERTHANFILE) {
+	COMPRESSED_IMAGE mImage;
+
+	// Width far bigger than the data stored
+	saveTestDDS("test_broken.dds", 32);
+	patchDDS("test_broken.dds", 16, 0x7FFFFFFF);
+	CHECK(!CompressedImageHelper::loadDDS("test_broken.dds", &mImage));
+
+	// Data cut in the middle of the first level
+	saveTestDDS("test_broken.dds", 16);
+	CHECK(!CompressedImageHelper::loadDDS("test_broken.dds", &mImage));
+
+	// Mipmap levels declared but not stored
+	saveTestDDS("test_broken.dds", 32);
+	patchDDS("test_broken.dds", 8, 0x00081007 | 0x00020000);     // Flags with MipMapCount
+	patchDDS("test_broken.dds", 28, 4);
+	CHECK(!CompressedImageHelper::loadDDS("test_broken.dds", &mImage));
+
+	// The same file with the levels it really has loads
+	patchDDS("test_broken.dds", 28, 1);
+	CHECK(CompressedImageHelper::loadDDS("test_broken.dds", &mImage));
+	CHECK_EQUAL(32, mImage._size);
+
+	CompressedImageHelper::freeImage(&mImage);
+	remove("test_broken.dds");
+}
@@ -0,0 +1,157 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+#include "dependencies/unittest++/src/UnitTest++.h"
+#include "CIndieLib.h"
+#include "IND_Animation.h"
+#include "IND_AnimationManager.h"
+#include "IND_Entity2d.h"
+#include "IND_Entity2dManager.h"
+#include "IND_Surface.h"
+#include "IND_SurfaceManager.h"
+#include "IND_Render.h"
+#include "IND_Camera2d.h"
+
+struct fixture {
+    fixture() {
+        iLib = CIndieLib::instance();
+        iLib->init();
+        testAnimation = IND_Animation::newAnimation();
+        iLib->_animationManager->addToSurface(testAnimation, "animations/sword_master.xml", IND_ALPHA, IND_32);
+    }
+    ~fixture() {
+        iLib->end();
+        
+    }
+    IND_Animation *testAnimation;
+    CIndieLib* iLib;
+};
+
+
+TEST_FIXTURE(fixture,ENTITY2DMANAGER_UPDATE_ENTITIESKEEPTHEIROWNFRAME) {
+	IND_Entity2d *first = IND_Entity2d::newEntity2d();
+	IND_Entity2d *second = IND_Entity2d::newEntity2d();
+	iLib->_entity2dManager->add(first);
+	iLib->_entity2dManager->add(second);
+	first->setAnimation(testAnimation);
+	second->setAnimation(testAnimation);
+
+	// Starts both animations, then the first frame (1000 ms) finishes
+	iLib->_entity2dManager->update(0.0f);
+	iLib->_entity2dManager->update(1001.0f);
+	CHECK_EQUAL(1, first->getFramePos());
+	CHECK_EQUAL(1, second->getFramePos());
+
+	// Restarting one entity doesn't change the other one, nor the animation
+	second->setSequence(0);
+	iLib->_entity2dManager->update(0.0f);
+	CHECK_EQUAL(1, first->getFramePos());
+	CHECK_EQUAL(0, second->getFramePos());
+	CHECK_EQUAL(0u, testAnimation->getActualFramePos(0));
+}
+
+TEST_FIXTURE(fixture,ENTITY2DMANAGER_UPDATEWITHTHREADS_SAMEFRAMES) {
+	const int numEntities = 2000;
+	IND_Entity2d *entities [numEntities];
+	for (int i = 0; i < numEntities; i++) {
+		entities [i] = IND_Entity2d::newEntity2d();
+		iLib->_entity2dManager->add(entities [i]);
+		entities [i]->setAnimation(testAnimation);
+	}
+
+	iLib->_entity2dManager->setUpdateThreads(4);
+	CHECK_EQUAL(4, iLib->_entity2dManager->getUpdateThreads());
+
+	iLib->_entity2dManager->update(0.0f);
+	iLib->_entity2dManager->update(1001.0f);
+	iLib->_entity2dManager->update(1001.0f);
+
+	for (int i = 0; i < numEntities; i++)
+		CHECK_EQUAL(2, entities [i]->getFramePos());
+}
+
+TEST_FIXTURE(fixture,ENTITY2DMANAGER_SPATIALINDEX_DISCARDSOFFSCREENENTITIES) {
+	IND_Surface *testSurf = IND_Surface::newSurface();
+	iLib->_surfaceManager->add(testSurf,const_cast<char *>("blue_background.jpg"), IND_OPAQUE, IND_32);
+
+	IND_Entity2d *visible = IND_Entity2d::newEntity2d();
+	IND_Entity2d *far1 = IND_Entity2d::newEntity2d();
+	IND_Entity2d *far2 = IND_Entity2d::newEntity2d();
+	iLib->_entity2dManager->add(1, visible);
+	iLib->_entity2dManager->add(1, far1);
+	iLib->_entity2dManager->add(1, far2);
+	visible->setSurface(testSurf);
+	far1->setSurface(testSurf);
+	far2->setSurface(testSurf);
+	far1->setPosition(100000, 100000, 0);
+	far2->setPosition(-100000, 50000, 0);
+
+	CHECK(iLib->_entity2dManager->setSpatialIndex(1, 256));
+	CHECK_EQUAL(256, iLib->_entity2dManager->getSpatialIndex(1));
+
+	IND_Camera2d camera (400, 300);
+	iLib->_render->beginScene();
+	iLib->_render->setCamera2d(&camera);
+	iLib->_entity2dManager->renderEntities2d(1);
+	iLib->_render->endScene();
+	CHECK_EQUAL(2, iLib->_entity2dManager->getNumCulledInt(1));
+
+	// Moved entities are found in their new cells
+	far1->setPosition(100, 100, 0);
+	iLib->_render->beginScene();
+	iLib->_render->setCamera2d(&camera);
+	iLib->_entity2dManager->renderEntities2d(1);
+	iLib->_render->endScene();
+	CHECK_EQUAL(1, iLib->_entity2dManager->getNumCulledInt(1));
+
+	CHECK(iLib->_entity2dManager->setSpatialIndex(1, 0));
+	CHECK_EQUAL(0, iLib->_entity2dManager->getSpatialIndex(1));
+}
+
+TEST_FIXTURE(fixture,ENTITY2DMANAGER_OPAQUEFIRST_OPAQUETILESDRAWNONCE) {
+	IND_Surface *testSurf = IND_Surface::newSurface();
+	iLib->_surfaceManager->add(testSurf,const_cast<char *>("blue_background.jpg"), IND_OPAQUE, IND_32);
+	CHECK_EQUAL(IND_ALPHA_CLASS_OPAQUE, testSurf->getAlphaClass());
+
+	const int numTiles = 16;
+	for (int i = 0; i < numTiles; i++) {
+		IND_Entity2d *tile = IND_Entity2d::newEntity2d();
+		iLib->_entity2dManager->add(2, tile);
+		tile->setSurface(testSurf);
+		tile->setPosition(static_cast<float>(i * 10), 0, i);
+	}
+
+	// The opaque tiles are completely drawn in the opaque pass, and not again in the translucent one
+	iLib->_entity2dManager->setOpaqueFirst(true);
+	IND_Camera2d camera (400, 300);
+	iLib->_render->beginScene();
+	iLib->_render->setCamera2d(&camera);
+	iLib->_render->resetNumrenderedObject();
+	iLib->_entity2dManager->renderEntities2d(2);
+	CHECK_EQUAL(numTiles, iLib->_render->getNumrenderedObjectsInt());
+	iLib->_render->endScene();
+
+	iLib->_entity2dManager->setOpaqueFirst(false);
+}
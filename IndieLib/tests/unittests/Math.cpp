@@ -592,3 +592,25 @@ TEST_FIXTURE(INDMathTests,idendityMatrix) {
     CHECK_CLOSE(0.f, matrix._43, 0.01f);
     CHECK_CLOSE(1.f, matrix._44, 0.01f);
 }
+
+TEST_FIXTURE(INDMathTests,ReadFromGLArrayTranslation) {
+    //GL matrices are column major: a translation is in the elements 12, 13 and 14
+    float glMatrix [16] = {1.f, 0.f, 0.f, 0.f,
+                           0.f, 1.f, 0.f, 0.f,
+                           0.f, 0.f, 1.f, 0.f,
+                           10.f, 20.f, 30.f, 1.f};
+    IND_Matrix matrix;
+    matrix.readFromArray(glMatrix);
+
+    CHECK_CLOSE(10.f, matrix._14, 0.01f);
+    CHECK_CLOSE(20.f, matrix._24, 0.01f);
+    CHECK_CLOSE(30.f, matrix._34, 0.01f);
+    CHECK_CLOSE(0.f, matrix._41, 0.01f);
+    CHECK_CLOSE(0.f, matrix._42, 0.01f);
+
+    IND_Vector3 vec(1.0f, 1.0f, 1.0f);
+    math->transformVector3DbyMatrix4D(vec, matrix);
+    CHECK_CLOSE(11.0f, vec._x, 0.01f);
+    CHECK_CLOSE(21.0f, vec._y, 0.01f);
+    CHECK_CLOSE(31.0f, vec._z, 0.01f);
+}
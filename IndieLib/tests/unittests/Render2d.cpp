@@ -0,0 +1,118 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "dependencies/unittest++/src/UnitTest++.h"
+#include "dependencies/glew-1.9.0/include/GL/glew.h"
+#include "CIndieLib.h"
+#include "IND_Entity2d.h"
+#include "IND_Entity2dManager.h"
+#include "IND_Surface.h"
+#include "IND_SurfaceManager.h"
+#include "IND_Render.h"
+#include "IND_Camera2d.h"
+#include <stdlib.h>
+#include <vector>
+
+struct fixture {
+    fixture() {
+        iLib = CIndieLib::instance();
+        iLib->init();
+    }
+    ~fixture() {
+        iLib->_render->setProgrammable2d(false);
+        iLib->end();
+        
+    }
+    CIndieLib* iLib;
+};
+
+// Draws the entities of layer 0 and reads the back buffer (800 x 600, RGBA)
+static void renderAndRead(CIndieLib *iLib, std::vector<unsigned char> *pPixels) {
+	IND_Camera2d camera (400, 300);
+	iLib->_render->beginScene();
+	iLib->_render->clearViewPort(0, 0, 0);
+	iLib->_render->setCamera2d(&camera);
+	iLib->_entity2dManager->renderEntities2d();
+
+	// Setting the renderer draws the quads still in the batch
+	bool programmable = iLib->_render->isProgrammable2d();
+	iLib->_render->setProgrammable2d(programmable);
+
+	pPixels->resize(800 * 600 * 4);
+	glReadPixels(0, 0, 800, 600, GL_RGBA, GL_UNSIGNED_BYTE, &(*pPixels) [0]);
+	iLib->_render->endScene();
+}
+
+TEST_FIXTURE(fixture,RENDER_PROGRAMMABLE2D_MATCHESFIXEDPIPELINE) {
+	IND_Surface *surface = IND_Surface::newSurface();
+	CHECK(iLib->_surfaceManager->add(surface, const_cast<char *>("rabbit.png"), IND_ALPHA, IND_32));
+
+	// Translated, rotated and scaled, a region, mirrored, and tinted with transparency
+	IND_Entity2d *entities [4];
+	for (int i = 0; i < 4; i++) {
+		entities [i] = IND_Entity2d::newEntity2d();
+		iLib->_entity2dManager->add(entities [i]);
+		entities [i]->setSurface(surface);
+	}
+	entities [0]->setPosition(20, 30, 0);
+	entities [1]->setPosition(400, 300, 1);
+	entities [1]->setAngleXYZ(0, 0, 30);
+	entities [1]->setScale(1.5f, 0.75f);
+	entities [1]->setHotSpot(0.5f, 0.5f);
+	entities [2]->setPosition(600, 50, 2);
+	entities [2]->setRegion(10, 10, 40, 30);
+	entities [2]->setScale(2.0f, 2.0f);
+	entities [3]->setPosition(150, 400, 3);
+	entities [3]->setMirrorX(true);
+	entities [3]->setTint(255, 128, 0);
+	entities [3]->setTransparency(128);
+
+	iLib->_render->setProgrammable2d(false);
+	std::vector<unsigned char> fixedPixels;
+	renderAndRead(iLib, &fixedPixels);
+
+	// Without OpenGL 3.3 there is nothing to compare
+	if (!iLib->_render->setProgrammable2d(true))
+		return;
+	std::vector<unsigned char> batchedPixels;
+	renderAndRead(iLib, &batchedPixels);
+
+	// Same image, except a few pixels on the edges of the rotated quad (the vertices are
+	// transformed by the CPU instead of the fixed pipeline)
+	int drawn = 0;
+	int different = 0;
+	for (int i = 0; i < 800 * 600; i++) {
+		int difference = 0;
+		for (int j = 0; j < 4; j++)
+			difference += abs(fixedPixels [i * 4 + j] - batchedPixels [i * 4 + j]);
+		if (difference > 8)
+			different++;
+		if (fixedPixels [i * 4] || fixedPixels [i * 4 + 1] || fixedPixels [i * 4 + 2])
+			drawn++;
+	}
+	CHECK(drawn > 1000);
+	CHECK(different <= drawn / 100);
+}
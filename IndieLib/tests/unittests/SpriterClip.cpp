@@ -0,0 +1,312 @@
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+
+#include "dependencies/unittest++/src/UnitTest++.h"
+#include "CIndieLib.h"
+#include "IND_SpriterEntity.h"
+#include "src/SpriterClip.h"
+
+// One timeline moving from (0, 0) to (100, 50) and rotating from 0 to 90 degrees in the first second,
+// with a mainline key in each key of the timeline. The animation lasts two seconds.
+static Animation *createAnimation(const char *pLooping) {
+	Animation *mAnimation = new Animation(0, "test", 2000, pLooping, 0);
+
+	Timeline *mTimeline = mAnimation->addTimeline(0, "object", "sprite", "", "");
+	mTimeline->addKey(0, 0, 1)->addTimelineObject(0, 0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	mTimeline->addKey(1, 1000, 1)->addTimelineObject(0, 0, 100.0f, 50.0f, 0.0f, 1.0f, 90.0f, 1.0f, 1.0f, 0.5f);
+
+	mAnimation->getMainline()->addKey(0, 0)->addObjectref(0, -1, 0, 0, 0);
+	mAnimation->getMainline()->addKey(1, 1000)->addObjectref(0, -1, 0, 1, 0);
+
+	return mAnimation;
+}
+
+struct SpriterClipTests {
+	SpriterClipTests() {
+		Animation *mLooping = createAnimation("true");
+		Animation *mNotLooping = createAnimation("false");
+		looping.build(mLooping, &surfaces);
+		notLooping.build(mNotLooping, &surfaces);
+		delete mLooping;
+		delete mNotLooping;
+	}
+
+	map <Fileref, IND_Surface *> surfaces;
+	SpriterClip looping;
+	SpriterClip notLooping;
+	SpriterClip empty;
+};
+
+static SpriterSpatial createSpatial(float pX, float pAngle) {
+	SpriterSpatial mSpatial = {pX, 0.0f, pAngle, 1.0f, 1.0f, 1.0f};
+	return mSpatial;
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_WRAPTIME_LOOPINGSTARTSAGAIN) {
+	CHECK_CLOSE(500.0, looping.wrapTime(500.0), 0.001);
+	CHECK_CLOSE(500.0, looping.wrapTime(2500.0), 0.001);
+	CHECK_CLOSE(0.0, looping.wrapTime(4000.0), 0.001);
+	CHECK_CLOSE(0.0, looping.wrapTime(-10.0), 0.001);
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_WRAPTIME_NOTLOOPINGSTAYSINTHEEND) {
+	CHECK_CLOSE(500.0, notLooping.wrapTime(500.0), 0.001);
+	CHECK_CLOSE(2000.0, notLooping.wrapTime(2500.0), 0.001);
+	CHECK_CLOSE(0.0, empty.wrapTime(500.0), 0.001);
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_ADVANCECURSOR_MOVESFORWARD) {
+	CHECK_EQUAL(0, looping.advanceCursor(0, 500.0));
+	CHECK_EQUAL(1, looping.advanceCursor(0, 1000.0));
+	CHECK_EQUAL(1, looping.advanceCursor(1, 1999.0));
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_ADVANCECURSOR_TIMEBACKSTARTSAGAIN) {
+	CHECK_EQUAL(0, looping.advanceCursor(1, 500.0));
+	CHECK_EQUAL(1, looping.advanceCursor(7, 1500.0));
+	CHECK_EQUAL(0, looping.advanceCursor(-1, 0.0));
+	CHECK_EQUAL(-1, empty.advanceCursor(0, 500.0));
+}
+
+TEST(SPRITERCLIP_LERPSPATIAL_SPINWRAPSTHEANGLE) {
+	SpriterSpatial mOut;
+
+	// Counter clockwise from 350 goes through 360
+	SpriterClip::lerpSpatial(createSpatial(0.0f, 350.0f), createSpatial(10.0f, 10.0f), 1, 0.5f, &mOut);
+	CHECK_CLOSE(360.0f, mOut._angle, 0.001f);
+	CHECK_CLOSE(5.0f, mOut._x, 0.001f);
+
+	// Clockwise from 10 goes through 0
+	SpriterClip::lerpSpatial(createSpatial(0.0f, 10.0f), createSpatial(0.0f, 350.0f), -1, 0.5f, &mOut);
+	CHECK_CLOSE(0.0f, mOut._angle, 0.001f);
+
+	// The other way round, each goes the long way
+	SpriterClip::lerpSpatial(createSpatial(0.0f, 10.0f), createSpatial(0.0f, 350.0f), 1, 0.5f, &mOut);
+	CHECK_CLOSE(180.0f, mOut._angle, 0.001f);
+	SpriterClip::lerpSpatial(createSpatial(0.0f, 350.0f), createSpatial(0.0f, 10.0f), -1, 0.5f, &mOut);
+	CHECK_CLOSE(180.0f, mOut._angle, 0.001f);
+}
+
+TEST(SPRITERCLIP_LERPSPATIAL_NOSPINKEEPSTHEANGLE) {
+	SpriterSpatial mOut;
+	SpriterClip::lerpSpatial(createSpatial(0.0f, 30.0f), createSpatial(10.0f, 90.0f), 0, 0.5f, &mOut);
+	CHECK_CLOSE(30.0f, mOut._angle, 0.001f);
+	CHECK_CLOSE(5.0f, mOut._x, 0.001f);
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_EVALUATE_INTERPOLATESTHEKEYS) {
+	SpriterPose mPose;
+	looping.evaluate(looping.advanceCursor(-1, 500.0), 500.0, &mPose);
+
+	CHECK_EQUAL(1, static_cast<int>(mPose._sprites.size()));
+	CHECK_CLOSE(50.0f, mPose._sprites [0]._spatial._x, 0.001f);
+	CHECK_CLOSE(25.0f, mPose._sprites [0]._spatial._y, 0.001f);
+	CHECK_CLOSE(45.0f, mPose._sprites [0]._spatial._angle, 0.001f);
+	CHECK_CLOSE(0.75f, mPose._sprites [0]._spatial._alpha, 0.001f);
+}
+
+TEST_FIXTURE(SpriterClipTests, SPRITERCLIP_EVALUATE_LOOPINGGOESTOTHEFIRSTKEY) {
+	// After the last key, a looping animation goes back to the first key, which comes one length later
+	SpriterPose mPose;
+	looping.evaluate(looping.advanceCursor(-1, 1500.0), 1500.0, &mPose);
+
+	CHECK_EQUAL(1, static_cast<int>(mPose._sprites.size()));
+	CHECK_CLOSE(50.0f, mPose._sprites [0]._spatial._x, 0.001f);
+	CHECK_CLOSE(225.0f, mPose._sprites [0]._spatial._angle, 0.001f);
+
+	// The others stay in the last key
+	notLooping.evaluate(notLooping.advanceCursor(-1, 1500.0), 1500.0, &mPose);
+
+	CHECK_EQUAL(1, static_cast<int>(mPose._sprites.size()));
+	CHECK_CLOSE(100.0f, mPose._sprites [0]._spatial._x, 0.001f);
+	CHECK_CLOSE(90.0f, mPose._sprites [0]._spatial._angle, 0.001f);
+}
+
+// A root bone moving from 0 to 100 in the first second, a child bone 5 to the right of it, and an object
+// 10 to the right of the child. The child comes first in the file.
+static Animation *createBoneAnimation() {
+	Animation *mAnimation = new Animation(0, "bones", 2000, "true", 0);
+
+	Timeline *mRoot = mAnimation->addTimeline(0, "root", "bone", "", "");
+	mRoot->addKey(0, 0, 0)->addTimelineObject(0, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	mRoot->addKey(1, 1000, 0)->addTimelineObject(0, 0, 100.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	Timeline *mObject = mAnimation->addTimeline(1, "object", "sprite", "", "");
+	mObject->addKey(0, 0, 0)->addTimelineObject(0, 0, 10.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	Timeline *mChild = mAnimation->addTimeline(2, "child", "bone", "", "");
+	mChild->addKey(0, 0, 0)->addTimelineObject(0, 0, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+
+	MainlineKey *mKey = mAnimation->getMainline()->addKey(0, 0);
+	mKey->addBoneref(1, 0, 2, 0);
+	mKey->addBoneref(0, -1, 0, 0);
+	mKey->addObjectref(0, 1, 1, 0, 0);
+
+	return mAnimation;
+}
+
+struct SpriterClipBoneTests {
+	SpriterClipBoneTests() {
+		Animation *mAnimation = createBoneAnimation();
+		clip.build(mAnimation, &surfaces);
+		delete mAnimation;
+	}
+
+	map <Fileref, IND_Surface *> surfaces;
+	SpriterClip clip;
+};
+
+static void sortBones(MainlineBoneref *pBones, int pNumBones, unsigned int pNumTimelines, vector <unsigned int> *pOrder, vector <int> *pParents) {
+	vector <MainlineBoneref *> mBones;
+	for (int i = 0; i < pNumBones; i++)
+		mBones.push_back(&pBones [i]);
+
+	// One key in each timeline
+	SpriterClip::sortBones(mBones, vector <unsigned int>(pNumTimelines, 1), pOrder, pParents);
+}
+
+TEST(SPRITERCLIP_SORTBONES_PARENTSFIRST) {
+	// Bone 5 is the child of 2, which is the child of 9
+	MainlineBoneref mBones [] = {{5, 2, 0, 0}, {2, 9, 0, 0}, {9, -1, 0, 0}};
+	vector <unsigned int> mOrder;
+	vector <int> mParents;
+	sortBones(mBones, 3, 1, &mOrder, &mParents);
+
+	CHECK_EQUAL(3, static_cast<int>(mOrder.size()));
+	CHECK_EQUAL(2u, mOrder [0]);
+	CHECK_EQUAL(1u, mOrder [1]);
+	CHECK_EQUAL(0u, mOrder [2]);
+	CHECK_EQUAL(-1, mParents [0]);
+	CHECK_EQUAL(0, mParents [1]);
+	CHECK_EQUAL(1, mParents [2]);
+}
+
+TEST(SPRITERCLIP_SORTBONES_SKIPSCYCLES) {
+	// 0 and 1 are parents of each other, 3 is a child of the cycle, and 4 is its own parent
+	MainlineBoneref mBones [] = {{0, 1, 0, 0}, {1, 0, 0, 0}, {2, -1, 0, 0}, {3, 0, 0, 0}, {4, 4, 0, 0}};
+	vector <unsigned int> mOrder;
+	vector <int> mParents;
+	sortBones(mBones, 5, 1, &mOrder, &mParents);
+
+	CHECK_EQUAL(2, static_cast<int>(mOrder.size()));
+	CHECK_EQUAL(2u, mOrder [0]);
+	CHECK_EQUAL(4u, mOrder [1]);
+	CHECK_EQUAL(-1, mParents [0]);
+	CHECK_EQUAL(-1, mParents [1]);
+}
+
+TEST(SPRITERCLIP_SORTBONES_SKIPSMISSINGTIMELINES) {
+	// The timeline of 0 and the key of 2 don't exist: their children become roots
+	MainlineBoneref mBones [] = {{0, -1, 3, 0}, {1, 0, 0, 0}, {2, 1, 0, 5}, {3, 2, 0, 0}};
+	vector <unsigned int> mOrder;
+	vector <int> mParents;
+	sortBones(mBones, 4, 1, &mOrder, &mParents);
+
+	CHECK_EQUAL(2, static_cast<int>(mOrder.size()));
+	CHECK_EQUAL(1u, mOrder [0]);
+	CHECK_EQUAL(3u, mOrder [1]);
+	CHECK_EQUAL(-1, mParents [0]);
+	CHECK_EQUAL(-1, mParents [1]);
+}
+
+TEST(SPRITERCLIP_COMPOSESPATIAL_PARENTTRANSFORMSCHILD) {
+	SpriterSpatial mParent = {10.0f, 20.0f, 90.0f, 2.0f, 1.0f, 0.5f};
+	SpriterSpatial mLocal = {5.0f, 0.0f, 30.0f, 1.0f, 3.0f, 0.5f};
+	SpriterSpatial mOut;
+	SpriterClip::composeSpatial(mParent, mLocal, &mOut);
+
+	CHECK_CLOSE(10.0f, mOut._x, 0.001f);
+	CHECK_CLOSE(30.0f, mOut._y, 0.001f);
+	CHECK_CLOSE(120.0f, mOut._angle, 0.001f);
+	CHECK_CLOSE(2.0f, mOut._scaleX, 0.001f);
+	CHECK_CLOSE(3.0f, mOut._scaleY, 0.001f);
+	CHECK_CLOSE(0.25f, mOut._alpha, 0.001f);
+}
+
+TEST(SPRITERCLIP_COMPOSESPATIAL_MIRRORREVERSESTHEANGLE) {
+	SpriterSpatial mParent = {10.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f};
+	SpriterSpatial mLocal = {5.0f, 0.0f, 30.0f, 1.0f, 1.0f, 1.0f};
+	SpriterSpatial mOut;
+	SpriterClip::composeSpatial(mParent, mLocal, &mOut);
+
+	CHECK_CLOSE(5.0f, mOut._x, 0.001f);
+	CHECK_CLOSE(-30.0f, mOut._angle, 0.001f);
+	CHECK_CLOSE(-1.0f, mOut._scaleX, 0.001f);
+}
+
+TEST_FIXTURE(SpriterClipBoneTests, SPRITERCLIP_EVALUATE_OBJECTFOLLOWSTHEBONES) {
+	SpriterPose mPose;
+	clip.evaluate(0, 500.0, &mPose);
+
+	CHECK_EQUAL(2, static_cast<int>(mPose._bones.size()));
+	CHECK_EQUAL(-1, mPose._bones [0]._parent);
+	CHECK_EQUAL(0, mPose._bones [1]._parent);
+	CHECK_CLOSE(50.0f, mPose._bones [0]._world._x, 0.001f);
+	CHECK_CLOSE(55.0f, mPose._bones [1]._world._x, 0.001f);
+	CHECK_EQUAL(1, static_cast<int>(mPose._sprites.size()));
+	CHECK_CLOSE(65.0f, mPose._sprites [0]._spatial._x, 0.001f);
+
+	// Nothing changed in the same time
+	clip.evaluate(0, 500.0, &mPose);
+	CHECK(!mPose._bones [0]._dirty);
+	CHECK(!mPose._bones [1]._dirty);
+}
+
+TEST_FIXTURE(SpriterClipBoneTests, SPRITERCLIP_GETPOSE_EACHENTITYKEEPSITSBONES) {
+	SpriterPose mPoseA;
+	SpriterPose mPoseB;
+
+	// Two entities out of phase in the same frame
+	clip.getPose(0, 500.0, 1, &mPoseA);
+	const SpriterPose &mB = clip.getPose(0, 250.0, 1, &mPoseB);
+	CHECK(&mB == &mPoseB);
+	CHECK_CLOSE(40.0f, mPoseB._sprites [0]._spatial._x, 0.001f);
+	CHECK_CLOSE(50.0f, mPoseA._bones [0]._world._x, 0.001f);
+	CHECK_CLOSE(65.0f, mPoseA._sprites [0]._spatial._x, 0.001f);
+
+	// In the next frame the first entity moves on, from the bones of its own last pose
+	clip.getPose(0, 750.0, 2, &mPoseA);
+	CHECK(mPoseA._bones [0]._dirty);
+	CHECK_CLOSE(90.0f, mPoseA._sprites [0]._spatial._x, 0.001f);
+
+	// The second one plays the same time, and gets the pose of the first one
+	const SpriterPose &mShared = clip.getPose(0, 750.0, 2, &mPoseB);
+	CHECK(&mShared == &mPoseA);
+	CHECK_CLOSE(40.0f, mPoseB._sprites [0]._spatial._x, 0.001f);
+}
+
+TEST_FIXTURE(SpriterClipBoneTests, SPRITERCLIP_FORGETPOSE_DELETEDENTITYNOTSHARED) {
+	SpriterPose *mPoseA = new SpriterPose();
+	SpriterPose mPoseB;
+
+	// The first entity is deleted after its pose is shared
+	clip.getPose(0, 750.0, 1, mPoseA);
+	clip.forgetPose(mPoseA);
+	delete mPoseA;
+
+	// The second one playing the same time in the same frame evaluates its own pose
+	const SpriterPose &mPose = clip.getPose(0, 750.0, 1, &mPoseB);
+	CHECK(&mPose == &mPoseB);
+	CHECK_CLOSE(90.0f, mPoseB._sprites [0]._spatial._x, 0.001f);
+}
@@ -27,6 +27,7 @@
 #include "dependencies/unittest++/src/UnitTest++.h"
 #include "CIndieLib.h"
 #include "IND_Surface.h"
+#include "IND_Image.h"
 
 struct fixture {
     fixture() {
@@ -59,3 +60,44 @@ TEST_FIXTURE(fixture,SURFACEMANAGER_ADDEXISTING_REMOVEIT_NOFAIL) {
 TEST_FIXTURE(fixture,SURFACEMANAGER_REMOVENONEXISTING_FAILS) {
     CHECK(!iLib->_surfaceManager->remove(testSurf));
 }
+
+TEST_FIXTURE(fixture,SURFACEMANAGER_ADDEXISTING_COUNTSTEXTUREMEMORY) {
+	iLib->_surfaceManager->add(testSurf,const_cast<char *>("blue_background.jpg"), IND_OPAQUE, IND_32);
+	CHECK(iLib->_surfaceManager->getTextureMemoryInt() >= static_cast<size_t>(testSurf->getWidth() * testSurf->getHeight() * 4));
+	CHECK(iLib->_surfaceManager->getTextureMemoryWastedInt() <= iLib->_surfaceManager->getTextureMemoryInt());
+}
+
+TEST_FIXTURE(fixture,SURFACEMANAGER_ADDEXISTING_REMOVEIT_FREESTEXTUREMEMORY) {
+	iLib->_surfaceManager->add(testSurf,const_cast<char *>("blue_background.jpg"), IND_OPAQUE, IND_32);
+	iLib->_surfaceManager->remove(testSurf);
+	CHECK_EQUAL(static_cast<size_t>(0), iLib->_surfaceManager->getTextureMemoryInt());
+	CHECK_EQUAL(static_cast<size_t>(0), iLib->_surfaceManager->getTextureMemoryWastedInt());
+}
+
+TEST_FIXTURE(fixture,SURFACEMANAGER_ADDTRIMMED_KEEPSSIZE) {
+	IND_Image *image = IND_Image::newImage();
+	iLib->_imageManager->add(image, 64, 64, IND_RGBA);
+	image->clear(0, 0, 0, 0);
+	image->putPixel(10, 20, 255, 255, 255, 255);
+	image->putPixel(29, 39, 255, 255, 255, 255);
+
+	iLib->_surfaceManager->setTrim(true);
+	CHECK(iLib->_surfaceManager->add(testSurf, image, IND_ALPHA, IND_32));
+	iLib->_surfaceManager->setTrim(false);
+
+	CHECK(testSurf->isTrimmed());
+	CHECK_EQUAL(64, testSurf->getWidth());
+	CHECK_EQUAL(64, testSurf->getHeight());
+	CHECK_EQUAL(20, testSurf->getTrimWidth());
+	CHECK_EQUAL(20, testSurf->getTrimHeight());
+}
+
+TEST_FIXTURE(fixture,SURFACEMANAGER_ADD_CLASSIFIESALPHA) {
+	IND_Image *image = IND_Image::newImage();
+	iLib->_imageManager->add(image, 64, 64, IND_RGBA);
+	image->clear(255, 255, 255, 255);
+	image->putPixel(10, 20, 0, 0, 0, 0);
+
+	CHECK(iLib->_surfaceManager->add(testSurf, image, IND_ALPHA, IND_32));
+	CHECK_EQUAL(IND_ALPHA_CLASS_TESTED, testSurf->getAlphaClass());
+}
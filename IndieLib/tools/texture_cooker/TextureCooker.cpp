@@ -0,0 +1,161 @@
+/*****************************************************************************************
+ * File: TextureCooker.cpp
+ * Desc: Offline tool that converts images (png, tga, bmp...) into the pre-compressed .dds
+ *       variants loaded by IND_SurfaceManager
+ *****************************************************************************************/
+
+/*********************************** The zlib License ************************************
+ *
+ * Copyright (c) 2013 Indielib-crossplatform Development Team
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ * distribution.
+ *
+ *****************************************************************************************/
+
+#include "dependencies/FreeImage/Dist/FreeImage.h"
+#include "src/CompressedImageHelper.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+==================
+Usage
+==================
+*/
+static void printUsage() {
+	printf("Usage: texturecooker [-dxt1 | -dxt5] <image> [<output.dds>]\n\n");
+	printf("Encodes an image as DXT1 (no alpha) or DXT5 (alpha). When no format is given, DXT5 is\n");
+	printf("used for images with transparent pixels. The default output is the image name with\n");
+	printf(".dds extension, which is the file that IND_SurfaceManager looks for.\n\n");
+	printf("The output is a standard DDS file (rows from the upper one), so .dds files made with\n");
+	printf("other tools (i.e. BC7) are loaded by IndieLib as they are.\n");
+}
+
+/*
+==================
+True if any pixel of a 32 bpp bitmap is not opaque
+==================
+*/
+static bool hasTransparentPixels(FIBITMAP *pBitmap) {
+	int mWidth = FreeImage_GetWidth(pBitmap);
+	int mHeight = FreeImage_GetHeight(pBitmap);
+
+	for (int y = 0; y < mHeight; y++) {
+		BYTE *mLine = FreeImage_GetScanLine(pBitmap, y);
+		for (int x = 0; x < mWidth; x++) {
+			if (mLine[x * 4 + FI_RGBA_ALPHA] != 255)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+==================
+Main
+==================
+*/
+int main(int argc, char **argv) {
+	int mFormat = COMPRESSED_UNKNOWN;
+	const char *mInput = NULL;
+	const char *mOutput = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-dxt1")) {
+			mFormat = COMPRESSED_DXT1;
+		} else if (!strcmp(argv[i], "-dxt5")) {
+			mFormat = COMPRESSED_DXT5;
+		} else if (!mInput) {
+			mInput = argv[i];
+		} else if (!mOutput) {
+			mOutput = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (!mInput) {
+		printUsage();
+		return 1;
+	}
+
+	char mCompressedName [MAX_TOKEN];
+	if (!mOutput) {
+		CompressedImageHelper::getCompressedName(mInput, mCompressedName);
+		mOutput = mCompressedName;
+	}
+
+	// ----- Loading -----
+
+	FreeImage_Initialise();
+
+	FREE_IMAGE_FORMAT mFif = FreeImage_GetFileType(mInput, 0);
+	if (FIF_UNKNOWN == mFif)
+		mFif = FreeImage_GetFIFFromFilename(mInput);
+
+	FIBITMAP *mLoaded = (FIF_UNKNOWN != mFif) ? FreeImage_Load(mFif, mInput, 0) : NULL;
+	if (!mLoaded) {
+		printf("Error: can't load %s\n", mInput);
+		FreeImage_DeInitialise();
+		return 1;
+	}
+
+	// Same layout used by IndieLib images: 32 bpp, rows from the lower one (the encoder flips them)
+	FIBITMAP *mBitmap = FreeImage_ConvertTo32Bits(mLoaded);
+	FreeImage_Unload(mLoaded);
+	if (!mBitmap) {
+		printf("Error: can't convert %s to 32 bpp\n", mInput);
+		FreeImage_DeInitialise();
+		return 1;
+	}
+
+	if (COMPRESSED_UNKNOWN == mFormat)
+		mFormat = hasTransparentPixels(mBitmap) ? COMPRESSED_DXT5 : COMPRESSED_DXT1;
+
+	// ----- Encoding -----
+
+	int mWidth = FreeImage_GetWidth(mBitmap);
+	int mHeight = FreeImage_GetHeight(mBitmap);
+
+	COMPRESSED_IMAGE mImage;
+	bool mOk = CompressedImageHelper::encode(FreeImage_GetBits(mBitmap), mWidth, mHeight, mFormat, &mImage) &&
+	           CompressedImageHelper::saveDDS(mOutput, &mImage);
+
+	if (mOk) {
+		printf("%s -> %s (%s, %dx%d, %d bytes, %d bytes uncompressed)\n",
+		       mInput,
+		       mOutput,
+		       CompressedImageHelper::getFormatName(mFormat),
+		       mWidth,
+		       mHeight,
+		       mImage._size,
+		       mWidth * mHeight * 4);
+	} else {
+		printf("Error: can't write %s\n", mOutput);
+	}
+
+	CompressedImageHelper::freeImage(&mImage);
+	FreeImage_Unload(mBitmap);
+	FreeImage_DeInitialise();
+
+	return mOk ? 0 : 1;
+}